@@ -102,6 +102,22 @@ class IAppState {
   // may return different block numbers.
 };
 
+// Compression of the blocks sent by source replicas. Block digests are always computed over uncompressed blocks.
+enum class BlockCodec : uint8_t { None = 0, LZ4, ZSTD, End };
+
+inline std::ostream &operator<<(std::ostream &os, const BlockCodec &c) {
+  switch (c) {
+    case BlockCodec::None:
+      return os << "none";
+    case BlockCodec::LZ4:
+      return os << "lz4";
+    case BlockCodec::ZSTD:
+      return os << "zstd";
+    default:
+      return os << "unknown(" << static_cast<int>(c) << ")";
+  }
+}
+
 struct Config {
   uint16_t myReplicaId;
   uint16_t fVal = 0;
@@ -130,6 +146,15 @@ struct Config {
   // misc
   bool runInSeparateThread = false;
   bool enableReservedPages = true;
+  // The codec that source replicas are asked to send blocks with
+  BlockCodec blockCodec = BlockCodec::None;
+  // If bigger than maxNumberOfChunksInBatch, the number of chunks asked for in a batch starts at
+  // maxNumberOfChunksInBatch and adapts to the measured throughput and latency of the source, up to this value.
+  uint16_t maxNumberOfChunksInAdaptiveBatch = 0;
+  // If true, the digest of the reserved pages descriptor is the root of a merkle tree over its entries, which is
+  // updated incrementally on each checkpoint. All the replicas must use the same value, as the digest is part of the
+  // checkpoints they agree on.
+  bool resPagesMerkleTreeDigest = false;
 };
 
 inline std::ostream &operator<<(std::ostream &os, const Config &c) {
@@ -154,7 +179,10 @@ inline std::ostream &operator<<(std::ostream &os, const Config &c) {
               c.fetchRetransmissionTimeoutMs,
               c.metricsDumpIntervalSec,
               c.runInSeparateThread,
-              c.enableReservedPages);
+              c.enableReservedPages,
+              c.blockCodec,
+              c.maxNumberOfChunksInAdaptiveBatch,
+              c.resPagesMerkleTreeDigest);
   return os;
 }
 // creates an instance of the state transfer module.
@@ -12,6 +12,8 @@
 
 #pragma once
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace bftEngine {
 class IReservedPages {
@@ -22,5 +24,12 @@ class IReservedPages {
   virtual bool loadReservedPage(uint32_t reservedPageId, uint32_t copyLength, char *outReservedPage) const = 0;
   virtual void saveReservedPage(uint32_t reservedPageId, uint32_t copyLength, const char *inReservedPage) = 0;
   virtual void zeroReservedPage(uint32_t reservedPageId) = 0;
+
+  // An append-only log of records that the reserved pages' owner folds into the pages later on, e.g. before a
+  // checkpoint is created. It survives restarts and is dropped when a new state is fetched. An implementation without
+  // a log returns false from appendToReservedPagesLog() and the caller has to save the pages right away.
+  virtual bool appendToReservedPagesLog(const char *record, uint32_t length) { return false; }
+  virtual std::vector<std::string> loadReservedPagesLog() const { return {}; }
+  virtual void clearReservedPagesLog() {}
 };
 }  // namespace bftEngine
@@ -86,6 +86,12 @@ class IReplicaForStateTransfer {
 
   virtual void sendStateTransferMessage(char *m, uint32_t size, uint16_t replicaId) = 0;
 
+  // Allocate a zeroed message of up to size bytes, to be released by using freeStateTransferMsg.
+  // It can be sent any number of times with sendPreallocatedStateTransferMessage, which doesn't copy it first.
+  virtual char *allocStateTransferMsg(uint32_t size) = 0;
+
+  virtual void sendPreallocatedStateTransferMessage(char *m, uint32_t size, uint16_t replicaId) = 0;
+
   // the timer is disabled when timerPeriodMilli==0
   // (notice that the state transfer module can use its own timers and threads)
   virtual void changeStateTransferTimerPeriod(uint32_t timerPeriodMilli) = 0;
@@ -88,6 +88,16 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
                "Number of threads to be used by the PreProcessor to execute "
                "client requests. If equals to 0, a default of "
                "min(thread::hardware_concurrency(), numOfClients) is used ");
+  CONFIG_PARAM(preExecMsgProcessingShards,
+               uint16_t,
+               1,
+               "number of threads the PreProcessor uses to validate and handle messages. Messages are sharded by "
+               "client id");
+  CONFIG_PARAM(preExecResultBuffersMemoryLimit,
+               uint64_t,
+               0,
+               "maximal total size in bytes of the buffers allocated for pre-execution results; 0 means unlimited. "
+               "Requests that can't get a buffer are not pre-executed");
 
   CONFIG_PARAM(batchingPolicy, uint32_t, BATCH_SELF_ADJUSTED, "BFT consensus batching policy for requests");
   CONFIG_PARAM(batchFlushPeriod, uint32_t, 1000, "BFT consensus batching flush period");
@@ -106,6 +116,21 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
   CONFIG_PARAM(adaptiveBatchingMidIncCond, std::string, "0.9", "The mid increase condition");
   CONFIG_PARAM(adaptiveBatchingMinIncCond, std::string, "0.75", "The min increase condition");
   CONFIG_PARAM(adaptiveBatchingDecCond, std::string, "0.5", "The decrease condition");
+  CONFIG_PARAM(prePrepareWithRequestDigestsOnly,
+               bool,
+               false,
+               "the primary sends PrePrepare messages that carry only the digests of the requests; the request bodies "
+               "are delivered to the replicas separately");
+  CONFIG_PARAM(disseminateClientRequests,
+               bool,
+               true,
+               "with prePrepareWithRequestDigestsOnly, a replica forwards each request it receives from a client to "
+               "all other replicas. Can be disabled if clients send their requests to all replicas");
+  CONFIG_PARAM(maxNumOfStoredClientRequests,
+               uint32_t,
+               10000,
+               "with prePrepareWithRequestDigestsOnly, max number of request bodies a replica keeps to resolve "
+               "PrePrepare messages");
 
   // Crypto system
   // RSA public keys of all replicas. map from replica identifier to a public key
@@ -207,6 +232,8 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     serialize(outStream, clientTransactionSigningEnabled);
     serialize(outStream, preExecReqStatusCheckTimerMillisec);
     serialize(outStream, preExecConcurrencyLevel);
+    serialize(outStream, preExecMsgProcessingShards);
+    serialize(outStream, preExecResultBuffersMemoryLimit);
     serialize(outStream, batchingPolicy);
     serialize(outStream, batchFlushPeriod);
     serialize(outStream, maxNumOfRequestsInBatch);
@@ -218,6 +245,9 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     serialize(outStream, adaptiveBatchingMidIncCond);
     serialize(outStream, adaptiveBatchingMinIncCond);
     serialize(outStream, adaptiveBatchingDecCond);
+    serialize(outStream, prePrepareWithRequestDigestsOnly);
+    serialize(outStream, disseminateClientRequests);
+    serialize(outStream, maxNumOfStoredClientRequests);
 
     serialize(outStream, publicKeysOfReplicas);
     serialize(outStream, publicKeysOfClients);
@@ -273,6 +303,8 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     deserialize(inStream, clientTransactionSigningEnabled);
     deserialize(inStream, preExecReqStatusCheckTimerMillisec);
     deserialize(inStream, preExecConcurrencyLevel);
+    deserialize(inStream, preExecMsgProcessingShards);
+    deserialize(inStream, preExecResultBuffersMemoryLimit);
     deserialize(inStream, batchingPolicy);
     deserialize(inStream, batchFlushPeriod);
     deserialize(inStream, maxNumOfRequestsInBatch);
@@ -284,6 +316,9 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     deserialize(inStream, adaptiveBatchingMidIncCond);
     deserialize(inStream, adaptiveBatchingMinIncCond);
     deserialize(inStream, adaptiveBatchingDecCond);
+    deserialize(inStream, prePrepareWithRequestDigestsOnly);
+    deserialize(inStream, disseminateClientRequests);
+    deserialize(inStream, maxNumOfStoredClientRequests);
 
     deserialize(inStream, publicKeysOfReplicas);
     deserialize(inStream, publicKeysOfClients);
@@ -381,6 +416,12 @@ inline std::ostream& operator<<(std::ostream& os, const ReplicaConfig& rc) {
               rc.timeServiceSoftLimitMillis.count(),
               rc.timeServiceHardLimitMillis.count(),
               rc.timeServiceEpsilonMillis.count());
+  os << ", ";
+  os << KVLOG(rc.prePrepareWithRequestDigestsOnly,
+              rc.disseminateClientRequests,
+              rc.maxNumOfStoredClientRequests,
+              rc.preExecMsgProcessingShards,
+              rc.preExecResultBuffersMemoryLimit);
 
   for (auto& [param, value] : rc.config_params_) os << param << ": " << value << "\n";
 
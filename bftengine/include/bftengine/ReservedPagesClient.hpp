@@ -101,6 +101,11 @@ class ResPagesClient : public ReservedPagesClientBase, public IReservedPages {
   void zeroReservedPage(uint32_t reservedPageId) override {
     res_pages_->zeroReservedPage(my_offset() + reservedPageId);
   }
+  bool appendToReservedPagesLog(const char* record, uint32_t length) override {
+    return res_pages_->appendToReservedPagesLog(record, length);
+  }
+  std::vector<std::string> loadReservedPagesLog() const override { return res_pages_->loadReservedPagesLog(); }
+  void clearReservedPagesLog() override { res_pages_->clearReservedPagesLog(); }
 
  private:
   /** is called when calculating absolute pageId */
@@ -24,6 +24,7 @@
 #include "assertUtils.hpp"
 #include "hex_tools.h"
 #include "BCStateTran.hpp"
+#include "BlockCodec.hpp"
 #include "STDigest.hpp"
 #include "InMemoryDataStore.hpp"
 #include "json_output.hpp"
@@ -156,6 +157,11 @@ BCStateTran::BCStateTran(const Config &config, IAppState *const stateApi, DataSt
       randomGen_{randomDevice_()},
       sourceSelector_{
           allOtherReplicas(), config_.fetchRetransmissionTimeoutMs, config_.sourceReplicaReplacementTimeoutMs},
+      fetchWindow_{config_.maxNumberOfChunksInBatch,
+                   config_.maxNumberOfChunksInAdaptiveBatch,
+                   config_.fetchRetransmissionTimeoutMs,
+                   config_.maxPendingDataFromSourceReplica},
+      resPagesHashingPool_{std::clamp(std::thread::hardware_concurrency(), 1u, kMaxResPagesHashingThreads)},
       last_metrics_dump_time_(0),
       metrics_dump_interval_in_sec_{std::chrono::seconds(config_.metricsDumpIntervalSec)},
       metrics_component_{
@@ -213,6 +219,7 @@ BCStateTran::BCStateTran(const Config &config, IAppState *const stateApi, DataSt
                metrics_component_.RegisterCounter("load_reserved_page_from_checkpoint"),
                metrics_component_.RegisterCounter("save_reserved_page"),
                metrics_component_.RegisterCounter("zero_reserved_page"),
+               metrics_component_.RegisterCounter("append_to_reserved_pages_log"),
                metrics_component_.RegisterCounter("start_collecting_state"),
                metrics_component_.RegisterCounter("on_timer"),
                metrics_component_.RegisterCounter("on_transferring_complete"),
@@ -389,6 +396,9 @@ void BCStateTran::stopRunning() {
 
   pendingItemDataMsgs.clear();
   totalSizeOfPendingItemDataMsgs = 0;
+
+  if (chunkMsg_) replicaForStateTransfer_->freeStateTransferMsg(reinterpret_cast<char *>(chunkMsg_));
+  chunkMsg_ = nullptr;
   replicaForStateTransfer_ = nullptr;
 }
 
@@ -427,21 +437,23 @@ DataStore::CheckpointDesc BCStateTran::createCheckpointDesc(uint64_t checkpointN
 
 // Associate any pending reserved pages with the current checkpoint.
 // Return the digest of all the reserved pages descriptor.
-//
-// This has the side effect of mutating buffer_.
 STDigest BCStateTran::checkpointReservedPages(uint64_t checkpointNumber, DataStoreTransaction *txn) {
   set<uint32_t> pages = txn->getNumbersOfPendingResPages();
   auto numberOfPagesInCheckpoint = pages.size();
   LOG_INFO(getLogger(),
            "Associating pending pages with checkpoint: " << KVLOG(numberOfPagesInCheckpoint, checkpointNumber));
-  std::unique_ptr<char[]> buffer(new char[config_.sizeOfReservedPage]);
-  for (uint32_t p : pages) {
-    STDigest d;
-    txn->getPendingResPage(p, buffer.get(), config_.sizeOfReservedPage);
-    computeDigestOfPage(p, checkpointNumber, buffer.get(), config_.sizeOfReservedPage, d);
-    txn->associatePendingResPageWithCheckpoint(p, checkpointNumber, d);
+
+  std::vector<uint32_t> pageIds(pages.begin(), pages.end());
+  std::vector<STDigest> digests(pageIds.size());
+  computeDigestsOfPendingPages(checkpointNumber, pageIds, digests, txn);
+
+  if (config_.resPagesMerkleTreeDigest) {
+    return checkpointReservedPagesInTree(checkpointNumber, pageIds, digests, txn);
   }
 
+  for (size_t i = 0; i < pageIds.size(); ++i) {
+    txn->associatePendingResPageWithCheckpoint(pageIds[i], checkpointNumber, digests[i]);
+  }
   ConcordAssertEQ(txn->numOfAllPendingResPage(), 0);
   DataStore::ResPagesDescriptor *allPagesDesc = txn->getResPagesDescriptor(checkpointNumber);
   ConcordAssertEQ(allPagesDesc->numOfPages, numberOfReservedPages_);
@@ -455,6 +467,83 @@ STDigest BCStateTran::checkpointReservedPages(uint64_t checkpointNumber, DataSto
   return digestOfResPagesDescriptor;
 }
 
+// Return the root of resPagesTree_ as the digest of all the reserved pages descriptor.
+//
+// Only the pending pages' paths in resPagesTree_ are hashed. The tree is rebuilt from the stored descriptor if it
+// doesn't reflect the last stored checkpoint (after startup or state transfer).
+STDigest BCStateTran::checkpointReservedPagesInTree(uint64_t checkpointNumber,
+                                                    const std::vector<uint32_t> &pageIds,
+                                                    const std::vector<STDigest> &digests,
+                                                    DataStoreTransaction *txn) {
+  const uint64_t lastStoredCheckpoint = txn->getLastStoredCheckpoint();
+  if (!resPagesTree_ || resPagesTree_->numOfPages() != numberOfReservedPages_ ||
+      resPagesTree_->checkpoint() != lastStoredCheckpoint) {
+    LOG_INFO(getLogger(), "Building reserved pages merkle tree: " << KVLOG(lastStoredCheckpoint));
+    resPagesTree_ = std::make_unique<ResPagesMerkleTree>(numberOfReservedPages_);
+    DataStore::ResPagesDescriptor *lastPagesDesc = txn->getResPagesDescriptor(lastStoredCheckpoint);
+    resPagesTree_->build(lastPagesDesc);
+    txn->free(lastPagesDesc);
+  }
+
+  // The tree doesn't reflect any stored checkpoint until the new one is fully associated.
+  resPagesTree_->resetCheckpoint();
+  for (size_t i = 0; i < pageIds.size(); ++i) {
+    txn->associatePendingResPageWithCheckpoint(pageIds[i], checkpointNumber, digests[i]);
+    resPagesTree_->update(DataStore::SingleResPageDesc{pageIds[i], checkpointNumber, digests[i]});
+  }
+  ConcordAssertEQ(txn->numOfAllPendingResPage(), 0);
+
+  STDigest digestOfResPagesDescriptor = resPagesTree_->root();
+  resPagesTree_->setCheckpoint(checkpointNumber);
+
+  if (config_.pedanticChecks) {
+    DataStore::ResPagesDescriptor *allPagesDesc = txn->getResPagesDescriptor(checkpointNumber);
+    ConcordAssertEQ(allPagesDesc->numOfPages, numberOfReservedPages_);
+    STDigest computedDigestOfResPagesDescriptor;
+    computeDigestOfPagesDescriptor(allPagesDesc, computedDigestOfResPagesDescriptor);
+    LOG_INFO(getLogger(), allPagesDesc->toString(computedDigestOfResPagesDescriptor.toString()));
+    ConcordAssertEQ(computedDigestOfResPagesDescriptor, digestOfResPagesDescriptor);
+    txn->free(allPagesDesc);
+  }
+
+  LOG_INFO(getLogger(), KVLOG(checkpointNumber, digestOfResPagesDescriptor));
+  return digestOfResPagesDescriptor;
+}
+
+void BCStateTran::computeDigestsOfPendingPages(uint64_t checkpointNumber,
+                                               const std::vector<uint32_t> &pageIds,
+                                               std::vector<STDigest> &outDigests,
+                                               DataStoreTransaction *txn) {
+  ConcordAssertEQ(pageIds.size(), outDigests.size());
+  if (pageIds.empty()) return;
+
+  const size_t pageSize = config_.sizeOfReservedPage;
+  const size_t batchSize = std::min<size_t>(pageIds.size(), kResPagesHashingBatchSize);
+  std::unique_ptr<char[]> buffer(new char[batchSize * pageSize]);
+  std::vector<std::future<void>> futures;
+
+  for (size_t batchBegin = 0; batchBegin < pageIds.size(); batchBegin += batchSize) {
+    const size_t batchEnd = std::min(batchBegin + batchSize, pageIds.size());
+    // Pages are copied sequentially, as the data store isn't thread safe.
+    for (size_t i = batchBegin; i < batchEnd; ++i)
+      txn->getPendingResPage(pageIds[i], buffer.get() + (i - batchBegin) * pageSize, pageSize);
+
+    // Split the batch into one contiguous range of pages per thread.
+    const size_t numOfRanges = std::min<size_t>(batchEnd - batchBegin, kMaxResPagesHashingThreads);
+    const size_t rangeSize = (batchEnd - batchBegin + numOfRanges - 1) / numOfRanges;
+    futures.clear();
+    for (size_t rangeBegin = batchBegin; rangeBegin < batchEnd; rangeBegin += rangeSize) {
+      const size_t rangeEnd = std::min(rangeBegin + rangeSize, batchEnd);
+      futures.push_back(resPagesHashingPool_.async([&, rangeBegin, rangeEnd]() {
+        for (size_t i = rangeBegin; i < rangeEnd; ++i)
+          computeDigestOfPage(
+              pageIds[i], checkpointNumber, buffer.get() + (i - batchBegin) * pageSize, pageSize, outDigests[i]);
+      }));
+    }
+    for (auto &f : futures) f.get();
+  }
+}
+
 void BCStateTran::deleteOldCheckpoints(uint64_t checkpointNumber, DataStoreTransaction *txn) {
   uint64_t minRelevantCheckpoint = 0;
   if (checkpointNumber >= maxNumOfStoredCheckpoints_)
@@ -607,6 +696,20 @@ void BCStateTran::zeroReservedPage(uint32_t reservedPageId) {
   psd_->setPendingResPage(reservedPageId, buffer.get(), config_.sizeOfReservedPage);
 }
 
+bool BCStateTran::appendToReservedPagesLog(const char *record, uint32_t length) {
+  ConcordAssert(!isFetching());
+  metrics_.append_to_reserved_pages_log_.Get().Inc();
+  psd_->appendResPagesLogRecord(std::string(record, length));
+  return true;
+}
+
+std::vector<std::string> BCStateTran::loadReservedPagesLog() const { return psd_->getResPagesLog(); }
+
+void BCStateTran::clearReservedPagesLog() {
+  LOG_DEBUG(getLogger(), "");
+  psd_->clearResPagesLog();
+}
+
 void BCStateTran::startCollectingStats() {
   blocks_collected_.start();
   bytes_collected_.start();
@@ -636,6 +739,7 @@ void BCStateTran::startCollectingState() {
   {  // txn scope
     DataStoreTransaction::Guard g(psd_->beginTransaction());
     g.txn()->deleteAllPendingPages();
+    g.txn()->clearResPagesLog();
     g.txn()->setIsFetchingState(true);
   }
   sendAskForCheckpointSummariesMsg();
@@ -757,6 +861,7 @@ void BCStateTran::handleStateTransferMessageImp(char *msg, uint32_t msgLen, uint
         noDelete = onMessage(reinterpret_cast<RejectFetchingMsg *>(msg), msgLen, senderId);
       break;
     case MsgType::ItemData:
+    case MsgType::CompressedItemData:
       if (fs == FetchingState::GettingMissingBlocks || fs == FetchingState::GettingMissingResPages)
         noDelete = onMessage(reinterpret_cast<ItemDataMsg *>(msg), msgLen, senderId);
       break;
@@ -979,15 +1084,21 @@ void BCStateTran::sendFetchBlocksMsg(uint64_t firstRequiredBlock,
   msg.firstRequiredBlock = firstRequiredBlock;
   msg.lastRequiredBlock = lastRequiredBlock;
   msg.lastKnownChunkInLastRequiredBlock = lastKnownChunkInLastRequiredBlock;
+  msg.blockCodec = static_cast<uint8_t>(config_.blockCodec);
+  msg.maxNumberOfChunksInBatch = fetchWindow_.chunks();
+  numOfChunksInRequestedBatch_ = msg.maxNumberOfChunksInBatch;
 
   LOG_DEBUG(getLogger(),
             KVLOG(sourceSelector_.currentReplica(),
                   msg.msgSeqNum,
                   msg.firstRequiredBlock,
                   msg.lastRequiredBlock,
-                  msg.lastKnownChunkInLastRequiredBlock));
+                  msg.lastKnownChunkInLastRequiredBlock,
+                  config_.blockCodec,
+                  msg.maxNumberOfChunksInBatch));
 
   sourceSelector_.setFetchingTimeStamp(getLogger(), getMonotonicTimeMilli());
+  fetchWindow_.onBatchRequested(getMonotonicTimeMilli());
   fetch_block_msg_latency_rec_.start(lastMsgSeqNum_);
   replicaForStateTransfer_->sendStateTransferMessage(
       reinterpret_cast<char *>(&msg), sizeof(FetchBlocksMsg), sourceSelector_.currentReplica());
@@ -1231,8 +1342,15 @@ bool BCStateTran::onMessage(const FetchBlocksMsg *m, uint32_t msgLen, uint16_t r
   LOG_DEBUG(getLogger(), "");
   metrics_.received_fetch_blocks_msg_.Get().Inc();
 
+  // older replicas send shorter messages, without a block codec and a batch size
+  FetchBlocksMsg legacyMsg;
+  if (msgLen >= FetchBlocksMsg::kLegacySize && msgLen < sizeof(FetchBlocksMsg)) {
+    memcpy(&legacyMsg, m, msgLen);
+    m = &legacyMsg;
+  }
+
   // if msg is invalid
-  if (msgLen < sizeof(FetchBlocksMsg) || m->msgSeqNum == 0 || m->firstRequiredBlock == 0 ||
+  if (msgLen < FetchBlocksMsg::kLegacySize || m->msgSeqNum == 0 || m->firstRequiredBlock == 0 ||
       m->lastRequiredBlock < m->firstRequiredBlock) {
     LOG_WARN(getLogger(),
              "Msg is invalid: " << KVLOG(replicaId, m->msgSeqNum, m->firstRequiredBlock, m->lastRequiredBlock));
@@ -1271,6 +1389,8 @@ bool BCStateTran::onMessage(const FetchBlocksMsg *m, uint32_t msgLen, uint16_t r
   bool tmp = as_->getBlock(nextBlock, buffer_, &sizeOfNextBlock);
   ConcordAssert(tmp);
   ConcordAssertGT(sizeOfNextBlock, 0);
+  const char *nextBlockData = buffer_;
+  BlockCodec codecOfNextBlock = encodeBlock(m->blockCodec, nextBlockData, sizeOfNextBlock);
 
   uint32_t sizeOfLastChunk = config_.maxChunkSize;
   uint32_t numOfChunksInNextBlock = sizeOfNextBlock / config_.maxChunkSize;
@@ -1288,6 +1408,14 @@ bool BCStateTran::onMessage(const FetchBlocksMsg *m, uint32_t msgLen, uint16_t r
     return false;
   }
 
+  // the destination may ask for smaller or bigger batches, up to the biggest one we would ask for
+  uint16_t numOfChunksInBatch = config_.maxNumberOfChunksInBatch;
+  if (m->maxNumberOfChunksInBatch > 0) {
+    numOfChunksInBatch = std::min(
+        m->maxNumberOfChunksInBatch,
+        std::max(config_.maxNumberOfChunksInBatch, config_.maxNumberOfChunksInAdaptiveBatch));
+  }
+
   // send chunks
   uint16_t numOfSentChunks = 0;
   while (true) {
@@ -1296,15 +1424,15 @@ bool BCStateTran::onMessage(const FetchBlocksMsg *m, uint32_t msgLen, uint16_t r
 
     ConcordAssertGT(chunkSize, 0);
 
-    char *pRawChunk = buffer_ + (nextChunk - 1) * config_.maxChunkSize;
-    ItemDataMsg *outMsg = ItemDataMsg::alloc(chunkSize);  // TODO(GG): improve
+    const char *pRawChunk = nextBlockData + (nextChunk - 1) * config_.maxChunkSize;
+    ItemDataMsg *outMsg = getChunkMsg(chunkSize);
 
     outMsg->requestMsgSeqNum = m->msgSeqNum;
     outMsg->blockNumber = nextBlock;
     outMsg->totalNumberOfChunksInBlock = numOfChunksInNextBlock;
     outMsg->chunkNumber = nextChunk;
-    outMsg->dataSize = chunkSize;
-    outMsg->lastInBatch = ((numOfSentChunks + 1) >= config_.maxNumberOfChunksInBatch);
+    outMsg->lastInBatch = ((numOfSentChunks + 1) >= numOfChunksInBatch);
+    if (codecOfNextBlock != BlockCodec::None) outMsg->type = MsgType::CompressedItemData;
     memcpy(outMsg->data, pRawChunk, chunkSize);
 
     LOG_DEBUG(getLogger(),
@@ -1314,16 +1442,17 @@ bool BCStateTran::onMessage(const FetchBlocksMsg *m, uint32_t msgLen, uint16_t r
                                                outMsg->totalNumberOfChunksInBlock,
                                                outMsg->chunkNumber,
                                                outMsg->dataSize,
-                                               outMsg->lastInBatch));
+                                               outMsg->lastInBatch,
+                                               codecOfNextBlock));
 
     metrics_.sent_item_data_msg_.Get().Inc();
-    replicaForStateTransfer_->sendStateTransferMessage(reinterpret_cast<char *>(outMsg), outMsg->size(), replicaId);
+    replicaForStateTransfer_->sendPreallocatedStateTransferMessage(
+        reinterpret_cast<char *>(outMsg), outMsg->size(), replicaId);
 
-    ItemDataMsg::free(outMsg);
     numOfSentChunks++;
 
     // if we've already sent enough chunks
-    if (numOfSentChunks >= config_.maxNumberOfChunksInBatch) {
+    if (numOfSentChunks >= numOfChunksInBatch) {
       LOG_DEBUG(getLogger(), "Sent enough chunks: " << KVLOG(numOfSentChunks));
       break;
     }
@@ -1342,6 +1471,8 @@ bool BCStateTran::onMessage(const FetchBlocksMsg *m, uint32_t msgLen, uint16_t r
       bool tmp2 = as_->getBlock(nextBlock, buffer_, &sizeOfNextBlock);
       ConcordAssert(tmp2);
       ConcordAssertGT(sizeOfNextBlock, 0);
+      nextBlockData = buffer_;
+      codecOfNextBlock = encodeBlock(m->blockCodec, nextBlockData, sizeOfNextBlock);
 
       sizeOfLastChunk = config_.maxChunkSize;
       numOfChunksInNextBlock = sizeOfNextBlock / config_.maxChunkSize;
@@ -1445,13 +1576,12 @@ bool BCStateTran::onMessage(const FetchResPagesMsg *m, uint32_t msgLen, uint16_t
     ConcordAssertGT(chunkSize, 0);
 
     char *pRawChunk = vblock + (nextChunk - 1) * config_.maxChunkSize;
-    ItemDataMsg *outMsg = ItemDataMsg::alloc(chunkSize);
+    ItemDataMsg *outMsg = getChunkMsg(chunkSize);
 
     outMsg->requestMsgSeqNum = m->msgSeqNum;
     outMsg->blockNumber = ID_OF_VBLOCK_RES_PAGES;
     outMsg->totalNumberOfChunksInBlock = numOfChunksInVBlock;
     outMsg->chunkNumber = nextChunk;
-    outMsg->dataSize = chunkSize;
     memcpy(outMsg->data, pRawChunk, chunkSize);
 
     LOG_DEBUG(getLogger(),
@@ -1463,9 +1593,9 @@ bool BCStateTran::onMessage(const FetchResPagesMsg *m, uint32_t msgLen, uint16_t
                                                outMsg->dataSize));
     metrics_.sent_item_data_msg_.Get().Inc();
 
-    replicaForStateTransfer_->sendStateTransferMessage(reinterpret_cast<char *>(outMsg), outMsg->size(), replicaId);
+    replicaForStateTransfer_->sendPreallocatedStateTransferMessage(
+        reinterpret_cast<char *>(outMsg), outMsg->size(), replicaId);
 
-    ItemDataMsg::free(outMsg);
     numOfSentChunks++;
 
     // if we've already sent enough chunks
@@ -1580,10 +1710,12 @@ bool BCStateTran::onMessage(const ItemDataMsg *m, uint32_t msgLen, uint16_t repl
 
   auto fetchingState = fs;
   if (fs == FetchingState::GettingMissingBlocks) {
+    // older sources ignore the requested batch size and send maxNumberOfChunksInBatch chunks
+    const uint16_t numOfChunksInBatch = std::max(numOfChunksInRequestedBatch_, config_.maxNumberOfChunksInBatch);
     // if msg is not relevant
     if (sourceSelector_.currentReplica() != replicaId || m->requestMsgSeqNum != lastMsgSeqNum_ ||
         m->blockNumber > lastRequiredBlock || m->blockNumber < firstRequiredBlock ||
-        (m->blockNumber + config_.maxNumberOfChunksInBatch + 1 < lastRequiredBlock) ||
+        (m->blockNumber + numOfChunksInBatch + 1 < lastRequiredBlock) ||
         m->dataSize + totalSizeOfPendingItemDataMsgs > config_.maxPendingDataFromSourceReplica) {
       LOG_WARN(getLogger(),
                "Msg is irrelevant: " << KVLOG(replicaId,
@@ -1594,7 +1726,7 @@ bool BCStateTran::onMessage(const ItemDataMsg *m, uint32_t msgLen, uint16_t repl
                                               m->blockNumber,
                                               firstRequiredBlock,
                                               lastRequiredBlock,
-                                              config_.maxNumberOfChunksInBatch,
+                                              numOfChunksInBatch,
                                               m->dataSize,
                                               totalSizeOfPendingItemDataMsgs,
                                               config_.maxPendingDataFromSourceReplica));
@@ -1639,6 +1771,11 @@ bool BCStateTran::onMessage(const ItemDataMsg *m, uint32_t msgLen, uint16_t repl
     metrics_.num_pending_item_data_msgs_.Get().Set(pendingItemDataMsgs.size());
     totalSizeOfPendingItemDataMsgs += m->dataSize;
     metrics_.total_size_of_pending_item_data_msgs_.Get().Set(totalSizeOfPendingItemDataMsgs);
+    if (fs == FetchingState::GettingMissingBlocks) {
+      const uint64_t currTime = getMonotonicTimeMilli();
+      fetchWindow_.onChunkReceived(m->dataSize, currTime);
+      if (m->lastInBatch) fetchWindow_.onBatchCompleted(currTime);
+    }
     processData();
     return true;
   } else {
@@ -1812,7 +1949,8 @@ bool BCStateTran::getNextFullBlock(uint64_t requiredBlock,
                                    char *outBlock,
                                    uint32_t &outBlockSize,
                                    bool isVBLock,
-                                   bool &outLastInBatch) {
+                                   bool &outLastInBatch,
+                                   BlockCodec &outBlockCodec) {
   ConcordAssertGE(requiredBlock, 1);
 
   const uint32_t maxSize = (isVBLock ? maxVBlockSize_ : config_.maxBlockSize);
@@ -1827,6 +1965,7 @@ bool BCStateTran::getNextFullBlock(uint64_t requiredBlock,
   uint16_t totalNumberOfChunks = 0;
   uint16_t maxAvailableChunk = 0;
   uint32_t blockSize = 0;
+  uint16_t msgType = MsgType::None;
 
   auto it = pendingItemDataMsgs.begin();
   while ((it != pendingItemDataMsgs.end()) && ((*it)->blockNumber == requiredBlock)) {
@@ -1836,11 +1975,17 @@ bool BCStateTran::getNextFullBlock(uint64_t requiredBlock,
     ConcordAssertGT(msg->totalNumberOfChunksInBlock, 0);
     ConcordAssertGE(msg->chunkNumber, 1);
 
-    if (totalNumberOfChunks == 0) totalNumberOfChunks = msg->totalNumberOfChunksInBlock;
+    if (totalNumberOfChunks == 0) {
+      totalNumberOfChunks = msg->totalNumberOfChunksInBlock;
+      msgType = msg->type;
+    }
 
     blockSize += msg->dataSize;
+    // all the chunks of a block are compressed together, and only if we asked for it. Virtual blocks are never
+    // compressed.
     if (totalNumberOfChunks != msg->totalNumberOfChunksInBlock || msg->chunkNumber > totalNumberOfChunks ||
-        blockSize > maxSize) {
+        blockSize > maxSize || msgType != msg->type ||
+        (msgType == MsgType::CompressedItemData && (isVBLock || config_.blockCodec == BlockCodec::None))) {
       badData = true;
       break;
     }
@@ -1902,11 +2047,61 @@ bool BCStateTran::getNextFullBlock(uint64_t requiredBlock,
     if (currentChunk == totalNumberOfChunks) {
       outBlockSize = currentPos;
       outLastInBatch = lastInBatch;
+      outBlockCodec = (msgType == MsgType::CompressedItemData) ? config_.blockCodec : BlockCodec::None;
       return true;
     }
   }
 }
 
+BlockCodec BCStateTran::encodeBlock(uint8_t requestedCodec, const char *&block, uint32_t &blockSize) {
+  const auto codec = static_cast<BlockCodec>(requestedCodec);
+  if (codec == BlockCodec::None || requestedCodec >= static_cast<uint8_t>(BlockCodec::End)) {
+    return BlockCodec::None;
+  }
+  if (!codecBuffer_) {
+    codecBuffer_.reset(new char[maxItemSize_]);
+  }
+  // only send compressed blocks that are smaller than the uncompressed ones
+  const uint32_t compressedSize = compressBlock(codec, block, blockSize, codecBuffer_.get(), blockSize - 1);
+  if (compressedSize == 0) {
+    return BlockCodec::None;
+  }
+  LOG_DEBUG(getLogger(), KVLOG(codec, blockSize, compressedSize));
+  block = codecBuffer_.get();
+  blockSize = compressedSize;
+  return codec;
+}
+
+bool BCStateTran::decodeBlock(uint64_t blockNum, BlockCodec codec, char *block, uint32_t &blockSize) {
+  if (codec == BlockCodec::None) {
+    return true;
+  }
+  if (!codecBuffer_) {
+    codecBuffer_.reset(new char[maxItemSize_]);
+  }
+  const uint32_t decompressedSize = decompressBlock(codec, block, blockSize, codecBuffer_.get(), config_.maxBlockSize);
+  if (decompressedSize == 0) {
+    LOG_WARN(getLogger(), "Failed to decompress block: " << KVLOG(blockNum, codec, blockSize));
+    return false;
+  }
+  memcpy(block, codecBuffer_.get(), decompressedSize);
+  blockSize = decompressedSize;
+  return true;
+}
+
+ItemDataMsg *BCStateTran::getChunkMsg(uint32_t dataSize) {
+  ConcordAssertLE(dataSize, config_.maxChunkSize);
+  if (!chunkMsg_) {
+    chunkMsg_ = reinterpret_cast<ItemDataMsg *>(
+        replicaForStateTransfer_->allocStateTransferMsg(sizeof(ItemDataMsg) - 1 + config_.maxChunkSize));
+  } else {
+    memset(chunkMsg_, 0, sizeof(ItemDataMsg) - 1);
+  }
+  chunkMsg_->type = MsgType::ItemData;
+  chunkMsg_->dataSize = dataSize;
+  return chunkMsg_;
+}
+
 bool BCStateTran::checkBlock(uint64_t blockNum,
                              const STDigest &expectedBlockDigest,
                              char *block,
@@ -2160,6 +2355,7 @@ void BCStateTran::processData() {
     int16_t lastChunkInRequiredBlock = 0;
     uint32_t actualBlockSize = 0;
     bool lastInBatch = false;
+    BlockCodec blockCodec = BlockCodec::None;
 
     const bool newBlock = getNextFullBlock(nextRequiredBlock_,
                                            badDataFromCurrentSourceReplica,
@@ -2167,12 +2363,15 @@ void BCStateTran::processData() {
                                            buffer_,
                                            actualBlockSize,
                                            !isGettingBlocks,
-                                           lastInBatch);
+                                           lastInBatch,
+                                           blockCodec);
     bool newBlockIsValid = false;
 
     if (newBlock && isGettingBlocks) {
       ConcordAssert(!badDataFromCurrentSourceReplica);
-      newBlockIsValid = checkBlock(nextRequiredBlock_, digestOfNextRequiredBlock, buffer_, actualBlockSize);
+      // the digest is checked over the uncompressed block
+      newBlockIsValid = decodeBlock(nextRequiredBlock_, blockCodec, buffer_, actualBlockSize) &&
+                        checkBlock(nextRequiredBlock_, digestOfNextRequiredBlock, buffer_, actualBlockSize);
       badDataFromCurrentSourceReplica = !newBlockIsValid;
     } else if (newBlock && !isGettingBlocks) {
       ConcordAssert(!badDataFromCurrentSourceReplica);
@@ -2300,6 +2499,11 @@ void BCStateTran::processData() {
         if (isGettingBlocks) {
           ConcordAssertEQ(psd_->getLastRequiredBlock(), nextRequiredBlock_);
           LOG_DEBUG(getLogger(), "Sending FetchBlocksMsg: " << KVLOG(newSourceReplica, retransmissionTimeoutExpired));
+          if (newSourceReplica) {
+            fetchWindow_.reset();
+          } else {
+            fetchWindow_.onBatchTimeout();
+          }
           sendFetchBlocksMsg(psd_->getFirstRequiredBlock(), nextRequiredBlock_, lastChunkInRequiredBlock);
         } else {
           sendFetchResPagesMsg(lastChunkInRequiredBlock);
@@ -2491,7 +2695,12 @@ void BCStateTran::computeDigestOfPage(
   c.writeDigest(reinterpret_cast<char *>(&outDigest));
 }
 
-void BCStateTran::computeDigestOfPagesDescriptor(const DataStore::ResPagesDescriptor *pagesDesc, STDigest &outDigest) {
+void BCStateTran::computeDigestOfPagesDescriptor(const DataStore::ResPagesDescriptor *pagesDesc,
+                                                 STDigest &outDigest) const {
+  if (config_.resPagesMerkleTreeDigest) {
+    outDigest = ResPagesMerkleTree::computeRoot(pagesDesc);
+    return;
+  }
   DigestContext c;
   c.update(reinterpret_cast<const char *>(pagesDesc), pagesDesc->size());
   c.writeDigest(reinterpret_cast<char *>(&outDigest));
@@ -33,12 +33,15 @@
 #include "STDigest.hpp"
 #include "Metrics.hpp"
 #include "SourceSelector.hpp"
+#include "FetchWindow.hpp"
+#include "ResPagesMerkleTree.hpp"
 #include "callback_registry.hpp"
 #include "Handoff.hpp"
 #include "SysConsts.hpp"
 #include "throughput.hpp"
 #include "diagnostics.h"
 #include "performance_handler.h"
+#include "thread_pool.hpp"
 
 using std::set;
 using std::map;
@@ -86,6 +89,10 @@ class BCStateTran : public IStateTransfer {
   void saveReservedPage(uint32_t reservedPageId, uint32_t copyLength, const char* inReservedPage) override;
   void zeroReservedPage(uint32_t reservedPageId) override;
 
+  bool appendToReservedPagesLog(const char* record, uint32_t length) override;
+  std::vector<std::string> loadReservedPagesLog() const override;
+  void clearReservedPagesLog() override;
+
   void onTimer() override { timerHandler_(); };
   void handleStateTransferMessage(char* msg, uint32_t msgLen, uint16_t senderId) override {
     messageHandler_(msg, msgLen, senderId);
@@ -116,6 +123,8 @@ class BCStateTran : public IStateTransfer {
   static constexpr uint64_t kMaxNumOfStoredCheckpoints = 10;
   static constexpr uint16_t kMaxVBlocksInCache = 28;                    // TBD
   static constexpr uint32_t kResetCount_AskForCheckpointSummaries = 4;  // TBD
+  static constexpr uint32_t kMaxResPagesHashingThreads = 8;
+  static constexpr uint32_t kResPagesHashingBatchSize = 1024;  // max pending pages copied to memory at once
 
   ///////////////////////////////////////////////////////////////////////////
   // External interfaces
@@ -141,6 +150,11 @@ class BCStateTran : public IStateTransfer {
   IReplicaForStateTransfer* replicaForStateTransfer_ = nullptr;
 
   char* buffer_;  // temporary buffer
+  // compressed blocks sent to or uncompressed blocks received from other replicas, allocated on first use
+  std::unique_ptr<char[]> codecBuffer_;
+  // reused to send the chunks of blocks and vblocks to other replicas without copying them, allocated on first use by
+  // the replica and freed when stopping
+  ItemDataMsg* chunkMsg_ = nullptr;
 
   // random generator
   std::random_device randomDevice_;
@@ -257,6 +271,9 @@ class BCStateTran : public IStateTransfer {
   ///////////////////////////////////////////////////////////////////////////
 
   SourceSelector sourceSelector_;
+  FetchWindow fetchWindow_;
+  // The number of chunks asked for in the last FetchBlocksMsg
+  uint16_t numOfChunksInRequestedBatch_ = 0;
 
   static const uint64_t ID_OF_VBLOCK_RES_PAGES = UINT64_MAX;
 
@@ -284,10 +301,21 @@ class BCStateTran : public IStateTransfer {
                         char* outBlock,
                         uint32_t& outBlockSize,
                         bool isVBLock,
-                        bool& outLastInBatch);
+                        bool& outLastInBatch,
+                        BlockCodec& outBlockCodec);
+
+  // Compress the block to send with the codec requested by the destination replica, if that makes it smaller.
+  // Return the codec the block is sent with, and update `block` and `blockSize` to the data to send.
+  BlockCodec encodeBlock(uint8_t requestedCodec, const char*& block, uint32_t& blockSize);
+
+  // Decompress a received block in place. Return false if the block is invalid.
+  bool decodeBlock(uint64_t blockNum, BlockCodec codec, char* block, uint32_t& blockSize);
 
   bool checkBlock(uint64_t blockNum, const STDigest& expectedBlockDigest, char* block, uint32_t blockSize) const;
 
+  // Return chunkMsg_, with a zeroed header and the given data size.
+  ItemDataMsg* getChunkMsg(uint32_t dataSize);
+
   bool checkVirtualBlockOfResPages(const STDigest& expectedDigestOfResPagesDescriptor,
                                    char* vblock,
                                    uint32_t vblockSize) const;
@@ -306,6 +334,24 @@ class BCStateTran : public IStateTransfer {
 
   STDigest checkpointReservedPages(uint64_t checkpointNumber, DataStoreTransaction* txn);
 
+  // Compute the digests of the given pending pages in parallel. outDigests[i] is the digest of pageIds[i].
+  void computeDigestsOfPendingPages(uint64_t checkpointNumber,
+                                    const std::vector<uint32_t>& pageIds,
+                                    std::vector<STDigest>& outDigests,
+                                    DataStoreTransaction* txn);
+
+  // Used instead of hashing the whole reserved pages descriptor if config_.resPagesMerkleTreeDigest
+  STDigest checkpointReservedPagesInTree(uint64_t checkpointNumber,
+                                         const std::vector<uint32_t>& pageIds,
+                                         const std::vector<STDigest>& digests,
+                                         DataStoreTransaction* txn);
+
+  // Merkle tree over the reserved pages descriptor of the last stored checkpoint. Its root is the digest of the
+  // reserved pages descriptor if config_.resPagesMerkleTreeDigest.
+  std::unique_ptr<ResPagesMerkleTree> resPagesTree_;
+  // Used to compute the digests of pending reserved pages in parallel when checkpointing.
+  concord::util::ThreadPool resPagesHashingPool_;
+
   void deleteOldCheckpoints(uint64_t checkpointNumber, DataStoreTransaction* txn);
 
   ///////////////////////////////////////////////////////////////////////////
@@ -328,7 +374,7 @@ class BCStateTran : public IStateTransfer {
   static void computeDigestOfPage(
       const uint32_t pageId, const uint64_t checkpointNumber, const char* page, uint32_t pageSize, STDigest& outDigest);
 
-  static void computeDigestOfPagesDescriptor(const DataStore::ResPagesDescriptor* pagesDesc, STDigest& outDigest);
+  void computeDigestOfPagesDescriptor(const DataStore::ResPagesDescriptor* pagesDesc, STDigest& outDigest) const;
 
   static void computeDigestOfBlock(const uint64_t blockNum,
                                    const char* block,
@@ -407,6 +453,7 @@ class BCStateTran : public IStateTransfer {
     CounterHandle load_reserved_page_from_checkpoint_;
     CounterHandle save_reserved_page_;
     CounterHandle zero_reserved_page_;
+    CounterHandle append_to_reserved_pages_log_;
     CounterHandle start_collecting_state_;
     CounterHandle on_timer_;
 
@@ -0,0 +1,65 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "BlockCodec.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <lz4.h>
+#include <zstd.h>
+
+namespace bftEngine {
+namespace bcst {
+namespace impl {
+
+namespace {
+
+// LZ4 sizes are ints
+int lz4Size(uint32_t size) { return static_cast<int>(std::min<uint32_t>(size, std::numeric_limits<int>::max())); }
+
+}  // namespace
+
+uint32_t compressBlock(BlockCodec codec, const char *in, uint32_t size, char *out, uint32_t outCapacity) {
+  switch (codec) {
+    case BlockCodec::LZ4: {
+      const auto compressed = LZ4_compress_default(in, out, lz4Size(size), lz4Size(outCapacity));
+      return compressed > 0 ? static_cast<uint32_t>(compressed) : 0;
+    }
+    case BlockCodec::ZSTD: {
+      const auto compressed = ZSTD_compress(out, outCapacity, in, size, ZSTD_CLEVEL_DEFAULT);
+      return ZSTD_isError(compressed) ? 0 : static_cast<uint32_t>(compressed);
+    }
+    default:
+      return 0;
+  }
+}
+
+uint32_t decompressBlock(BlockCodec codec, const char *in, uint32_t size, char *out, uint32_t outCapacity) {
+  switch (codec) {
+    case BlockCodec::LZ4: {
+      const auto decompressed = LZ4_decompress_safe(in, out, lz4Size(size), lz4Size(outCapacity));
+      return decompressed > 0 ? static_cast<uint32_t>(decompressed) : 0;
+    }
+    case BlockCodec::ZSTD: {
+      const auto decompressed = ZSTD_decompress(out, outCapacity, in, size);
+      return ZSTD_isError(decompressed) ? 0 : static_cast<uint32_t>(decompressed);
+    }
+    default:
+      return 0;
+  }
+}
+
+}  // namespace impl
+}  // namespace bcst
+}  // namespace bftEngine
@@ -0,0 +1,35 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "SimpleBCStateTransfer.hpp"
+
+namespace bftEngine {
+namespace bcst {
+namespace impl {
+
+// Compress the `size` bytes of `in` into `out` with `codec`.
+// Return the compressed size, or 0 if the compressed block doesn't fit in `outCapacity` bytes. Pass a capacity
+// smaller than `size` in order to only get blocks that compression makes smaller.
+uint32_t compressBlock(BlockCodec codec, const char *in, uint32_t size, char *out, uint32_t outCapacity);
+
+// Decompress the `size` bytes of `in`, as compressed by compressBlock() with `codec`, into `out`.
+// Return the decompressed size, or 0 if the data is invalid or its decompressed size exceeds `outCapacity`.
+uint32_t decompressBlock(BlockCodec codec, const char *in, uint32_t size, char *out, uint32_t outCapacity);
+
+}  // namespace impl
+}  // namespace bcst
+}  // namespace bftEngine
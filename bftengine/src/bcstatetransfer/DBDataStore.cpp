@@ -2,14 +2,61 @@
 #include "DBDataStore.hpp"
 #include "storage/db_interface.h"
 #include "Serializable.h"
+#include "endianness.hpp"
 
 using bftEngine::bcst::BLOCK_DIGEST_SIZE;
 using concord::serialize::Serializable;
+using concordUtils::appendLittleEndian;
+using concordUtils::fromLittleEndianBuffer;
 
 namespace bftEngine {
 namespace bcst {
 namespace impl {
 
+/**
+ * Records are stored in a flat layout with little-endian integers (format version 2). Format version 1 records were
+ * written with Serializable through streams, with the integers in host order, a page size before the reserved page and
+ * no page id in the pending page.
+ */
+namespace {
+constexpr size_t kCheckpointDescSize = 2 * sizeof(uint64_t) + 2 * BLOCK_DIGEST_SIZE;
+constexpr size_t kResPageHeaderSize = sizeof(uint32_t) + sizeof(uint64_t) + BLOCK_DIGEST_SIZE;
+constexpr size_t kPendingPageHeaderSize = sizeof(uint32_t);
+
+std::istringstream streamOf(const Sliver& record) { return std::istringstream(record.toString()); }
+
+DataStore::CheckpointDesc deserializeCheckpointV1(const Sliver& record) {
+  auto is = streamOf(record);
+  DataStore::CheckpointDesc desc;
+  Serializable::deserialize(is, desc.checkpointNum);
+  Serializable::deserialize(is, desc.lastBlock);
+  Serializable::deserialize(is, desc.digestOfLastBlock.getForUpdate(), BLOCK_DIGEST_SIZE);
+  Serializable::deserialize(is, desc.digestOfResPagesDescriptor.getForUpdate(), BLOCK_DIGEST_SIZE);
+  return desc;
+}
+
+void deserializeResPageV1(
+    const Sliver& record, uint32_t& outPageId, uint64_t& outCheckpoint, STDigest& outPageDigest, std::string& outPage) {
+  auto is = streamOf(record);
+  Serializable::deserialize(is, outPageId);
+  Serializable::deserialize(is, outCheckpoint);
+  Serializable::deserialize(is, outPageDigest.getForUpdate(), BLOCK_DIGEST_SIZE);
+  std::uint32_t sizeOfReservedPage;
+  Serializable::deserialize(is, sizeOfReservedPage);
+  outPage.resize(sizeOfReservedPage);
+  Serializable::deserialize(is, outPage.data(), sizeOfReservedPage);
+}
+
+std::string deserializePendingPageV1(const Sliver& record) {
+  auto is = streamOf(record);
+  std::uint32_t pageLen = 0;
+  Serializable::deserialize(is, pageLen);
+  std::string page(pageLen, '\0');
+  Serializable::deserialize(is, page.data(), pageLen);
+  return page;
+}
+}  // namespace
+
 std::ostream& operator<<(std::ostream& os, const DataStore::CheckpointDesc& desc) {
   os << "CheckpointDesc "
      << " checkpointNum: " << desc.checkpointNum << " lastBlock: " << desc.lastBlock
@@ -39,6 +86,7 @@ void DBDataStore::load(bool loadResPages_) {
     LOG_INFO(logger(), "Not initialized");
     return;
   }
+  if (get<uint32_t>(FormatVersion) < kFormatVersion) migrateFromFormatVersion1();
   inmem_->setAsInitialized();
   inmem_->setMyReplicaId(get<uint16_t>(MyReplicaId));
   inmem_->setMaxNumOfStoredCheckpoints(get<uint64_t>(MaxNumOfStoredCheckpoints));
@@ -59,16 +107,14 @@ void DBDataStore::load(bool loadResPages_) {
   }
   Sliver cpbf;
   if (get(CheckpointBeingFetched, cpbf)) {
-    std::istringstream iss(std::string(reinterpret_cast<const char*>(cpbf.data()), cpbf.length()));
-    DataStore::CheckpointDesc cpd;
-    deserializeCheckpoint(iss, cpd);
-    inmem_->setCheckpointBeingFetched(cpd);
+    inmem_->setCheckpointBeingFetched(deserializeCheckpoint(cpbf));
   }
 
   if (loadResPages_) {
     if (inmem_->getLastStoredCheckpoint() > 0) loadResPages();
 
     loadPendingPages();
+    loadResPagesLog();
   }
 
   LOG_DEBUG(logger(), "MyReplicaId: " << inmem_->getMyReplicaId());
@@ -87,6 +133,7 @@ void DBDataStore::load(bool loadResPages_) {
 void DBDataStore::setAsInitialized() {
   LOG_DEBUG(logger(), "");
   putInt(Initialized, true);
+  putInt(FormatVersion, kFormatVersion);
   inmem_->setAsInitialized();
 }
 void DBDataStore::setMyReplicaId(uint16_t id) {
@@ -143,33 +190,38 @@ void DBDataStore::setReplicas(const std::set<std::uint16_t> replicas) {
 /** ******************************************************************************************************************
  *  Checkpoint
  */
-void DBDataStore::serializeCheckpoint(std::ostream& os, const CheckpointDesc& desc) const {
-  Serializable::serialize(os, desc.checkpointNum);
-  Serializable::serialize(os, desc.lastBlock);
-  Serializable::serialize(os, desc.digestOfLastBlock.get(), BLOCK_DIGEST_SIZE);
-  Serializable::serialize(os, desc.digestOfResPagesDescriptor.get(), BLOCK_DIGEST_SIZE);
-}
-void DBDataStore::deserializeCheckpoint(std::istream& is, CheckpointDesc& desc) const {
-  Serializable::deserialize(is, desc.checkpointNum);
-  Serializable::deserialize(is, desc.lastBlock);
-  Serializable::deserialize(is, desc.digestOfLastBlock.getForUpdate(), BLOCK_DIGEST_SIZE);
-  Serializable::deserialize(is, desc.digestOfResPagesDescriptor.getForUpdate(), BLOCK_DIGEST_SIZE);
+/**
+ * CheckpointDesc serialized form: [checkpointNum][lastBlock][digestOfLastBlock][digestOfResPagesDescriptor]
+ */
+std::string DBDataStore::serializeCheckpoint(const CheckpointDesc& desc) const {
+  std::string record;
+  record.reserve(kCheckpointDescSize);
+  appendLittleEndian(record, desc.checkpointNum);
+  appendLittleEndian(record, desc.lastBlock);
+  record.append(desc.digestOfLastBlock.get(), BLOCK_DIGEST_SIZE);
+  record.append(desc.digestOfResPagesDescriptor.get(), BLOCK_DIGEST_SIZE);
+  return record;
+}
+DataStore::CheckpointDesc DBDataStore::deserializeCheckpoint(const Sliver& record) const {
+  ConcordAssertEQ(record.length(), kCheckpointDescSize);
+  const char* p = record.data();
+  CheckpointDesc desc;
+  desc.checkpointNum = fromLittleEndianBuffer<uint64_t>(p);
+  desc.lastBlock = fromLittleEndianBuffer<uint64_t>(p + sizeof(uint64_t));
+  desc.digestOfLastBlock = STDigest(p + 2 * sizeof(uint64_t));
+  desc.digestOfResPagesDescriptor = STDigest(p + 2 * sizeof(uint64_t) + BLOCK_DIGEST_SIZE);
+  return desc;
 }
 void DBDataStore::setCheckpointDesc(uint64_t checkpoint, const CheckpointDesc& desc) {
   LOG_DEBUG(logger(), toString(desc));
-  std::ostringstream oss;
-  serializeCheckpoint(oss, desc);
-  put(chkpDescKey(checkpoint), oss.str());
+  put(chkpDescKey(checkpoint), serializeCheckpoint(desc));
   inmem_->setCheckpointDesc(checkpoint, desc);
 }
 bool DBDataStore::hasCheckpointDesc(uint64_t checkpoint) {
   if (inmem_->hasCheckpointDesc(checkpoint)) return true;
   Sliver val;
   if (!get(chkpDescKey(checkpoint), val)) return false;
-  std::istringstream iss(std::string(reinterpret_cast<const char*>(val.data()), val.length()));
-  DataStore::CheckpointDesc cpd;
-  deserializeCheckpoint(iss, cpd);
-  inmem_->setCheckpointDesc(checkpoint, cpd);
+  inmem_->setCheckpointDesc(checkpoint, deserializeCheckpoint(val));
   return true;
 }
 DataStore::CheckpointDesc DBDataStore::getCheckpointDesc(uint64_t checkpoint) {
@@ -197,9 +249,7 @@ void DBDataStore::deleteDescOfSmallerCheckpoints(uint64_t checkpoint) {
 }
 void DBDataStore::setCheckpointBeingFetched(const CheckpointDesc& desc) {
   LOG_DEBUG(logger(), toString(desc));
-  std::ostringstream oss;
-  serializeCheckpoint(oss, desc);
-  put(CheckpointBeingFetched, oss.str());
+  put(CheckpointBeingFetched, serializeCheckpoint(desc));
   inmem_->setCheckpointBeingFetched(desc);
 }
 void DBDataStore::deleteCheckpointBeingFetched() {
@@ -208,33 +258,34 @@ void DBDataStore::deleteCheckpointBeingFetched() {
   inmem_->deleteCheckpointBeingFetched();
 }
 /**
- * ResPage serialized form: [pageId][checkpoint][PageDigest][PageSize][Page]
+ * ResPage serialized form: [pageId][checkpoint][PageDigest][Page]
  */
-void DBDataStore::serializeResPage(std::ostream& os,
-                                   uint32_t inPageId,
-                                   uint64_t inCheckpoint,
-                                   const STDigest& inPageDigest,
-                                   const char* inPage) const {
-  Serializable::serialize(os, inPageId);
-  Serializable::serialize(os, inCheckpoint);
-  Serializable::serialize(os, inPageDigest.get(), BLOCK_DIGEST_SIZE);
-  Serializable::serialize(os, inmem_->getSizeOfReservedPage());
-  Serializable::serialize(os, inPage, inmem_->getSizeOfReservedPage());
-}
-void DBDataStore::deserializeResPage(
-    std::istream& is, uint32_t& outPageId, uint64_t& outCheckpoint, STDigest& outPageDigest, char*& outPage) const {
-  Serializable::deserialize(is, outPageId);
-  Serializable::deserialize(is, outCheckpoint);
-  char dgst[BLOCK_DIGEST_SIZE];
-  Serializable::deserialize(is, dgst, BLOCK_DIGEST_SIZE);
-  outPageDigest = STDigest(dgst);
-  std::uint32_t sizeOfReseredPage;
-  Serializable::deserialize(is, sizeOfReseredPage);
-  ConcordAssert(sizeOfReseredPage == inmem_->getSizeOfReservedPage());
-  Serializable::deserialize(is, outPage, sizeOfReseredPage);
+std::string DBDataStore::serializeResPage(uint32_t inPageId,
+                                          uint64_t inCheckpoint,
+                                          const STDigest& inPageDigest,
+                                          const char* inPage) const {
+  std::string record;
+  record.reserve(kResPageHeaderSize + inmem_->getSizeOfReservedPage());
+  appendLittleEndian(record, inPageId);
+  appendLittleEndian(record, inCheckpoint);
+  record.append(inPageDigest.get(), BLOCK_DIGEST_SIZE);
+  record.append(inPage, inmem_->getSizeOfReservedPage());
+  return record;
+}
+void DBDataStore::deserializeResPage(const Sliver& record,
+                                     uint32_t& outPageId,
+                                     uint64_t& outCheckpoint,
+                                     STDigest& outPageDigest,
+                                     const char*& outPage) const {
+  ConcordAssertEQ(record.length(), kResPageHeaderSize + inmem_->getSizeOfReservedPage());
+  const char* p = record.data();
+  outPageId = fromLittleEndianBuffer<uint32_t>(p);
+  outCheckpoint = fromLittleEndianBuffer<uint64_t>(p + sizeof(uint32_t));
+  outPageDigest = STDigest(p + sizeof(uint32_t) + sizeof(uint64_t));
+  outPage = p + kResPageHeaderSize;
 }
 /**
- * Reserved pages are loaded on startup.
+ * Reserved pages are loaded on startup, in a single pass over their keys.
  *
  * [pageId, checkpoint] => <serialized page>
  */
@@ -243,25 +294,20 @@ void DBDataStore::loadResPages() {
   for (auto keyValue = it->seekAtLeast(dynamicResPageKey(0, 0));  // start of dynamic keys space
        !it->isEnd() && keyValue.first.string_view().find(keymanip_->getReservedPageKeyPrefix().string_view()) == 0;
        keyValue = it->next()) {
-    std::istringstream iss(
-        std::string(reinterpret_cast<const char*>(keyValue.second.data()), keyValue.second.length()));
     uint32_t pageid;
     uint64_t checkpoint;
     STDigest digest;
-    char* page = new char[inmem_->getSizeOfReservedPage()];
-    deserializeResPage(iss, pageid, checkpoint, digest, page);
-    inmem_->setResPage(pageid, checkpoint, digest, page);
-    delete[] page;  // is copied
-    LOG_DEBUG(logger(), KVLOG(pageid, checkpoint, digest.toString()));
+    const char* page = nullptr;
+    deserializeResPage(keyValue.second, pageid, checkpoint, digest, page);
+    inmem_->setResPage(pageid, checkpoint, digest, page);  // is copied
+    LOG_TRACE(logger(), KVLOG(pageid, checkpoint, digest.toString()));
   }
   LOG_DEBUG(logger(), inmem_->getPagesForLog());
 }
 void DBDataStore::setResPageTxn(
     uint32_t inPageId, uint64_t inCheckpoint, const STDigest& inPageDigest, const char* inPage, ITransaction* txn) {
-  std::ostringstream oss;
-  serializeResPage(oss, inPageId, inCheckpoint, inPageDigest, inPage);
   Sliver dynamic_key = dynamicResPageKey(inPageId, inCheckpoint);
-  txn->put(dynamic_key, oss.str());
+  txn->put(dynamic_key, serializeResPage(inPageId, inCheckpoint, inPageDigest, inPage));
   LOG_DEBUG(logger(), KVLOG(inPageId, inCheckpoint, inPageDigest.toString(), txn->getId(), dynamic_key));
 }
 
@@ -281,33 +327,45 @@ void DBDataStore::setResPage(uint32_t inPageId,
 /** ******************************************************************************************************************
  *  Pending Reserved Pages
  */
-void DBDataStore::deserializePendingPage(std::istream& is, char*& page, uint32_t& pageLen) const {
-  Serializable::deserialize(is, pageLen);
-  page = new char[pageLen];
-  Serializable::deserialize(is, page, pageLen);
+/**
+ * Pending page serialized form: [pageId][Page], the page length is the rest of the record
+ */
+std::string DBDataStore::serializePendingPage(uint32_t inPageId, const char* inPage, uint32_t inPageLen) const {
+  std::string record;
+  record.reserve(kPendingPageHeaderSize + inPageLen);
+  appendLittleEndian(record, inPageId);
+  record.append(inPage, inPageLen);
+  return record;
+}
+void DBDataStore::deserializePendingPage(const Sliver& record,
+                                         uint32_t& outPageId,
+                                         const char*& outPage,
+                                         uint32_t& outPageLen) const {
+  ConcordAssertGE(record.length(), kPendingPageHeaderSize);
+  outPageId = fromLittleEndianBuffer<uint32_t>(record.data());
+  outPage = record.data() + kPendingPageHeaderSize;
+  outPageLen = static_cast<uint32_t>(record.length() - kPendingPageHeaderSize);
 }
 
 void DBDataStore::loadPendingPages() {
-  LOG_DEBUG(logger(), "");
-  for (uint32_t pageid = 0; pageid < inmem_->getNumberOfReservedPages(); ++pageid) {
-    Sliver serializedPendingPage;
-    if (!get(pendingPageKey(pageid), serializedPendingPage)) continue;
-    std::istringstream iss(
-        std::string(reinterpret_cast<const char*>(serializedPendingPage.data()), serializedPendingPage.length()));
-    std::uint32_t pageLen = 0;
-    char* page = nullptr;
-    deserializePendingPage(iss, page, pageLen);
+  auto it(dbc_->getIteratorGuard());
+  const Sliver prefix = keymanip_->getSTPendingPageKeyPrefix();
+  for (auto keyValue = it->seekAtLeast(pendingPageKey(0));
+       !it->isEnd() && keyValue.first.string_view().find(prefix.string_view()) == 0;
+       keyValue = it->next()) {
+    uint32_t pageid;
+    const char* page = nullptr;
+    uint32_t pageLen = 0;
+    deserializePendingPage(keyValue.second, pageid, page, pageLen);
+    if (pageid >= inmem_->getNumberOfReservedPages()) continue;
     inmem_->setPendingResPage(pageid, page, pageLen);
-    delete[] page;
   }
+  LOG_DEBUG(logger(), "pending pages: " << inmem_->numOfAllPendingResPage());
 }
 
 void DBDataStore::setPendingResPage(uint32_t inPageId, const char* inPage, uint32_t inPageLen) {
   LOG_DEBUG(logger(), "page: " << inPageId);
-  std::ostringstream oss;
-  Serializable::serialize(oss, inPageLen);
-  Serializable::serialize(oss, inPage, inPageLen);
-  put(pendingPageKey(inPageId), oss.str());
+  put(pendingPageKey(inPageId), serializePendingPage(inPageId, inPage, inPageLen));
   inmem_->setPendingResPage(inPageId, inPage, inPageLen);
 }
 
@@ -352,6 +410,40 @@ void DBDataStore::deleteAllPendingPages() {
   inmem_->deleteAllPendingPages();
 }
 
+/** ******************************************************************************************************************
+ *  Reserved Pages Log
+ *
+ *  Records are appended one key at a time and loaded in order until the first missing key. The whole log is deleted in
+ *  a single transaction, hence there are no holes.
+ */
+void DBDataStore::loadResPagesLog() {
+  Sliver record;
+  for (size_t i = 0; get(resPagesLogKey(i), record); ++i) {
+    inmem_->appendResPagesLogRecord(record.toString());
+  }
+  LOG_DEBUG(logger(), "records: " << inmem_->getResPagesLogSize());
+}
+
+void DBDataStore::appendResPagesLogRecord(const std::string& record) {
+  put(resPagesLogKey(inmem_->getResPagesLogSize()), Sliver::copy(record.data(), record.size()));
+  inmem_->appendResPagesLogRecord(record);
+}
+
+void DBDataStore::clearResPagesLogTxn(ITransaction* txn) {
+  LOG_DEBUG(logger(), "records: " << inmem_->getResPagesLogSize() << " txn: " << txn->getId());
+  for (size_t i = 0; i < inmem_->getResPagesLogSize(); ++i) txn->del(resPagesLogKey(i));
+}
+
+void DBDataStore::clearResPagesLog() {
+  if (txn_) {
+    clearResPagesLogTxn(txn_);
+  } else {
+    ITransaction::Guard g(dbc_->beginTransaction());
+    clearResPagesLogTxn(g.txn());
+  }
+  inmem_->clearResPagesLog();
+}
+
 void DBDataStore::deleteCoveredResPageInSmallerCheckpointsTxn(uint64_t minChkp, ITransaction* txn) {
   LOG_DEBUG(logger(), " min chkp: " << minChkp << " txn: " << txn->getId());
   auto pages = inmem_->getPagesMap();
@@ -401,7 +493,60 @@ void DBDataStore::clearDataStoreData() {
   del(LastRequiredBlock);
   del(Replicas);
   del(CheckpointBeingFetched);
+  del(FormatVersion);
   deleteAllPendingPages();
+  // the log's keys are known only once it's loaded
+  loadResPagesLog();
+  clearResPagesLog();
+}
+
+void DBDataStore::migrateFromFormatVersion1() {
+  LOG_INFO(logger(), "Migrating from format version 1 to " << kFormatVersion);
+  ITransaction::Guard g(dbc_->beginTransaction());
+  size_t numOfRecords = 0;
+
+  // descriptors are kept for the stored checkpoints and the one being fetched
+  const auto lastStoredCheckpoint = get<uint64_t>(LastStoredCheckpoint);
+  for (auto checkpoint = get<uint64_t>(FirstStoredCheckpoint); checkpoint <= lastStoredCheckpoint; ++checkpoint) {
+    Sliver record;
+    if (!get(chkpDescKey(checkpoint), record)) continue;
+    g.txn()->put(chkpDescKey(checkpoint), serializeCheckpoint(deserializeCheckpointV1(record)));
+    ++numOfRecords;
+  }
+  Sliver checkpointBeingFetched;
+  if (get(CheckpointBeingFetched, checkpointBeingFetched)) {
+    g.txn()->put(genKey(CheckpointBeingFetched), serializeCheckpoint(deserializeCheckpointV1(checkpointBeingFetched)));
+    ++numOfRecords;
+  }
+
+  {
+    auto it(dbc_->getIteratorGuard());
+    for (auto keyValue = it->seekAtLeast(dynamicResPageKey(0, 0));
+         !it->isEnd() && keyValue.first.string_view().find(keymanip_->getReservedPageKeyPrefix().string_view()) == 0;
+         keyValue = it->next()) {
+      uint32_t pageid;
+      uint64_t checkpoint;
+      STDigest digest;
+      std::string page;
+      deserializeResPageV1(keyValue.second, pageid, checkpoint, digest, page);
+      ConcordAssertEQ(page.size(), inmem_->getSizeOfReservedPage());
+      g.txn()->put(keyValue.first, serializeResPage(pageid, checkpoint, digest, page.data()));
+      ++numOfRecords;
+    }
+  }
+
+  // version 1 pending pages can't be told apart by their keys, only looked up by page id
+  const auto numberOfReservedPages = get<uint32_t>(NumberOfReservedPages);
+  for (uint32_t pageid = 0; pageid < numberOfReservedPages; ++pageid) {
+    Sliver record;
+    if (!get(pendingPageKey(pageid), record)) continue;
+    const auto page = deserializePendingPageV1(record);
+    g.txn()->put(pendingPageKey(pageid), serializePendingPage(pageid, page.data(), page.size()));
+    ++numOfRecords;
+  }
+
+  g.txn()->put(genKey(FormatVersion), std::to_string(kFormatVersion));
+  LOG_INFO(logger(), "Migrated " << numOfRecords << " records to format version " << kFormatVersion);
 }
 
 /** ******************************************************************************************************************/
@@ -78,6 +78,8 @@ class DBDataStore : public DataStore {
   void setPendingResPage(uint32_t, const char*, uint32_t) override;
   void setCheckpointDesc(uint64_t, const CheckpointDesc&) override;
   void associatePendingResPageWithCheckpoint(uint32_t, uint64_t, const STDigest&) override;
+  void appendResPagesLogRecord(const std::string&) override;
+  void clearResPagesLog() override;
 
   void free(ResPagesDescriptor* desc) override { inmem_->free(desc); }
   bool initialized() override { return inmem_->initialized(); }
@@ -98,6 +100,7 @@ class DBDataStore : public DataStore {
   CheckpointDesc getCheckpointBeingFetched() override { return inmem_->getCheckpointBeingFetched(); }
   set<uint16_t> getReplicas() override { return inmem_->getReplicas(); }
   set<uint32_t> getNumbersOfPendingResPages() override { return inmem_->getNumbersOfPendingResPages(); }
+  std::vector<std::string> getResPagesLog() override { return inmem_->getResPagesLog(); }
 
   void getPendingResPage(uint32_t inPageId, char* outPage, uint32_t pageLen) override {
     inmem_->getPendingResPage(inPageId, outPage, pageLen);
@@ -122,6 +125,8 @@ class DBDataStore : public DataStore {
  protected:
   DBDataStore(const DBDataStore&) = default;
 
+  static constexpr uint32_t kFormatVersion = 2;
+
   enum GeneralIds : ObjectId {
     Initialized = 1,
     MyReplicaId,
@@ -136,19 +141,31 @@ class DBDataStore : public DataStore {
     Replicas,
     CheckpointBeingFetched,
     EraseDataOnStartup,
+    FormatVersion,
+    // record i of the reserved pages log is stored as object ResPagesLog + i
+    ResPagesLog = 0x10000,
   };
 
   void load(bool loadResPages);
   void loadResPages();
   void loadPendingPages();
+  void loadResPagesLog();
+
+  /**
+   * Records are stored in a flat little-endian layout and parsed in place, see DBDataStore.cpp. Deserialized pages
+   * point into the record.
+   */
+  std::string serializeCheckpoint(const CheckpointDesc& desc) const;
+  CheckpointDesc deserializeCheckpoint(const Sliver& record) const;
 
-  void serializeCheckpoint(std::ostream& os, const CheckpointDesc& desc) const;
-  void deserializeCheckpoint(std::istream& is, CheckpointDesc& desc) const;
+  std::string serializeResPage(uint32_t, uint64_t, const STDigest&, const char*) const;
+  void deserializeResPage(const Sliver& record, uint32_t&, uint64_t&, STDigest&, const char*&) const;
 
-  void serializeResPage(std::ostream&, uint32_t, uint64_t, const STDigest&, const char*) const;
-  void deserializeResPage(std::istream&, uint32_t&, uint64_t&, STDigest&, char*&) const;
+  std::string serializePendingPage(uint32_t, const char*, uint32_t) const;
+  void deserializePendingPage(const Sliver& record, uint32_t&, const char*&, uint32_t&) const;
 
-  void deserializePendingPage(std::istream&, char*&, uint32_t&) const;
+  // Rewrites the records of format version 1 (written with Serializable) in the current format
+  void migrateFromFormatVersion1();
 
   /**
    * add to existing transaction
@@ -158,6 +175,7 @@ class DBDataStore : public DataStore {
   void deleteAllPendingPagesTxn(ITransaction*);
   void deleteCoveredResPageInSmallerCheckpointsTxn(uint64_t, ITransaction*);
   void deleteDescOfSmallerCheckpointsTxn(uint64_t, ITransaction*);
+  void clearResPagesLogTxn(ITransaction*);
   /** *****************************************************************************************************************
    * db layer access
    */
@@ -227,6 +245,7 @@ class DBDataStore : public DataStore {
   Sliver pendingPageKey(uint32_t pageid) const { return keymanip_->generateSTPendingPageKey(pageid); }
   Sliver chkpDescKey(uint64_t chkpt) const { return keymanip_->generateSTCheckpointDescriptorKey(chkpt); }
   Sliver genKey(const ObjectId& objId) const { return keymanip_->generateStateTransferKey(objId); }
+  Sliver resPagesLogKey(size_t index) const { return genKey(ResPagesLog + static_cast<ObjectId>(index)); }
   /** ****************************************************************************************************************/
   logging::Logger& logger() {
     static logging::Logger logger_ = logging::getLogger("concord.bft.st.dbdatastore");
@@ -16,6 +16,7 @@
 #include <cassert>
 #include <string>
 #include <set>
+#include <vector>
 #include "assertUtils.hpp"
 #include "storage/db_interface.h"
 #include "STDigest.hpp"
@@ -117,6 +118,11 @@ class DataStore : public std::enable_shared_from_this<DataStore> {
 
   virtual void deleteCoveredResPageInSmallerCheckpoints(uint64_t inCheckpoint) = 0;
 
+  // records of the reserved pages log, in append order
+  virtual void appendResPagesLogRecord(const std::string& record) = 0;
+  virtual std::vector<std::string> getResPagesLog() = 0;
+  virtual void clearResPagesLog() = 0;
+
   struct SingleResPageDesc {
     uint32_t pageId;
     uint64_t relevantCheckpoint;
@@ -209,6 +215,9 @@ class DataStoreTransaction : public DataStore, public ITransaction {
   void deleteCoveredResPageInSmallerCheckpoints(uint64_t inCheckpoint) override {
     return ds_->deleteCoveredResPageInSmallerCheckpoints(inCheckpoint);
   }
+  void appendResPagesLogRecord(const std::string& record) override { ds_->appendResPagesLogRecord(record); }
+  std::vector<std::string> getResPagesLog() override { return ds_->getResPagesLog(); }
+  void clearResPagesLog() override { ds_->clearResPagesLog(); }
   void associatePendingResPageWithCheckpoint(uint32_t inPageId,
                                              uint64_t inCheckpoint,
                                              const STDigest& inPageDigest) override {
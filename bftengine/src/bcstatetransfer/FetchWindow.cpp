@@ -0,0 +1,90 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "FetchWindow.hpp"
+
+#include <algorithm>
+
+namespace bftEngine {
+namespace bcst {
+namespace impl {
+
+FetchWindow::FetchWindow(uint16_t initialChunks, uint16_t maxChunks, uint32_t maxBatchTimeMilli, uint64_t maxBatchBytes)
+    : initialChunks_{std::max<uint16_t>(initialChunks, 1)},
+      maxChunks_{std::max(maxChunks, initialChunks_)},
+      maxBatchTimeMilli_{maxBatchTimeMilli},
+      maxBatchBytes_{maxBatchBytes},
+      chunks_{initialChunks_} {}
+
+void FetchWindow::onBatchRequested(uint64_t currTimeMilli) {
+  batchInFlight_ = true;
+  requestTimeMilli_ = currTimeMilli;
+  firstChunkTimeMilli_ = 0;
+  receivedChunks_ = 0;
+  receivedBytes_ = 0;
+}
+
+void FetchWindow::onChunkReceived(uint32_t chunkSize, uint64_t currTimeMilli) {
+  if (!batchInFlight_) return;
+  if (receivedChunks_ == 0) firstChunkTimeMilli_ = currTimeMilli;
+  receivedChunks_++;
+  receivedBytes_ += chunkSize;
+}
+
+void FetchWindow::onBatchCompleted(uint64_t currTimeMilli) {
+  if (!batchInFlight_ || receivedChunks_ == 0) return;
+  batchInFlight_ = false;
+  if (maxChunks_ == initialChunks_) return;
+
+  uint64_t target = slowStart_ ? 2 * uint64_t{chunks_} : chunks_ + std::max(chunks_ / 8, 1);
+  const double avgChunkSize = static_cast<double>(receivedBytes_) / receivedChunks_;
+  auto capChunks = static_cast<uint64_t>(maxBatchBytes_ / avgChunkSize);
+
+  const uint64_t transferTimeMilli = currTimeMilli - firstChunkTimeMilli_;
+  if (transferTimeMilli > 0) {
+    const double bytesPerMilli = static_cast<double>(receivedBytes_) / transferTimeMilli;
+    const uint64_t rttMilli = std::max<uint64_t>(firstChunkTimeMilli_ - requestTimeMilli_, 1);
+    const auto bdpChunks = static_cast<uint64_t>(kBdpMultiple * bytesPerMilli * rttMilli / avgChunkSize);
+    target = std::max(target, bdpChunks);
+
+    // a slow source cannot send big batches in time
+    const auto timeCapChunks = static_cast<uint64_t>(bytesPerMilli * maxBatchTimeMilli_ / avgChunkSize);
+    capChunks = std::min(capChunks, timeCapChunks);
+  }
+  if (target > capChunks) {
+    target = capChunks;
+    slowStart_ = false;
+  }
+  setChunks(target);
+}
+
+void FetchWindow::onBatchTimeout() {
+  batchInFlight_ = false;
+  if (maxChunks_ == initialChunks_) return;
+  slowStart_ = false;
+  setChunks(chunks_ / 2);
+}
+
+void FetchWindow::reset() {
+  batchInFlight_ = false;
+  slowStart_ = true;
+  chunks_ = initialChunks_;
+}
+
+void FetchWindow::setChunks(uint64_t chunks) {
+  chunks_ = static_cast<uint16_t>(std::clamp<uint64_t>(chunks, 1, maxChunks_));
+}
+
+}  // namespace impl
+}  // namespace bcst
+}  // namespace bftEngine
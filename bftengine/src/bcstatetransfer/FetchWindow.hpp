@@ -0,0 +1,75 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+#pragma once
+
+#include <stdint.h>
+
+namespace bftEngine {
+namespace bcst {
+namespace impl {
+
+// The number of chunks a destination replica asks for in a FetchBlocksMsg. Only one batch is in flight at a time, so
+// small batches leave high-latency links idle while big ones flood slow sources.
+//
+// Similarly to a TCP congestion window, the batch size starts at `initialChunks` and doubles after each completed
+// batch until a batch times out, after which it grows by 1/8 per batch and halves on each timeout. Each completed
+// batch also measures the round trip time and the throughput of the source:
+//  * The batch size is raised to kBdpMultiple times the bandwidth-delay product, so that the round trip between two
+//    batches takes a small part of the time.
+//  * The batch size is capped by what the source sends in `maxBatchTimeMilli` and by `maxBatchBytes`.
+// The batch size is fixed if `maxChunks` is not bigger than `initialChunks`.
+class FetchWindow {
+ public:
+  static constexpr uint64_t kBdpMultiple = 4;
+
+  FetchWindow(uint16_t initialChunks, uint16_t maxChunks, uint32_t maxBatchTimeMilli, uint64_t maxBatchBytes);
+
+  uint16_t chunks() const { return chunks_; }
+
+  // A batch of chunks() chunks was requested.
+  void onBatchRequested(uint64_t currTimeMilli);
+
+  // A chunk of the requested batch was received.
+  void onChunkReceived(uint32_t chunkSize, uint64_t currTimeMilli);
+
+  // The last chunk of the requested batch was received.
+  void onBatchCompleted(uint64_t currTimeMilli);
+
+  // The requested batch is being requested again as the source didn't send it in time.
+  void onBatchTimeout();
+
+  // Start over, e.g. with a new source.
+  void reset();
+
+ private:
+  void setChunks(uint64_t chunks);
+
+  const uint16_t initialChunks_;
+  const uint16_t maxChunks_;
+  const uint32_t maxBatchTimeMilli_;
+  const uint64_t maxBatchBytes_;
+
+  uint16_t chunks_;
+  bool slowStart_ = true;
+
+  // The requested batch
+  bool batchInFlight_ = false;
+  uint64_t requestTimeMilli_ = 0;
+  uint64_t firstChunkTimeMilli_ = 0;
+  uint64_t receivedChunks_ = 0;
+  uint64_t receivedBytes_ = 0;
+};
+
+}  // namespace impl
+}  // namespace bcst
+}  // namespace bftEngine
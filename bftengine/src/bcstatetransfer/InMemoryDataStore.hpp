@@ -123,6 +123,10 @@ class InMemoryDataStore : public DataStore {
 
   void deleteCoveredResPageInSmallerCheckpoints(uint64_t inCheckpoint) override;
 
+  void appendResPagesLogRecord(const std::string& record) override { resPagesLog.push_back(record); }
+  std::vector<std::string> getResPagesLog() override { return resPagesLog; }
+  void clearResPagesLog() override { resPagesLog.clear(); }
+
   ResPagesDescriptor* getResPagesDescriptor(uint64_t inCheckpoint) override;
   void free(ResPagesDescriptor*) override;
 
@@ -192,6 +196,8 @@ class InMemoryDataStore : public DataStore {
 
   map<ResPageKey, ResPageVal> pages;
 
+  std::vector<std::string> resPagesLog;
+
   std::string getPagesForLog() {
     std::ostringstream oss;
     oss << "reserved pages: ";
@@ -204,6 +210,7 @@ class InMemoryDataStore : public DataStore {
   const map<uint64_t, CheckpointDesc>& getDescMap() const { return descMap; }
   const map<ResPageKey, ResPageVal>& getPagesMap() const { return pages; }
   const map<uint32_t, char*>& getPendingPagesMap() const { return pendingPages; }
+  size_t getResPagesLogSize() const { return resPagesLog.size(); }
 
   void setInitialized(bool init) { wasInit_ = init; }
   logging::Logger& logger() {
@@ -34,7 +34,10 @@ class MsgType {
     FetchBlocks,
     FetchResPages,
     RejectFetching,
-    ItemData
+    ItemData,
+    // An ItemDataMsg whose block is compressed with the BlockCodec asked for in the FetchBlocksMsg. Sent only to
+    // replicas that asked for a codec, so replicas that don't know it never receive it.
+    CompressedItemData
   };
 };
 
@@ -107,6 +110,14 @@ struct FetchBlocksMsg : public BCStateTranBaseMsg {
   uint64_t firstRequiredBlock;
   uint64_t lastRequiredBlock;
   uint16_t lastKnownChunkInLastRequiredBlock;
+  // The fields below are missing from messages sent by older replicas, and are then read as zero.
+  // A BlockCodec the source may compress the blocks with
+  uint8_t blockCodec;
+  // The number of chunks to send, 0 for the source's maxNumberOfChunksInBatch
+  uint16_t maxNumberOfChunksInBatch;
+
+  // The size of a FetchBlocksMsg sent by older replicas
+  static constexpr uint32_t kLegacySize = sizeof(BCStateTranBaseMsg) + 3 * sizeof(uint64_t) + sizeof(uint16_t);
 };
 
 struct FetchResPagesMsg : public BCStateTranBaseMsg {
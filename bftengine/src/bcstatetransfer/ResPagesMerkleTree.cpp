@@ -0,0 +1,107 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "ResPagesMerkleTree.hpp"
+
+#include <algorithm>
+
+#include "assertUtils.hpp"
+
+namespace bftEngine {
+namespace bcst {
+namespace impl {
+
+namespace {
+
+// Domain separation between leaves and inner nodes.
+constexpr uint8_t kLeafPrefix = 0;
+constexpr uint8_t kInnerNodePrefix = 1;
+
+uint32_t calcNumOfLeaves(uint32_t numOfPages) {
+  ConcordAssertGT(numOfPages, 0);
+  uint32_t n = 1;
+  while (n < numOfPages) n <<= 1;
+  return n;
+}
+
+}  // namespace
+
+ResPagesMerkleTree::ResPagesMerkleTree(uint32_t numOfPages)
+    : numOfPages_{numOfPages}, numOfLeaves_{calcNumOfLeaves(numOfPages)}, nodes_(2 * numOfLeaves_) {}
+
+void ResPagesMerkleTree::build(const DataStore::ResPagesDescriptor* desc) {
+  ConcordAssertEQ(desc->numOfPages, numOfPages_);
+  dirtyLeaves_.clear();
+  for (uint32_t i = 0; i < numOfPages_; ++i) computeLeaf(desc->d[i], nodes_[numOfLeaves_ + i]);
+  for (uint32_t i = numOfPages_; i < numOfLeaves_; ++i) nodes_[numOfLeaves_ + i].makeZero();
+  for (uint32_t i = numOfLeaves_ - 1; i > 0; --i) computeParent(nodes_[2 * i], nodes_[2 * i + 1], nodes_[i]);
+}
+
+void ResPagesMerkleTree::update(const DataStore::SingleResPageDesc& desc) {
+  ConcordAssertLT(desc.pageId, numOfPages_);
+  const uint32_t index = numOfLeaves_ + desc.pageId;
+  computeLeaf(desc, nodes_[index]);
+  dirtyLeaves_.push_back(index);
+}
+
+const STDigest& ResPagesMerkleTree::root() {
+  if (dirtyLeaves_.empty()) return nodes_[1];
+
+  std::sort(dirtyLeaves_.begin(), dirtyLeaves_.end());
+  dirtyLeaves_.erase(std::unique(dirtyLeaves_.begin(), dirtyLeaves_.end()), dirtyLeaves_.end());
+
+  // Walk up level by level. The indexes in each level are sorted, hence the parents are sorted too and siblings share
+  // a single parent entry.
+  std::vector<uint32_t> level = std::move(dirtyLeaves_);
+  std::vector<uint32_t> parents;
+  parents.reserve(level.size());
+  while (level.front() > 1) {
+    parents.clear();
+    for (auto i : level) {
+      const uint32_t p = i / 2;
+      if (!parents.empty() && parents.back() == p) continue;
+      computeParent(nodes_[2 * p], nodes_[2 * p + 1], nodes_[p]);
+      parents.push_back(p);
+    }
+    level.swap(parents);
+  }
+  dirtyLeaves_.clear();
+  return nodes_[1];
+}
+
+STDigest ResPagesMerkleTree::computeRoot(const DataStore::ResPagesDescriptor* desc) {
+  ResPagesMerkleTree tree{desc->numOfPages};
+  tree.build(desc);
+  return tree.root();
+}
+
+void ResPagesMerkleTree::computeLeaf(const DataStore::SingleResPageDesc& desc, STDigest& outDigest) {
+  DigestContext c;
+  c.update(reinterpret_cast<const char*>(&kLeafPrefix), sizeof(kLeafPrefix));
+  c.update(reinterpret_cast<const char*>(&desc.pageId), sizeof(desc.pageId));
+  c.update(reinterpret_cast<const char*>(&desc.relevantCheckpoint), sizeof(desc.relevantCheckpoint));
+  c.update(desc.pageDigest.get(), BLOCK_DIGEST_SIZE);
+  c.writeDigest(outDigest.getForUpdate());
+}
+
+void ResPagesMerkleTree::computeParent(const STDigest& left, const STDigest& right, STDigest& outDigest) {
+  DigestContext c;
+  c.update(reinterpret_cast<const char*>(&kInnerNodePrefix), sizeof(kInnerNodePrefix));
+  c.update(left.get(), BLOCK_DIGEST_SIZE);
+  c.update(right.get(), BLOCK_DIGEST_SIZE);
+  c.writeDigest(outDigest.getForUpdate());
+}
+
+}  // namespace impl
+}  // namespace bcst
+}  // namespace bftEngine
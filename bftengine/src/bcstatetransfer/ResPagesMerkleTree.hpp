@@ -0,0 +1,77 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "DataStore.hpp"
+#include "STDigest.hpp"
+
+namespace bftEngine {
+namespace bcst {
+namespace impl {
+
+// A binary Merkle tree over the entries of a reserved pages descriptor.
+//
+// Leaf i is the digest of the descriptor entry of page i. Leaves are padded with zero digests up to the next power of
+// two. The root of the tree is used as the digest of the reserved pages descriptor. Updating a page only marks its leaf
+// dirty - root() re-hashes the dirty leaves and their paths to the root, i.e. O(d * log(n)) digests for d updated pages
+// instead of hashing the whole descriptor.
+//
+// The tree is not thread safe.
+class ResPagesMerkleTree {
+ public:
+  explicit ResPagesMerkleTree(uint32_t numOfPages);
+
+  // Recompute the whole tree from the given descriptor.
+  void build(const DataStore::ResPagesDescriptor* desc);
+
+  // Replace the leaf of desc.pageId. Inner nodes are recomputed lazily by root().
+  void update(const DataStore::SingleResPageDesc& desc);
+
+  // Returns the root digest, after re-hashing all paths from dirty leaves.
+  const STDigest& root();
+
+  uint32_t numOfPages() const { return numOfPages_; }
+
+  // The checkpoint the tree currently reflects. Empty if the tree may not reflect any stored checkpoint (e.g. while it
+  // is being updated).
+  std::optional<uint64_t> checkpoint() const { return checkpoint_; }
+  void setCheckpoint(uint64_t checkpoint) { checkpoint_ = checkpoint; }
+  void resetCheckpoint() { checkpoint_.reset(); }
+
+  // Computes the root of a tree for the given descriptor from scratch.
+  static STDigest computeRoot(const DataStore::ResPagesDescriptor* desc);
+
+ private:
+  static void computeLeaf(const DataStore::SingleResPageDesc& desc, STDigest& outDigest);
+  static void computeParent(const STDigest& left, const STDigest& right, STDigest& outDigest);
+
+ private:
+  const uint32_t numOfPages_;
+  // Number of leaves - a power of two >= numOfPages_.
+  const uint32_t numOfLeaves_;
+  // Heap layout - nodes_[1] is the root, the children of node i are 2i and 2i+1 and leaf i is nodes_[numOfLeaves_ + i].
+  // nodes_[0] is unused.
+  std::vector<STDigest> nodes_;
+  // Indexes (in nodes_) of leaves updated since the last call to root().
+  std::vector<uint32_t> dirtyLeaves_;
+  std::optional<uint64_t> checkpoint_;
+};
+
+}  // namespace impl
+}  // namespace bcst
+}  // namespace bftEngine
@@ -0,0 +1,43 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#include "ClientRequestsStore.hpp"
+#include "messages/PrePrepareMsg.hpp"
+
+namespace bftEngine::impl {
+
+bool ClientRequestsStore::add(const char* request, uint32_t requestSize) {
+  if (maxNumOfRequests_ == 0) return false;
+  const Digest digest = PrePrepareMsg::digestOfRequest(request, requestSize);
+  if (requests_.count(digest)) return false;
+
+  if (requests_.size() == maxNumOfRequests_) {
+    requests_.erase(order_.front());
+    order_.pop_front();
+  }
+  order_.push_back(digest);
+  requests_.emplace(digest, Entry{std::string(request, requestSize), std::prev(order_.end())});
+  return true;
+}
+
+const char* ClientRequestsStore::get(const Digest& digest) const {
+  auto it = requests_.find(digest);
+  return (it != requests_.end()) ? it->second.body.data() : nullptr;
+}
+
+void ClientRequestsStore::remove(const Digest& digest) {
+  auto it = requests_.find(digest);
+  if (it == requests_.end()) return;
+  order_.erase(it->second.order);
+  requests_.erase(it);
+}
+
+}  // namespace bftEngine::impl
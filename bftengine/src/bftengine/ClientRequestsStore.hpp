@@ -0,0 +1,59 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#pragma once
+
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "Digest.hpp"
+
+namespace bftEngine::impl {
+
+// Bodies of client requests that were delivered to this replica outside of PrePrepare messages, indexed by their
+// digests (see PrePrepareMsg::digestOfRequest). Used to resolve digests-only PrePrepare messages.
+// Bounded: when full, the oldest body is evicted.
+class ClientRequestsStore {
+ public:
+  explicit ClientRequestsStore(size_t maxNumOfRequests) : maxNumOfRequests_{maxNumOfRequests} {}
+
+  // Returns false if the request is already stored.
+  bool add(const char* request, uint32_t requestSize);
+
+  // Returns nullptr if the request isn't stored. Valid until the next call to add() or remove().
+  const char* get(const Digest& digest) const;
+
+  void remove(const Digest& digest);
+
+  size_t size() const { return requests_.size(); }
+
+ private:
+  // Digests may be read from packed message buffers, so the hash doesn't assume alignment
+  struct DigestHash {
+    size_t operator()(const Digest& d) const {
+      size_t h;
+      std::memcpy(&h, d.content(), sizeof(h));
+      return h;
+    }
+  };
+  struct Entry {
+    std::string body;
+    std::list<Digest>::iterator order;
+  };
+
+  const size_t maxNumOfRequests_;
+  std::unordered_map<Digest, Entry, DigestHash> requests_;
+  std::list<Digest> order_;  // oldest first
+};
+
+}  // namespace bftEngine::impl
@@ -16,6 +16,9 @@
 #include "Logger.hpp"
 #include "ReplicaConfig.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace bftEngine::impl {
 // Initialize:
 // * map of client id to indices.
@@ -79,16 +82,80 @@ ClientsManager::~ClientsManager() { std::free(scratchPage_); }
 
 uint32_t ClientsManager::numberOfRequiredReservedPages() const { return requiredNumberOfPages_; }
 
+void ClientsManager::writeReplyPages(uint16_t clientIdx, const char* msg, uint32_t msgSize, bool unsaved) {
+  const uint32_t firstPageId = clientIdx * reservedPagesPerClient_;
+  uint32_t numOfPages = msgSize / sizeOfReservedPage_;
+  uint32_t sizeLastPage = sizeOfReservedPage_;
+  if (msgSize % sizeOfReservedPage_ != 0) {
+    numOfPages++;
+    sizeLastPage = msgSize % sizeOfReservedPage_;
+  }
+  LOG_DEBUG(CL_MNGR, KVLOG(clientIdx, firstPageId, numOfPages, sizeLastPage, unsaved));
+
+  auto& unsavedPages = indexToClientInfo_.at(clientIdx).unsavedPages;
+  for (uint32_t i = 0; i < numOfPages; i++) {
+    const char* ptrPage = msg + i * sizeOfReservedPage_;
+    const uint32_t sizePage = ((i < numOfPages - 1) ? sizeOfReservedPage_ : sizeLastPage);
+    if (unsaved)
+      unsavedPages[i].assign(ptrPage, sizePage);
+    else
+      saveReservedPage(firstPageId + i, sizePage, ptrPage);
+  }
+}
+
+// A page that was written to partially is zero padded, as it is by the state transfer when saved
+bool ClientsManager::loadClientPage(uint16_t clientIdx, uint32_t pageIdx, uint32_t copyLength, char* outPage) const {
+  const auto& unsavedPages = indexToClientInfo_.at(clientIdx).unsavedPages;
+  const auto it = unsavedPages.find(pageIdx);
+  if (it == unsavedPages.end()) {
+    return loadReservedPage(clientIdx * reservedPagesPerClient_ + pageIdx, copyLength, outPage);
+  }
+
+  const uint32_t size = std::min<uint32_t>(copyLength, it->second.size());
+  memcpy(outPage, it->second.data(), size);
+  memset(outPage + size, 0, copyLength - size);
+  return true;
+}
+
+// Reply log record: [clientIdx][reply message as saved to the reserved pages]
+void ClientsManager::replayReplyLog() {
+  for (auto& c : indexToClientInfo_) c.unsavedPages.clear();
+
+  const auto log = loadReservedPagesLog();
+  for (const auto& record : log) {
+    uint16_t clientIdx = 0;
+    ConcordAssertGT(record.size(), sizeof(clientIdx));
+    memcpy(&clientIdx, record.data(), sizeof(clientIdx));
+    ConcordAssertLT(clientIdx, indexToClientInfo_.size());
+    writeReplyPages(clientIdx, record.data() + sizeof(clientIdx), record.size() - sizeof(clientIdx), true);
+  }
+  LOG_INFO(CL_MNGR, "Replayed the reply log" << KVLOG(log.size()));
+}
+
+void ClientsManager::foldReplyLogIntoReservedPages() {
+  uint32_t numOfPages = 0;
+  for (uint16_t clientIdx = 0; clientIdx < indexToClientInfo_.size(); clientIdx++) {
+    auto& unsavedPages = indexToClientInfo_[clientIdx].unsavedPages;
+    for (const auto& [pageIdx, page] : unsavedPages) {
+      saveReservedPage(clientIdx * reservedPagesPerClient_ + pageIdx, page.size(), page.data());
+    }
+    numOfPages += unsavedPages.size();
+    unsavedPages.clear();
+  }
+  // Replaying the log again after a crash before it's cleared just saves the same pages again
+  clearReservedPagesLog();
+  LOG_DEBUG(CL_MNGR, KVLOG(numOfPages));
+}
+
 // Per client:
 // * calculate offset of reserved page start.
-// * load corresponding page from state-transfer to scratchPage.
+// * load corresponding page from state-transfer (or the reply log) to scratchPage.
 // * Fill its clientInfo.
 // * remove pending request if loaded reply is newer.
 void ClientsManager::loadInfoFromReservedPages() {
+  replayReplyLog();
   for (auto const& [clientId, clientIdx] : clientIdToIndex_) {
-    const uint32_t firstPageId = clientIdx * reservedPagesPerClient_;
-
-    if (!loadReservedPage(firstPageId, sizeOfReservedPage_, scratchPage_)) continue;
+    if (!loadClientPage(clientIdx, 0, sizeOfReservedPage_, scratchPage_)) continue;
 
     ClientReplyMsgHeader* replyHeader = (ClientReplyMsgHeader*)scratchPage_;
     ConcordAssert(replyHeader->msgType == 0 || replyHeader->msgType == MsgCode::ClientReply);
@@ -170,8 +237,8 @@ bool ClientsManager::isValidClient(NodeIdType clientId) const { return (clientId
 // * set last reply seq num to the seq num of the request we reply to.
 // * set reply time to `now`.
 // * allocate new ClientReplyMsg
-// * calculate: num of pages, size of last page.
-// * save the reply to the reserved pages.
+// * append the reply to the reply log (it's written to the reserved pages when the log is folded), or save it to the
+//   reserved pages right away if there's no log.
 std::unique_ptr<ClientReplyMsg> ClientsManager::allocateNewReplyMsgAndWriteToStorage(
     NodeIdType clientId, ReqId requestSeqNum, uint16_t currentPrimaryId, char* reply, uint32_t replyLength) {
   uint16_t clientIdx = 0;
@@ -193,29 +260,18 @@ std::unique_ptr<ClientReplyMsg> ClientsManager::allocateNewReplyMsgAndWriteToSto
   c.repliesInfo.insert_or_assign(requestSeqNum, getMonotonicTime());
   LOG_DEBUG(CL_MNGR, KVLOG(clientId, requestSeqNum));
   auto r = std::make_unique<ClientReplyMsg>(myId_, requestSeqNum, reply, replyLength);
-  const uint32_t firstPageId = clientIdx * reservedPagesPerClient_;
-  LOG_DEBUG(CL_MNGR, "firstPageId=" << firstPageId);
-  uint32_t numOfPages = r->size() / sizeOfReservedPage_;
-  uint32_t sizeLastPage = sizeOfReservedPage_;
-  if (numOfPages > reservedPagesPerClient_) {
+  if (r->size() / sizeOfReservedPage_ > reservedPagesPerClient_) {
     LOG_FATAL(CL_MNGR,
               "Client reply is larger than reservedPagesPerClient_ allows"
                   << KVLOG(clientId, requestSeqNum, reservedPagesPerClient_ * sizeOfReservedPage_, replyLength));
     ConcordAssert(false);
   }
 
-  if (r->size() % sizeOfReservedPage_ != 0) {
-    numOfPages++;
-    sizeLastPage = r->size() % sizeOfReservedPage_;
-  }
-
-  LOG_DEBUG(CL_MNGR, KVLOG(clientId, requestSeqNum, numOfPages, sizeLastPage));
-  // write reply message to reserved pages
-  for (uint32_t i = 0; i < numOfPages; i++) {
-    const char* ptrPage = r->body() + i * sizeOfReservedPage_;
-    const uint32_t sizePage = ((i < numOfPages - 1) ? sizeOfReservedPage_ : sizeLastPage);
-    saveReservedPage(firstPageId + i, sizePage, ptrPage);
-  }
+  std::string record(sizeof(clientIdx) + r->size(), '\0');
+  memcpy(record.data(), &clientIdx, sizeof(clientIdx));
+  memcpy(record.data() + sizeof(clientIdx), r->body(), r->size());
+  const bool logged = appendToReservedPagesLog(record.data(), record.size());
+  writeReplyPages(clientIdx, r->body(), r->size(), logged);
 
   // write currentPrimaryId to message (we don't store the currentPrimaryId in the reserved pages)
   r->setPrimaryId(currentPrimaryId);
@@ -223,7 +279,7 @@ std::unique_ptr<ClientReplyMsg> ClientsManager::allocateNewReplyMsgAndWriteToSto
   return r;
 }
 
-// * load client reserve page to scratchPage
+// * load client reserve page (or its unsaved image) to scratchPage
 // * cast to ClientReplyMsgHeader and validate.
 // * calculate: reply msg size, num of pages, size of last page.
 // * allocate new ClientReplyMsg.
@@ -240,9 +296,8 @@ std::unique_ptr<ClientReplyMsg> ClientsManager::allocateReplyFromSavedOne(NodeId
     throw;
   }
 
-  const uint32_t firstPageId = clientIdx * reservedPagesPerClient_;
-  LOG_DEBUG(CL_MNGR, KVLOG(clientId, requestSeqNum, firstPageId));
-  loadReservedPage(firstPageId, sizeOfReservedPage_, scratchPage_);
+  LOG_DEBUG(CL_MNGR, KVLOG(clientId, requestSeqNum, clientIdx));
+  loadClientPage(clientIdx, 0, sizeOfReservedPage_, scratchPage_);
 
   ClientReplyMsgHeader* replyHeader = (ClientReplyMsgHeader*)scratchPage_;
   ConcordAssert(replyHeader->msgType == MsgCode::ClientReply);
@@ -264,7 +319,7 @@ std::unique_ptr<ClientReplyMsg> ClientsManager::allocateReplyFromSavedOne(NodeId
   for (uint32_t i = 0; i < numOfPages; i++) {
     char* const ptrPage = r->body() + i * sizeOfReservedPage_;
     const uint32_t sizePage = ((i < numOfPages - 1) ? sizeOfReservedPage_ : sizeLastPage);
-    loadReservedPage(firstPageId + i, sizePage, ptrPage);
+    loadClientPage(clientIdx, i, sizePage, ptrPage);
   }
 
   const auto& replySeqNum = r->reqSeqNum();
@@ -20,6 +20,7 @@
 #include <set>
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace bftEngine {
 class IStateTransfer;
@@ -35,8 +36,13 @@ class ClientsManager : public ResPagesClient<ClientsManager, 0>, public IPending
 
   uint32_t numberOfRequiredReservedPages() const;
 
+  // Loads the replies from the reserved pages and replays the reply log on top of them.
   void loadInfoFromReservedPages();
 
+  // Replies are appended to the reply log and kept in memory rather than saved to the reserved pages one by one. This
+  // saves the pages written since the last call, in order, and clears the log. Call it before creating a checkpoint.
+  void foldReplyLogIntoReservedPages();
+
   // Replies
 
   // TODO(GG): make sure that ReqId is based on time (and ignore requests with time that does
@@ -85,6 +91,12 @@ class ClientsManager : public ResPagesClient<ClientsManager, 0>, public IPending
   int getIndexOfClient(const NodeIdType& id) const;
 
  protected:
+  // Writes a reply message over the client's reserved pages, either to the pages themselves or to their unsaved images
+  void writeReplyPages(uint16_t clientIdx, const char* msg, uint32_t msgSize, bool unsaved);
+  // Loads a client's reserved page (pageIdx is relative to the client's first page), preferring the unsaved image
+  bool loadClientPage(uint16_t clientIdx, uint32_t pageIdx, uint32_t copyLength, char* outPage) const;
+  void replayReplyLog();
+
   const ReplicaId myId_;
   const uint32_t sizeOfReservedPage_;
 
@@ -110,6 +122,8 @@ class ClientsManager : public ResPagesClient<ClientsManager, 0>, public IPending
   struct ClientInfo {
     std::map<ReqId, RequestInfo> requestsInfo;
     std::map<ReqId, Time> repliesInfo;  // replyId to replyTime
+    // page index to the bytes written since the reply log was last folded into the reserved pages
+    std::map<uint32_t, std::string> unsavedPages;
   };
 
   std::vector<ClientInfo> indexToClientInfo_;
@@ -0,0 +1,100 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#include "PrimaryRequestsQueue.hpp"
+#include "messages/ClientRequestMsg.hpp"
+#include "assertUtils.hpp"
+
+namespace bftEngine::impl {
+
+PrimaryRequestsQueue::PrimaryRequestsQueue(const ReplicaConfig& config, concordMetrics::Component& metrics)
+    // A quantum that fits any request lets each client send at least one request per round
+    : quantum_{config.getmaxExternalMessageSize()},
+      activeClientsMetric_{metrics.RegisterGauge("primary_queue_active_clients", 0)},
+      maxClientSizeMetric_{metrics.RegisterGauge("primary_queue_max_client_size", 0)} {}
+
+bool PrimaryRequestsQueue::push(ClientRequestMsg* m) {
+  const NodeIdType clientId = m->clientProxyId();
+  ClientQueue& queue = clients_[clientId];
+  if (!queue.reqSeqNums.insert(m->requestSeqNum()).second) return false;
+
+  queue.requests.push_back(m);
+  if (!queue.active) {
+    queue.active = true;
+    activeClients_.push_back(clientId);
+  }
+  size_++;
+  sizeInBytes_ += m->size();
+  onClientSizeChanged(queue.requests.size() - 1, queue.requests.size());
+  return true;
+}
+
+ClientRequestMsg* PrimaryRequestsQueue::front() {
+  if (empty()) return nullptr;
+  while (true) {
+    ClientQueue& queue = clients_[activeClients_.front()];
+    if (!quantumAdded_) {
+      queue.deficit += quantum_;
+      quantumAdded_ = true;
+    }
+    ClientRequestMsg* m = queue.requests.front();
+    if (m->size() <= queue.deficit) return m;
+    // the client used its quantum for this round
+    activeClients_.push_back(activeClients_.front());
+    activeClients_.pop_front();
+    quantumAdded_ = false;
+  }
+}
+
+void PrimaryRequestsQueue::pop() {
+  ClientRequestMsg* m = front();
+  ConcordAssertNE(m, nullptr);
+  ClientQueue& queue = clients_[activeClients_.front()];
+  queue.deficit -= m->size();
+  queue.requests.pop_front();
+  queue.reqSeqNums.erase(m->requestSeqNum());
+  size_--;
+  sizeInBytes_ -= m->size();
+  if (queue.requests.empty()) {
+    // an idle client doesn't accumulate credit
+    queue.deficit = 0;
+    queue.active = false;
+    activeClients_.pop_front();
+    quantumAdded_ = false;
+  }
+  onClientSizeChanged(queue.requests.size() + 1, queue.requests.size());
+}
+
+size_t PrimaryRequestsQueue::size(NodeIdType clientId) const {
+  auto it = clients_.find(clientId);
+  return (it != clients_.end()) ? it->second.requests.size() : 0;
+}
+
+bool PrimaryRequestsQueue::contains(NodeIdType clientId, ReqId reqSeqNum) const {
+  auto it = clients_.find(clientId);
+  return (it != clients_.end()) && it->second.reqSeqNums.count(reqSeqNum);
+}
+
+// The size of a client queue changes by one request at a time, so the largest size is updated in O(1)
+void PrimaryRequestsQueue::onClientSizeChanged(size_t oldSize, size_t newSize) {
+  if (numOfClientsWithSize_.size() <= newSize) numOfClientsWithSize_.resize(newSize + 1, 0);
+  if (oldSize > 0) numOfClientsWithSize_[oldSize]--;
+  if (newSize > 0) numOfClientsWithSize_[newSize]++;
+  if (newSize > maxClientSize_) {
+    maxClientSize_ = newSize;
+  } else if (oldSize == maxClientSize_ && numOfClientsWithSize_[oldSize] == 0) {
+    maxClientSize_ = newSize;
+  }
+  activeClientsMetric_.Get().Set(activeClients_.size());
+  maxClientSizeMetric_.Get().Set(maxClientSize_);
+}
+
+}  // namespace bftEngine::impl
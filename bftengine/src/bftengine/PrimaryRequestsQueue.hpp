@@ -0,0 +1,79 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Metrics.hpp"
+#include "PrimitiveTypes.hpp"
+#include "ReplicaConfig.hpp"
+
+namespace bftEngine::impl {
+
+class ClientRequestMsg;
+
+// The requests queue of the primary. Requests are kept in a queue per client, and front() picks the next request by
+// deficit round robin over the clients with queued requests, weighted by request size: in each round a client may
+// send up to `quantum` bytes more than it did so far. Thus clients that send large batches of requests don't delay
+// the requests of other clients.
+// The queue doesn't own the messages.
+class PrimaryRequestsQueue {
+ public:
+  // The number of clients with queued requests and the largest number of requests queued by a client are reported as
+  // gauges of `metrics`
+  PrimaryRequestsQueue(const ReplicaConfig& config, concordMetrics::Component& metrics);
+
+  // Returns false if a request with the same client and sequence number is already in the queue
+  bool push(ClientRequestMsg* m);
+
+  // The next request to be popped, nullptr if the queue is empty
+  ClientRequestMsg* front();
+
+  void pop();
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  // Total size of the queued requests
+  size_t sizeInBytes() const { return sizeInBytes_; }
+
+  size_t size(NodeIdType clientId) const;
+  bool contains(NodeIdType clientId, ReqId reqSeqNum) const;
+
+ private:
+  struct ClientQueue {
+    std::deque<ClientRequestMsg*> requests;
+    std::unordered_set<ReqId> reqSeqNums;
+    uint64_t deficit = 0;
+    bool active = false;  // in activeClients_
+  };
+
+  void onClientSizeChanged(size_t oldSize, size_t newSize);
+
+  const uint64_t quantum_;
+  std::unordered_map<NodeIdType, ClientQueue> clients_;
+  // Clients with queued requests, in round robin order. The front client is being served.
+  std::deque<NodeIdType> activeClients_;
+  // Whether the front client already got its quantum in this round
+  bool quantumAdded_ = false;
+  size_t size_ = 0;
+  size_t sizeInBytes_ = 0;
+  // numOfClientsWithSize_[n] is the number of clients with n > 0 queued requests
+  std::vector<size_t> numOfClientsWithSize_;
+  size_t maxClientSize_ = 0;
+  concordMetrics::GaugeHandle activeClientsMetric_;
+  concordMetrics::GaugeHandle maxClientSizeMetric_;
+};
+
+}  // namespace bftEngine::impl
@@ -91,6 +91,21 @@ void ReplicaForStateTransfer::sendStateTransferMessage(char *m, uint32_t size, u
   delete p;
 }
 
+char *ReplicaForStateTransfer::allocStateTransferMsg(uint32_t size) {
+  // the message is preceded by its header, like the messages that are passed to handleStateTransferMessage
+  MessageBase p(config_.replicaId, MsgCode::StateTransfer, size + sizeof(MessageBase::Header));
+  p.releaseOwnership();
+  return p.body() + sizeof(MessageBase::Header);
+}
+
+void ReplicaForStateTransfer::sendPreallocatedStateTransferMessage(char *m, uint32_t size, uint16_t replicaId) {
+  MessageBase p(config_.replicaId,
+                reinterpret_cast<MessageBase::Header *>(m - sizeof(MessageBase::Header)),
+                size + sizeof(MessageBase::Header),
+                false);
+  send(&p, replicaId);
+}
+
 void ReplicaForStateTransfer::onTransferringComplete(uint64_t checkpointNumberOfNewState) {
   // TODO(GG): if this method is invoked by an external thread, then send an "internal message" to the commands
   // processing thread
@@ -34,6 +34,8 @@ class ReplicaForStateTransfer : public IReplicaForStateTransfer, public ReplicaB
   // IReplicaForStateTransfer
   void freeStateTransferMsg(char* m) override;
   void sendStateTransferMessage(char* m, uint32_t size, uint16_t replicaId) override;
+  char* allocStateTransferMsg(uint32_t size) override;
+  void sendPreallocatedStateTransferMessage(char* m, uint32_t size, uint16_t replicaId) override;
   void onTransferringComplete(uint64_t checkpointNumberOfNewState) override;
   void changeStateTransferTimerPeriod(uint32_t timerPeriodMilli) override;
 
@@ -32,6 +32,7 @@
 #include "messages/ClientReplyMsg.hpp"
 #include "messages/StartSlowCommitMsg.hpp"
 #include "messages/ReqMissingDataMsg.hpp"
+#include "messages/ReqMissingClientRequestsMsg.hpp"
 #include "messages/SimpleAckMsg.hpp"
 #include "messages/ViewChangeMsg.hpp"
 #include "messages/NewViewMsg.hpp"
@@ -87,6 +88,9 @@ void ReplicaImp::registerMsgHandlers() {
   msgHandlers_->registerMsgHandler(MsgCode::ReqMissingData,
                                    bind(&ReplicaImp::messageHandler<ReqMissingDataMsg>, this, _1));
 
+  msgHandlers_->registerMsgHandler(MsgCode::ReqMissingClientRequests,
+                                   bind(&ReplicaImp::messageHandler<ReqMissingClientRequestsMsg>, this, _1));
+
   msgHandlers_->registerMsgHandler(MsgCode::SimpleAck, bind(&ReplicaImp::messageHandler<SimpleAckMsg>, this, _1));
 
   msgHandlers_->registerMsgHandler(MsgCode::StartSlowCommit,
@@ -195,7 +199,11 @@ void ReplicaImp::onMessage<ClientRequestMsg>(ClientRequestMsg *m) {
 
   // check message validity
   const bool invalidClient = !isValidClient(clientId);
-  const bool sentFromReplicaToNonPrimary = repsInfo->isIdOfReplica(senderId) && !isCurrentPrimary();
+  // with digests-only PrePrepare messages, replicas deliver the request bodies to each other
+  const bool disseminatedRequest =
+      clientRequestsStore_ && repsInfo->isIdOfReplica(senderId) && !isCurrentPrimary() && !readOnly;
+  const bool sentFromReplicaToNonPrimary =
+      repsInfo->isIdOfReplica(senderId) && !isCurrentPrimary() && !disseminatedRequest;
 
   if (invalidClient) {
     ++numInvalidClients;
@@ -210,6 +218,12 @@ void ReplicaImp::onMessage<ClientRequestMsg>(ClientRequestMsg *m) {
     return;
   }
 
+  if (disseminatedRequest) {
+    if (!isReplyAlreadySentToClient(clientId, reqSeqNum)) storeClientRequest(m);
+    delete m;
+    return;
+  }
+
   if (readOnly) {
     executeReadOnlyRequest(span, m);
     delete m;
@@ -245,10 +259,16 @@ void ReplicaImp::onMessage<ClientRequestMsg>(ClientRequestMsg *m) {
         LOG_DEBUG(CNSUS,
                   "Pushing to primary queue, request [" << reqSeqNum << "], client [" << clientId
                                                         << "], senderId=" << senderId);
+        if (!requestsQueueOfPrimary.push(m)) {
+          LOG_DEBUG(GL, "ClientRequestMsg is already in the primary queue" << KVLOG(clientId, reqSeqNum));
+          delete m;
+          return;
+        }
+        // A request forwarded by a replica has already been disseminated by it
+        if (clientRequestsStore_ && config_.getdisseminateClientRequests() && !repsInfo->isIdOfReplica(senderId))
+          sendToAllOtherReplicas(m);
         if (time_to_collect_batch_ == MinTime) time_to_collect_batch_ = getMonotonicTime();
-        requestsQueueOfPrimary.push(m);
         primary_queue_size_.Get().Set(requestsQueueOfPrimary.size());
-        primaryCombinedReqSize += m->size();
         tryToSendPrePrepareMsg(true);
         return;
       } else {
@@ -260,9 +280,15 @@ void ReplicaImp::onMessage<ClientRequestMsg>(ClientRequestMsg *m) {
       if (clientsManager->canBecomePending(clientId, reqSeqNum)) {
         clientsManager->addPendingRequest(clientId, reqSeqNum, m->getCid());
 
+        if (clientRequestsStore_) storeClientRequest(m);
         // TODO(GG): add a mechanism that retransmits (otherwise we may start unnecessary view-change)
-        send(m, currentPrimary());
-        LOG_INFO(GL, "Forwarding ClientRequestMsg to the current primary." << KVLOG(reqSeqNum, clientId));
+        if (clientRequestsStore_ && config_.getdisseminateClientRequests()) {
+          sendToAllOtherReplicas(m);
+          LOG_INFO(GL, "Disseminating ClientRequestMsg to all replicas." << KVLOG(reqSeqNum, clientId));
+        } else {
+          send(m, currentPrimary());
+          LOG_INFO(GL, "Forwarding ClientRequestMsg to the current primary." << KVLOG(reqSeqNum, clientId));
+        }
       }
       if (clientsManager->isPending(clientId, reqSeqNum)) {
         // As long as this request is not committed, we want to continue and alert the primary about it
@@ -349,19 +375,18 @@ void ReplicaImp::removeDuplicatedRequestsFromRequestsQueue() {
   // Remove duplicated requests that are result of client retrials from the head of the requestsQueueOfPrimary
   ClientRequestMsg *first = requestsQueueOfPrimary.front();
   while (first != nullptr && !clientsManager->canBecomePending(first->clientProxyId(), first->requestSeqNum())) {
-    primaryCombinedReqSize -= first->size();
-    delete first;
     requestsQueueOfPrimary.pop();
-    first = (!requestsQueueOfPrimary.empty() ? requestsQueueOfPrimary.front() : nullptr);
+    delete first;
+    first = requestsQueueOfPrimary.front();
   }
   primary_queue_size_.Get().Set(requestsQueueOfPrimary.size());
 }
 
 PrePrepareMsg *ReplicaImp::buildPrePrepareMsgBatchByOverallSize(uint32_t requiredBatchSizeInBytes) {
-  if (primaryCombinedReqSize < requiredBatchSizeInBytes) {
+  if (requestsQueueOfPrimary.sizeInBytes() < requiredBatchSizeInBytes) {
     LOG_DEBUG(GL,
               "Not sufficient messages size in the primary replica queue to fill a batch"
-                  << KVLOG(primaryCombinedReqSize, requiredBatchSizeInBytes));
+                  << KVLOG(requestsQueueOfPrimary.sizeInBytes(), requiredBatchSizeInBytes));
     return nullptr;
   }
   if (!checkSendPrePrepareMsgPrerequisites()) return nullptr;
@@ -423,7 +448,7 @@ PrePrepareMsg *ReplicaImp::createPrePrepareMessage() {
                            (primaryLastUsedSeqNum + 1),
                            firstPath,
                            requestsQueueOfPrimary.front()->spanContext<ClientRequestMsg>(),
-                           primaryCombinedReqSize);
+                           requestsQueueOfPrimary.sizeInBytes());
 }
 
 ClientRequestMsg *ReplicaImp::addRequestToPrePrepareMessage(ClientRequestMsg *&nextRequest,
@@ -436,16 +461,15 @@ ClientRequestMsg *ReplicaImp::addRequestToPrePrepareMessage(ClientRequestMsg *&n
       clientsManager->addPendingRequest(
           nextRequest->clientProxyId(), nextRequest->requestSeqNum(), nextRequest->getCid());
     }
-    primaryCombinedReqSize -= nextRequest->size();
   } else if (nextRequest->size() > maxStorageForRequests) {  // The message is too big
     LOG_ERROR(GL,
               "Request was dropped because it exceeds maximum allowed size" << KVLOG(
                   prePrepareMsg.seqNumber(), nextRequest->senderId(), nextRequest->size(), maxStorageForRequests));
   }
-  delete nextRequest;
   requestsQueueOfPrimary.pop();
+  delete nextRequest;
   primary_queue_size_.Get().Set(requestsQueueOfPrimary.size());
-  return (!requestsQueueOfPrimary.empty() ? requestsQueueOfPrimary.front() : nullptr);
+  return requestsQueueOfPrimary.front();
 }
 
 PrePrepareMsg *ReplicaImp::finishAddingRequestsToPrePrepareMsg(PrePrepareMsg *&prePrepareMsg,
@@ -561,11 +585,13 @@ void ReplicaImp::startConsensusProcess(PrePrepareMsg *pp, bool isInternalNoop) {
 
   {
     TimeRecorder scoped_timer(*histograms_.broadcastPrePrepare);
+    std::unique_ptr<PrePrepareMsg> digestsOnlyPP = createDigestsOnlyPrePrepareMsgToSend(pp);
+    PrePrepareMsg *ppToSend = digestsOnlyPP ? digestsOnlyPP.get() : pp;
     if (!retransmissionsLogicEnabled) {
-      sendToAllOtherReplicas(pp);
+      sendToAllOtherReplicas(ppToSend);
     } else {
       for (ReplicaId x : repsInfo->idsOfPeerReplicas()) {
-        sendRetransmittableMsgToReplica(pp, x, primaryLastUsedSeqNum);
+        sendRetransmittableMsgToReplica(ppToSend, x, primaryLastUsedSeqNum);
       }
     }
   }
@@ -672,6 +698,15 @@ void ReplicaImp::onMessage<PrePrepareMsg>(PrePrepareMsg *msg) {
   SCOPED_MDC_PRIMARY(std::to_string(currentPrimary()));
   SCOPED_MDC_SEQ_NUM(std::to_string(msgSeqNum));
   LOG_DEBUG(MSGS, KVLOG(msg->senderId(), msg->size()));
+  if (msg->isDigestsOnly()) {
+    onDigestsOnlyPrePrepareMsg(msg);
+    return;
+  }
+  onFullPrePrepareMsg(msg);
+}
+
+void ReplicaImp::onFullPrePrepareMsg(PrePrepareMsg *msg) {
+  const SeqNum msgSeqNum = msg->seqNumber();
   auto span = concordUtils::startChildSpanFromContext(msg->spanContext<std::remove_pointer<decltype(msg)>::type>(),
                                                       "handle_bft_preprepare");
   span.setTag("rid", config_.getreplicaId());
@@ -696,14 +731,7 @@ void ReplicaImp::onMessage<PrePrepareMsg>(PrePrepareMsg *msg) {
     SeqNumInfo &seqNumInfo = mainLog->get(msgSeqNum);
     const bool slowStarted = (msg->firstPath() == CommitPath::SLOW || seqNumInfo.slowPathStarted());
 
-    // Check to see if this is a noop.
-    bool isNoop = false;
-    if (msg->numberOfRequests() == 1) {
-      auto it = RequestsIterator(msg);
-      char *requestBody = nullptr;
-      it.getCurrent(requestBody);
-      isNoop = (reinterpret_cast<ClientRequestMsgHeader *>(requestBody)->requestLength == 0);
-    }
+    const bool isNoop = isInternalNoopPrePrepare(msg);
 
     // For MDC it doesn't matter which type of fast path
     SCOPED_MDC_PATH(CommitPathToMDCString(slowStarted ? CommitPath::SLOW : CommitPath::OPTIMISTIC_FAST));
@@ -750,6 +778,134 @@ void ReplicaImp::onMessage<PrePrepareMsg>(PrePrepareMsg *msg) {
   if (!msgAdded) delete msg;
 }
 
+bool ReplicaImp::isInternalNoopPrePrepare(const PrePrepareMsg *pp) {
+  if (pp->numberOfRequests() != 1) return false;
+  auto it = RequestsIterator(pp);
+  char *requestBody = nullptr;
+  it.getCurrent(requestBody);
+  return (reinterpret_cast<ClientRequestMsgHeader *>(requestBody)->requestLength == 0);
+}
+
+std::unique_ptr<PrePrepareMsg> ReplicaImp::createDigestsOnlyPrePrepareMsgToSend(const PrePrepareMsg *pp) const {
+  // A noop request is generated by the primary and is always sent as is.
+  if (!clientRequestsStore_ || pp->isNull() || pp->isDigestsOnly() || isInternalNoopPrePrepare(pp)) return nullptr;
+  return std::unique_ptr<PrePrepareMsg>(PrePrepareMsg::createDigestsOnlyMsg(*pp));
+}
+
+void ReplicaImp::onDigestsOnlyPrePrepareMsg(PrePrepareMsg *msg) {
+  std::unique_ptr<PrePrepareMsg> digestsOnlyMsg{msg};
+  if (!clientRequestsStore_) return;
+  if (!tryToResolveDigestsOnlyPrePrepareMsg(*digestsOnlyMsg, true))
+    addPendingDigestsOnlyPrePrepareMsg(std::move(digestsOnlyMsg));
+}
+
+bool ReplicaImp::relevantDigestsOnlyPrePrepareMsg(const PrePrepareMsg *msg) {
+  const SeqNum msgSeqNum = msg->seqNumber();
+  if (msg->senderId() != repsInfo->primaryOfView(msg->viewNumber()) || msgSeqNum <= strictLowerBoundOfSeqNums ||
+      !mainLog->insideActiveWindow(msgSeqNum))
+    return false;
+  // While the view is inactive, the message is kept: the replica may need it to enter the next view
+  if (!currentViewIsActive()) return true;
+  return msg->viewNumber() == getCurrentView() && !mainLog->get(msgSeqNum).hasPrePrepareMsg();
+}
+
+bool ReplicaImp::tryToResolveDigestsOnlyPrePrepareMsg(PrePrepareMsg &msg, bool askForMissingRequests) {
+  if (!relevantDigestsOnlyPrePrepareMsg(&msg)) return true;
+  // As with full PrePrepare messages, an inactive view only handles the ones that the views manager waits for
+  if (!currentViewIsActive() && !viewsManager->waitingForMsgs()) return false;
+
+  std::vector<PrePrepareMsg::RequestDigest> missingRequests;
+  PrePrepareMsg *fullMsg = resolveDigestsOnlyPrePrepareMsg(msg, missingRequests);
+  if (fullMsg) {
+    onFullPrePrepareMsg(fullMsg);
+    return true;
+  }
+  if (missingRequests.empty()) {
+    onReportAboutInvalidMessage(&msg, "Request bodies don't match the digest of the PrePrepare");
+    return true;
+  }
+  if (askForMissingRequests) {
+    LOG_INFO(CNSUS,
+             "Missing request bodies of digests-only PrePrepare"
+                 << KVLOG(msg.senderId(), msg.seqNumber(), missingRequests.size()));
+    ReqMissingClientRequestsMsg reqMissing(config_.getreplicaId(), msg.viewNumber(), msg.seqNumber(), missingRequests);
+    send(&reqMissing, msg.senderId());
+    metric_sent_req_missing_client_requests_.Get().Inc();
+  }
+  return false;
+}
+
+void ReplicaImp::addPendingDigestsOnlyPrePrepareMsg(std::unique_ptr<PrePrepareMsg> msg) {
+  std::unique_ptr<PrePrepareMsg> &pending = digestsOnlyPrePrepares_[msg->seqNumber()];
+  if (!pending || pending->viewNumber() <= msg->viewNumber()) pending = std::move(msg);
+}
+
+PrePrepareMsg *ReplicaImp::resolveDigestsOnlyPrePrepareMsg(
+    const PrePrepareMsg &msg, std::vector<PrePrepareMsg::RequestDigest> &missingRequests) {
+  const PrePrepareMsg::RequestDigest *entries = msg.requestDigests();
+  std::vector<const char *> requests;
+  requests.reserve(msg.numberOfRequests());
+  for (uint16_t i = 0; i < msg.numberOfRequests(); i++) {
+    const char *request = clientRequestsStore_->get(entries[i].digest);
+    if (request)
+      requests.push_back(request);
+    else
+      missingRequests.push_back(entries[i]);
+  }
+  if (!missingRequests.empty()) return nullptr;
+
+  PrePrepareMsg *fullMsg = PrePrepareMsg::createFromDigestsOnlyMsg(msg, requests);
+  if (fullMsg) {
+    for (uint16_t i = 0; i < msg.numberOfRequests(); i++) clientRequestsStore_->remove(entries[i].digest);
+  }
+  return fullMsg;
+}
+
+void ReplicaImp::storeClientRequest(const ClientRequestMsg *m) {
+  if (clientRequestsStore_->add(m->body(), m->size()) && !digestsOnlyPrePrepares_.empty())
+    tryToResolveDigestsOnlyPrePrepareMsgs(false);
+}
+
+void ReplicaImp::tryToResolveDigestsOnlyPrePrepareMsgs(bool askForMissingRequests) {
+  // Handling a resolved message may enter a new view, which resolves the pending messages again
+  std::map<SeqNum, std::unique_ptr<PrePrepareMsg>> pending;
+  pending.swap(digestsOnlyPrePrepares_);
+  for (auto &entry : pending) {
+    if (!tryToResolveDigestsOnlyPrePrepareMsg(*entry.second, askForMissingRequests))
+      addPendingDigestsOnlyPrePrepareMsg(std::move(entry.second));
+  }
+}
+
+template <>
+void ReplicaImp::onMessage<ReqMissingClientRequestsMsg>(ReqMissingClientRequestsMsg *msg) {
+  const SeqNum msgSeqNum = msg->seqNumber();
+  const ReplicaId msgSender = msg->senderId();
+  SCOPED_MDC_SEQ_NUM(std::to_string(msgSeqNum));
+  LOG_INFO(GL, "Received ReqMissingClientRequestsMsg. " << KVLOG(msgSender, msg->numberOfRequests()));
+
+  PrePrepareMsg *pp = nullptr;
+  if (currentViewIsActive() && msg->viewNumber() == getCurrentView() && mainLog->insideActiveWindow(msgSeqNum))
+    pp = mainLog->get(msgSeqNum).getPrePrepareMsg();
+  if (!pp) {
+    LOG_INFO(GL, "Ignore the ReqMissingClientRequestsMsg message. " << KVLOG(msgSender, getCurrentView()));
+    delete msg;
+    return;
+  }
+
+  const ReqMissingClientRequestsMsg::RequestDigest *entries = msg->requestDigests();
+  RequestsIterator reqIter(pp);
+  char *requestBody = nullptr;
+  while (reqIter.getAndGoToNext(requestBody)) {
+    ClientRequestMsg req((ClientRequestMsgHeader *)requestBody);
+    for (uint16_t i = 0; i < msg->numberOfRequests(); i++) {
+      if (entries[i].clientId != req.clientProxyId() || entries[i].reqSeqNum != req.requestSeqNum()) continue;
+      if (PrePrepareMsg::digestOfRequest(req.body(), req.size()) == entries[i].digest) send(&req, msgSender);
+      break;
+    }
+  }
+  delete msg;
+}
+
 void ReplicaImp::tryToStartSlowPaths() {
   if (!isCurrentPrimary() || isCollectingState() || !currentViewIsActive())
     return;  // TODO(GG): consider to stop the related timer when this method is not needed (to avoid useless
@@ -828,6 +984,8 @@ void ReplicaImp::tryToStartSlowPaths() {
 void ReplicaImp::tryToAskForMissingInfo() {
   if (!currentViewIsActive() || isCollectingState()) return;
 
+  if (!digestsOnlyPrePrepares_.empty()) tryToResolveDigestsOnlyPrePrepareMsgs(true);
+
   ConcordAssertLE(maxSeqNumTransferredFromPrevViews, lastStableSeqNum + kWorkWindowSize);
 
   const bool recentViewChange = (maxSeqNumTransferredFromPrevViews > lastStableSeqNum);
@@ -1942,6 +2100,9 @@ void ReplicaImp::onRetransmissionsProcessingResults(SeqNum relatedLastStableSeqN
         SeqNumInfo &seqNumInfo = mainLog->get(s.msgSeqNum);
         PrePrepareMsg *msgToSend = seqNumInfo.getSelfPrePrepareMsg();
         ConcordAssertNE(msgToSend, nullptr);
+        // The replica fetches the request bodies it is missing with ReqMissingClientRequestsMsg
+        std::unique_ptr<PrePrepareMsg> digestsOnlyPP = createDigestsOnlyPrePrepareMsgToSend(msgToSend);
+        if (digestsOnlyPP) msgToSend = digestsOnlyPP.get();
         sendRetransmittableMsgToReplica(msgToSend, s.replicaId, s.msgSeqNum);
         LOG_DEBUG(MSGS,
                   "Replica " << myId << " retransmits to replica " << s.replicaId << " PrePrepareMsg with seqNumber "
@@ -2639,7 +2800,6 @@ void ReplicaImp::onNewView(const std::vector<PrePrepareMsg *> &prePreparesForNew
   // clear requestsQueueOfPrimary
   while (!requestsQueueOfPrimary.empty()) {
     auto msg = requestsQueueOfPrimary.front();
-    primaryCombinedReqSize -= msg->size();
     requestsQueueOfPrimary.pop();
     delete msg;
   }
@@ -2663,6 +2823,8 @@ void ReplicaImp::onNewView(const std::vector<PrePrepareMsg *> &prePreparesForNew
   controller->onNewView(curView, primaryLastUsedSeqNum);
   metric_current_active_view_.Get().Set(curView);
   metric_sent_replica_asks_to_leave_view_msg_.Get().Set(0);
+
+  if (!digestsOnlyPrePrepares_.empty()) tryToResolveDigestsOnlyPrePrepareMsgs(true);
 }
 
 void ReplicaImp::sendCheckpointIfNeeded() {
@@ -3029,7 +3191,9 @@ void ReplicaImp::onMessage<ReqMissingDataMsg>(ReqMissingDataMsg *msg) {
       PrePrepareMsg *pp = seqNumInfo.getSelfPrePrepareMsg();
       if (msg->getPrePrepareIsMissing()) {
         if (pp != nullptr) {
-          sendAndIncrementMetric(pp, msgSender, metric_sent_preprepare_msg_due_to_reqMissingData_);
+          std::unique_ptr<PrePrepareMsg> digestsOnlyPP = createDigestsOnlyPrePrepareMsgToSend(pp);
+          sendAndIncrementMetric(
+              digestsOnlyPP ? digestsOnlyPP.get() : pp, msgSender, metric_sent_preprepare_msg_due_to_reqMissingData_);
         }
       }
 
@@ -3575,6 +3739,7 @@ ReplicaImp::ReplicaImp(bool firstTime,
       viewChangeProtocolEnabled{config.viewChangeProtocolEnabled},
       autoPrimaryRotationEnabled{config.autoPrimaryRotationEnabled},
       restarted_{!firstTime},
+      requestsQueueOfPrimary{config_, metrics_},
       replyBuffer{(char *)std::malloc(config_.getmaxReplyMessageSize() - sizeof(ClientReplyMsgHeader))},
       timeOfLastStateSynch{getMonotonicTime()},    // TODO(GG): TBD
       timeOfLastViewEntrance{getMonotonicTime()},  // TODO(GG): TBD
@@ -3627,6 +3792,7 @@ ReplicaImp::ReplicaImp(bool firstTime,
       metric_received_simple_acks_{metrics_.RegisterCounter("receivedSimpleAckMsgs")},
       metric_sent_status_msgs_not_due_timer_{metrics_.RegisterCounter("sentStatusMsgsNotDueTime")},
       metric_sent_req_for_missing_data_{metrics_.RegisterCounter("sentReqForMissingData")},
+      metric_sent_req_missing_client_requests_{metrics_.RegisterCounter("sentReqMissingClientRequestsMsgs")},
       metric_sent_checkpoint_msg_due_to_status_{metrics_.RegisterCounter("sentCheckpointMsgDueToStatus")},
       metric_sent_viewchange_msg_due_to_status_{metrics_.RegisterCounter("sentViewChangeMsgDueToTimer")},
       metric_sent_newview_msg_due_to_status_{metrics_.RegisterCounter("sentNewviewMsgDueToCounter")},
@@ -3670,6 +3836,9 @@ ReplicaImp::ReplicaImp(bool firstTime,
   registerMsgHandlers();
   replStatusHandlers_.registerStatusHandlers();
 
+  if (config_.getprePrepareWithRequestDigestsOnly())
+    clientRequestsStore_ = std::make_unique<ClientRequestsStore>(config_.getmaxNumOfStoredClientRequests());
+
   // Register metrics component with the default aggregator.
   metrics_.Register();
 
@@ -4016,6 +4185,7 @@ void ReplicaImp::executeRequestsInPrePrepareMsg(concordUtils::SpanWrapper &paren
   uint64_t checkpointNum{};
   if ((lastExecutedSeqNum + 1) % checkpointWindowSize == 0) {
     checkpointNum = (lastExecutedSeqNum + 1) / checkpointWindowSize;
+    clientsManager->foldReplyLogIntoReservedPages();
     stateTransfer->createCheckpointOfCurrentState(checkpointNum);
     checkpoint_times_.start(lastExecutedSeqNum);
   }
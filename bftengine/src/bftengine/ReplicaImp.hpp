@@ -39,6 +39,8 @@
 #include "PerformanceManager.hpp"
 #include "secrets_manager_impl.h"
 #include "SigManager.hpp"
+#include "ClientRequestsStore.hpp"
+#include "PrimaryRequestsQueue.hpp"
 
 namespace bftEngine::impl {
 
@@ -104,8 +106,12 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
   SeqNum maxSeqNumTransferredFromPrevViews = 0;
 
   // requests queue (used by the primary)
-  std::queue<ClientRequestMsg*> requestsQueueOfPrimary;  // only used by the primary
-  size_t primaryCombinedReqSize = 0;                     // only used by the primary
+  PrimaryRequestsQueue requestsQueueOfPrimary;  // only used by the primary
+
+  // request bodies delivered outside of PrePrepare messages (only if prePrepareWithRequestDigestsOnly)
+  std::unique_ptr<ClientRequestsStore> clientRequestsStore_;
+  // digests-only PrePrepare messages that wait for request bodies, also kept while the view is inactive
+  std::map<SeqNum, std::unique_ptr<PrePrepareMsg>> digestsOnlyPrePrepares_;
 
   // bounded log used to store information about SeqNums in the range (lastStableSeqNum,lastStableSeqNum +
   // kWorkWindowSize]
@@ -221,6 +227,7 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
   CounterHandle metric_received_simple_acks_;
   CounterHandle metric_sent_status_msgs_not_due_timer_;
   CounterHandle metric_sent_req_for_missing_data_;
+  CounterHandle metric_sent_req_missing_client_requests_;
   CounterHandle metric_sent_checkpoint_msg_due_to_status_;
   CounterHandle metric_sent_viewchange_msg_due_to_status_;
   CounterHandle metric_sent_newview_msg_due_to_status_;
@@ -385,6 +392,31 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
 
   void tryToAskForMissingInfo();
 
+  void onFullPrePrepareMsg(PrePrepareMsg* msg);
+
+  void onDigestsOnlyPrePrepareMsg(PrePrepareMsg* msg);
+
+  bool relevantDigestsOnlyPrePrepareMsg(const PrePrepareMsg* msg);
+
+  // Returns false if the message waits for request bodies, true if it was handled or dropped
+  bool tryToResolveDigestsOnlyPrePrepareMsg(PrePrepareMsg& msg, bool askForMissingRequests);
+
+  void addPendingDigestsOnlyPrePrepareMsg(std::unique_ptr<PrePrepareMsg> msg);
+
+  static bool isInternalNoopPrePrepare(const PrePrepareMsg* pp);
+
+  // With digests-only PrePrepare messages, returns the copy of the primary's PrePrepare that is sent (and resent) to
+  // the other replicas, which get the request bodies separately. Returns nullptr if pp is sent as is.
+  std::unique_ptr<PrePrepareMsg> createDigestsOnlyPrePrepareMsgToSend(const PrePrepareMsg* pp) const;
+
+  // Returns nullptr if some request bodies are missing (added to missingRequests) or don't match the digest
+  PrePrepareMsg* resolveDigestsOnlyPrePrepareMsg(const PrePrepareMsg& msg,
+                                                 std::vector<PrePrepareMsg::RequestDigest>& missingRequests);
+
+  void storeClientRequest(const ClientRequestMsg* m);
+
+  void tryToResolveDigestsOnlyPrePrepareMsgs(bool askForMissingRequests);
+
   void tryToRemovePendingRequestsForSeqNum(SeqNum seqNum);
 
   void sendPreparePartial(SeqNumInfo&);
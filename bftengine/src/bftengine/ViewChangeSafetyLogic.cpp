@@ -14,8 +14,12 @@
 #include "assertUtils.hpp"
 #include "Logger.hpp"
 #include "CryptoManager.hpp"
+#include <algorithm>
+#include <cstring>
+#include <future>
 #include <set>
 #include <unordered_map>
+#include <utility>
 
 namespace bftEngine {
 namespace impl {
@@ -135,6 +139,12 @@ ViewChangeSafetyLogic::ViewChangeSafetyLogic(const uint16_t n,
   ConcordAssert(N == (3 * F + 2 * C + 1));
 }
 
+bool ViewChangeSafetyLogic::CertificateKey::operator<(const CertificateKey& other) const {
+  if (seqNum != other.seqNum) return (seqNum < other.seqNum);
+  if (view != other.view) return (view < other.view);
+  return (memcmp(&digest, &other.digest, sizeof(Digest)) < 0);
+}
+
 // TODO(GG): consider to optimize this method
 SeqNum ViewChangeSafetyLogic::calcLBStableForView(ViewChangeMsg** const viewChangeMsgsOfPendingView) const {
   const uint16_t INC_IN_VC = (2 * F + 2 * C + 1);
@@ -169,6 +179,56 @@ SeqNum ViewChangeSafetyLogic::calcLBStableForView(ViewChangeMsg** const viewChan
   return lowerBoundOfLastStable;
 }
 
+ViewChangeSafetyLogic::VerifiedCertificates ViewChangeSafetyLogic::verifyPreparedCertificates(
+    ViewChangeMsg** const inViewChangeMsgsOfCurrentView, const SeqNum lowerBound, const SeqNum upperBound) const {
+  // collect the distinct signatures of each certificate (more than one means that some replica is malicious)
+  std::map<CertificateKey, vector<SlowElem>> certificates;
+  for (uint16_t i = 0; i < N; i++) {
+    const ViewChangeMsg* vc = inViewChangeMsgsOfCurrentView[i];
+    if (vc == nullptr || vc->numberOfElements() == 0) continue;
+
+    ViewChangeMsg::ElementsIterator iter(vc);
+    iter.goToAtLeast(lowerBound);
+    ViewChangeMsg::Element* elem = nullptr;
+    for (; iter.getCurrent(elem) && elem->seqNum <= upperBound; iter.gotoNext()) {
+      if (!elem->hasPreparedCertificate) continue;
+
+      SlowElem slow{elem};
+      vector<SlowElem>& signatures = certificates[{slow.seqNum(), slow.certificateView(), slow.prePrepreDigest()}];
+      const bool knownSignature = std::any_of(signatures.begin(), signatures.end(), [&slow](const SlowElem& other) {
+        return (other.certificateSigLength() == slow.certificateSigLength()) &&
+               (memcmp(other.certificateSig(), slow.certificateSig(), slow.certificateSigLength()) == 0);
+      });
+      if (!knownSignature) signatures.push_back(slow);
+    }
+  }
+
+  // verify in parallel (the verifiers are fetched here, as CryptoManager is not thread safe)
+  vector<std::pair<const CertificateKey*, std::future<bool>>> verifications;
+  for (const auto& [key, signatures] : certificates) {
+    std::shared_ptr<IThresholdVerifier> verifier =
+        CryptoManager::instance().thresholdVerifierForSlowPathCommit(key.seqNum);
+    Digest d;
+    Digest::calcCombination(key.digest, key.view, key.seqNum, d);
+    for (const SlowElem& slow : signatures) {
+      verifications.emplace_back(&key, certificatesVerificationPool.async([verifier, d, slow]() {
+        return verifier->verify(d.content(), DIGEST_SIZE, slow.certificateSig(), slow.certificateSigLength());
+      }));
+    }
+  }
+
+  // wait for all the verifications, as they point into the messages
+  VerifiedCertificates verifiedCertificates;
+  for (auto& [key, verification] : verifications) {
+    const bool valid = verification.get();
+    bool& certificateValid = verifiedCertificates[*key];
+    certificateValid = certificateValid || valid;
+  }
+
+  LOG_DEBUG(GL, "Verified prepared certificates: " << KVLOG(certificates.size(), verifications.size()));
+  return verifiedCertificates;
+}
+
 void ViewChangeSafetyLogic::computeRestrictions(ViewChangeMsg** const inViewChangeMsgsOfCurrentView,
                                                 const SeqNum inLBStableForView,
                                                 SeqNum& outMinRestrictedSeqNum,
@@ -179,6 +239,9 @@ void ViewChangeSafetyLogic::computeRestrictions(ViewChangeMsg** const inViewChan
 
   SeqNum lastRestcitionNum = 0;
 
+  const VerifiedCertificates verifiedCertificates =
+      verifyPreparedCertificates(inViewChangeMsgsOfCurrentView, lowerBound, upperBound);
+
   // TODO(GG): optimize the restricted range (e.g., add lastPrepared to each VC - the max of all VC msgs can be used as
   // a better upper bound)
 
@@ -209,7 +272,7 @@ void ViewChangeSafetyLogic::computeRestrictions(ViewChangeMsg** const inViewChan
   for (; currSeqNum <= upperBound && !VCIterators.empty(); currSeqNum++) {
     Restriction& r = outSafetyRestrictionsArray[currSeqNum - lowerBound];
 
-    bool hasRest = computeRestrictionsForSeqNum(currSeqNum, VCIterators, upperBound, r.digest);
+    bool hasRest = computeRestrictionsForSeqNum(currSeqNum, VCIterators, upperBound, verifiedCertificates, r.digest);
 
     if (hasRest && (r.digest != nullDigest)) {
       lastRestcitionNum = currSeqNum;
@@ -247,6 +310,7 @@ void ViewChangeSafetyLogic::computeRestrictions(ViewChangeMsg** const inViewChan
 bool ViewChangeSafetyLogic::computeRestrictionsForSeqNum(SeqNum s,
                                                          vector<ViewChangeMsg::ElementsIterator*>& VCIterators,
                                                          const SeqNum upperBound,
+                                                         const VerifiedCertificates& verifiedCertificates,
                                                          Digest& outRestrictedDigest) const {
   ConcordAssert(!VCIterators.empty());
   ConcordAssert(s <= upperBound);
@@ -277,11 +341,7 @@ bool ViewChangeSafetyLogic::computeRestrictionsForSeqNum(SeqNum s,
 
   for (SlowElem slow : slowPathCertificates) {
     ConcordAssert(s == slow.seqNum());
-    Digest d;
-    Digest::calcCombination(slow.prePrepreDigest(), slow.certificateView(), slow.seqNum(), d);
-
-    bool valid = CryptoManager::instance().thresholdVerifierForSlowPathCommit(s)->verify(
-        d.content(), DIGEST_SIZE, slow.certificateSig(), slow.certificateSigLength());
+    const bool valid = verifiedCertificates.at({s, slow.certificateView(), slow.prePrepreDigest()});
 
     if (valid) {
       selectedSlow = slow;
@@ -12,8 +12,10 @@
 #pragma once
 
 #include "messages/ViewChangeMsg.hpp"
+#include <map>
 #include <vector>
 #include "threshsign/IThresholdVerifier.h"
+#include "thread_pool.hpp"
 
 using std::vector;
 
@@ -45,9 +47,28 @@ class ViewChangeSafetyLogic {
   // restrictions between outMinRestrictedSeqNum and outMaxRestrictedSeqNum
 
  protected:
+  // Identifies a prepared certificate: replicas that report the same certificate report the same key
+  struct CertificateKey {
+    SeqNum seqNum;
+    ViewNum view;
+    Digest digest;
+
+    bool operator<(const CertificateKey& other) const;
+  };
+
+  // Validity of each prepared certificate in the view change messages
+  using VerifiedCertificates = std::map<CertificateKey, bool>;
+
+  // Verifies the prepared certificates of the sequence numbers in [lowerBound, upperBound] in parallel. Each
+  // certificate is verified once, no matter how many replicas report it.
+  VerifiedCertificates verifyPreparedCertificates(ViewChangeMsg** const inViewChangeMsgsOfCurrentView,
+                                                  const SeqNum lowerBound,
+                                                  const SeqNum upperBound) const;
+
   bool computeRestrictionsForSeqNum(SeqNum s,
                                     vector<ViewChangeMsg::ElementsIterator*>& VCIterators,
                                     const SeqNum upperBound,
+                                    const VerifiedCertificates& verifiedCertificates,
                                     Digest& outRestrictedDigest) const;
 
   const uint16_t N;  // number of replicas
@@ -57,6 +78,8 @@ class ViewChangeSafetyLogic {
   std::shared_ptr<IThresholdVerifier> preparedCertVerifier;
 
   const Digest nullDigest;
+
+  mutable concord::util::ThreadPool certificatesVerificationPool;
 };
 
 }  // namespace impl
@@ -40,6 +40,7 @@ class MsgCode {
     ReqMissingData,
     StateTransfer,
     ReplicaAsksToLeaveView,
+    ReqMissingClientRequests,
 
     ClientPreProcessRequest = 500,
     PreProcessRequest,
@@ -114,6 +115,9 @@ inline std::ostream& operator<<(std::ostream& os, const MsgCode::Type& c) {
     case MsgCode::ReplicaAsksToLeaveView:
       os << "ReplicaAsksToLeaveView";
       break;
+    case MsgCode::ReqMissingClientRequests:
+      os << "ReqMissingClientRequests";
+      break;
     case MsgCode::ClientPreProcessRequest:
       os << "ClientPreProcessRequest";
       break;
@@ -30,6 +30,77 @@ static Digest nullDigest(0x18);
 
 const Digest& PrePrepareMsg::digestOfNullPrePrepareMsg() { return nullDigest; }
 
+static constexpr uint16_t kDigestsOnlyFlag = 0x10;
+
+Digest PrePrepareMsg::digestOfRequest(const char* pRequest, uint32_t requestSize) {
+  Digest d;
+  DigestUtil::compute(pRequest, requestSize, (char*)&d, sizeof(Digest));
+  return d;
+}
+
+PrePrepareMsg* PrePrepareMsg::createDigestsOnlyMsg(const PrePrepareMsg& fullMsg) {
+  ConcordAssert(fullMsg.isReady());
+  ConcordAssert(!fullMsg.isNull());
+  ConcordAssert(!fullMsg.isDigestsOnly());
+
+  auto* msg = new PrePrepareMsg(fullMsg.senderId(),
+                                fullMsg.viewNumber(),
+                                fullMsg.seqNumber(),
+                                fullMsg.firstPath(),
+                                fullMsg.spanContext<PrePrepareMsg>(),
+                                fullMsg.getCid(),
+                                fullMsg.numberOfRequests() * sizeof(RequestDigest));
+  RequestsIterator it(&fullMsg);
+  char* requestBody = nullptr;
+  while (it.getAndGoToNext(requestBody)) {
+    ClientRequestMsg req((ClientRequestMsgHeader*)requestBody);
+    RequestDigest entry;
+    entry.clientId = req.clientProxyId();
+    entry.reqSeqNum = req.requestSeqNum();
+    entry.digest = digestOfRequest(req.body(), req.size());
+    ConcordAssert(msg->remainingSizeForRequests() >= sizeof(RequestDigest));
+    memcpy(msg->body() + msg->b()->endLocationOfLastRequest, &entry, sizeof(RequestDigest));
+    msg->b()->endLocationOfLastRequest += sizeof(RequestDigest);
+    msg->b()->numberOfRequests++;
+  }
+  msg->b()->flags |= (0x2 | kDigestsOnlyFlag);
+  msg->b()->digestOfRequests = fullMsg.digestOfRequests();
+  msg->setMsgSize(msg->b()->endLocationOfLastRequest);
+  msg->shrinkToFit();
+  return msg;
+}
+
+PrePrepareMsg* PrePrepareMsg::createFromDigestsOnlyMsg(const PrePrepareMsg& digestsOnlyMsg,
+                                                       const std::vector<const char*>& requests) {
+  ConcordAssert(digestsOnlyMsg.isDigestsOnly());
+  ConcordAssertEQ(requests.size(), digestsOnlyMsg.numberOfRequests());
+
+  uint32_t requestsSize = 0;
+  for (const auto* request : requests) requestsSize += getRequestSizeTemp(request);
+
+  auto* msg = new PrePrepareMsg(digestsOnlyMsg.senderId(),
+                                digestsOnlyMsg.viewNumber(),
+                                digestsOnlyMsg.seqNumber(),
+                                digestsOnlyMsg.firstPath(),
+                                digestsOnlyMsg.spanContext<PrePrepareMsg>(),
+                                digestsOnlyMsg.getCid(),
+                                requestsSize);
+  for (const auto* request : requests) {
+    const uint32_t requestSize = getRequestSizeTemp(request);
+    if (requestSize > msg->remainingSizeForRequests()) {
+      delete msg;
+      return nullptr;
+    }
+    msg->addRequest(request, requestSize);
+  }
+  msg->finishAddingRequests();
+  if (msg->digestOfRequests() != digestsOnlyMsg.digestOfRequests()) {
+    delete msg;
+    return nullptr;
+  }
+  return msg;
+}
+
 void PrePrepareMsg::validate(const ReplicasInfo& repInfo) const {
   ConcordAssert(senderId() != repInfo.myId());
 
@@ -44,17 +115,21 @@ void PrePrepareMsg::validate(const ReplicasInfo& repInfo) const {
   const bool isNull = ((flags & 0x1) == 0);
   const bool isReady = (((flags >> 1) & 0x1) == 1);
   const uint16_t firstPath_ = ((flags >> 2) & 0x3);
-  const uint16_t reservedBits = (flags >> 4);
+  const uint16_t reservedBits = (flags >> 5);
 
   if (b()->seqNum == 0 || isNull ||  // we don't send null requests
       !isReady ||                    // not ready
       firstPath_ >= 3 ||             // invalid first path
       ((firstPath() == CommitPath::FAST_WITH_THRESHOLD) && (repInfo.cVal() == 0)) || reservedBits != 0 ||
       b()->endLocationOfLastRequest > size() || b()->numberOfRequests == 0 ||
-      b()->numberOfRequests >= b()->endLocationOfLastRequest || !checkRequests()) {
+      b()->numberOfRequests >= b()->endLocationOfLastRequest ||
+      !(isDigestsOnly() ? checkRequestDigests() : checkRequests())) {
     throw std::runtime_error(__PRETTY_FUNCTION__ + std::string(": advanced"));
   }
 
+  // the digest of a digests-only message is verified when the full message is rebuilt
+  if (isDigestsOnly()) return;
+
   // digest
   Digest d;
   const char* requestBuffer = (char*)&(b()->numberOfRequests);
@@ -222,6 +297,15 @@ bool PrePrepareMsg::checkRequests() const {
   ConcordAssert(false);
   return false;
 }
+bool PrePrepareMsg::checkRequestDigests() const {
+  return (b()->endLocationOfLastRequest == payloadShift() + b()->numberOfRequests * sizeof(RequestDigest));
+}
+
+const PrePrepareMsg::RequestDigest* PrePrepareMsg::requestDigests() const {
+  ConcordAssert(isDigestsOnly());
+  return reinterpret_cast<const RequestDigest*>(body() + payloadShift());
+}
+
 const std::string PrePrepareMsg::getClientCorrelationIdForMsg(int index) const {
   auto it = RequestsIterator(this);
   int req_num = 0;
@@ -256,6 +340,7 @@ uint32_t PrePrepareMsg::payloadShift() const {
 
 RequestsIterator::RequestsIterator(const PrePrepareMsg* const m) : msg{m}, currLoc{m->payloadShift()} {
   ConcordAssert(msg->isReady());
+  ConcordAssert(!msg->isDigestsOnly());
 }
 
 void RequestsIterator::restart() { currLoc = msg->payloadShift(); }
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "PrimitiveTypes.hpp"
 #include "assertUtils.hpp"
@@ -44,7 +45,9 @@ class PrePrepareMsg : public MessageBase {
     // bit 0: 0=null , 1=non-null
     // bit 1: 0=not ready , 1=ready
     // bits 2-3: represent the first commit path that should be tried (00 = OPTIMISTIC_FAST, 01 = FAST_WITH_THRESHOLD,
-    // 10 = SLOW) bits 4-15: zero
+    // 10 = SLOW)
+    // bit 4: 0=requests , 1=digests of requests (see RequestDigest)
+    // bits 5-15: zero
   };
 #pragma pack(pop)
   static_assert(sizeof(Header) == (6 + 8 + 8 + 2 + DIGEST_SIZE + 2 + 4 + 8), "Header is 70B");
@@ -53,10 +56,30 @@ class PrePrepareMsg : public MessageBase {
       sizeof(Header) - sizeof(Header::numberOfRequests) - sizeof(Header::endLocationOfLastRequest);
 
  public:
+#pragma pack(push, 1)
+  // In a digests-only message, identifies a request whose body is delivered to the replicas separately
+  struct RequestDigest {
+    NodeIdType clientId;
+    ReqId reqSeqNum;
+    Digest digest;
+  };
+#pragma pack(pop)
+
   // static
 
   static const Digest& digestOfNullPrePrepareMsg();
 
+  static Digest digestOfRequest(const char* pRequest, uint32_t requestSize);
+
+  // Creates a copy of a ready message in which each request is replaced by its RequestDigest. digestOfRequests() is
+  // the one of the full message.
+  static PrePrepareMsg* createDigestsOnlyMsg(const PrePrepareMsg& fullMsg);
+
+  // Rebuilds the full message from a digests-only message and the bodies of its requests (in order).
+  // Returns nullptr if the bodies don't match digestOfRequests().
+  static PrePrepareMsg* createFromDigestsOnlyMsg(const PrePrepareMsg& digestsOnlyMsg,
+                                                 const std::vector<const char*>& requests);
+
   void validate(const ReplicasInfo&) const override;
 
   // size - total size of all requests that will be added
@@ -103,6 +126,11 @@ class PrePrepareMsg : public MessageBase {
 
   uint16_t numberOfRequests() const { return b()->numberOfRequests; }
 
+  bool isDigestsOnly() const { return (((b()->flags >> 4) & 0x1) == 1); }
+
+  // numberOfRequests() entries; only for digests-only messages
+  const RequestDigest* requestDigests() const;
+
   // update view and first path
 
   void updateView(ViewNum v, CommitPath firstPath = CommitPath::SLOW);
@@ -116,6 +144,8 @@ class PrePrepareMsg : public MessageBase {
 
   bool checkRequests() const;
 
+  bool checkRequestDigests() const;
+
   Header* b() const { return (Header*)msgBody_; }
 
   uint32_t payloadShift() const;
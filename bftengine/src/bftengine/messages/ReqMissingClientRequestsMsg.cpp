@@ -0,0 +1,47 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "ReqMissingClientRequestsMsg.hpp"
+#include <cstring>
+#include "assertUtils.hpp"
+
+namespace bftEngine {
+namespace impl {
+
+ReqMissingClientRequestsMsg::ReqMissingClientRequestsMsg(ReplicaId senderId,
+                                                         ViewNum v,
+                                                         SeqNum s,
+                                                         const std::vector<RequestDigest>& missingRequests,
+                                                         const concordUtils::SpanContext& spanContext)
+    : MessageBase(senderId,
+                  MsgCode::ReqMissingClientRequests,
+                  spanContext.data().size(),
+                  sizeof(Header) + missingRequests.size() * sizeof(RequestDigest)) {
+  ConcordAssertGT(missingRequests.size(), 0);
+  ConcordAssertLE(missingRequests.size(), UINT16_MAX);
+  b()->viewNum = v;
+  b()->seqNum = s;
+  b()->numberOfRequests = static_cast<uint16_t>(missingRequests.size());
+  char* position = body() + sizeof(Header);
+  std::memcpy(position, spanContext.data().data(), spanContext.data().size());
+  position += spanContext.data().size();
+  std::memcpy(position, missingRequests.data(), missingRequests.size() * sizeof(RequestDigest));
+}
+
+void ReqMissingClientRequestsMsg::validate(const ReplicasInfo& repInfo) const {
+  if (size() < sizeof(Header) + spanContextSize() || senderId() == repInfo.myId() ||
+      !repInfo.isIdOfReplica(senderId()) || b()->numberOfRequests == 0 ||
+      size() != sizeof(Header) + spanContextSize() + b()->numberOfRequests * sizeof(RequestDigest))
+    throw std::runtime_error(__PRETTY_FUNCTION__);
+}
+
+}  // namespace impl
+}  // namespace bftEngine
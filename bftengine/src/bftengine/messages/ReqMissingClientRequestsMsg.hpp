@@ -0,0 +1,66 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <vector>
+
+#include "MessageBase.hpp"
+#include "PrePrepareMsg.hpp"
+#include "OpenTracing.hpp"
+
+namespace bftEngine {
+namespace impl {
+
+// Sent by a replica that received a digests-only PrePrepareMsg, but is missing the bodies of some of its requests.
+// The receiver answers with the missing requests (as ClientRequestMsg-s).
+class ReqMissingClientRequestsMsg : public MessageBase {
+ public:
+  using RequestDigest = PrePrepareMsg::RequestDigest;
+
+  ReqMissingClientRequestsMsg(ReplicaId senderId,
+                              ViewNum v,
+                              SeqNum s,
+                              const std::vector<RequestDigest>& missingRequests,
+                              const concordUtils::SpanContext& spanContext = concordUtils::SpanContext{});
+
+  BFTENGINE_GEN_CONSTRUCT_FROM_BASE_MESSAGE(ReqMissingClientRequestsMsg)
+
+  ViewNum viewNumber() const { return b()->viewNum; }
+
+  SeqNum seqNumber() const { return b()->seqNum; }
+
+  uint16_t numberOfRequests() const { return b()->numberOfRequests; }
+
+  const RequestDigest* requestDigests() const {
+    return reinterpret_cast<const RequestDigest*>(body() + sizeof(Header) + spanContextSize());
+  }
+
+  void validate(const ReplicasInfo&) const override;
+
+ protected:
+  template <typename MessageT>
+  friend size_t sizeOfHeader();
+
+#pragma pack(push, 1)
+  struct Header : public MessageBase::Header {
+    ViewNum viewNum;
+    SeqNum seqNum;
+    uint16_t numberOfRequests;
+  };
+#pragma pack(pop)
+  static_assert(sizeof(Header) == (6 + 8 + 8 + 2), "Header is 24B");
+
+  Header* b() const { return (Header*)msgBody_; }
+};
+
+}  // namespace impl
+}  // namespace bftEngine
@@ -0,0 +1,94 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#include "PreProcessResultBufferPool.hpp"
+#include "assertUtils.hpp"
+
+namespace preprocessor {
+
+using namespace std;
+
+void PreProcessResultBufferDeleter::operator()(char *buf) const {
+  if (buf) pool_->release(buf, sizeClass_);
+}
+
+PreProcessResultBufferPool::PreProcessResultBufferPool(uint32_t maxBufferSize, uint64_t memoryLimit)
+    : memoryLimit_{memoryLimit} {
+  ConcordAssertGT(maxBufferSize, 0);
+  for (uint32_t size = MIN_BUFFER_SIZE; size < maxBufferSize; size *= 2) classSizes_.push_back(size);
+  classSizes_.push_back(maxBufferSize);
+  freeBuffers_.resize(classSizes_.size());
+}
+
+PreProcessResultBufferPool::~PreProcessResultBufferPool() {
+  ConcordAssertEQ(inUseBytes_, 0);
+  for (auto &buffers : freeBuffers_)
+    for (auto *buf : buffers) delete[] buf;
+}
+
+uint16_t PreProcessResultBufferPool::sizeClassOf(uint32_t size) const {
+  uint16_t sizeClass = 0;
+  while (sizeClass < classSizes_.size() - 1 && classSizes_[sizeClass] < size) sizeClass++;
+  return sizeClass;
+}
+
+PreProcessResultBuffer PreProcessResultBufferPool::acquire(uint32_t size) {
+  const auto sizeClass = sizeClassOf(size);
+  char *buf = nullptr;
+  {
+    lock_guard<mutex> lock(lock_);
+    auto &buffers = freeBuffers_[sizeClass];
+    if (!buffers.empty()) {
+      buf = buffers.back();
+      buffers.pop_back();
+    } else if (reserve(sizeClass)) {
+      allocatedBytes_ += classSizes_[sizeClass];
+    } else {
+      return PreProcessResultBuffer{};
+    }
+    inUseBytes_ += classSizes_[sizeClass];
+  }
+  if (!buf) buf = new char[classSizes_[sizeClass]];
+  return PreProcessResultBuffer{buf, PreProcessResultBufferDeleter{this, sizeClass}};
+}
+
+bool PreProcessResultBufferPool::reserve(uint16_t sizeClass) {
+  if (!memoryLimit_) return true;
+  const auto size = classSizes_[sizeClass];
+  // Deallocate free buffers, largest first, until the new one fits
+  for (auto i = freeBuffers_.size(); i-- > 0 && allocatedBytes_ + size > memoryLimit_;) {
+    auto &buffers = freeBuffers_[i];
+    while (!buffers.empty() && allocatedBytes_ + size > memoryLimit_) {
+      delete[] buffers.back();
+      buffers.pop_back();
+      allocatedBytes_ -= classSizes_[i];
+    }
+  }
+  return allocatedBytes_ + size <= memoryLimit_;
+}
+
+void PreProcessResultBufferPool::release(char *buf, uint16_t sizeClass) {
+  lock_guard<mutex> lock(lock_);
+  freeBuffers_[sizeClass].push_back(buf);
+  inUseBytes_ -= classSizes_[sizeClass];
+}
+
+uint64_t PreProcessResultBufferPool::allocatedBytes() const {
+  lock_guard<mutex> lock(lock_);
+  return allocatedBytes_;
+}
+
+uint64_t PreProcessResultBufferPool::inUseBytes() const {
+  lock_guard<mutex> lock(lock_);
+  return inUseBytes_;
+}
+
+}  // namespace preprocessor
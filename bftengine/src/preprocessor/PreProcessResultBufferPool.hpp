@@ -0,0 +1,78 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace preprocessor {
+
+class PreProcessResultBufferPool;
+
+class PreProcessResultBufferDeleter {
+ public:
+  PreProcessResultBufferDeleter() = default;
+  PreProcessResultBufferDeleter(PreProcessResultBufferPool *pool, uint16_t sizeClass)
+      : pool_{pool}, sizeClass_{sizeClass} {}
+  void operator()(char *buf) const;
+
+ private:
+  PreProcessResultBufferPool *pool_ = nullptr;
+  uint16_t sizeClass_ = 0;
+};
+
+// Returned to the pool on destruction
+typedef std::unique_ptr<char[], PreProcessResultBufferDeleter> PreProcessResultBuffer;
+
+// Buffers for the pre-execution results, allocated on demand.
+// The buffer sizes are powers of 2 from MIN_BUFFER_SIZE up to the maximal result size. Released buffers are kept for
+// reuse. The total size of the allocated buffers is limited by memoryLimit (0 - unlimited); free buffers of other
+// sizes get deallocated to make room for a new buffer.
+// Thread safe. The pool has to outlive its buffers.
+class PreProcessResultBufferPool {
+ public:
+  static constexpr uint32_t MIN_BUFFER_SIZE = 1024;
+
+  PreProcessResultBufferPool(uint32_t maxBufferSize, uint64_t memoryLimit);
+  ~PreProcessResultBufferPool();
+  PreProcessResultBufferPool(const PreProcessResultBufferPool &) = delete;
+  PreProcessResultBufferPool &operator=(const PreProcessResultBufferPool &) = delete;
+
+  // Returns a buffer of at least `size` bytes (and at most maxBufferSize), or an empty one if the memory limit
+  // doesn't allow it.
+  PreProcessResultBuffer acquire(uint32_t size);
+
+  // The size of the buffer acquire(size) returns
+  uint32_t bufferSize(uint32_t size) const { return classSizes_[sizeClassOf(size)]; }
+
+  uint64_t allocatedBytes() const;
+  uint64_t inUseBytes() const;
+
+ private:
+  friend class PreProcessResultBufferDeleter;
+
+  uint16_t sizeClassOf(uint32_t size) const;
+  void release(char *buf, uint16_t sizeClass);
+  // Should be called under lock_
+  bool reserve(uint16_t sizeClass);
+
+  const uint64_t memoryLimit_;
+  std::vector<uint32_t> classSizes_;
+  mutable std::mutex lock_;
+  std::vector<std::vector<char *>> freeBuffers_;  // per size class
+  uint64_t allocatedBytes_ = 0;
+  uint64_t inUseBytes_ = 0;
+};
+
+}  // namespace preprocessor
@@ -89,27 +89,33 @@ PreProcessor::PreProcessor(shared_ptr<MsgsCommunicator> &msgsCommunicator,
       numOfInternalClients_(myReplica.getReplicaConfig().numOfClientProxies),
       clientBatchingEnabled_(myReplica.getReplicaConfig().clientBatchingEnabled),
       clientMaxBatchSize_(clientBatchingEnabled_ ? myReplica.getReplicaConfig().clientBatchingMaxMsgsNbr : 1),
+      resultBufferPool_(maxPreExecResultSize_, myReplica.getReplicaConfig().preExecResultBuffersMemoryLimit),
       metricsComponent_{concordMetrics::Component("preProcessor", std::make_shared<concordMetrics::Aggregator>())},
       metricsLastDumpTime_(0),
       metricsDumpIntervalInSec_{myReplica_.getReplicaConfig().metricsDumpIntervalSeconds},
       preProcessorMetrics_{metricsComponent_.RegisterAtomicCounter("preProcReqReceived"),
-                           metricsComponent_.RegisterCounter("preProcBatchReqReceived"),
-                           metricsComponent_.RegisterCounter("preProcReqInvalid"),
+                           metricsComponent_.RegisterAtomicCounter("preProcBatchReqReceived"),
+                           metricsComponent_.RegisterAtomicCounter("preProcReqInvalid"),
                            metricsComponent_.RegisterAtomicCounter("preProcReqIgnored"),
                            metricsComponent_.RegisterAtomicCounter("preProcReqRejected"),
-                           metricsComponent_.RegisterCounter("preProcConsensusNotReached"),
+                           metricsComponent_.RegisterAtomicCounter("preProcConsensusNotReached"),
                            metricsComponent_.RegisterCounter("preProcessRequestTimedOut"),
                            metricsComponent_.RegisterCounter("preProcPossiblePrimaryFaultDetected"),
-                           metricsComponent_.RegisterCounter("preProcReqCompleted"),
-                           metricsComponent_.RegisterCounter("preProcReqRetried"),
+                           metricsComponent_.RegisterAtomicCounter("preProcReqCompleted"),
+                           metricsComponent_.RegisterAtomicCounter("preProcReqRetried"),
                            metricsComponent_.RegisterAtomicGauge("preProcessingTimeAvg", 0),
-                           metricsComponent_.RegisterAtomicGauge("PreProcInFlyRequestsNum", 0)},
+                           metricsComponent_.RegisterAtomicGauge("PreProcInFlyRequestsNum", 0),
+                           metricsComponent_.RegisterGauge("preProcResultBuffersAllocatedBytes", 0),
+                           metricsComponent_.RegisterGauge("preProcResultBuffersInUseBytes", 0),
+                           metricsComponent_.RegisterAtomicCounter("preProcResultBuffersExhausted")},
       totalPreProcessingTime_(true),
       preExecReqStatusCheckPeriodMilli_(myReplica_.getReplicaConfig().preExecReqStatusCheckTimerMillisec),
       timers_{timers},
       recorder_{histograms_.totalPreExecutionDuration},
       lastViewNum_(myReplica.getCurrentView()),
       pm_{pm} {
+  const uint16_t numOfMsgShards = max<uint16_t>(myReplica.getReplicaConfig().preExecMsgProcessingShards, 1);
+  for (uint16_t i = 0; i < numOfMsgShards; i++) msgShards_.push_back(make_unique<MsgShard>());
   registerMsgHandlers();
   metricsComponent_.Register();
   const uint16_t numOfExternalClients = myReplica.getReplicaConfig().numOfExternalClients;
@@ -118,19 +124,17 @@ PreProcessor::PreProcessor(shared_ptr<MsgsCommunicator> &msgsCommunicator,
   for (uint16_t i = 0; i < numOfReqEntries; i++) {
     // Placeholders for all clients including batches
     ongoingRequests_[firstClientRequestId + i] = make_shared<RequestState>();
-    // Allocate a buffer for the pre-execution result per client * batch
-    preProcessResultBuffers_.push_back(Sliver(new char[maxPreExecResultSize_], maxPreExecResultSize_));
   }
   RequestState::reqProcessingHistoryHeight *= clientMaxBatchSize_;
   uint64_t numOfThreads = myReplica.getReplicaConfig().preExecConcurrencyLevel;
   if (!numOfThreads) {
     if (myReplica.getReplicaConfig().numOfExternalClients)
-      numOfThreads = myReplica.getReplicaConfig().numOfExternalClients * clientMaxBatchSize_;
+      numOfThreads = min<uint64_t>(max(thread::hardware_concurrency(), 1u), numOfReqEntries);
     else  // For testing purpose
       numOfThreads = myReplica.getReplicaConfig().numOfClientProxies / numOfReplicas_;
   }
   threadPool_.start(numOfThreads);
-  msgLoopThread_ = std::thread{&PreProcessor::msgProcessingLoop, this};
+  for (auto &shard : msgShards_) shard->thread = std::thread{&PreProcessor::msgProcessingLoop, this, std::ref(*shard)};
   LOG_INFO(logger(),
            KVLOG(numOfReplicas_,
                  numOfExternalClients,
@@ -140,18 +144,23 @@ PreProcessor::PreProcessor(shared_ptr<MsgsCommunicator> &msgsCommunicator,
                  clientBatchingEnabled_,
                  clientMaxBatchSize_,
                  maxPreExecResultSize_,
+                 myReplica.getReplicaConfig().preExecResultBuffersMemoryLimit,
                  preExecReqStatusCheckPeriodMilli_,
-                 numOfThreads));
+                 numOfThreads,
+                 numOfMsgShards));
   RequestProcessingState::init(numOfRequiredReplies(), &histograms_);
   addTimers();
 }
 
 PreProcessor::~PreProcessor() {
   msgLoopDone_ = true;
-  msgLoopSignal_.notify_all();
+  for (auto &shard : msgShards_) shard->signal.notify_all();
   cancelTimers();
   threadPool_.stop();
-  if (msgLoopThread_.joinable()) msgLoopThread_.join();
+  for (auto &shard : msgShards_) {
+    if (shard->thread.joinable()) shard->thread.join();
+    shard->msgs.consume_all([](MessageBase *msg) { delete msg; });
+  }
 }
 
 void PreProcessor::addTimers() {
@@ -265,6 +274,8 @@ bool PreProcessor::checkClientBatchMsgCorrectness(const ClientBatchRequestMsgUni
 }
 
 void PreProcessor::updateAggregatorAndDumpMetrics() {
+  preProcessorMetrics_.preProcResultBuffersAllocatedBytes.Get().Set(resultBufferPool_.allocatedBytes());
+  preProcessorMetrics_.preProcResultBuffersInUseBytes.Get().Set(resultBufferPool_.inUseBytes());
   metricsComponent_.UpdateAggregator();
   auto currTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch());
   if (currTime - metricsLastDumpTime_ >= metricsDumpIntervalInSec_) {
@@ -308,7 +319,7 @@ void PreProcessor::sendRejectPreProcessReplyMsg(NodeIdType clientId,
                                                 const string &ongoingCid) {
   auto replyMsg =
       make_shared<PreProcessReplyMsg>(&histograms_, myReplicaId_, clientId, reqOffsetInBatch, reqSeqNum, reqRetryId);
-  replyMsg->setupMsgBody(getPreProcessResultBuffer(clientId, reqSeqNum, reqOffsetInBatch), 0, cid, STATUS_REJECT);
+  replyMsg->setupMsgBody(nullptr, 0, cid, STATUS_REJECT);
   LOG_DEBUG(
       logger(),
       KVLOG(reqSeqNum, senderId, clientId, reqOffsetInBatch, ongoingReqSeqNum, ongoingCid)
@@ -587,72 +598,73 @@ void PreProcessor::onMessage<PreProcessReplyMsg>(PreProcessReplyMsg *msg) {
   handlePreProcessReplyMsg(cid, result, clientId, reqOffsetInBatch, reqSeqNum);
 }
 
-template <typename T>
-void PreProcessor::messageHandler(MessageBase *msg) {
-  if (!msgs_.write_available()) {
-    LOG_ERROR(logger(), "PreProcessor queue is full, returning message");
+void PreProcessor::pushToMsgShard(uint16_t clientId, MessageBase *msg) {
+  auto &shard = msgShardOf(clientId);
+  if (!shard.msgs.push(msg)) {
+    LOG_ERROR(logger(), "PreProcessor queue is full, returning message" << KVLOG(clientId));
     incomingMsgsStorage_->pushExternalMsg(std::unique_ptr<MessageBase>(msg));
     return;
   }
+  shard.signal.notify_one();
+}
+
+template <typename T>
+void PreProcessor::messageHandler(MessageBase *msg) {
   T *trueTypeObj = new T(msg);
   delete msg;
-  msgs_.push(trueTypeObj);
-  msgLoopSignal_.notify_one();
+  if constexpr (std::is_same_v<T, ClientPreProcessRequestMsg>)
+    pushToMsgShard(trueTypeObj->clientProxyId(), trueTypeObj);
+  else
+    pushToMsgShard(trueTypeObj->clientId(), trueTypeObj);
 }
 
 template <>
 void PreProcessor::messageHandler<PreProcessReplyMsg>(MessageBase *msg) {
-  if (!msgs_.write_available()) {
-    LOG_ERROR(logger(), "PreProcessor queue is full, returning message");
-    incomingMsgsStorage_->pushExternalMsg(std::unique_ptr<MessageBase>(msg));
-    return;
-  }
   PreProcessReplyMsg *trueTypeObj = new PreProcessReplyMsg(msg);
   trueTypeObj->setPreProcessorHistograms(&histograms_);
   delete msg;
-  msgs_.push(trueTypeObj);
-  msgLoopSignal_.notify_one();
+  pushToMsgShard(trueTypeObj->clientId(), trueTypeObj);
 }
 
-void PreProcessor::msgProcessingLoop() {
+void PreProcessor::msgProcessingLoop(MsgShard &shard) {
   while (!msgLoopDone_) {
     {
-      std::unique_lock<std::mutex> l(msgLock_);
-      while (!msgLoopDone_ && !msgs_.read_available()) {
-        msgLoopSignal_.wait_until(l, chrono::steady_clock::now() + std::chrono::milliseconds(WAIT_TIMEOUT_MILLI));
+      std::unique_lock<std::mutex> l(shard.lock);
+      while (!msgLoopDone_ && !shard.msgs.read_available()) {
+        shard.signal.wait_until(l, chrono::steady_clock::now() + std::chrono::milliseconds(WAIT_TIMEOUT_MILLI));
       }
     }
 
-    while (!msgLoopDone_ && msgs_.read_available()) {
-      auto msg = msgs_.front();
-      msgs_.pop();
-      if (validateMessage(msg)) {
-        switch (msg->type()) {
-          case (MsgCode::ClientBatchRequest): {
-            onMessage<ClientBatchRequestMsg>(static_cast<ClientBatchRequestMsg *>(msg));
-            break;
-          }
-          case (MsgCode::ClientPreProcessRequest): {
-            onMessage<ClientPreProcessRequestMsg>(static_cast<ClientPreProcessRequestMsg *>(msg));
-            break;
-          }
-          case (MsgCode::PreProcessRequest): {
-            onMessage<PreProcessRequestMsg>(static_cast<PreProcessRequestMsg *>(msg));
-            break;
-          }
-          case (MsgCode::PreProcessReply): {
-            onMessage<PreProcessReplyMsg>(static_cast<PreProcessReplyMsg *>(msg));
-            break;
-          }
-          default:
-            LOG_ERROR(logger(), "Unknown message" << KVLOG(msg->type()));
-        }
-
-      } else {
-        preProcessorMetrics_.preProcReqInvalid.Get().Inc();
-        delete msg;
+    MessageBase *msg = nullptr;
+    while (!msgLoopDone_ && shard.msgs.pop(msg)) handleMsg(msg);
+  }
+}
+
+void PreProcessor::handleMsg(MessageBase *msg) {
+  if (validateMessage(msg)) {
+    switch (msg->type()) {
+      case (MsgCode::ClientBatchRequest): {
+        onMessage<ClientBatchRequestMsg>(static_cast<ClientBatchRequestMsg *>(msg));
+        break;
       }
+      case (MsgCode::ClientPreProcessRequest): {
+        onMessage<ClientPreProcessRequestMsg>(static_cast<ClientPreProcessRequestMsg *>(msg));
+        break;
+      }
+      case (MsgCode::PreProcessRequest): {
+        onMessage<PreProcessRequestMsg>(static_cast<PreProcessRequestMsg *>(msg));
+        break;
+      }
+      case (MsgCode::PreProcessReply): {
+        onMessage<PreProcessReplyMsg>(static_cast<PreProcessReplyMsg *>(msg));
+        break;
+      }
+      default:
+        LOG_ERROR(logger(), "Unknown message" << KVLOG(msg->type()));
     }
+  } else {
+    preProcessorMetrics_.preProcReqInvalid.Get().Inc();
+    delete msg;
   }
 }
 
@@ -823,6 +835,7 @@ void PreProcessor::releaseClientPreProcessRequestSafe(uint16_t clientId,
 void PreProcessor::releaseClientPreProcessRequest(const RequestStateSharedPtr &reqEntry, PreProcessingResult result) {
   auto &givenReq = reqEntry->reqProcessingStatePtr;
   if (givenReq) {
+    reqEntry->primaryResultBuffer.reset();
     const auto &clientId = givenReq->getClientId();
     const auto &reqOffsetInBatch = givenReq->getReqOffsetInBatch();
     SeqNum reqSeqNum = givenReq->getReqSeqNum();
@@ -942,21 +955,6 @@ void PreProcessor::registerAndHandleClientPreProcessReqOnNonPrimary(ClientPrePro
   }
 }
 
-const char *PreProcessor::getPreProcessResultBuffer(uint16_t clientId,
-                                                    ReqId reqSeqNum,
-                                                    uint16_t reqOffsetInBatch) const {
-  // Pre-allocated buffers scheme:
-  // |first client's first buffer|...|first client's last buffer|......
-  // |last client's first buffer|...|last client's last buffer|
-  // First client id starts after the last replica id.
-  // First buffer offset = numOfReplicas_ * batchSize_
-  // The number of buffers per client comes from the configuration parameter clientBatchingMaxMsgsNbr.
-  const auto bufferOffset =
-      (clientId - numOfReplicas_ - numOfInternalClients_) * clientMaxBatchSize_ + reqOffsetInBatch;
-  LOG_TRACE(logger(), KVLOG(clientId, reqSeqNum, reqOffsetInBatch, bufferOffset));
-  return preProcessResultBuffers_[bufferOffset].data();
-}
-
 const uint16_t PreProcessor::getOngoingReqIndex(uint16_t clientId, uint16_t reqOffsetInBatch) const {
   // Index for ongoing requests starts from the first_client_id * batchSize_, e.g 28 * 10 = 280 (not from 0)
   const auto ongoingReqIndex = clientId * clientMaxBatchSize_ + reqOffsetInBatch;
@@ -1002,6 +1000,7 @@ uint32_t PreProcessor::launchReqPreProcessing(uint16_t clientId,
                                               ReqId reqSeqNum,
                                               uint32_t reqLength,
                                               char *reqBuf,
+                                              char *resultBuf,
                                               const concordUtils::SpanContext &span_context) {
   concord::diagnostics::TimeRecorder scoped_timer(*histograms_.launchReqPreProcessing);
   // Unused for now. Replica Specific Info not currently supported in pre-execution.
@@ -1017,7 +1016,7 @@ uint32_t PreProcessor::launchReqPreProcessing(uint16_t clientId,
       reqLength,
       reqBuf,
       maxPreExecResultSize_,
-      (char *)getPreProcessResultBuffer(clientId, reqSeqNum, reqOffsetInBatch)});
+      resultBuf});
   requestsHandler_.execute(accumulatedRequests, cid, span);
   const IRequestsHandler::ExecutionRequest &request = accumulatedRequests.back();
   const auto status = request.outExecutionStatus;
@@ -1040,13 +1039,20 @@ ReqId PreProcessor::getOngoingReqIdForClient(uint16_t clientId, uint16_t reqOffs
 
 PreProcessingResult PreProcessor::handlePreProcessedReqByPrimaryAndGetConsensusResult(uint16_t clientId,
                                                                                       uint16_t reqOffsetInBatch,
+                                                                                      PreProcessResultBuffer resultBuf,
                                                                                       uint32_t resultBufLen) {
   const auto &reqEntry = ongoingRequests_[getOngoingReqIndex(clientId, reqOffsetInBatch)];
   lock_guard<mutex> lock(reqEntry->mutex);
   if (reqEntry->reqProcessingStatePtr) {
-    reqEntry->reqProcessingStatePtr->handlePrimaryPreProcessed(
-        getPreProcessResultBuffer(clientId, reqEntry->reqProcessingStatePtr->getReqSeqNum(), reqOffsetInBatch),
-        resultBufLen);
+    // The result is kept until the pre-execution consensus is reached - move it to a buffer of its size
+    if (resultBufferPool_.bufferSize(resultBufLen) < resultBufferPool_.bufferSize(maxPreExecResultSize_)) {
+      if (auto fittingBuf = resultBufferPool_.acquire(resultBufLen)) {
+        memcpy(fittingBuf.get(), resultBuf.get(), resultBufLen);
+        resultBuf = move(fittingBuf);
+      }
+    }
+    reqEntry->primaryResultBuffer = move(resultBuf);
+    reqEntry->reqProcessingStatePtr->handlePrimaryPreProcessed(reqEntry->primaryResultBuffer.get(), resultBufLen);
     return reqEntry->reqProcessingStatePtr->definePreProcessingConsensusResult();
   }
   return NONE;
@@ -1054,8 +1060,10 @@ PreProcessingResult PreProcessor::handlePreProcessedReqByPrimaryAndGetConsensusR
 
 void PreProcessor::handlePreProcessedReqPrimaryRetry(NodeIdType clientId,
                                                      uint16_t reqOffsetInBatch,
+                                                     PreProcessResultBuffer resultBuf,
                                                      uint32_t resultBufLen) {
-  if (handlePreProcessedReqByPrimaryAndGetConsensusResult(clientId, reqOffsetInBatch, resultBufLen) == COMPLETE)
+  if (handlePreProcessedReqByPrimaryAndGetConsensusResult(clientId, reqOffsetInBatch, move(resultBuf), resultBufLen) ==
+      COMPLETE)
     finalizePreProcessing(clientId, reqOffsetInBatch);
   else
     cancelPreProcessing(clientId, reqOffsetInBatch);
@@ -1063,11 +1071,12 @@ void PreProcessor::handlePreProcessedReqPrimaryRetry(NodeIdType clientId,
 
 void PreProcessor::handlePreProcessedReqByPrimary(const PreProcessRequestMsgSharedPtr &preProcessReqMsg,
                                                   uint16_t clientId,
+                                                  PreProcessResultBuffer resultBuf,
                                                   uint32_t resultBufLen) {
   const uint16_t &reqOffsetInBatch = preProcessReqMsg->reqOffsetInBatch();
   concord::diagnostics::TimeRecorder scoped_timer(*histograms_.handlePreProcessedReqByPrimary);
   const PreProcessingResult result =
-      handlePreProcessedReqByPrimaryAndGetConsensusResult(clientId, reqOffsetInBatch, resultBufLen);
+      handlePreProcessedReqByPrimaryAndGetConsensusResult(clientId, reqOffsetInBatch, move(resultBuf), resultBufLen);
   if (result != NONE)
     handlePreProcessReplyMsg(
         preProcessReqMsg->getCid(), result, clientId, reqOffsetInBatch, preProcessReqMsg->reqSeqNum());
@@ -1077,13 +1086,14 @@ void PreProcessor::handlePreProcessedReqByNonPrimary(uint16_t clientId,
                                                      uint16_t reqOffsetInBatch,
                                                      ReqId reqSeqNum,
                                                      uint64_t reqRetryId,
+                                                     const char *resBuf,
                                                      uint32_t resBufLen,
                                                      const std::string &cid) {
   concord::diagnostics::TimeRecorder scoped_timer(*histograms_.handlePreProcessedReqByNonPrimary);
   setPreprocessingRightNow(clientId, reqOffsetInBatch, false);
   auto replyMsg =
       make_shared<PreProcessReplyMsg>(&histograms_, myReplicaId_, clientId, reqOffsetInBatch, reqSeqNum, reqRetryId);
-  replyMsg->setupMsgBody(getPreProcessResultBuffer(clientId, reqSeqNum, reqOffsetInBatch), resBufLen, cid, STATUS_GOOD);
+  replyMsg->setupMsgBody(resBuf, resBufLen, cid, STATUS_GOOD);
   // Release the request before sending a reply to the primary to be able accepting new messages
   releaseClientPreProcessRequestSafe(clientId, reqOffsetInBatch, COMPLETE);
   sendMsg(replyMsg->body(), myReplica_.currentPrimary(), replyMsg->type(), replyMsg->size());
@@ -1100,28 +1110,39 @@ void PreProcessor::handleReqPreProcessingJob(const PreProcessRequestMsgSharedPtr
   const uint16_t &reqOffsetInBatch = preProcessReqMsg->reqOffsetInBatch();
   const SeqNum &reqSeqNum = preProcessReqMsg->reqSeqNum();
   const auto &span_context = preProcessReqMsg->spanContext<PreProcessRequestMsgSharedPtr::element_type>();
+  SCOPED_MDC_CID(cid);
+  auto resultBuf = resultBufferPool_.acquire(maxPreExecResultSize_);
+  if (!resultBuf) {
+    preProcessorMetrics_.preProcResultBuffersExhausted.Get().Inc();
+    LOG_WARN(logger(),
+             "No memory left for the pre-execution result; cancel request"
+                 << KVLOG(reqSeqNum, clientId, reqOffsetInBatch, resultBufferPool_.allocatedBytes()));
+    releaseClientPreProcessRequestSafe(clientId, reqOffsetInBatch, CANCEL);
+    return;
+  }
   uint32_t actualResultBufLen = launchReqPreProcessing(clientId,
                                                        preProcessReqMsg->reqOffsetInBatch(),
                                                        cid,
                                                        reqSeqNum,
                                                        preProcessReqMsg->requestLength(),
                                                        preProcessReqMsg->requestBuf(),
+                                                       resultBuf.get(),
                                                        span_context);
   if (isPrimary && isRetry) {
-    handlePreProcessedReqPrimaryRetry(clientId, reqOffsetInBatch, actualResultBufLen);
+    handlePreProcessedReqPrimaryRetry(clientId, reqOffsetInBatch, move(resultBuf), actualResultBufLen);
     return;
   }
-  SCOPED_MDC_CID(cid);
   LOG_DEBUG(logger(), "Request pre-processed" << KVLOG(isPrimary, reqSeqNum, clientId, reqOffsetInBatch));
   if (isPrimary) {
     pm_->Delay<concord::performance::SlowdownPhase::PreProcessorAfterPreexecPrimary>();
-    handlePreProcessedReqByPrimary(preProcessReqMsg, clientId, actualResultBufLen);
+    handlePreProcessedReqByPrimary(preProcessReqMsg, clientId, move(resultBuf), actualResultBufLen);
   } else {
     pm_->Delay<concord::performance::SlowdownPhase::PreProcessorAfterPreexecNonPrimary>();
     handlePreProcessedReqByNonPrimary(clientId,
                                       reqOffsetInBatch,
                                       reqSeqNum,
                                       preProcessReqMsg->reqRetryId(),
+                                      resultBuf.get(),
                                       actualResultBufLen,
                                       preProcessReqMsg->getCid());
   }
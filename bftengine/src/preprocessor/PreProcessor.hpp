@@ -15,7 +15,7 @@
 #include "messages/ClientBatchRequestMsg.hpp"
 #include "MsgsCommunicator.hpp"
 #include "MsgHandlersRegistrator.hpp"
-#include "SimpleThreadPool.hpp"
+#include "WorkStealingThreadPool.hpp"
 #include "IRequestHandler.hpp"
 #include "Replica.hpp"
 #include "RequestProcessingState.hpp"
@@ -25,6 +25,7 @@
 #include "Timers.hpp"
 #include "InternalReplicaApi.hpp"
 #include "PreProcessorRecorder.hpp"
+#include "PreProcessResultBufferPool.hpp"
 #include "diagnostics.h"
 #include "PerformanceManager.hpp"
 #include <RollingAvgAndVar.hpp>
@@ -44,10 +45,10 @@ struct RequestState {
   std::deque<RequestProcessingStateUniquePtr> reqProcessingHistory;
   // Identity for matching request and reply
   uint64_t reqRetryId = 1;
+  // The pre-execution result of the primary replica, referenced by reqProcessingStatePtr
+  PreProcessResultBuffer primaryResultBuffer;
 };
 
-// Pre-allocated (clientId * dataSize) buffers
-typedef std::vector<concordUtils::Sliver> PreProcessResultBuffers;
 typedef std::shared_ptr<RequestState> RequestStateSharedPtr;
 // (clientId * dataSize + reqOffsetInBatch) -> RequestStateSharedPtr
 typedef std::unordered_map<uint16_t, RequestStateSharedPtr> OngoingReqMap;
@@ -129,7 +130,6 @@ class PreProcessor {
                                       NodeIdType destId,
                                       uint16_t reqOffsetInBatch,
                                       uint64_t reqRetryId);
-  const char *getPreProcessResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch) const;
   const uint16_t getOngoingReqIndex(uint16_t clientId, uint16_t reqOffsetInBatch) const;
   void launchAsyncReqPreProcessingJob(const PreProcessRequestMsgSharedPtr &preProcessReqMsg,
                                       bool isPrimary,
@@ -141,23 +141,30 @@ class PreProcessor {
                                   ReqId reqSeqNum,
                                   uint32_t reqLength,
                                   char *reqBuf,
+                                  char *resultBuf,
                                   const concordUtils::SpanContext &span_context);
   void handleReqPreProcessingJob(const PreProcessRequestMsgSharedPtr &preProcessReqMsg, bool isPrimary, bool isRetry);
   void handlePreProcessedReqByNonPrimary(uint16_t clientId,
                                          uint16_t reqOffsetInBatch,
                                          ReqId reqSeqNum,
                                          uint64_t reqRetryId,
+                                         const char *resBuf,
                                          uint32_t resBufLen,
                                          const std::string &cid);
   void handlePreProcessedReqByPrimary(const PreProcessRequestMsgSharedPtr &preProcessReqMsg,
                                       uint16_t clientId,
+                                      PreProcessResultBuffer resultBuf,
                                       uint32_t resultBufLen);
-  void handlePreProcessedReqPrimaryRetry(NodeIdType clientId, uint16_t reqOffsetInBatch, uint32_t resultBufLen);
+  void handlePreProcessedReqPrimaryRetry(NodeIdType clientId,
+                                         uint16_t reqOffsetInBatch,
+                                         PreProcessResultBuffer resultBuf,
+                                         uint32_t resultBufLen);
   void finalizePreProcessing(NodeIdType clientId, uint16_t reqOffsetInBatch);
   void cancelPreProcessing(NodeIdType clientId, uint16_t reqOffsetInBatch);
   void setPreprocessingRightNow(uint16_t clientId, uint16_t reqOffsetInBatch, bool set);
   PreProcessingResult handlePreProcessedReqByPrimaryAndGetConsensusResult(uint16_t clientId,
                                                                           uint16_t reqOffsetInBatch,
+                                                                          PreProcessResultBuffer resultBuf,
                                                                           uint32_t resultBufLen);
   void handlePreProcessReplyMsg(const std::string &cid,
                                 PreProcessingResult result,
@@ -190,15 +197,24 @@ class PreProcessor {
   }
 
  private:
-  const uint32_t MAX_MSGS = 10000;
+  static constexpr uint32_t MAX_MSGS = 10000;  // per shard
   const uint32_t WAIT_TIMEOUT_MILLI = 100;
-  void msgProcessingLoop();
 
-  boost::lockfree::spsc_queue<MessageBase *> msgs_{MAX_MSGS};
-  std::thread msgLoopThread_;
-  std::mutex msgLock_;
-  std::condition_variable msgLoopSignal_;
-  bool msgLoopDone_ = false;
+  // All the messages of a client are validated and handled, in their arrival order, by the thread of its shard.
+  // Each message queue has a single producer - the thread dispatching the incoming messages.
+  struct MsgShard {
+    boost::lockfree::spsc_queue<MessageBase *> msgs{MAX_MSGS};
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable signal;
+  };
+  MsgShard &msgShardOf(uint16_t clientId) { return *msgShards_[clientId % msgShards_.size()]; }
+  void pushToMsgShard(uint16_t clientId, MessageBase *msg);
+  void msgProcessingLoop(MsgShard &shard);
+  void handleMsg(MessageBase *msg);
+
+  std::vector<std::unique_ptr<MsgShard>> msgShards_;
+  std::atomic_bool msgLoopDone_ = false;
 
   static std::vector<std::shared_ptr<PreProcessor>> preProcessors_;  // The place holder for PreProcessor objects
 
@@ -214,26 +230,29 @@ class PreProcessor {
   const uint16_t numOfInternalClients_;
   const bool clientBatchingEnabled_;
   const uint16_t clientMaxBatchSize_;
-  util::SimpleThreadPool threadPool_;
-  // One-time allocated buffers (one per client) for the pre-execution results storage
-  PreProcessResultBuffers preProcessResultBuffers_;
+  util::WorkStealingThreadPool threadPool_;
+  // Buffers for the pre-execution results, acquired when a pre-execution job starts
+  PreProcessResultBufferPool resultBufferPool_;
   OngoingReqMap ongoingRequests_;  // clientId + reqOffsetInBatch -> RequestStateSharedPtr
   concordMetrics::Component metricsComponent_;
   std::chrono::seconds metricsLastDumpTime_;
   std::chrono::seconds metricsDumpIntervalInSec_;
   struct PreProcessingMetrics {
     concordMetrics::AtomicCounterHandle preProcReqReceived;
-    concordMetrics::CounterHandle preProcBatchReqReceived;
-    concordMetrics::CounterHandle preProcReqInvalid;
+    concordMetrics::AtomicCounterHandle preProcBatchReqReceived;
+    concordMetrics::AtomicCounterHandle preProcReqInvalid;
     concordMetrics::AtomicCounterHandle preProcReqIgnored;
     concordMetrics::AtomicCounterHandle preProcReqRejected;
-    concordMetrics::CounterHandle preProcConsensusNotReached;
+    concordMetrics::AtomicCounterHandle preProcConsensusNotReached;
     concordMetrics::CounterHandle preProcessRequestTimedOut;
     concordMetrics::CounterHandle preProcPossiblePrimaryFaultDetected;
-    concordMetrics::CounterHandle preProcReqCompleted;
-    concordMetrics::CounterHandle preProcReqRetried;
+    concordMetrics::AtomicCounterHandle preProcReqCompleted;
+    concordMetrics::AtomicCounterHandle preProcReqRetried;
     concordMetrics::AtomicGaugeHandle preProcessingTimeAvg;
     concordMetrics::AtomicGaugeHandle preProcInFlyRequestsNum;
+    concordMetrics::GaugeHandle preProcResultBuffersAllocatedBytes;
+    concordMetrics::GaugeHandle preProcResultBuffersInUseBytes;
+    concordMetrics::AtomicCounterHandle preProcResultBuffersExhausted;
   } preProcessorMetrics_;
   bftEngine::impl::RollingAvgAndVar totalPreProcessingTime_;
   concordUtil::Timers::Handle requestsStatusCheckTimer_;
@@ -250,7 +269,7 @@ class PreProcessor {
 
 // This class is used to send messages to other replicas in parallel
 
-class AsyncPreProcessJob : public util::SimpleThreadPool::Job {
+class AsyncPreProcessJob : public util::WorkStealingThreadPool::Job {
  public:
   AsyncPreProcessJob(PreProcessor &preProcessor,
                      const PreProcessRequestMsgSharedPtr &preProcessReqMsg,
@@ -77,6 +77,7 @@ void RequestProcessingState::handlePrimaryPreProcessed(const char *preProcessRes
 void RequestProcessingState::releaseResources() {
   clientPreProcessReqMsg_.reset();
   preProcessRequestMsg_.reset();
+  primaryPreProcessResult_ = nullptr;
 }
 
 void RequestProcessingState::detectNonDeterministicPreProcessing(const SHA3_256::Digest &newHash,
@@ -103,7 +103,7 @@ class RequestProcessingState {
   PreProcessRequestMsgSharedPtr preProcessRequestMsg_;
   uint16_t numOfReceivedReplies_ = 0;
   ReplicaIdsList rejectedReplicaIds_;
-  const char* primaryPreProcessResult_ = nullptr;  // This memory is statically pre-allocated per client in PreProcessor
+  const char* primaryPreProcessResult_ = nullptr;  // Owned by the RequestState of the request in PreProcessor
   uint32_t primaryPreProcessResultLen_ = 0;
   concord::util::SHA3_256::Digest primaryPreProcessResultHash_;
   // Maps result hash to the number of equal hashes
@@ -0,0 +1,75 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#include "PreProcessResultBufferPool.hpp"
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+using namespace preprocessor;
+
+namespace {
+
+const uint32_t maxBufferSize = 10000;
+
+TEST(PreProcessResultBufferPool, size_classes) {
+  PreProcessResultBufferPool pool(maxBufferSize, 0);
+  ASSERT_EQ(pool.bufferSize(1), PreProcessResultBufferPool::MIN_BUFFER_SIZE);
+  ASSERT_EQ(pool.bufferSize(1024), 1024u);
+  ASSERT_EQ(pool.bufferSize(1025), 2048u);
+  ASSERT_EQ(pool.bufferSize(8192), 8192u);
+  ASSERT_EQ(pool.bufferSize(8193), maxBufferSize);
+  ASSERT_EQ(pool.bufferSize(maxBufferSize), maxBufferSize);
+}
+
+TEST(PreProcessResultBufferPool, buffers_are_allocated_on_demand_and_reused) {
+  PreProcessResultBufferPool pool(maxBufferSize, 0);
+  ASSERT_EQ(pool.allocatedBytes(), 0u);
+  char* first = nullptr;
+  {
+    auto buf = pool.acquire(maxBufferSize);
+    ASSERT_TRUE(buf);
+    std::memset(buf.get(), 1, maxBufferSize);
+    first = buf.get();
+    ASSERT_EQ(pool.allocatedBytes(), maxBufferSize);
+    ASSERT_EQ(pool.inUseBytes(), maxBufferSize);
+  }
+  ASSERT_EQ(pool.allocatedBytes(), maxBufferSize);
+  ASSERT_EQ(pool.inUseBytes(), 0u);
+  auto buf = pool.acquire(maxBufferSize);
+  ASSERT_EQ(buf.get(), first);
+  ASSERT_EQ(pool.allocatedBytes(), maxBufferSize);
+  auto small = pool.acquire(100);
+  ASSERT_EQ(pool.allocatedBytes(), maxBufferSize + PreProcessResultBufferPool::MIN_BUFFER_SIZE);
+  ASSERT_EQ(pool.inUseBytes(), maxBufferSize + PreProcessResultBufferPool::MIN_BUFFER_SIZE);
+}
+
+TEST(PreProcessResultBufferPool, memory_limit) {
+  PreProcessResultBufferPool pool(maxBufferSize, 2 * maxBufferSize);
+  auto buf1 = pool.acquire(maxBufferSize);
+  auto buf2 = pool.acquire(maxBufferSize);
+  ASSERT_TRUE(buf1 && buf2);
+  ASSERT_FALSE(pool.acquire(maxBufferSize));
+  ASSERT_FALSE(pool.acquire(1));
+  buf1.reset();
+  // The free buffer is deallocated to make room for smaller ones
+  auto small1 = pool.acquire(4000);
+  auto small2 = pool.acquire(4000);
+  ASSERT_TRUE(small1 && small2);
+  ASSERT_EQ(pool.allocatedBytes(), maxBufferSize + 2 * 4096);
+  ASSERT_FALSE(pool.acquire(maxBufferSize));
+  small1.reset();
+  small2.reset();
+  ASSERT_TRUE(pool.acquire(maxBufferSize));
+  ASSERT_LE(pool.allocatedBytes(), 2 * maxBufferSize);
+}
+
+}  // namespace
@@ -617,6 +617,53 @@ TEST(requestPreprocessingState_test, batchMsgTimedOutOnPrimary) {
   }
 }
 
+TEST(requestPreprocessingState_test, msgsOfClientsHandledByDifferentShards) {
+  setUpConfiguration_7();
+
+  bftEngine::impl::ReplicasInfo replicasInfo(replicaConfig, false, false);
+  DummyReplica replica(replicasInfo);
+  replica.setPrimary(false);
+  replicaConfig.preExecReqStatusCheckTimerMillisec = preExecReqStatusCheckTimerMillisec;
+  replicaConfig.replicaId = replica_1;
+  replicaConfig.preExecMsgProcessingShards = 4;
+
+  concordUtil::Timers timers;
+  PreProcessor preProcessor(msgsCommunicator, msgsStorage, msgHandlersRegPtr, requestsHandler, replica, timers, sdm);
+
+  auto msgHandlerCallback = msgHandlersRegPtr->getCallback(bftEngine::impl::MsgCode::ClientBatchRequest);
+  deque<ClientRequestMsg*> allMsgs;
+  const uint16_t clientIds[] = {clientId, clientId + 1, clientId + 2};
+  for (auto id : clientIds) {
+    deque<ClientRequestMsg*> batch;
+    uint batchSize = 0;
+    for (uint i = 0; i < 2; i++) {
+      auto* clientReqMsg = new ClientRequestMsg(id, 2, i + 5, bufLen, buf, reqTimeoutMilli, to_string(i + 5));
+      batch.push_back(clientReqMsg);
+      allMsgs.push_back(clientReqMsg);
+      batchSize += clientReqMsg->size();
+    }
+    msgHandlerCallback(new ClientBatchRequestMsg(id, batch, batchSize, cid));
+  }
+  usleep(waitForExecTimerMillisec * 1000);
+  for (auto id : clientIds) {
+    ConcordAssert(preProcessor.getOngoingReqIdForClient(id, 0) == 5);
+    ConcordAssert(preProcessor.getOngoingReqIdForClient(id, 1) == 6);
+  }
+
+  usleep(replicaConfig.preExecReqStatusCheckTimerMillisec * 1000);
+  timers.evaluate();
+  for (auto id : clientIds) {
+    ConcordAssert(preProcessor.getOngoingReqIdForClient(id, 0) == 0);
+    ConcordAssert(preProcessor.getOngoingReqIdForClient(id, 1) == 0);
+  }
+  replicaConfig.preExecMsgProcessingShards = 1;
+  clearDiagnosticsHandlers();
+
+  for (auto& m : allMsgs) {
+    delete m;
+  }
+}
+
 }  // end namespace
 
 int main(int argc, char** argv) {
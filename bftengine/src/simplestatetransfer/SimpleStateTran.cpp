@@ -136,6 +136,12 @@ class SimpleStateTran : public ISimpleInMemoryStateTransfer {
       realInterface_->sendStateTransferMessage(m, size, replicaId);
     }
 
+    char* allocStateTransferMsg(uint32_t size) override { return realInterface_->allocStateTransferMsg(size); }
+
+    void sendPreallocatedStateTransferMessage(char* m, uint32_t size, uint16_t replicaId) override {
+      realInterface_->sendPreallocatedStateTransferMessage(m, size, replicaId);
+    }
+
     void changeStateTransferTimerPeriod(uint32_t timerPeriodMilli) override {
       realInterface_->changeStateTransferTimerPeriod(timerPeriodMilli);
     }
@@ -293,7 +299,10 @@ SimpleStateTran::SimpleStateTran(
       250,                                  // fetchRetransmissionTimeoutMs
       5,                                    // metricsDumpIntervalSec
       true,                                 // runInSeparateThread
-      true                                  // enableReservedPages
+      true,                                 // enableReservedPages
+      bcst::BlockCodec::None,               // blockCodec
+      0,                                    // maxNumberOfChunksInAdaptiveBatch
+      false                                 // resPagesMerkleTreeDigest
   };
 
   auto comparator = concord::storage::memorydb::KeyComparator();
@@ -21,6 +21,9 @@
 #include "direct_kv_db_adapter.h"
 #include "memorydb/client.h"
 #include "storage/direct_kv_key_manipulator.h"
+#include "Serializable.h"
+
+#include <sstream>
 
 using concord::storage::ITransaction;
 
@@ -58,7 +61,10 @@ Config TestConfig() {
       250,                // fetchRetransmissionTimeoutMs
       5,                  // metricsDumpIntervalSec
       false,              // runInSeparateThread
-      true                // enableReservedPages
+      true,               // enableReservedPages
+      BlockCodec::None,   // blockCodec
+      0,                  // maxNumberOfChunksInAdaptiveBatch
+      false               // resPagesMerkleTreeDigest
   };
 }
 
@@ -149,5 +155,111 @@ TEST(DBDataStore, API) {}
 
 TEST(DBDataStore, Transactions) {}
 
+// Exposes the ids of the general records in order to write records of an older format
+class TestDBDataStore : public DBDataStore {
+ public:
+  using DBDataStore::DBDataStore;
+  using DBDataStore::GeneralIds;
+  using DBDataStore::Initialized;
+  using DBDataStore::MaxNumOfStoredCheckpoints;
+  using DBDataStore::NumberOfReservedPages;
+  using DBDataStore::FirstStoredCheckpoint;
+  using DBDataStore::LastStoredCheckpoint;
+};
+
+constexpr uint32_t kTestPageSize = 128;
+
+std::string testPage(char c) { return std::string(kTestPageSize, c); }
+
+STDigest testDigest(char c) { return STDigest(std::string(BLOCK_DIGEST_SIZE, c).data()); }
+
+void assertLoaded(DBDataStore& ds) {
+  auto desc = ds.getCheckpointDesc(2);
+  ASSERT_EQ(desc.checkpointNum, 2);
+  ASSERT_EQ(desc.lastBlock, 100);
+  ASSERT_EQ(desc.digestOfLastBlock, testDigest('d'));
+  ASSERT_EQ(desc.digestOfResPagesDescriptor, testDigest('r'));
+
+  uint64_t actualCheckpoint = 0;
+  STDigest digest;
+  std::string page(kTestPageSize, 0);
+  ASSERT_TRUE(ds.getResPage(1, 2, &actualCheckpoint, &digest, page.data(), kTestPageSize));
+  ASSERT_EQ(actualCheckpoint, 2);
+  ASSERT_EQ(digest, testDigest('p'));
+  ASSERT_EQ(page, testPage('a'));
+
+  ASSERT_EQ(ds.getNumbersOfPendingResPages(), std::set<uint32_t>({0, 3}));
+  ds.getPendingResPage(3, page.data(), kTestPageSize);
+  ASSERT_EQ(page, std::string(10, 'b') + std::string(kTestPageSize - 10, 0));
+}
+
+// Records written by the data store are loaded by the next instance
+TEST(DBDataStore, LoadOnStartup) {
+  concord::storage::IDBClient::ptr dbc(new concord::storage::memorydb::Client());
+  auto keyManip = std::make_shared<concord::storage::v1DirectKeyValue::STKeyManipulator>();
+  {
+    DBDataStore ds(dbc, kTestPageSize, keyManip, true);
+    ds.setAsInitialized();
+    ds.setMaxNumOfStoredCheckpoints(3);
+    ds.setNumberOfReservedPages(4);
+    ds.setFirstStoredCheckpoint(1);
+    ds.setLastStoredCheckpoint(2);
+    ds.setCheckpointDesc(2, DataStore::CheckpointDesc{2, 100, testDigest('d'), testDigest('r')});
+    ds.setResPage(1, 2, testDigest('p'), testPage('a').data());
+    ds.setPendingResPage(0, testPage('c').data(), kTestPageSize);
+    ds.setPendingResPage(3, std::string(10, 'b').data(), 10);
+  }
+  DBDataStore ds(dbc, kTestPageSize, keyManip, true);
+  assertLoaded(ds);
+}
+
+// Records of format version 1 are migrated on startup
+TEST(DBDataStore, MigrateFromFormatVersion1) {
+  using concord::serialize::Serializable;
+  concord::storage::IDBClient::ptr dbc(new concord::storage::memorydb::Client());
+  auto keyManip = std::make_shared<concord::storage::v1DirectKeyValue::STKeyManipulator>();
+  auto putInt = [&](TestDBDataStore::GeneralIds id, uint64_t val) {
+    dbc->put(keyManip->generateStateTransferKey(id), std::to_string(val));
+  };
+  putInt(TestDBDataStore::Initialized, 1);
+  putInt(TestDBDataStore::MaxNumOfStoredCheckpoints, 3);
+  putInt(TestDBDataStore::NumberOfReservedPages, 4);
+  putInt(TestDBDataStore::FirstStoredCheckpoint, 1);
+  putInt(TestDBDataStore::LastStoredCheckpoint, 2);
+  {
+    std::ostringstream os;
+    Serializable::serialize(os, uint64_t{2});
+    Serializable::serialize(os, uint64_t{100});
+    Serializable::serialize(os, testDigest('d').get(), BLOCK_DIGEST_SIZE);
+    Serializable::serialize(os, testDigest('r').get(), BLOCK_DIGEST_SIZE);
+    dbc->put(keyManip->generateSTCheckpointDescriptorKey(2), os.str());
+  }
+  {
+    std::ostringstream os;
+    Serializable::serialize(os, uint32_t{1});
+    Serializable::serialize(os, uint64_t{2});
+    Serializable::serialize(os, testDigest('p').get(), BLOCK_DIGEST_SIZE);
+    Serializable::serialize(os, kTestPageSize);
+    Serializable::serialize(os, testPage('a').data(), kTestPageSize);
+    dbc->put(keyManip->generateSTReservedPageDynamicKey(1, 2), os.str());
+  }
+  auto putPendingPage = [&](uint32_t pageId, const std::string& page) {
+    std::ostringstream os;
+    Serializable::serialize(os, static_cast<uint32_t>(page.size()));
+    Serializable::serialize(os, page.data(), page.size());
+    dbc->put(keyManip->generateSTPendingPageKey(pageId), os.str());
+  };
+  putPendingPage(0, testPage('c'));
+  putPendingPage(3, std::string(10, 'b'));
+
+  {
+    DBDataStore ds(dbc, kTestPageSize, keyManip, true);
+    assertLoaded(ds);
+  }
+  // Migrated once
+  DBDataStore ds(dbc, kTestPageSize, keyManip, true);
+  assertLoaded(ds);
+}
+
 }  // namespace bcst
 }  // namespace bftEngine
@@ -0,0 +1,99 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "BlockCodec.hpp"
+#include "Messages.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using bftEngine::bcst::BlockCodec;
+using bftEngine::bcst::impl::compressBlock;
+using bftEngine::bcst::impl::decompressBlock;
+using bftEngine::bcst::impl::FetchBlocksMsg;
+using bftEngine::bcst::impl::ItemDataMsg;
+
+constexpr uint32_t kMaxBlockSize = 64 * 1024;
+
+std::string compressibleBlock() {
+  auto block = std::string{};
+  for (auto i = 0; block.size() < 16 * 1024; ++i) {
+    block += R"({"key":"key)" + std::to_string(i) + R"(","value":"value)" + std::to_string(i) + R"("})";
+  }
+  return block;
+}
+
+std::string randomBlock() {
+  auto gen = std::mt19937{42};
+  auto dist = std::uniform_int_distribution<int>{0, 255};
+  auto block = std::string(16 * 1024, 0);
+  for (auto& c : block) {
+    c = static_cast<char>(dist(gen));
+  }
+  return block;
+}
+
+class block_codec : public ::testing::TestWithParam<BlockCodec> {};
+
+TEST_P(block_codec, compress_and_decompress) {
+  const auto block = compressibleBlock();
+  auto compressed = std::vector<char>(block.size());
+  const auto compressedSize =
+      compressBlock(GetParam(), block.data(), block.size(), compressed.data(), block.size() - 1);
+  ASSERT_GT(compressedSize, 0);
+  ASSERT_LT(compressedSize, block.size() / 2);
+
+  auto decompressed = std::vector<char>(kMaxBlockSize);
+  const auto decompressedSize =
+      decompressBlock(GetParam(), compressed.data(), compressedSize, decompressed.data(), kMaxBlockSize);
+  ASSERT_EQ(decompressedSize, block.size());
+  ASSERT_EQ(std::string(decompressed.data(), decompressedSize), block);
+}
+
+TEST_P(block_codec, incompressible_block) {
+  const auto block = randomBlock();
+  auto compressed = std::vector<char>(block.size());
+  ASSERT_EQ(compressBlock(GetParam(), block.data(), block.size(), compressed.data(), block.size() - 1), 0);
+}
+
+TEST_P(block_codec, decompress_invalid_data) {
+  const auto block = randomBlock();
+  auto decompressed = std::vector<char>(kMaxBlockSize);
+  ASSERT_EQ(decompressBlock(GetParam(), block.data(), block.size(), decompressed.data(), kMaxBlockSize), 0);
+}
+
+TEST_P(block_codec, decompressed_block_too_big) {
+  const auto block = compressibleBlock();
+  auto compressed = std::vector<char>(block.size());
+  const auto compressedSize =
+      compressBlock(GetParam(), block.data(), block.size(), compressed.data(), block.size() - 1);
+  ASSERT_GT(compressedSize, 0);
+  auto decompressed = std::vector<char>(block.size() - 1);
+  ASSERT_EQ(decompressBlock(GetParam(), compressed.data(), compressedSize, decompressed.data(), block.size() - 1), 0);
+}
+
+// Replicas that don't know about block codecs must still be able to exchange blocks with us
+TEST(block_codec_messages, layout_of_older_replicas) {
+  ASSERT_EQ(FetchBlocksMsg::kLegacySize, 28);
+  ASSERT_GT(sizeof(FetchBlocksMsg), FetchBlocksMsg::kLegacySize);
+  ASSERT_EQ(sizeof(ItemDataMsg), 28);
+}
+
+INSTANTIATE_TEST_CASE_P(block_codec_test, block_codec, ::testing::Values(BlockCodec::LZ4, BlockCodec::ZSTD));
+
+}  // namespace
@@ -0,0 +1,157 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "FetchWindow.hpp"
+
+namespace {
+
+using bftEngine::bcst::impl::FetchWindow;
+
+constexpr uint32_t kChunkSize = 1000;
+constexpr uint32_t kMaxBatchTimeMilli = 2000;
+constexpr uint64_t kMaxBatchBytes = 128 * 1024 * 1024;
+
+// Request a batch of window.chunks() chunks at `now` and receive it from a source that replies after `rttMilli` and
+// sends a chunk every `chunkIntervalMilli`. Return the time the batch is completed.
+uint64_t fetchBatch(FetchWindow& window, uint64_t now, uint64_t rttMilli, uint64_t chunkIntervalMilli) {
+  window.onBatchRequested(now);
+  now += rttMilli;
+  for (auto i = 0; i < window.chunks(); ++i) {
+    if (i > 0) now += chunkIntervalMilli;
+    window.onChunkReceived(kChunkSize, now);
+  }
+  window.onBatchCompleted(now);
+  return now;
+}
+
+TEST(fetch_window_test, fixed_when_max_is_not_bigger_than_initial) {
+  auto window = FetchWindow{64, 0, kMaxBatchTimeMilli, kMaxBatchBytes};
+  auto now = fetchBatch(window, 0, 100, 1);
+  ASSERT_EQ(window.chunks(), 64);
+  window.onBatchTimeout();
+  ASSERT_EQ(window.chunks(), 64);
+  fetchBatch(window, now, 100, 1);
+  ASSERT_EQ(window.chunks(), 64);
+}
+
+TEST(fetch_window_test, doubles_in_slow_start) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  ASSERT_EQ(window.chunks(), 4);
+  auto now = fetchBatch(window, 0, 1, 1);
+  ASSERT_EQ(window.chunks(), 8);
+  now = fetchBatch(window, now, 1, 1);
+  ASSERT_EQ(window.chunks(), 16);
+  fetchBatch(window, now, 1, 1);
+  ASSERT_EQ(window.chunks(), 32);
+}
+
+TEST(fetch_window_test, grows_to_bandwidth_delay_product) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  // 1 chunk/ms with a 100ms round trip
+  fetchBatch(window, 0, 100, 1);
+  // the throughput is measured between the first and the last chunk, so it is a bit overestimated for small batches
+  ASSERT_GE(window.chunks(), FetchWindow::kBdpMultiple * 100);
+  ASSERT_LT(window.chunks(), 2 * FetchWindow::kBdpMultiple * 100);
+}
+
+TEST(fetch_window_test, never_bigger_than_max) {
+  auto window = FetchWindow{4, 128, kMaxBatchTimeMilli, kMaxBatchBytes};
+  auto now = fetchBatch(window, 0, 100, 1);
+  ASSERT_EQ(window.chunks(), 128);
+  fetchBatch(window, now, 100, 1);
+  ASSERT_EQ(window.chunks(), 128);
+}
+
+TEST(fetch_window_test, capped_by_slow_source) {
+  auto window = FetchWindow{16, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  // 10 chunks/s - at most 20 chunks in kMaxBatchTimeMilli, with some slack for the measurement
+  auto now = uint64_t{0};
+  for (auto i = 0; i < 10; ++i) {
+    now = fetchBatch(window, now, 1, 100);
+    ASSERT_LE(window.chunks(), 21);
+    ASSERT_GE(window.chunks(), 16);
+  }
+}
+
+TEST(fetch_window_test, capped_by_max_batch_bytes) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, 10 * kChunkSize};
+  auto now = uint64_t{0};
+  for (auto i = 0; i < 5; ++i) {
+    now = fetchBatch(window, now, 100, 1);
+    ASSERT_LE(window.chunks(), 10);
+  }
+  ASSERT_EQ(window.chunks(), 10);
+}
+
+TEST(fetch_window_test, capped_by_max_batch_bytes_when_batches_arrive_at_once) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, 10 * kChunkSize};
+  auto now = uint64_t{0};
+  for (auto i = 0; i < 5; ++i) {
+    now = fetchBatch(window, now, 1, 0);
+    ASSERT_LE(window.chunks(), 10);
+  }
+  ASSERT_EQ(window.chunks(), 10);
+}
+
+TEST(fetch_window_test, halves_on_timeout_then_grows_slowly) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  auto now = fetchBatch(window, 0, 1, 1);
+  now = fetchBatch(window, now, 1, 1);
+  now = fetchBatch(window, now, 1, 1);
+  ASSERT_EQ(window.chunks(), 32);
+
+  window.onBatchRequested(now);
+  window.onBatchTimeout();
+  ASSERT_EQ(window.chunks(), 16);
+
+  fetchBatch(window, now, 1, 1);
+  ASSERT_EQ(window.chunks(), 18);
+}
+
+TEST(fetch_window_test, never_smaller_than_one_chunk) {
+  auto window = FetchWindow{2, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  for (auto i = 0; i < 5; ++i) {
+    window.onBatchTimeout();
+  }
+  ASSERT_EQ(window.chunks(), 1);
+}
+
+TEST(fetch_window_test, ignores_chunks_of_timed_out_batch) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  window.onBatchRequested(0);
+  window.onBatchTimeout();
+  const auto chunks = window.chunks();
+  window.onChunkReceived(kChunkSize, 10);
+  window.onBatchCompleted(20);
+  ASSERT_EQ(window.chunks(), chunks);
+}
+
+TEST(fetch_window_test, reset) {
+  auto window = FetchWindow{4, 1024, kMaxBatchTimeMilli, kMaxBatchBytes};
+  auto now = fetchBatch(window, 0, 100, 1);
+  ASSERT_GT(window.chunks(), 4);
+  window.reset();
+  ASSERT_EQ(window.chunks(), 4);
+  // back in slow start
+  fetchBatch(window, now, 1, 1);
+  ASSERT_EQ(window.chunks(), 8);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "ResPagesMerkleTree.hpp"
+
+#include <cstdlib>
+#include <memory>
+
+namespace {
+
+using bftEngine::bcst::impl::DataStore;
+using bftEngine::bcst::impl::ResPagesMerkleTree;
+using bftEngine::bcst::impl::STDigest;
+
+constexpr uint32_t kNumOfPages = 37;
+
+struct DescDeleter {
+  void operator()(DataStore::ResPagesDescriptor* d) const { std::free(d); }
+};
+using DescPtr = std::unique_ptr<DataStore::ResPagesDescriptor, DescDeleter>;
+
+DescPtr emptyDescriptor(uint32_t numOfPages) {
+  const auto size = DataStore::ResPagesDescriptor::size(numOfPages);
+  auto desc = DescPtr{static_cast<DataStore::ResPagesDescriptor*>(std::calloc(1, size))};
+  desc->numOfPages = numOfPages;
+  return desc;
+}
+
+DataStore::SingleResPageDesc pageDesc(uint32_t pageId, uint64_t checkpoint) {
+  STDigest digest;
+  digest.getForUpdate()[0] = static_cast<char>(pageId);
+  digest.getForUpdate()[1] = static_cast<char>(checkpoint);
+  return DataStore::SingleResPageDesc{pageId, checkpoint, digest};
+}
+
+TEST(res_pages_merkle_tree_test, incremental_root_equals_full_root) {
+  auto desc = emptyDescriptor(kNumOfPages);
+  ResPagesMerkleTree tree{kNumOfPages};
+  tree.build(desc.get());
+  ASSERT_EQ(tree.root(), ResPagesMerkleTree::computeRoot(desc.get()));
+
+  for (uint64_t checkpoint = 1; checkpoint <= 5; ++checkpoint) {
+    for (uint32_t pageId = checkpoint - 1; pageId < kNumOfPages; pageId += checkpoint + 1) {
+      desc->d[pageId] = pageDesc(pageId, checkpoint);
+      tree.update(desc->d[pageId]);
+    }
+    ASSERT_EQ(tree.root(), ResPagesMerkleTree::computeRoot(desc.get()));
+  }
+}
+
+TEST(res_pages_merkle_tree_test, root_depends_on_every_page) {
+  auto desc = emptyDescriptor(kNumOfPages);
+  const auto emptyRoot = ResPagesMerkleTree::computeRoot(desc.get());
+  for (uint32_t pageId = 0; pageId < kNumOfPages; ++pageId) {
+    ResPagesMerkleTree tree{kNumOfPages};
+    tree.build(desc.get());
+    tree.update(pageDesc(pageId, 1));
+    ASSERT_NE(tree.root(), emptyRoot);
+  }
+}
+
+TEST(res_pages_merkle_tree_test, single_page) {
+  auto desc = emptyDescriptor(1);
+  ResPagesMerkleTree tree{1};
+  tree.build(desc.get());
+  const auto emptyRoot = tree.root();
+  desc->d[0] = pageDesc(0, 1);
+  tree.update(desc->d[0]);
+  ASSERT_NE(tree.root(), emptyRoot);
+  ASSERT_EQ(tree.root(), ResPagesMerkleTree::computeRoot(desc.get()));
+}
+
+TEST(res_pages_merkle_tree_test, checkpoint_tracking) {
+  ResPagesMerkleTree tree{kNumOfPages};
+  ASSERT_FALSE(tree.checkpoint().has_value());
+  tree.setCheckpoint(3);
+  ASSERT_EQ(tree.checkpoint(), 3);
+  tree.resetCheckpoint();
+  ASSERT_FALSE(tree.checkpoint().has_value());
+}
+
+}  // namespace
@@ -50,6 +50,16 @@ class TestReplica : public IReplicaForStateTransfer {
     sent_messages_.push_back(Msg{std::move(msg), size, replicaId});
   }
 
+  char* allocStateTransferMsg(uint32_t size) override {
+    const auto s = sizeof(bftEngine::impl::MessageBase::Header) + size;
+    char* p = reinterpret_cast<char*>(std::calloc(1, s));
+    return p + sizeof(bftEngine::impl::MessageBase::Header);
+  }
+
+  void sendPreallocatedStateTransferMessage(char* m, uint32_t size, uint16_t replicaId) override {
+    sendStateTransferMessage(m, size, replicaId);
+  }
+
   void changeStateTransferTimerPeriod(uint32_t timerPeriodMilli) override{};
 
   ///////////////////////////////////////////////////////////////////////////
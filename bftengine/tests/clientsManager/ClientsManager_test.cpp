@@ -10,8 +10,12 @@
 // file.
 
 #include "ClientsManager.hpp"
+#include "ReplicaConfig.hpp"
+#include "messages/ClientReplyMsg.hpp"
 #include "gtest/gtest.h"
 #include <chrono>
+#include <cstring>
+#include <map>
 #include <thread>
 
 using namespace std;
@@ -61,6 +65,107 @@ TEST(ClientsManager, initInternalClientInfo) {
   ASSERT_EQ(false, cm.isValidClient(firstIntClId + numRep));
 }
 
+// Reserved pages kept in memory, saved pages are zero padded. The reply log is supported on demand.
+struct ReservedPagesMock : public IReservedPages {
+  ReservedPagesMock(bool withLog) : with_log_{withLog} { ReservedPagesClientBase::setReservedPages(this); }
+  ~ReservedPagesMock() { ReservedPagesClientBase::setReservedPages(nullptr); }
+  uint32_t numberOfReservedPages() const override { return 1024; }
+  uint32_t sizeOfReservedPage() const override { return ReplicaConfig::instance().getsizeOfReservedPage(); }
+  bool loadReservedPage(uint32_t reservedPageId, uint32_t copyLength, char *outReservedPage) const override {
+    auto it = pages_.find(reservedPageId);
+    if (it == pages_.end()) return false;
+    memcpy(outReservedPage, it->second.data(), copyLength);
+    return true;
+  }
+  void saveReservedPage(uint32_t reservedPageId, uint32_t copyLength, const char *inReservedPage) override {
+    auto &page = pages_[reservedPageId];
+    page.assign(inReservedPage, copyLength);
+    page.resize(sizeOfReservedPage(), 0);
+  }
+  void zeroReservedPage(uint32_t reservedPageId) override {
+    pages_[reservedPageId] = std::string(sizeOfReservedPage(), 0);
+  }
+  bool appendToReservedPagesLog(const char *record, uint32_t length) override {
+    if (with_log_) log_.emplace_back(record, length);
+    return with_log_;
+  }
+  std::vector<std::string> loadReservedPagesLog() const override { return log_; }
+  void clearReservedPagesLog() override { log_.clear(); }
+
+  const bool with_log_;
+  std::map<uint32_t, std::string> pages_;
+  std::vector<std::string> log_;
+};
+
+void addReply(bftEngine::impl::ClientsManager &cm,
+              bftEngine::impl::NodeIdType clientId,
+              bftEngine::impl::ReqId reqSeqNum,
+              size_t len) {
+  std::string reply(len, static_cast<char>('a' + reqSeqNum % 26));
+  cm.allocateNewReplyMsgAndWriteToStorage(clientId, reqSeqNum, 0, reply.data(), reply.size());
+}
+
+// Replies are appended to the reply log and reach the reserved pages only when the log is folded
+TEST(ClientsManager, replyLog) {
+  std::set<bftEngine::impl::NodeIdType> clset{1, 4};
+  ReservedPagesMock pages{true};
+  {
+    bftEngine::impl::ClientsManager cm{metrics, clset};
+    cm.loadInfoFromReservedPages();
+    addReply(cm, 1, 10, 100);
+    addReply(cm, 4, 11, 6000);
+    ASSERT_TRUE(pages.pages_.empty());
+    ASSERT_EQ(pages.log_.size(), 2);
+    auto reply = cm.allocateReplyFromSavedOne(4, 11, 0);
+    ASSERT_EQ(reply->replyLength(), 6000);
+    ASSERT_EQ(std::string(reply->replyBuf(), reply->replyLength()), std::string(6000, 'l'));
+  }
+
+  // Restart: the replies are recovered from the log
+  bftEngine::impl::ClientsManager cm{metrics, clset};
+  cm.loadInfoFromReservedPages();
+  ASSERT_TRUE(cm.hasReply(1, 10));
+  ASSERT_TRUE(cm.hasReply(4, 11));
+  ASSERT_EQ(cm.allocateReplyFromSavedOne(1, 10, 0)->replyLength(), 100);
+
+  cm.foldReplyLogIntoReservedPages();
+  ASSERT_TRUE(pages.log_.empty());
+  ASSERT_FALSE(pages.pages_.empty());
+  bftEngine::impl::ClientsManager restarted{metrics, clset};
+  restarted.loadInfoFromReservedPages();
+  ASSERT_TRUE(restarted.hasReply(1, 10));
+  ASSERT_EQ(restarted.allocateReplyFromSavedOne(4, 11, 0)->replyLength(), 6000);
+}
+
+// Folding the reply log results in the same reserved pages as saving every reply right away
+TEST(ClientsManager, replyLogFoldsToSamePages) {
+  std::set<bftEngine::impl::NodeIdType> clset{1, 4, 7};
+  auto writeReplies = [&clset](ReservedPagesMock &pages) {
+    bftEngine::impl::ClientsManager cm{metrics, clset};
+    cm.loadInfoFromReservedPages();
+    bftEngine::impl::ReqId reqSeqNum = 1;
+    for (auto clientId : clset) addReply(cm, clientId, reqSeqNum++, 6000);
+    // A shorter reply overwrites the first page only
+    for (auto clientId : clset) {
+      addReply(cm, clientId, reqSeqNum, 10 * reqSeqNum);
+      reqSeqNum++;
+    }
+    cm.foldReplyLogIntoReservedPages();
+    addReply(cm, 7, reqSeqNum++, 3000);
+    cm.foldReplyLogIntoReservedPages();
+  };
+  std::map<uint32_t, std::string> withoutLog;
+  {
+    ReservedPagesMock pages{false};
+    writeReplies(pages);
+    withoutLog = pages.pages_;
+  }
+  ReservedPagesMock pages{true};
+  writeReplies(pages);
+  ASSERT_EQ(pages.pages_, withoutLog);
+  ASSERT_TRUE(pages.log_.empty());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
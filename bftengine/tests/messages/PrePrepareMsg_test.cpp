@@ -131,6 +131,55 @@ TEST_F(PrePrepareMsgTestFixture, base_methods) {
   testMessageBaseMethods(msg, MsgCode::PrePrepare, senderId, spanContext);
 }
 
+TEST_F(PrePrepareMsgTestFixture, digests_only_message) {
+  ReplicasInfo replicaInfo(createReplicaConfig(), false, false);
+  ReplicaId senderId = 1u;
+  ViewNum viewNum = 2u;
+  SeqNum seqNum = 3u;
+  CommitPath commitPath = CommitPath::OPTIMISTIC_FAST;
+  const char rawSpanContext[] = {"span_\0context"};
+  const std::string spanContext{rawSpanContext, sizeof(rawSpanContext)};
+  ClientRequestMsg client_request = create_client_request();
+  PrePrepareMsg msg(
+      senderId, viewNum, seqNum, commitPath, concordUtils::SpanContext{spanContext}, client_request.size() * 2);
+  msg.addRequest(client_request.body(), client_request.size());
+  msg.addRequest(client_request.body(), client_request.size());
+  msg.finishAddingRequests();
+  EXPECT_FALSE(msg.isDigestsOnly());
+
+  std::unique_ptr<PrePrepareMsg> digestsOnlyMsg{PrePrepareMsg::createDigestsOnlyMsg(msg)};
+  EXPECT_TRUE(digestsOnlyMsg->isDigestsOnly());
+  EXPECT_EQ(digestsOnlyMsg->viewNumber(), viewNum);
+  EXPECT_EQ(digestsOnlyMsg->seqNumber(), seqNum);
+  EXPECT_EQ(digestsOnlyMsg->firstPath(), commitPath);
+  EXPECT_EQ(digestsOnlyMsg->getCid(), msg.getCid());
+  EXPECT_EQ(digestsOnlyMsg->numberOfRequests(), 2u);
+  EXPECT_TRUE(digestsOnlyMsg->digestOfRequests() == msg.digestOfRequests());
+  EXPECT_LT(digestsOnlyMsg->size(), msg.size());
+  EXPECT_NO_THROW(digestsOnlyMsg->validate(replicaInfo));
+  testMessageBaseMethods(*digestsOnlyMsg, MsgCode::PrePrepare, senderId, spanContext);
+
+  const auto requestDigest = PrePrepareMsg::digestOfRequest(client_request.body(), client_request.size());
+  for (size_t i = 0; i < digestsOnlyMsg->numberOfRequests(); ++i) {
+    const auto& entry = digestsOnlyMsg->requestDigests()[i];
+    EXPECT_EQ(entry.clientId, client_request.clientProxyId());
+    EXPECT_EQ(entry.reqSeqNum, client_request.requestSeqNum());
+    EXPECT_TRUE(entry.digest == requestDigest);
+  }
+
+  std::unique_ptr<PrePrepareMsg> fullMsg{
+      PrePrepareMsg::createFromDigestsOnlyMsg(*digestsOnlyMsg, {client_request.body(), client_request.body()})};
+  ASSERT_NE(fullMsg, nullptr);
+  EXPECT_FALSE(fullMsg->isDigestsOnly());
+  EXPECT_EQ(fullMsg->size(), msg.size());
+  EXPECT_EQ(memcmp(fullMsg->body(), msg.body(), msg.size()), 0);
+  EXPECT_NO_THROW(fullMsg->validate(replicaInfo));
+
+  ClientRequestMsg other_request(1u, 'F', 101u, 5, "other", 0, "otherCid", concordUtils::SpanContext{});
+  EXPECT_EQ(PrePrepareMsg::createFromDigestsOnlyMsg(*digestsOnlyMsg, {client_request.body(), other_request.body()}),
+            nullptr);
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
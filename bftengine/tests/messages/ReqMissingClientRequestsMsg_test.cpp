@@ -0,0 +1,54 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include <cstring>
+#include <vector>
+#include "gtest/gtest.h"
+#include "messages/ReqMissingClientRequestsMsg.hpp"
+#include "messages/MsgCode.hpp"
+#include "bftengine/ReplicaConfig.hpp"
+#include "Digest.hpp"
+#include "helper.hpp"
+
+using namespace bftEngine;
+using namespace bftEngine::impl;
+
+TEST(ReqMissingClientRequestsMsg, base_methods) {
+  ReplicasInfo replicaInfo(createReplicaConfig(), false, false);
+  ReplicaId senderId = 1u;
+  ViewNum viewNum = 2u;
+  SeqNum seqNum = 3u;
+  const char rawSpanContext[] = {"span_\0context"};
+  const std::string spanContext{rawSpanContext, sizeof(rawSpanContext)};
+
+  std::vector<ReqMissingClientRequestsMsg::RequestDigest> missing(3);
+  for (size_t i = 0; i < missing.size(); ++i) {
+    missing[i].clientId = static_cast<NodeIdType>(10 + i);
+    missing[i].reqSeqNum = 100 + i;
+    missing[i].digest = Digest(static_cast<unsigned char>(i + 1));
+  }
+  ReqMissingClientRequestsMsg msg(senderId, viewNum, seqNum, missing, concordUtils::SpanContext{spanContext});
+  EXPECT_EQ(msg.viewNumber(), viewNum);
+  EXPECT_EQ(msg.seqNumber(), seqNum);
+  ASSERT_EQ(msg.numberOfRequests(), missing.size());
+  for (size_t i = 0; i < missing.size(); ++i) {
+    EXPECT_EQ(msg.requestDigests()[i].clientId, missing[i].clientId);
+    EXPECT_EQ(msg.requestDigests()[i].reqSeqNum, missing[i].reqSeqNum);
+    EXPECT_TRUE(msg.requestDigests()[i].digest == missing[i].digest);
+  }
+  EXPECT_NO_THROW(msg.validate(replicaInfo));
+  testMessageBaseMethods(msg, MsgCode::ReqMissingClientRequests, senderId, spanContext);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,140 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#include "PrimaryRequestsQueue.hpp"
+#include "messages/ClientRequestMsg.hpp"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <vector>
+
+using namespace bftEngine;
+using namespace bftEngine::impl;
+
+namespace {
+
+class PrimaryRequestsQueueTest : public ::testing::Test {
+ protected:
+  PrimaryRequestsQueueTest() {
+    auto& config = ReplicaConfig::instance();
+    config.numReplicas = 4;
+    config.numRoReplicas = 0;
+    config.numOfClientProxies = 2;
+    config.numOfExternalClients = 0;
+    config.maxExternalMessageSize = 1000;
+    queue = std::make_unique<PrimaryRequestsQueue>(config, metrics);
+    metrics.Register();
+  }
+
+  ClientRequestMsg* request(NodeIdType clientId, ReqId reqSeqNum, size_t bodySize) {
+    const std::string body(bodySize, 'r');
+    msgs.emplace_back(new ClientRequestMsg(clientId, 0, reqSeqNum, body.size(), body.c_str(), 0, "cid"));
+    return msgs.back().get();
+  }
+
+  uint64_t gauge(const std::string& name) {
+    metrics.UpdateAggregator();
+    return aggregator->GetGauge("replica", name).Get();
+  }
+
+  std::shared_ptr<concordMetrics::Aggregator> aggregator = std::make_shared<concordMetrics::Aggregator>();
+  concordMetrics::Component metrics{"replica", aggregator};
+  std::unique_ptr<PrimaryRequestsQueue> queue;
+  std::vector<std::unique_ptr<ClientRequestMsg>> msgs;
+};
+
+TEST_F(PrimaryRequestsQueueTest, push_and_pop) {
+  ASSERT_TRUE(queue->empty());
+  ASSERT_EQ(queue->front(), nullptr);
+  auto* m = request(4, 1, 100);
+  ASSERT_TRUE(queue->push(m));
+  ASSERT_EQ(queue->size(), 1);
+  ASSERT_EQ(queue->sizeInBytes(), m->size());
+  ASSERT_EQ(queue->front(), m);
+  queue->pop();
+  ASSERT_TRUE(queue->empty());
+  ASSERT_EQ(queue->sizeInBytes(), 0);
+}
+
+TEST_F(PrimaryRequestsQueueTest, duplicates_are_rejected) {
+  ASSERT_TRUE(queue->push(request(4, 1, 100)));
+  ASSERT_TRUE(queue->push(request(5, 1, 100)));
+  ASSERT_FALSE(queue->push(request(4, 1, 100)));
+  ASSERT_TRUE(queue->contains(4, 1));
+  ASSERT_FALSE(queue->contains(4, 2));
+  ASSERT_EQ(queue->size(), 2);
+  queue->pop();
+  queue->pop();
+  // a request can be queued again once it left the queue
+  ASSERT_TRUE(queue->push(request(4, 1, 100)));
+}
+
+TEST_F(PrimaryRequestsQueueTest, requests_of_a_client_are_in_order) {
+  for (ReqId i = 1; i <= 5; i++) ASSERT_TRUE(queue->push(request(4, i, 300)));
+  for (ReqId i = 1; i <= 5; i++) {
+    ASSERT_EQ(queue->front()->requestSeqNum(), i);
+    queue->pop();
+  }
+}
+
+TEST_F(PrimaryRequestsQueueTest, large_requests_dont_delay_other_clients) {
+  for (ReqId i = 1; i <= 6; i++) ASSERT_TRUE(queue->push(request(4, i, 600)));
+  for (ReqId i = 1; i <= 3; i++) ASSERT_TRUE(queue->push(request(5, i, 10)));
+  ASSERT_EQ(queue->size(4), 6);
+  ASSERT_EQ(queue->size(5), 3);
+  ASSERT_EQ(gauge("primary_queue_active_clients"), 2);
+  ASSERT_EQ(gauge("primary_queue_max_client_size"), 6);
+
+  std::vector<NodeIdType> order;
+  while (!queue->empty()) {
+    order.push_back(queue->front()->clientProxyId());
+    queue->pop();
+  }
+  // client 4 gets one request per round, client 5 sends all of its requests in its first round
+  const std::vector<NodeIdType> expected{4, 5, 5, 5, 4, 4, 4, 4, 4};
+  ASSERT_EQ(order, expected);
+  ASSERT_EQ(gauge("primary_queue_active_clients"), 0);
+  ASSERT_EQ(gauge("primary_queue_max_client_size"), 0);
+}
+
+TEST_F(PrimaryRequestsQueueTest, largest_client_queue_follows_pops) {
+  for (ReqId i = 1; i <= 2; i++) ASSERT_TRUE(queue->push(request(4, i, 10)));
+  ASSERT_TRUE(queue->push(request(5, 1, 10)));
+  ASSERT_EQ(gauge("primary_queue_active_clients"), 2);
+  ASSERT_EQ(gauge("primary_queue_max_client_size"), 2);
+
+  // client 4 is served first and sends both of its requests in its first round
+  queue->pop();
+  ASSERT_EQ(gauge("primary_queue_active_clients"), 2);
+  ASSERT_EQ(gauge("primary_queue_max_client_size"), 1);
+  queue->pop();
+  ASSERT_EQ(gauge("primary_queue_active_clients"), 1);
+  ASSERT_EQ(gauge("primary_queue_max_client_size"), 1);
+  queue->pop();
+  ASSERT_EQ(gauge("primary_queue_active_clients"), 0);
+  ASSERT_EQ(gauge("primary_queue_max_client_size"), 0);
+}
+
+TEST_F(PrimaryRequestsQueueTest, idle_client_does_not_accumulate_credit) {
+  ASSERT_TRUE(queue->push(request(5, 1, 10)));
+  queue->pop();
+  for (ReqId i = 1; i <= 2; i++) ASSERT_TRUE(queue->push(request(4, i, 600)));
+  for (ReqId i = 2; i <= 3; i++) ASSERT_TRUE(queue->push(request(5, i, 600)));
+  std::vector<NodeIdType> order;
+  while (!queue->empty()) {
+    order.push_back(queue->front()->clientProxyId());
+    queue->pop();
+  }
+  const std::vector<NodeIdType> expected{4, 5, 4, 5};
+  ASSERT_EQ(order, expected);
+}
+
+}  // namespace
@@ -28,6 +28,11 @@ TEST(metrics_test, updateLastSavedBlockId) {
   auto blockKey = keygen->blockKey(blockId);
   m.updateLastSavedBlockId(blockKey.toString());
   ASSERT_EQ(m.getLastSavedBlockId(), 2);
+
+  // Puts of an older block that complete later - they should NOT decrease the metric
+  m.updateLastSavedBlockId(keygen->blockKey(blockId - 1).toString());
+  m.updateLastSavedBlockId(keygen->dataKey(concord::kvbc::Key{keyName}, blockId - 1).toString());
+  ASSERT_EQ(m.getLastSavedBlockId(), 2);
 }
 
 }  // namespace
@@ -0,0 +1,132 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+// Times the view change safety logic. Not run as part of the unit tests: the verifier it installs in CryptoManager
+// simulates the cost of a pairing.
+
+#include "ReplicaConfig.hpp"
+#include "ViewChangeSafetyLogic.hpp"
+#include "messages/PrePrepareMsg.hpp"
+#include "messages/ViewChangeMsg.hpp"
+#include "KeyfileIOUtils.hpp"
+#include "CryptoManager.hpp"
+#include "SysConsts.hpp"
+#include "helper.hpp"
+#include "SigManager.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace std;
+using namespace bftEngine;
+
+namespace {
+class TestReplicaConfig : public bftEngine::ReplicaConfig {};
+
+TestReplicaConfig replicaConfig;
+static const int N = 4;
+static const int F = 1;
+static const int C = 0;
+ViewChangeSafetyLogic::Restriction restrictions[kWorkWindowSize];
+std::unique_ptr<bftEngine::impl::ReplicasInfo> pRepInfo;
+std::unique_ptr<SigManager> sigManager_;
+
+// Verification of a combined signature takes about as long as a BLS pairing
+std::atomic_size_t numOfVerifications{0};
+const std::chrono::microseconds verificationCost = std::chrono::milliseconds{1};
+
+class CostlyThresholdVerifier : public IThresholdVerifierDummy {
+ public:
+  bool verify(const char* msg, int msgLen, const char* sig, int sigLen) const override {
+    ++numOfVerifications;
+    std::this_thread::sleep_for(verificationCost);
+    return true;
+  }
+};
+
+class CostlyCryptoSystem : public TestCryptoSystem {
+ public:
+  IThresholdVerifier* createThresholdVerifier(uint16_t threshold = 0) override { return new CostlyThresholdVerifier; }
+};
+
+void setUpConfiguration_4() {
+  replicaConfig.numReplicas = N;
+  replicaConfig.fVal = F;
+  replicaConfig.cVal = C;
+  replicaConfig.replicaId = 0;
+  loadPrivateAndPublicKeys(replicaConfig.replicaPrivateKey, replicaConfig.publicKeysOfReplicas, 0, N);
+  pRepInfo = std::make_unique<bftEngine::impl::ReplicasInfo>(replicaConfig, true, true);
+
+  sigManager_.reset(createSigManager(0,
+                                     replicaConfig.replicaPrivateKey,
+                                     KeyFormat::HexaDecimalStrippedFormat,
+                                     replicaConfig.publicKeysOfReplicas,
+                                     *pRepInfo));
+}
+
+// Times the worst case view change: each of the 2F+2C+1 view change messages reports a prepared certificate for every
+// sequence number of the work window. Each certificate is expected to be verified once, in parallel with the others.
+TEST(testViewchangeSafetyLogic_test, full_window_view_change_benchmark) {
+  const bftEngine::impl::SeqNum lastStableSeqNum = 150;
+  const ViewNum view = 0;
+  const char signature[64]{'S'};
+
+  ViewChangeMsg** viewChangeMsgs = new ViewChangeMsg*[N];
+  for (int i = 0; i < N; i++) {
+    viewChangeMsgs[i] = nullptr;
+    if (i == N - 1) continue;
+    viewChangeMsgs[i] = new ViewChangeMsg(i, view + 1, lastStableSeqNum);
+    for (auto seqNum = lastStableSeqNum + 1; seqNum <= lastStableSeqNum + kWorkWindowSize; seqNum++) {
+      Digest digest(reinterpret_cast<char*>(&seqNum), sizeof(seqNum));
+      viewChangeMsgs[i]->addElement(seqNum, digest, view, true, view, sizeof(signature), signature);
+    }
+  }
+
+  auto VCS = ViewChangeSafetyLogic(N, F, C, PrePrepareMsg::digestOfNullPrePrepareMsg());
+
+  numOfVerifications = 0;
+  const auto start = std::chrono::steady_clock::now();
+  SeqNum min{}, max{};
+  VCS.computeRestrictions(viewChangeMsgs, VCS.calcLBStableForView(viewChangeMsgs), min, max, restrictions);
+  const auto duration = std::chrono::steady_clock::now() - start;
+
+  // Reported in the test's XML output (--gtest_output)
+  RecordProperty("duration_ms", std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+  RecordProperty("certificate_verifications", numOfVerifications.load());
+
+  ASSERT_EQ(numOfVerifications.load(), (size_t)kWorkWindowSize);
+  ASSERT_EQ(min, lastStableSeqNum + 1);
+  ASSERT_EQ(max, lastStableSeqNum + kWorkWindowSize);
+  for (auto seqNum = min; seqNum <= max; seqNum++) {
+    Digest digest(reinterpret_cast<char*>(&seqNum), sizeof(seqNum));
+    ASSERT_FALSE(restrictions[seqNum - min].isNull);
+    ASSERT_EQ(restrictions[seqNum - min].digest, digest);
+  }
+
+  for (int i = 0; i < N; i++) {
+    delete viewChangeMsgs[i];
+    viewChangeMsgs[i] = nullptr;
+  }
+  delete[] viewChangeMsgs;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  setUpConfiguration_4();
+  bftEngine::CryptoManager::instance(new CostlyCryptoSystem);
+  return RUN_ALL_TESTS();
+}
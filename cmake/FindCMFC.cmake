@@ -1,13 +1,19 @@
 # Generate C++ code from a CMF file
 #
-# cmf_generate_cpp(<LIST_OF_GENERATED_HEADER_FILES> <LIST_OF_GENERATED_CPP_FILES> <CPP_NAMESPACE> <CMFs> ...)
+# cmf_generate_cpp(<LIST_OF_GENERATED_HEADER_FILES> <LIST_OF_GENERATED_CPP_FILES> <CPP_NAMESPACE> [VIEWS] <CMFs> ...)
 #
 # LIST_OF_GENERATED_HEADER_FILES - Will be populated with generated header files
 # LIST_OF_GENERATED_CPP_FILES - Will be populated with generated cpp files
 # CPP_NAMESPACE - C++ namespace to use for the generated code
+# VIEWS - Also generate <Msg>View types, deserialized without copying strings and bytes
 # CMFs - List of CMF files
 function(CMF_GENERATE_CPP CPP_HEADER CPP_IMPL CPP_NAMESPACE)
-  foreach(FIL ${ARGN})
+  cmake_parse_arguments(CMF "VIEWS" "" "" ${ARGN})
+  set(CMF_VIEWS_ARG "")
+  if(CMF_VIEWS)
+    set(CMF_VIEWS_ARG "--views")
+  endif()
+  foreach(FIL ${CMF_UNPARSED_ARGUMENTS})
     if(NOT EXISTS "${CMAKE_CURRENT_SOURCE_DIR}/${FIL}")
       message(FATAL_ERROR "CMF doesn't exist: ${CMAKE_CURRENT_SOURCE_DIR}/${FIL}")
     endif()
@@ -19,6 +25,7 @@ function(CMF_GENERATE_CPP CPP_HEADER CPP_IMPL CPP_NAMESPACE)
            --output ${FIL}
            --language cpp
            --namespace ${CPP_NAMESPACE}
+           ${CMF_VIEWS_ARG}
       DEPENDS ${FIL} ${CMF_COMPILER}
       COMMENT "CMFC: Generate C++ code for ${FIL}"
       VERBATIM
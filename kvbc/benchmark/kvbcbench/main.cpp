@@ -18,6 +18,7 @@
 #include <iostream>
 #include <memory>
 #include <random>
+#include <thread>
 
 #include <boost/program_options.hpp>
 #include <boost/program_options/errors.hpp>
@@ -32,7 +33,9 @@
 
 #include "categorization/base_types.h"
 #include "categorization/column_families.h"
+#include "categorization/column_family_profiles.h"
 #include "categorization/updates.h"
+#include "categorization/updates_capture.h"
 #include "categorized_kvbc_msgs.cmf.hpp"
 #include "categorization/kv_blockchain.h"
 #include "performance_handler.h"
@@ -100,6 +103,31 @@ std::pair<po::options_description, po::variables_map> parseArgs(int argc, char**
     po::value<size_t>()->default_value(CACHE_SIZE_DEFAULT),
     "Rocksdb Block Cache size")
 
+    ("rocksdb-cf-profiles",
+    po::bool_switch()->default_value(false),
+    "Tune each column family for its access pattern, as KeyValueBlockchain does when creating them, instead of using "
+    "the same table options for all")
+
+    /*********************************
+     Capture and Replay Config
+     *********************************/
+    ("capture-file",
+    po::value<std::string>()->default_value(""s),
+    "Capture the updates of the added blocks to this file, for later use with --replay-file")
+
+    ("replay-file",
+    po::value<std::string>()->default_value(""s),
+    "Instead of generating blocks, add the blocks captured in this file - by --capture-file or by a replica with "
+    "concord.kvbc.captureUpdatesPath set. The block generation options are ignored.")
+
+    ("replay-pacing",
+    po::value<std::string>()->default_value("max"s)->notifier([] (const std::string& v) {
+       if (v != "max" && v != "recorded") {
+          throw po::validation_error{po::validation_error::invalid_option_value, "replay-pacing", v};
+       }}),
+    "How fast to add the replayed blocks: 'max' to add them back to back or 'recorded' to add them at the times they "
+    "were captured")
+
     /*********************************
      Block Merkle Category Config
      *********************************/
@@ -180,9 +208,12 @@ std::pair<po::options_description, po::variables_map> parseArgs(int argc, char**
 
 void printHistograms() {
   auto& registrar = diagnostics::RegistrarSingleton::getInstance();
-  registrar.perf.snapshot("bench");
-  auto data = registrar.perf.get("bench");
-  cout << registrar.perf.toString(data) << endl;
+  // The phases of KeyValueBlockchain::addBlock() are recorded by the "kvbc" component.
+  for (const auto& component : {"bench"s, "kvbc"s}) {
+    registrar.perf.snapshot(component);
+    auto data = registrar.perf.get(component);
+    cout << registrar.perf.toString(data) << endl;
+  }
 }
 
 void printRocksDbProperty(std::shared_ptr<storage::rocksdb::NativeClient>& db,
@@ -224,19 +255,56 @@ void printRocksDbProperties(std::shared_ptr<storage::rocksdb::NativeClient>& db)
   }
 }
 
+// The profile KeyValueBlockchain creates a column family with.
+categorization::detail::ColumnFamilyProfile columnFamilyProfile(const std::string& cf) {
+  using namespace categorization::detail;
+  const auto endsWith = [&cf](const std::string& suffix) {
+    return cf.size() >= suffix.size() && cf.compare(cf.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+  if (cf == BLOCKS_CF || cf == ST_CHAIN_CF || cf == BLOCK_MERKLE_STALE_CF || cf == BLOCK_MERKLE_PRUNED_BLOCKS_CF) {
+    return ColumnFamilyProfile::AppendOnly;
+  }
+  if (cf == CAT_ID_TYPE_CF || cf == BLOCK_MERKLE_LATEST_KEY_VERSION_CF ||
+      cf == BLOCK_MERKLE_ACTIVE_KEYS_FROM_PRUNED_BLOCKS_CF || endsWith(VERSIONED_KV_LATEST_VER_CF_SUFFIX) ||
+      endsWith(VERSIONED_KV_ACTIVE_KEYS_FROM_PRUNED_BLOCKS_CF_SUFFIX)) {
+    return ColumnFamilyProfile::PointLookup;
+  }
+  if (cf == BLOCK_MERKLE_INTERNAL_NODES_CF) {
+    return ColumnFamilyProfile::HashKeyed;
+  }
+  if (cf == BLOCK_MERKLE_LEAF_NODES_CF || cf == BLOCK_MERKLE_KEYS_CF) {
+    return ColumnFamilyProfile::VersionedHashKeyed;
+  }
+  if (endsWith(VERSIONED_KV_VALUES_CF_SUFFIX) || endsWith(IMMUTABLE_KV_CF_SUFFIX)) {
+    return ColumnFamilyProfile::LargeValues;
+  }
+  return ColumnFamilyProfile::Default;
+}
+
 std::shared_ptr<rocksdb::Statistics> completeRocksdbConfiguration(
-    ::rocksdb::Options& db_options, std::vector<::rocksdb::ColumnFamilyDescriptor>& cf_descs, size_t cache_size) {
+    ::rocksdb::Options& db_options,
+    std::vector<::rocksdb::ColumnFamilyDescriptor>& cf_descs,
+    size_t cache_size,
+    bool cf_profiles) {
   auto table_options = ::rocksdb::BlockBasedTableOptions{};
   table_options.block_cache = ::rocksdb::NewLRUCache(cache_size);
   table_options.filter_policy.reset(::rocksdb::NewBloomFilterPolicy(10, false));
   db_options.table_factory.reset(NewBlockBasedTableFactory(table_options));
 
-  // Use the same block cache and table options for all column familes for now.
+  // Use the same block cache and table options for all column familes.
   for (auto& d : cf_descs) {
     auto* cf_table_options =
         reinterpret_cast<::rocksdb::BlockBasedTableOptions*>(d.options.table_factory->GetOptions());
     cf_table_options->block_cache = table_options.block_cache;
     cf_table_options->filter_policy.reset(::rocksdb::NewBloomFilterPolicy(10, false));
+
+    // Replace the options from the options file by the profile's ones, keeping the block cache.
+    const auto profile = columnFamilyProfile(d.name);
+    if (cf_profiles && profile != categorization::detail::ColumnFamilyProfile::Default) {
+      cout << "Column family " << d.name << " uses the " << categorization::detail::toString(profile) << " profile"
+           << endl;
+      d.options = categorization::detail::columnFamilyOptions(profile, d.options);
+    }
   }
   return db_options.statistics;
 }
@@ -325,6 +393,30 @@ void addBlocks(const po::variables_map& config,
   }
 }
 
+// Add the blocks captured in `reader` and return their number.
+size_t replayBlocks(const po::variables_map& config,
+                    std::shared_ptr<storage::rocksdb::NativeClient>& db,
+                    categorization::KeyValueBlockchain& kvbc,
+                    categorization::UpdatesCaptureReader& reader,
+                    std::shared_ptr<diagnostics::Recorder>& add_block_recorder) {
+  const auto stats_dump_period_in_blocks = config["stats-dump-period-in-blocks"].as<size_t>();
+  const auto recorded_pacing = config["replay-pacing"].as<std::string>() == "recorded";
+  const auto start = std::chrono::steady_clock::now();
+  auto num_blocks = size_t{0};
+  while (auto captured = reader.next()) {
+    if (++num_blocks % stats_dump_period_in_blocks == 0) {
+      cout << "Adding Block " << num_blocks << endl;
+      printRocksDbProperties(db);
+    }
+    if (recorded_pacing) {
+      std::this_thread::sleep_until(start + std::chrono::microseconds{captured->time_us});
+    }
+    diagnostics::TimeRecorder<> guard(*add_block_recorder);
+    kvbc.addBlock(categorization::Updates{std::move(captured->updates)});
+  }
+  return num_blocks;
+}
+
 }  // namespace concord::kvbc::bench
 
 using namespace concord::kvbc::bench;
@@ -347,6 +439,36 @@ int main(int argc, char** argv) {
 
     diagnostics_server.start(registrar, INADDR_ANY, 6888);
 
+    auto rocksdb_stats = std::shared_ptr<::rocksdb::Statistics>{};
+    auto rocksdb_cache_size = config["rocksdb-cache-size"].as<size_t>();
+    auto rocksdb_cf_profiles = config["rocksdb-cf-profiles"].as<bool>();
+    auto completeInit = [&rocksdb_stats, rocksdb_cache_size, rocksdb_cf_profiles](auto& db_options, auto& cf_descs) {
+      rocksdb_stats = completeRocksdbConfiguration(db_options, cf_descs, rocksdb_cache_size, rocksdb_cf_profiles);
+    };
+    auto opts = storage::rocksdb::NativeClient::UserOptions{"kvbcbench_rocksdb_opts.ini", completeInit};
+
+    const auto replay_file = config["replay-file"].as<std::string>();
+    if (!replay_file.empty()) {
+      auto reader = kvbc::categorization::UpdatesCaptureReader{replay_file};
+      auto db = storage::rocksdb::NativeClient::newClient(config["rocksdb-path"].as<std::string>(), false, opts);
+      auto kvbc = kvbc::categorization::KeyValueBlockchain(db, false, reader.categoryTypes());
+
+      cout << "Starting to Replay Blocks from " << replay_file << "..." << endl;
+      const auto start = std::chrono::steady_clock::now();
+      const auto num_blocks = replayBlocks(config, db, kvbc, reader, add_block_recorder);
+      const auto end = std::chrono::steady_clock::now();
+      auto replay_duration = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+      cout << "Replaying " << num_blocks << " blocks completed in = " << replay_duration / 1000.0 << " seconds" << endl
+           << endl;
+
+      printRocksDbProperties(db);
+      printHistograms();
+
+      cout << "Avg. Throughput = " << num_blocks / (replay_duration / 1000.0) << " blocks/s" << endl;
+      diagnostics_server.stop();
+      return 0;
+    }
+
     cout << "Starting Input Data Generation..." << endl;
     auto start = std::chrono::steady_clock::now();
     auto input = createBlockInput(config);
@@ -354,12 +476,6 @@ int main(int argc, char** argv) {
     cout << "Input Data Generation completed in " << chrono::duration_cast<chrono::seconds>(end - start).count()
          << " seconds." << endl;
 
-    auto rocksdb_stats = std::shared_ptr<::rocksdb::Statistics>{};
-    auto rocksdb_cache_size = config["rocksdb-cache-size"].as<size_t>();
-    auto completeInit = [&rocksdb_stats, rocksdb_cache_size](auto& db_options, auto& cf_descs) {
-      rocksdb_stats = completeRocksdbConfiguration(db_options, cf_descs, rocksdb_cache_size);
-    };
-    auto opts = storage::rocksdb::NativeClient::UserOptions{"kvbcbench_rocksdb_opts.ini", completeInit};
     auto db = storage::rocksdb::NativeClient::newClient(config["rocksdb-path"].as<std::string>(), false, opts);
     auto kvbc = kvbc::categorization::KeyValueBlockchain(
         db,
@@ -369,6 +485,11 @@ int main(int argc, char** argv) {
             {kCategoryImmutable, kvbc::categorization::CATEGORY_TYPE::immutable},
             {kCategoryVersioned, kvbc::categorization::CATEGORY_TYPE::versioned_kv}});
 
+    const auto capture_file = config["capture-file"].as<std::string>();
+    if (!capture_file.empty()) {
+      kvbc.startUpdatesCapture(capture_file);
+    }
+
     auto pre_exec_config = preExecConfig(config, input.block_merkle_read_keys.size(), input.ver_read_keys.size());
     auto pre_exec_sim = PreExecutionSimulator(pre_exec_config, input.block_merkle_read_keys, input.ver_read_keys, kvbc);
     pre_exec_sim.start();
@@ -381,6 +502,7 @@ int main(int argc, char** argv) {
     cout << "Adding blocks completed in = " << add_block_duration / 1000.0 << " seconds" << endl << endl;
 
     pre_exec_sim.stop();
+    kvbc.stopUpdatesCapture();
 
     printRocksDbProperties(db);
     printHistograms();
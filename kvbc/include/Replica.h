@@ -76,6 +76,8 @@ class Replica : public IReplica,
                              std::vector<std::optional<categorization::TaggedVersion>> &versions) const override;
 
   std::optional<categorization::Updates> getBlockUpdates(BlockId block_id) const override;
+  std::optional<categorization::Updates> getBlockUpdates(BlockId block_id,
+                                                         const std::set<std::string> &category_ids) const override;
 
   // Get the current genesis block ID in the system.
   BlockId getGenesisBlockId() const override;
@@ -94,11 +94,26 @@ class BlockMerkleCategory {
   //   In any event, blocks that aren't synced shouldn't even be eligible for pruning at an even higher level.
   void deleteLastReachableBlock(BlockId, const BlockMerkleOutput&, storage::rocksdb::NativeWriteBatch&);
 
+  // If set, deleteGenesisBlock() leaves the stale merkle nodes in the database and they must be deleted later on via
+  // deleteStaleDataBatch(). That takes the stale data deletion off the pruning path.
+  void deferStaleDataDeletion(bool defer) { defer_stale_data_deletion_ = defer; }
+
+  // Delete the stale data of at most `max_versions` tree versions, starting from the one after the last deleted tree
+  // version and up to (including) `tree_version`. The deletions are written to the database directly.
+  // Return the size in bytes of the written batch or 0 if there is nothing to delete.
+  std::size_t deleteStaleDataBatch(uint64_t tree_version, uint64_t max_versions);
+
+  // Compact the key ranges deleted by deleteStaleDataBatch() since the last call, reclaiming their disk space.
+  // Leaf nodes are keyed by key hashes and their deletions are spread over the whole key space - they are left to
+  // automatic compactions.
+  void compactDeletedStaleData();
+
   //
   // Accessors useful for tests or tools
   //
   uint64_t getLatestTreeVersion() const;
   uint64_t getLastDeletedTreeVersion() const;
+  Hash getRootHash() const { return tree_.get_root_hash().dataArray(); }
 
  private:
   void multiGet(const std::vector<Buffer>& versioned_keys,
@@ -167,10 +182,12 @@ class BlockMerkleCategory {
   // Delete a batch of stale merkle nodes as part of `deleteStaleData`.
   //
   // 1. Multiget a batch of stale indexes for tree versions in the range [`start`,`end`).
-  // 2. Create a WriteBatch of all the deletions for the keys in those indexes, as well as the stale
-  //    index keys themselves, and the last deleted tree version for this batch.
+  // 2. Create a WriteBatch of all the deletions for the keys in those indexes, a range deletion of the
+  //    stale index keys themselves, and the last deleted tree version for this batch.
   // 3. Atomically write the batch to the database.
-  void deleteStaleBatch(uint64_t start, uint64_t end);
+  //
+  // Return the size in bytes of the written batch.
+  std::size_t deleteStaleBatch(uint64_t start, uint64_t end);
 
   // Retrieve the latest versions for all raw keys in a block and return them along with the hashed keys.
   std::pair<std::vector<Hash>, std::vector<std::optional<TaggedVersion>>> getLatestVersions(
@@ -221,6 +238,13 @@ class BlockMerkleCategory {
 
   logging::Logger logger_;
   sparse_merkle::Tree tree_;
+
+  bool defer_stale_data_deletion_{false};
+
+  // The [min, max] keys of the internal nodes and tree versions deleted by deleteStaleBatch() that haven't been
+  // compacted yet.
+  std::optional<std::pair<Buffer, Buffer>> deleted_internal_nodes_;
+  std::optional<std::pair<uint64_t, uint64_t>> deleted_stale_versions_;
 };
 
 inline const MerkleValue& asMerkle(const Value& v) { return std::get<MerkleValue>(v); }
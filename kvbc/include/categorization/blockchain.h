@@ -73,6 +73,16 @@ class Blockchain {
     return RawBlock(block.value(), native_client_, categorires);
   }
 
+  std::optional<RawBlock> getRawBlock(const BlockId block_id,
+                                      const CategoriesMap& categorires,
+                                      const std::set<std::string>& category_ids) const {
+    auto block = getBlock(block_id);
+    if (!block) {
+      return std::optional<RawBlock>{};
+    }
+    return RawBlock(block.value(), native_client_, categorires, category_ids);
+  }
+
   std::optional<Hash> parentDigest(BlockId block_id) const {
     const auto block_ser = native_client_->getSlice(detail::BLOCKS_CF, Block::generateKey(block_id));
     if (!block_ser) {
@@ -92,7 +102,8 @@ class Blockchain {
    public:
     StateTransfer(const std::shared_ptr<concord::storage::rocksdb::NativeClient>& native_client)
         : native_client_{native_client} {
-      if (detail::createColumnFamilyIfNotExisting(detail::ST_CHAIN_CF, *native_client_.get())) {
+      if (detail::createColumnFamilyIfNotExisting(
+              detail::ST_CHAIN_CF, *native_client_.get(), detail::ColumnFamilyProfile::AppendOnly)) {
         LOG_INFO(CAT_BLOCK_LOG,
                  "Created [" << detail::ST_CHAIN_CF << "] column family for the state transfer blockchain");
       }
@@ -14,6 +14,8 @@
 #pragma once
 
 #include "updates.h"
+#include <set>
+#include <string>
 #include <utility>
 #include <block_digest.h>
 #include "details.h"
@@ -92,6 +94,12 @@ struct RawBlock {
            const std::shared_ptr<storage::rocksdb::NativeClient>& native_client,
            const CategoriesMap& categorires);
 
+  // Reconstructs only the updates of the given categories - values of other categories are not read from storage.
+  RawBlock(const Block& block,
+           const std::shared_ptr<storage::rocksdb::NativeClient>& native_client,
+           const CategoriesMap& categorires,
+           const std::set<std::string>& category_ids);
+
   BlockMerkleInput getUpdates(const std::string& category_id,
                               const BlockMerkleOutput& update_info,
                               const BlockId& block_id,
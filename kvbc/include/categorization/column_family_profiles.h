@@ -0,0 +1,50 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <rocksdb/options.h>
+
+#include <string>
+
+namespace concord::kvbc::categorization::detail {
+
+// The access pattern of a column family. Column families are created with RocksDB options tuned for their profile.
+enum class ColumnFamilyProfile {
+  // RocksDB default options (`base` is ignored).
+  Default,
+  // Keys are written in increasing order and read mostly sequentially (e.g. blocks by block ID). Large blocks, no
+  // filter as SST files don't overlap, compressed.
+  AppendOnly,
+  // Small values that are read by key, often for keys that don't exist (e.g. latest versions). Small blocks, whole-key
+  // bloom filter and hash index in data blocks.
+  PointLookup,
+  // Large tables of hash-keyed and incompressible values (e.g. merkle tree internal nodes). Partitioned index and
+  // filters, no compression.
+  HashKeyed,
+  // Large tables of versioned keys that start with a key hash (e.g. block merkle keys and leaf nodes). As HashKeyed,
+  // with a prefix bloom filter on the key hash on top of the whole-key one and compression of the lower levels.
+  VersionedHashKeyed,
+  // Large tables of compressible values that are read by key (e.g. versioned and immutable values). Partitioned index
+  // and filters, compressed.
+  LargeValues,
+};
+
+// Return the options of a column family with the given profile. The block cache is shared with `base` - usually the
+// options of the default column family. The other options are RocksDB defaults.
+::rocksdb::ColumnFamilyOptions columnFamilyOptions(ColumnFamilyProfile profile,
+                                                   const ::rocksdb::ColumnFamilyOptions &base);
+
+std::string toString(ColumnFamilyProfile profile);
+
+}  // namespace concord::kvbc::categorization::detail
@@ -15,6 +15,7 @@
 
 #include "base_types.h"
 #include "categorized_kvbc_msgs.cmf.hpp"
+#include "column_family_profiles.h"
 #include "rocksdb/native_client.h"
 
 #include <algorithm>
@@ -84,9 +85,13 @@ void deserialize(const Span &in, T &out) {
   deserialize(begin, begin + in.size(), out);
 }
 
-inline bool createColumnFamilyIfNotExisting(const std::string &cf, storage::rocksdb::NativeClient &db) {
+// Creates the column family with the options of its profile, based on the options of the default column family.
+inline bool createColumnFamilyIfNotExisting(const std::string &cf,
+                                            storage::rocksdb::NativeClient &db,
+                                            ColumnFamilyProfile profile) {
   if (!db.hasColumnFamily(cf)) {
-    db.createColumnFamily(cf);
+    const auto base = db.columnFamilyOptions(storage::rocksdb::NativeClient::defaultColumnFamily());
+    db.createColumnFamily(cf, columnFamilyOptions(profile, base));
     return true;
   }
   return false;
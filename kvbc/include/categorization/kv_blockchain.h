@@ -15,7 +15,10 @@
 
 #include "updates.h"
 #include "rocksdb/native_client.h"
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include "blocks.h"
 #include "blockchain.h"
 #include "immutable_kv_category.h"
@@ -23,6 +26,7 @@
 #include "versioned_kv_category.h"
 #include "kv_types.hpp"
 #include "categorization/types.h"
+#include "categorization/updates_capture.h"
 #include "thread_pool.hpp"
 #include "Metrics.hpp"
 #include "diagnostics.h"
@@ -44,15 +48,48 @@ class KeyValueBlockchain {
   KeyValueBlockchain(const std::shared_ptr<concord::storage::rocksdb::NativeClient>& native_client,
                      bool link_st_chain,
                      const std::optional<std::map<std::string, CATEGORY_TYPE>>& category_types = std::nullopt);
+  ~KeyValueBlockchain();
   /////////////////////// Add Block ///////////////////////
 
   BlockId addBlock(Updates&& updates);
 
+  // Record the updates of the blocks added by addBlock() to the capture file at `path`, replacing any previous
+  // capture. See UpdatesCaptureWriter.
+  void startUpdatesCapture(const std::string& path);
+  void stopUpdatesCapture();
+
+  /////////////////////// Snapshots ///////////////////////
+
+  // Export a consistent snapshot of the blockchain to the new directory `dir` as SST files: the state of all categories
+  // and the last `num_blocks` blocks, or all of them if nullopt. Blocks that are being state transferred are not
+  // exported. Return the ID of the last exported block.
+  //
+  // The state of the categories includes the versions of keys from blocks before the exported ones that haven't been
+  // pruned yet. They are kept as they are, as the ones still needed by the exported blocks aren't known.
+  BlockId exportSnapshot(const std::string& dir, const std::optional<std::uint64_t>& num_blocks = std::nullopt) const;
+
+  // Ingest a snapshot exported by exportSnapshot() into a database without blocks, and verify the digest of the last
+  // ingested block against `expected_last_block_digest`, the parent digests of the ingested blocks, the block merkle
+  // root hash of the last one and the versioned and immutable root hashes of all of them. The snapshot itself can't be
+  // trusted, so the expected digest must come from elsewhere, e.g. from a stable checkpoint. Throws if a digest or a
+  // root hash doesn't match or can't be verified, e.g. because a block merkle category was pruned after its last
+  // update. The SST files are moved into the database. The database can then be opened by a KeyValueBlockchain. Return
+  // the ID of the last ingested block.
+  static BlockId importSnapshot(const std::shared_ptr<concord::storage::rocksdb::NativeClient>& native_client,
+                                const std::string& dir,
+                                const BlockDigest& expected_last_block_digest);
+
   /////////////////////// Delete block ///////////////////////
 
   bool deleteBlock(const BlockId& blockId);
   void deleteLastReachableBlock();
 
+  // If concord.kvbc.backgroundStaleDataDeletion is set, the stale merkle data of pruned blocks is deleted by a
+  // background thread, at most concord.kvbc.staleDataDeletionRateLimitBytesPerSec bytes per second (0 means
+  // unlimited). If concord.kvbc.compactDeletedStaleData is set too, the deleted ranges are then compacted to reclaim
+  // their disk space right away. Block until it has caught up with the pruned blocks.
+  void waitForStaleDataDeletion();
+
   /////////////////////// Raw Blocks ///////////////////////
 
   // Adds raw block and tries to link the state transfer blockchain to the main blockchain
@@ -108,6 +145,10 @@ class KeyValueBlockchain {
   // Get the updates that were used to create `block_id`.
   std::optional<Updates> getBlockUpdates(BlockId block_id) const;
 
+  // Get the updates of the given categories only, as used to create `block_id`. Values of other categories in the block
+  // are not read.
+  std::optional<Updates> getBlockUpdates(BlockId block_id, const std::set<std::string>& category_ids) const;
+
   // Get a map of category_id and stale keys for `block_id`
   std::map<std::string, std::vector<std::string>> getBlockStaleKeys(BlockId block_id) const;
 
@@ -150,6 +191,12 @@ class KeyValueBlockchain {
   void deleteStateTransferBlock(const BlockId block_id);
   void deleteGenesisBlock();
 
+  // Background deletion of stale merkle data
+  void startStaleDataDeletion();
+  void stopStaleDataDeletion();
+  void scheduleStaleDataDeletion(const std::string& category_id, uint64_t tree_version);
+  void staleDataDeletionLoop();
+
   // Delete per category
   void deleteGenesisBlock(BlockId block_id,
                           const std::string& category_id,
@@ -214,6 +261,25 @@ class KeyValueBlockchain {
   // currently we are operating with single thread
   util::ThreadPool thread_pool_{1};
 
+  // Set while capturing the updates of added blocks
+  std::unique_ptr<UpdatesCaptureWriter> updates_capture_;
+
+  // Background deletion of stale merkle data. Block merkle category ID -> tree version up to which to delete.
+  const bool background_stale_data_deletion_{
+      bftEngine::ReplicaConfig::instance().get("concord.kvbc.backgroundStaleDataDeletion", false)};
+  // Bytes per second, 0 means unlimited
+  const uint64_t stale_data_deletion_rate_limit_{bftEngine::ReplicaConfig::instance().get<uint64_t>(
+      "concord.kvbc.staleDataDeletionRateLimitBytesPerSec", 32 * 1024 * 1024)};
+  // Compact the deleted ranges right away instead of leaving them to the automatic compactions
+  const bool compact_deleted_stale_data_{
+      bftEngine::ReplicaConfig::instance().get("concord.kvbc.compactDeletedStaleData", false)};
+  std::map<std::string, std::pair<detail::BlockMerkleCategory*, uint64_t>> stale_data_deletion_targets_;
+  bool stop_stale_data_deletion_{false};
+  std::mutex stale_data_deletion_mutex_;
+  std::condition_variable stale_data_deletion_cv_;
+  std::condition_variable stale_data_deleted_cv_;
+  std::thread stale_data_deletion_thread_;
+
   // metrics
   std::shared_ptr<concordMetrics::Aggregator> aggregator_;
   concordMetrics::Component delete_metrics_comp_;
@@ -269,10 +335,15 @@ class KeyValueBlockchain {
       auto& registrar = concord::diagnostics::RegistrarSingleton::getInstance();
       registrar.perf.registerComponent("kvbc",
                                        {addBlock,
+                                        addBlockCategoryUpdates,
+                                        hashParentBlock,
+                                        addBlockWriteBatch,
+                                        addBlockDbWrite,
                                         addRawBlock,
                                         getRawBlock,
                                         deleteBlock,
                                         deleteLastReachableBlock,
+                                        deleteStaleDataBatch,
                                         get,
                                         getLatest,
                                         multiGet,
@@ -287,11 +358,19 @@ class KeyValueBlockchain {
     // DEFINE_SHARED_RECORDER(may_have_conflict_between, 1, MAX_VALUE_NANOSECONDS, 3,
     // concord::diagnostics::Unit::NANOSECONDS);
     DEFINE_SHARED_RECORDER(addBlock, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    // The phases of addBlock()
+    DEFINE_SHARED_RECORDER(
+        addBlockCategoryUpdates, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(hashParentBlock, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(addBlockWriteBatch, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(addBlockDbWrite, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(addRawBlock, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(getRawBlock, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(deleteBlock, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(
         deleteLastReachableBlock, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(
+        deleteStaleDataBatch, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(get, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(getLatest, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
     DEFINE_SHARED_RECORDER(multiGet, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
@@ -0,0 +1,74 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include "base_types.h"
+#include "categorized_kvbc_msgs.cmf.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace concord::kvbc::categorization {
+
+// Writes the input of KeyValueBlockchain::addBlock() to a capture file, so that real workloads can be replayed offline
+// (see kvbcbench --replay-file). The format of the file is described in categorized_kvbc_msgs.cmf.
+//
+// Throws std::runtime_error on I/O errors.
+class UpdatesCaptureWriter {
+ public:
+  // Create or truncate the file at `path`. Blocks must only update the given categories.
+  UpdatesCaptureWriter(const std::string& path, const std::map<std::string, CATEGORY_TYPE>& category_types);
+
+  void write(const CategoryInput& updates);
+
+  // Flush the buffered blocks to the file.
+  void flush();
+
+ private:
+  void writeRecord();
+
+  const std::string path_;
+  std::ofstream out_;
+  const std::chrono::steady_clock::time_point start_;
+  std::vector<uint8_t> buffer_;
+};
+
+// Reads a capture file written by UpdatesCaptureWriter.
+//
+// Throws std::runtime_error on I/O errors and if the file is not a capture file.
+class UpdatesCaptureReader {
+ public:
+  explicit UpdatesCaptureReader(const std::string& path);
+
+  const std::map<std::string, CATEGORY_TYPE>& categoryTypes() const { return category_types_; }
+
+  // Return the next captured block or std::nullopt after the last one. A truncated last block, as left by a process
+  // that didn't stop capturing, is treated as the end of the capture.
+  std::optional<CapturedUpdates> next();
+
+ private:
+  bool readRecord();
+
+  const std::string path_;
+  std::ifstream in_;
+  std::map<std::string, CATEGORY_TYPE> category_types_;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace concord::kvbc::categorization
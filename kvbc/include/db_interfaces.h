@@ -10,6 +10,7 @@
 #include "categorization/updates.h"
 
 #include <optional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -77,6 +78,24 @@ class IReader {
   // Return std::nullopt if this block doesn't exist.
   virtual std::optional<categorization::Updates> getBlockUpdates(BlockId block_id) const = 0;
 
+  // Get the updates of the given categories only, as used to create `block_id`.
+  // Return std::nullopt if this block doesn't exist.
+  // Implementations that can read a subset of the block's categories should override this method.
+  virtual std::optional<categorization::Updates> getBlockUpdates(BlockId block_id,
+                                                                 const std::set<std::string> &category_ids) const {
+    auto updates = getBlockUpdates(block_id);
+    if (!updates) {
+      return std::nullopt;
+    }
+    auto filtered = categorization::CategoryInput{};
+    for (const auto &[category_id, category_updates] : updates->categoryUpdates().kv) {
+      if (category_ids.count(category_id)) {
+        filtered.kv.emplace(category_id, category_updates);
+      }
+    }
+    return categorization::Updates{std::move(filtered)};
+  }
+
   // Get the current genesis block ID in the system.
   virtual BlockId getGenesisBlockId() const = 0;
 
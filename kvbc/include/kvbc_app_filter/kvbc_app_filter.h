@@ -18,10 +18,19 @@
 
 #include "categorization/updates.h"
 #include <atomic>
-#include <boost/lockfree/spsc_queue.hpp>
+#include <functional>
 #include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 #include "Logger.hpp"
+#include "openssl_crypto.hpp"
 
 #include "block_update/block_update.hpp"
 #include "db_interfaces.h"
@@ -42,6 +51,12 @@ struct KvbFilteredUpdate {
   OrderedKVPairs kv_pairs;
 };
 
+// Values of an update's key-value pairs decoded from ValueWithTrids, in the order of the update's keys. Lets several
+// filters of the same update decode each value at most once. A value that cannot be decoded is std::nullopt.
+struct KvbDecodedValues {
+  std::vector<std::optional<std::optional<std::string>>> values;
+};
+
 class KvbReadError : public std::exception {
  public:
   explicit KvbReadError(const std::string &what) : msg(what){};
@@ -63,13 +78,81 @@ class InvalidBlockRange : public std::exception {
   std::string msg_;
 };
 
+// Checkpoints of state hash computations (see KvbAppFilter::readBlockRangeHash)
+// so that the state hash up to a block only needs to read the blocks after the
+// nearest checkpoint. A checkpoint is kept every `interval` blocks per filter
+// (client id and key prefix) and start block. Only the latest
+// `max_checkpoints_per_filter` checkpoints of a filter are kept, for up to
+// `max_filters` filters - the least recently used filter is evicted to make
+// room for a new one. Thread-safe.
+class KvbStateHashIndex {
+ public:
+  // (client id, key prefix, start block)
+  using Key = std::tuple<std::string, std::string, kvbc::BlockId>;
+
+  KvbStateHashIndex(kvbc::BlockId interval, size_t max_filters, size_t max_checkpoints_per_filter)
+      : interval_(interval), max_filters_(max_filters), max_checkpoints_per_filter_(max_checkpoints_per_filter) {
+    ConcordAssertGT(interval, 0);
+    ConcordAssertGT(max_checkpoints_per_filter, 0);
+  }
+
+  kvbc::BlockId interval() const { return interval_; }
+
+  // Return the checkpoint with the highest block ID that is not greater than the given one, if any.
+  std::optional<std::pair<kvbc::BlockId, util::openssl_utils::SHA256Hasher>> nearest(const Key &key,
+                                                                                     kvbc::BlockId block_id) const;
+
+  // Add a checkpoint of the state hash computation, after hashing the given block.
+  void add(const Key &key, kvbc::BlockId block_id, const util::openssl_utils::SHA256Hasher &hasher);
+
+  // Record how far the state hash computation got, i.e. the state after hashing the given block. Live updates extend
+  // the computation from there (see extend()).
+  void setLatest(const Key &key, kvbc::BlockId block_id, const util::openssl_utils::SHA256Hasher &hasher);
+
+  // Extend the state hash computations of the given filter that got up to the block before the given one by the
+  // hash of the block's filtered update. Checkpoints are added as if the blocks were read from storage. The hash is
+  // only computed if a computation is extended.
+  void extend(const std::string &client_id,
+              const std::string &key_prefix,
+              kvbc::BlockId block_id,
+              const std::function<std::string()> &update_hash);
+
+ private:
+  struct Checkpoints {
+    std::map<kvbc::BlockId, util::openssl_utils::SHA256Hasher> by_block;
+    // The state after hashing the latest block
+    std::optional<std::pair<kvbc::BlockId, util::openssl_utils::SHA256Hasher>> latest;
+    // The position of the filter in lru_
+    std::list<Key>::iterator lru_it;
+  };
+
+  // Return the checkpoints of the given filter, if it has any or can have them
+  Checkpoints *checkpoints(const Key &key);
+  void addCheckpoint(Checkpoints &filter_checkpoints,
+                     kvbc::BlockId block_id,
+                     const util::openssl_utils::SHA256Hasher &hasher) const;
+  void markUsed(const Checkpoints &filter_checkpoints) const;
+
+  const kvbc::BlockId interval_;
+  const size_t max_filters_;
+  const size_t max_checkpoints_per_filter_;
+  mutable std::mutex mutex_;
+  std::map<Key, Checkpoints> checkpoints_;
+  // The filters in checkpoints_, the most recently used first
+  mutable std::list<Key> lru_;
+};
+
 class KvbAppFilter {
  public:
-  KvbAppFilter(const concord::kvbc::IReader *rostorage, const std::string &client_id, const std::string &key_prefix)
+  KvbAppFilter(const concord::kvbc::IReader *rostorage,
+               const std::string &client_id,
+               const std::string &key_prefix,
+               KvbStateHashIndex *state_hash_index = nullptr)
       : logger_(logging::getLogger("concord.storage.KvbFilter")),
         rostorage_(rostorage),
         client_id_(client_id),
-        key_prefix_(key_prefix) {}
+        key_prefix_(key_prefix),
+        state_hash_index_(state_hash_index) {}
 
   // Filter the given update
   KvbFilteredUpdate filterUpdate(const KvbUpdate &update);
@@ -77,37 +160,46 @@ class KvbAppFilter {
   // Compute hash for the given update
   std::string hashUpdate(const KvbFilteredUpdate &update);
 
-  // Return all key-value pairs from the KVB in the block range [earliest block
-  // available, given block_id] with the following conditions:
-  //   * The key-value pair is part of a block
-  //   * The key starts with the given key_prefix
-  // The result is pushed to the given queue. Thereby, the caller is responsible
-  // for consuming the elements from the queue. The function will block if the
-  // queue is full and therefore, it cannot push a new key-value pair.
-  // Note: single producer & single consumer queue.
-  void readBlockRange(kvbc::BlockId start,
-                      kvbc::BlockId end,
-                      boost::lockfree::spsc_queue<KvbFilteredUpdate> &queue_out,
-                      const std::atomic_bool &stop_execution);
-
   // Compute the state hash of all key-value pairs in the range of [earliest
   // block available, given block_id] based on the given KvbAppFilter::AppType.
+  // If the filter has a state hash index, the computation starts at the
+  // nearest checkpoint and adds checkpoints for the blocks it reads.
   std::string readBlockRangeHash(kvbc::BlockId start, kvbc::BlockId end);
 
   // Compute the hash of a single block based on the given
   // KvbAppFilter::AppType.
   std::string readBlockHash(kvbc::BlockId block_id);
 
+  // Read and filter a single block.
+  // Thread-safe, i.e. several blocks can be read in parallel.
+  KvbFilteredUpdate readBlock(kvbc::BlockId block_id);
+
+  // Extend the indexed state hash computations of this filter by a live update of the given block, so that they
+  // don't need to read it from storage later. `update_hash` returns hashUpdate() of the filtered update.
+  void extendStateHash(kvbc::BlockId block_id, const std::function<std::string()> &update_hash);
+
   std::optional<kvbc::categorization::ImmutableInput> getBlockEvents(kvbc::BlockId block_id, std::string &cid);
 
   // Filter the given set of key-value pairs and return the result.
   KvbFilteredUpdate::OrderedKVPairs filterKeyValuePairs(const kvbc::categorization::ImmutableInput &kvs);
 
+  // Same as above, but takes the decoded values from (and adds them to) `decoded`, which is shared with the other
+  // filters of the same key-value pairs.
+  KvbFilteredUpdate::OrderedKVPairs filterKeyValuePairs(const kvbc::categorization::ImmutableInput &kvs,
+                                                        KvbDecodedValues &decoded);
+
+  // Filter the given update, sharing the decoded values with the other filters of the same update.
+  KvbFilteredUpdate filterUpdate(const KvbUpdate &update, KvbDecodedValues &decoded);
+
+  const std::string &clientId() const { return client_id_; }
+  const std::string &keyPrefix() const { return key_prefix_; }
+
  private:
   logging::Logger logger_;
   const concord::kvbc::IReader *rostorage_;
   const std::string client_id_;
   const std::string key_prefix_;
+  KvbStateHashIndex *const state_hash_index_;
 };
 
 }  // namespace kvbc
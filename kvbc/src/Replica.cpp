@@ -185,6 +185,11 @@ std::optional<categorization::Updates> Replica::getBlockUpdates(BlockId block_id
   return m_kvBlockchain->getBlockUpdates(block_id);
 }
 
+std::optional<categorization::Updates> Replica::getBlockUpdates(BlockId block_id,
+                                                                const std::set<std::string> &category_ids) const {
+  return m_kvBlockchain->getBlockUpdates(block_id, category_ids);
+}
+
 BlockId Replica::getGenesisBlockId() const {
   if (replicaConfig_.isReadOnly) return m_bcDbAdapter->getGenesisBlockId();
   return m_kvBlockchain->getGenesisBlockId();
@@ -256,6 +261,22 @@ Replica::Replica(ICommunication *comm,
   }
 #endif
 
+#if defined USE_COMM_PLAIN_TCP || defined USE_COMM_TLS_TCP
+  stConfig.maxNumberOfChunksInAdaptiveBatch =
+      replicaConfig_.get<uint16_t>("concord.bft.st.maxNumberOfChunksInAdaptiveBatch", 1024);
+#endif
+
+  stConfig.resPagesMerkleTreeDigest = replicaConfig_.get("concord.bft.st.resPagesMerkleTreeDigest", false);
+
+  const auto stBlockCodec = replicaConfig_.get<std::string>("concord.bft.st.blockCodec", "none");
+  if (stBlockCodec == "lz4") {
+    stConfig.blockCodec = bftEngine::bcst::BlockCodec::LZ4;
+  } else if (stBlockCodec == "zstd") {
+    stConfig.blockCodec = bftEngine::bcst::BlockCodec::ZSTD;
+  } else if (stBlockCodec != "none") {
+    LOG_WARN(logger, "Unknown state transfer block codec " << stBlockCodec << ", blocks are not compressed");
+  }
+
   if (!replicaConfig.isReadOnly) {
     const auto linkStChain = true;
     auto [it, inserted] =
@@ -268,6 +289,10 @@ Replica::Replica(ICommunication *comm,
     m_kvBlockchain.emplace(
         storage::rocksdb::NativeClient::fromIDBClient(m_dbSet.dataDBClient), linkStChain, kvbc_categories);
     m_kvBlockchain->setAggregator(aggregator);
+    const auto capture_path = replicaConfig_.get<std::string>("concord.kvbc.captureUpdatesPath", "");
+    if (!capture_path.empty()) {
+      m_kvBlockchain->startUpdatesCapture(capture_path);
+    }
 
     auto &registrar = concord::diagnostics::RegistrarSingleton::getInstance();
     concord::diagnostics::StatusHandler handler(
@@ -299,7 +299,7 @@ std::vector<KeyHash> remainingActiveKeys(std::vector<KeyHash>& previously_active
   return active_keys;
 }
 
-void addStaleKeysToDeleteBatch(const ::rocksdb::PinnableSlice& slice, uint64_t tree_version, NativeWriteBatch& batch) {
+StaleKeys addStaleKeysToDeleteBatch(const ::rocksdb::PinnableSlice& slice, NativeWriteBatch& batch) {
   auto stale = StaleKeys{};
   deserialize(slice, stale);
   for (auto& key : stale.internal_keys) {
@@ -308,17 +308,29 @@ void addStaleKeysToDeleteBatch(const ::rocksdb::PinnableSlice& slice, uint64_t t
   for (auto& key : stale.leaf_keys) {
     batch.del(BLOCK_MERKLE_LEAF_NODES_CF, key);
   }
-  batch.del(BLOCK_MERKLE_STALE_CF, serialize(TreeVersion{tree_version}));
+  return stale;
+}
+
+// Extend `range` to include `key`.
+void extendKeyRange(std::optional<std::pair<Buffer, Buffer>>& range, const Buffer& key) {
+  if (!range) {
+    range.emplace(key, key);
+  } else if (key < range->first) {
+    range->first = key;
+  } else if (range->second < key) {
+    range->second = key;
+  }
 }
 
 BlockMerkleCategory::BlockMerkleCategory(const std::shared_ptr<storage::rocksdb::NativeClient>& db) : db_{db} {
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_INTERNAL_NODES_CF, *db);
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_LEAF_NODES_CF, *db);
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_LATEST_KEY_VERSION_CF, *db);
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_KEYS_CF, *db);
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_STALE_CF, *db);
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_ACTIVE_KEYS_FROM_PRUNED_BLOCKS_CF, *db);
-  createColumnFamilyIfNotExisting(BLOCK_MERKLE_PRUNED_BLOCKS_CF, *db);
+  createColumnFamilyIfNotExisting(BLOCK_MERKLE_INTERNAL_NODES_CF, *db, ColumnFamilyProfile::HashKeyed);
+  createColumnFamilyIfNotExisting(BLOCK_MERKLE_LEAF_NODES_CF, *db, ColumnFamilyProfile::VersionedHashKeyed);
+  createColumnFamilyIfNotExisting(BLOCK_MERKLE_LATEST_KEY_VERSION_CF, *db, ColumnFamilyProfile::PointLookup);
+  createColumnFamilyIfNotExisting(BLOCK_MERKLE_KEYS_CF, *db, ColumnFamilyProfile::VersionedHashKeyed);
+  createColumnFamilyIfNotExisting(BLOCK_MERKLE_STALE_CF, *db, ColumnFamilyProfile::AppendOnly);
+  createColumnFamilyIfNotExisting(
+      BLOCK_MERKLE_ACTIVE_KEYS_FROM_PRUNED_BLOCKS_CF, *db, ColumnFamilyProfile::PointLookup);
+  createColumnFamilyIfNotExisting(BLOCK_MERKLE_PRUNED_BLOCKS_CF, *db, ColumnFamilyProfile::AppendOnly);
   tree_ = sparse_merkle::Tree{std::make_shared<Reader>(*db_)};
 }
 
@@ -341,14 +353,15 @@ std::optional<Value> BlockMerkleCategory::get(const std::string& key, BlockId bl
 
 std::optional<Value> BlockMerkleCategory::get(const Hash& hashed_key, BlockId block_id) const {
   auto key = VersionedKey{KeyHash{hashed_key}, block_id};
-  if (auto ser = db_->get(BLOCK_MERKLE_KEYS_CF, serialize(key))) {
-    auto v = DbValue{};
+  if (auto ser = db_->getSlice(BLOCK_MERKLE_KEYS_CF, serialize(key))) {
+    // The value is copied once, from the slice.
+    auto v = DbValueView{};
     deserialize(*ser, v);
     if (v.deleted) {
       return std::nullopt;
     }
     auto rv = MerkleValue{};
-    rv.data = std::move(v.data);
+    rv.data = std::string{v.data};
     rv.block_id = block_id;
     return rv;
   }
@@ -401,12 +414,12 @@ void BlockMerkleCategory::multiGet(const std::vector<Buffer>& versioned_keys,
     const auto& slice = slices[i];
     const auto version = versions[i];
     if (status.ok()) {
-      auto v = DbValue{};
+      auto v = DbValueView{};
       deserialize(slice, v);
       if (v.deleted) {
         values.push_back(std::nullopt);
       } else {
-        values.push_back(MerkleValue{{version, v.data}});
+        values.push_back(MerkleValue{{version, std::string{v.data}}});
       }
     } else if (status.IsNotFound()) {
       values.push_back(std::nullopt);
@@ -592,7 +605,9 @@ size_t BlockMerkleCategory::deleteGenesisBlock(BlockId block_id,
   }
   auto update_batch = tree_.update(block_adds, block_removes);
   putMerkleNodes(batch, std::move(update_batch));
-  deleteStaleData(out.state_root_version, batch);
+  if (!defer_stale_data_deletion_) {
+    deleteStaleData(out.state_root_version, batch);
+  }
   return num_of_deletes;
 }
 
@@ -663,7 +678,28 @@ uint64_t BlockMerkleCategory::getLastDeletedTreeVersion() const {
   return last_deleted;
 }
 
-void BlockMerkleCategory::deleteStaleBatch(uint64_t start, uint64_t end) {
+std::size_t BlockMerkleCategory::deleteStaleDataBatch(uint64_t tree_version, uint64_t max_versions) {
+  const auto start = getLastDeletedTreeVersion() + 1;
+  if (start > tree_version || max_versions == 0) {
+    return 0;
+  }
+  return deleteStaleBatch(start, std::min(start + max_versions, tree_version + 1));
+}
+
+void BlockMerkleCategory::compactDeletedStaleData() {
+  if (deleted_stale_versions_) {
+    db_->compactRange(BLOCK_MERKLE_STALE_CF,
+                      serialize(TreeVersion{deleted_stale_versions_->first}),
+                      serialize(TreeVersion{deleted_stale_versions_->second}));
+    deleted_stale_versions_.reset();
+  }
+  if (deleted_internal_nodes_) {
+    db_->compactRange(BLOCK_MERKLE_INTERNAL_NODES_CF, deleted_internal_nodes_->first, deleted_internal_nodes_->second);
+    deleted_internal_nodes_.reset();
+  }
+}
+
+std::size_t BlockMerkleCategory::deleteStaleBatch(uint64_t start, uint64_t end) {
   auto keys = std::vector<Buffer>{};
   keys.reserve(end - start);
   for (auto i = start; i < end; ++i) {
@@ -679,13 +715,27 @@ void BlockMerkleCategory::deleteStaleBatch(uint64_t start, uint64_t end) {
     const auto& status = statuses[i];
     const auto& slice = slices[i];
     if (status.ok()) {
-      addStaleKeysToDeleteBatch(slice, start + i, batch);
+      const auto stale = addStaleKeysToDeleteBatch(slice, batch);
+      for (const auto& key : stale.internal_keys) {
+        extendKeyRange(deleted_internal_nodes_, key);
+      }
     } else {
       throw std::runtime_error{"BlockMerkleCategory multiGet() failure: " + status.ToString()};
     }
   }
+  if (start < end) {
+    // Stale indexes are keyed by big-endian tree versions and are, therefore, contiguous.
+    batch.delRange(BLOCK_MERKLE_STALE_CF, keys.front(), serialize(TreeVersion{end}));
+    if (deleted_stale_versions_) {
+      deleted_stale_versions_->second = end - 1;
+    } else {
+      deleted_stale_versions_.emplace(start, end - 1);
+    }
+  }
   putLastDeletedTreeVersion(end - 1, batch);
+  const auto size = batch.size();
   db_->write(std::move(batch));
+  return size;
 }
 
 void BlockMerkleCategory::deleteStaleData(uint64_t tree_version, NativeWriteBatch& batch) {
@@ -705,7 +755,8 @@ void BlockMerkleCategory::deleteStaleData(uint64_t tree_version, NativeWriteBatc
   // Create a batch to delete stale keys for this tree version
   auto ser_stale = db_->getSlice(BLOCK_MERKLE_STALE_CF, serialize(TreeVersion{tree_version}));
   ConcordAssert(ser_stale.has_value());
-  addStaleKeysToDeleteBatch(*ser_stale, tree_version, batch);
+  addStaleKeysToDeleteBatch(*ser_stale, batch);
+  batch.del(BLOCK_MERKLE_STALE_CF, serialize(TreeVersion{tree_version}));
   putLastDeletedTreeVersion(tree_version, batch);
 }
 
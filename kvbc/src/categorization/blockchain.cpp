@@ -18,7 +18,8 @@ namespace concord::kvbc::categorization::detail {
 
 Blockchain::Blockchain(const std::shared_ptr<concord::storage::rocksdb::NativeClient>& native_client)
     : native_client_{native_client} {
-  if (detail::createColumnFamilyIfNotExisting(detail::BLOCKS_CF, *native_client_.get())) {
+  if (detail::createColumnFamilyIfNotExisting(
+          detail::BLOCKS_CF, *native_client_.get(), detail::ColumnFamilyProfile::AppendOnly)) {
     LOG_INFO(CAT_BLOCK_LOG, "Created [" << detail::BLOCKS_CF << "] column family for the main blockchain");
   }
   auto last_reachable_block_id = loadLastReachableBlockId();
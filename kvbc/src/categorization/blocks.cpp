@@ -37,6 +37,24 @@ RawBlock::RawBlock(const Block& block,
   }
 }
 
+RawBlock::RawBlock(const Block& block,
+                   const std::shared_ptr<storage::rocksdb::NativeClient>& native_client,
+                   const CategoriesMap& categorires,
+                   const std::set<std::string>& category_ids) {
+  data.parent_digest = block.data.parent_digest;
+  for (auto& [cat_id, update_info] : block.data.categories_updates_info) {
+    if (category_ids.count(cat_id) == 0) {
+      continue;
+    }
+    std::visit(
+        [category_id = cat_id, &block, this, &native_client, &categorires](const auto& update_info) {
+          auto category_updates = getUpdates(category_id, update_info, block.id(), native_client, categorires);
+          data.updates.kv.emplace(category_id, std::move(category_updates));
+        },
+        update_info);
+  }
+}
+
 // Reconstructs the updates data as recieved from the user
 // This set methods are overloaded in order to construct the appropriate updates
 
@@ -0,0 +1,139 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "categorization/column_family_profiles.h"
+
+#include "categorization/base_types.h"
+
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/table.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace concord::kvbc::categorization::detail {
+
+namespace {
+
+constexpr auto kBloomBitsPerKey = 10;
+
+// Default table options that share the block cache of `base`.
+::rocksdb::BlockBasedTableOptions baseTableOptions(const ::rocksdb::ColumnFamilyOptions &base) {
+  auto table_options = ::rocksdb::BlockBasedTableOptions{};
+  if (base.table_factory && std::strcmp(base.table_factory->Name(), "BlockBasedTable") == 0) {
+    table_options.block_cache =
+        reinterpret_cast<::rocksdb::BlockBasedTableOptions *>(base.table_factory->GetOptions())->block_cache;
+  }
+  return table_options;
+}
+
+// Levels 0 and 1 are rewritten soon, so don't pay for compressing them. LZ4 is cheap to decompress on reads, ZSTD
+// packs the bottommost level that holds most of the data.
+void compressLowerLevels(::rocksdb::ColumnFamilyOptions &options) {
+  options.compression_per_level.assign(options.num_levels, ::rocksdb::kLZ4Compression);
+  for (auto level = 0; level < 2 && level < options.num_levels; ++level) {
+    options.compression_per_level[level] = ::rocksdb::kNoCompression;
+  }
+  options.bottommost_compression = ::rocksdb::kZSTD;
+}
+
+void disableCompression(::rocksdb::ColumnFamilyOptions &options) {
+  options.compression_per_level.clear();
+  options.compression = ::rocksdb::kNoCompression;
+  options.bottommost_compression = ::rocksdb::kDisableCompressionOption;
+}
+
+// Two-level index and filters for large tables so that only the top-level index has to stay in memory.
+void partitionIndexAndFilters(::rocksdb::BlockBasedTableOptions &table_options) {
+  table_options.index_type = ::rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+  table_options.partition_filters = true;
+  table_options.metadata_block_size = 4096;
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.cache_index_and_filter_blocks_with_high_priority = true;
+  table_options.pin_top_level_index_and_filter = true;
+}
+
+}  // namespace
+
+::rocksdb::ColumnFamilyOptions columnFamilyOptions(ColumnFamilyProfile profile,
+                                                   const ::rocksdb::ColumnFamilyOptions &base) {
+  if (profile == ColumnFamilyProfile::Default) {
+    return ::rocksdb::ColumnFamilyOptions{};
+  }
+
+  // Only the block cache is shared with `base`. The write buffers and compaction triggers of the default column family
+  // are tuned for its own load and would be multiplied by the number of column families.
+  auto options = ::rocksdb::ColumnFamilyOptions{};
+  auto table_options = baseTableOptions(base);
+  table_options.filter_policy.reset(::rocksdb::NewBloomFilterPolicy(kBloomBitsPerKey, false));
+  table_options.whole_key_filtering = true;
+
+  switch (profile) {
+    case ColumnFamilyProfile::Default:
+      break;
+    case ColumnFamilyProfile::AppendOnly:
+      table_options.block_size = 32 * 1024;
+      table_options.filter_policy.reset();
+      compressLowerLevels(options);
+      break;
+    case ColumnFamilyProfile::PointLookup:
+      table_options.block_size = 4 * 1024;
+      table_options.data_block_index_type = ::rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+      table_options.cache_index_and_filter_blocks = true;
+      table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+      options.memtable_whole_key_filtering = true;
+      options.memtable_prefix_bloom_size_ratio = 0.02;
+      compressLowerLevels(options);
+      break;
+    case ColumnFamilyProfile::HashKeyed:
+      table_options.block_size = 16 * 1024;
+      partitionIndexAndFilters(table_options);
+      disableCompression(options);
+      break;
+    case ColumnFamilyProfile::VersionedHashKeyed:
+      table_options.block_size = 16 * 1024;
+      partitionIndexAndFilters(table_options);
+      options.prefix_extractor.reset(::rocksdb::NewFixedPrefixTransform(sizeof(Hash)));
+      compressLowerLevels(options);
+      break;
+    case ColumnFamilyProfile::LargeValues:
+      table_options.block_size = 16 * 1024;
+      partitionIndexAndFilters(table_options);
+      compressLowerLevels(options);
+      break;
+  }
+
+  options.table_factory.reset(::rocksdb::NewBlockBasedTableFactory(table_options));
+  return options;
+}
+
+std::string toString(ColumnFamilyProfile profile) {
+  switch (profile) {
+    case ColumnFamilyProfile::Default:
+      return "Default";
+    case ColumnFamilyProfile::AppendOnly:
+      return "AppendOnly";
+    case ColumnFamilyProfile::PointLookup:
+      return "PointLookup";
+    case ColumnFamilyProfile::HashKeyed:
+      return "HashKeyed";
+    case ColumnFamilyProfile::VersionedHashKeyed:
+      return "VersionedHashKeyed";
+    case ColumnFamilyProfile::LargeValues:
+      return "LargeValues";
+  }
+  throw std::invalid_argument{"Unknown column family profile"};
+}
+
+}  // namespace concord::kvbc::categorization::detail
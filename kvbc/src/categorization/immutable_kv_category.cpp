@@ -71,7 +71,7 @@ ImmutableValue value(const Span &ser) {
 ImmutableKeyValueCategory::ImmutableKeyValueCategory(const std::string &category_id,
                                                      const std::shared_ptr<storage::rocksdb::NativeClient> &db)
     : cf_{category_id + IMMUTABLE_KV_CF_SUFFIX}, db_{db} {
-  createColumnFamilyIfNotExisting(cf_, *db_);
+  createColumnFamilyIfNotExisting(cf_, *db_, ColumnFamilyProfile::LargeValues);
 }
 
 ImmutableOutput ImmutableKeyValueCategory::add(BlockId block_id,
@@ -181,9 +181,11 @@ void ImmutableKeyValueCategory::multiGet(const std::vector<std::string> &keys,
     const auto &slice = slices[i];
     const auto version = versions[i];
     if (status.ok()) {
-      const auto v = value(slice);
+      // Only copy the values of the requested versions.
+      auto v = ImmutableDbValueView{};
+      deserialize(slice, v);
       if (v.block_id == version) {
-        values.push_back(v);
+        values.push_back(ImmutableValue{{v.block_id, std::string{v.data}}});
       } else {
         values.push_back(std::nullopt);
       }
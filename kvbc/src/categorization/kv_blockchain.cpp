@@ -18,6 +18,10 @@
 #include "diagnostics.h"
 #include "performance_handler.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <stdexcept>
 
 namespace concord::kvbc::categorization {
@@ -25,6 +29,74 @@ namespace concord::kvbc::categorization {
 using ::bftEngine::bcst::computeBlockDigest;
 using concordUtils::toPair;
 
+namespace fs = std::filesystem;
+
+namespace {
+
+const auto kSnapshotManifestFile = std::string{"snapshot_manifest"};
+
+std::string snapshotSstFile(const std::string& dir, const std::string& cf) {
+  return (fs::path{dir} / (cf + ".sst")).string();
+}
+
+void updateRootHash(const std::string& key, const std::string& value, Hasher& hasher) {
+  const auto key_hash = detail::hash(key);
+  const auto value_hash = detail::hash(value);
+  hasher.update(key_hash.data(), key_hash.size());
+  hasher.update(value_hash.data(), value_hash.size());
+}
+
+// Recompute the root hash of a block's versioned updates from the stored values, as VersionedKeyValueCategory::add()
+// does. Return nullopt if a value is missing.
+std::optional<Hash> versionedRootHash(const detail::VersionedKeyValueCategory& category,
+                                      BlockId block_id,
+                                      const VersionedOutput& output) {
+  auto hasher = Hasher{};
+  hasher.init();
+  for (const auto& [key, flags] : output.keys) {
+    if (flags.deleted) {
+      continue;
+    }
+    const auto value = category.get(key, block_id);
+    if (!value) {
+      return std::nullopt;
+    }
+    updateRootHash(key, detail::asVersioned(value).data, hasher);
+  }
+  return hasher.finish();
+}
+
+// Recompute the tag root hashes of a block's immutable updates from the stored values, as
+// ImmutableKeyValueCategory::add() does. Return nullopt if a value is missing.
+std::optional<std::map<std::string, Hash>> immutableTagRootHashes(const detail::ImmutableKeyValueCategory& category,
+                                                                  BlockId block_id,
+                                                                  const ImmutableOutput& output) {
+  auto tag_hashers = std::map<std::string, Hasher>{};
+  for (const auto& [key, tags] : output.tagged_keys) {
+    if (tags.empty()) {
+      continue;
+    }
+    const auto value = category.get(key, block_id);
+    if (!value) {
+      return std::nullopt;
+    }
+    for (const auto& tag : tags) {
+      auto [it, inserted] = tag_hashers.emplace(tag, Hasher{});
+      if (inserted) {
+        it->second.init();
+      }
+      updateRootHash(key, detail::asImmutable(value).data, it->second);
+    }
+  }
+  auto tag_root_hashes = std::map<std::string, Hash>{};
+  for (auto& [tag, hasher] : tag_hashers) {
+    tag_root_hashes[tag] = hasher.finish();
+  }
+  return tag_root_hashes;
+}
+
+}  // namespace
+
 template <typename T>
 void nullopts(std::vector<std::optional<T>>& vec, std::size_t count) {
   vec.resize(count, std::nullopt);
@@ -48,7 +120,8 @@ KeyValueBlockchain::KeyValueBlockchain(const std::shared_ptr<concord::storage::r
       versioned_num_of_keys_{add_metrics_comp_.RegisterCounter("numOfVersionedKeys")},
       immutable_num_of_keys_{add_metrics_comp_.RegisterCounter("numOfImmutableKeys")},
       merkle_num_of_keys_{add_metrics_comp_.RegisterCounter("numOfMerkleKeys")} {
-  if (detail::createColumnFamilyIfNotExisting(detail::CAT_ID_TYPE_CF, *native_client_.get())) {
+  if (detail::createColumnFamilyIfNotExisting(
+          detail::CAT_ID_TYPE_CF, *native_client_.get(), detail::ColumnFamilyProfile::PointLookup)) {
     LOG_INFO(CAT_BLOCK_LOG, "Created [" << detail::CAT_ID_TYPE_CF << "] column family for the category types");
   }
 
@@ -59,17 +132,26 @@ KeyValueBlockchain::KeyValueBlockchain(const std::shared_ptr<concord::storage::r
     initExistingBlockchainCategories(category_types);
   }
 
-  if (!link_st_chain) return;
-  // Make sure that if linkSTChainFrom() has been interrupted (e.g. a crash or an abnormal shutdown), all DBAdapter
-  // methods will return the correct values. For example, if state transfer had completed and linkSTChainFrom() was
-  // interrupted, getLatestBlockId() should be equal to getLastReachableBlockId() on the next startup. Another example
-  // is getValue() that returns keys from the blockchain only and ignores keys in the temporary state
-  // transfer chain.
-  linkSTChainFrom(getLastReachableBlockId() + 1);
-  delete_metrics_comp_.Register();
-  add_metrics_comp_.Register();
+  if (link_st_chain) {
+    // Make sure that if linkSTChainFrom() has been interrupted (e.g. a crash or an abnormal shutdown), all DBAdapter
+    // methods will return the correct values. For example, if state transfer had completed and linkSTChainFrom() was
+    // interrupted, getLatestBlockId() should be equal to getLastReachableBlockId() on the next startup. Another
+    // example is getValue() that returns keys from the blockchain only and ignores keys in the temporary state
+    // transfer chain.
+    linkSTChainFrom(getLastReachableBlockId() + 1);
+    delete_metrics_comp_.Register();
+    add_metrics_comp_.Register();
+  }
+
+  // Must be the last step: if the constructor throws, the destructor doesn't run and a joinable thread terminates the
+  // process when destroyed.
+  if (background_stale_data_deletion_) {
+    startStaleDataDeletion();
+  }
 }
 
+KeyValueBlockchain::~KeyValueBlockchain() { stopStaleDataDeletion(); }
+
 void KeyValueBlockchain::initNewBlockchainCategories(
     const std::optional<std::map<std::string, CATEGORY_TYPE>>& category_types) {
   if (!category_types) {
@@ -123,11 +205,13 @@ void KeyValueBlockchain::loadCategories() {
     }
     auto cat_type = static_cast<CATEGORY_TYPE>(itr.valueView()[0]);
     switch (cat_type) {
-      case CATEGORY_TYPE::block_merkle:
-        categories_.emplace(itr.key(), detail::BlockMerkleCategory{native_client_});
+      case CATEGORY_TYPE::block_merkle: {
+        auto it = categories_.emplace(itr.key(), detail::BlockMerkleCategory{native_client_}).first;
+        std::get<detail::BlockMerkleCategory>(it->second).deferStaleDataDeletion(background_stale_data_deletion_);
         category_types_[itr.key()] = CATEGORY_TYPE::block_merkle;
         LOG_INFO(CAT_BLOCK_LOG, "Created category [" << itr.key() << "] as type BlockMerkleCategory");
         break;
+      }
       case CATEGORY_TYPE::immutable:
         categories_.emplace(itr.key(), detail::ImmutableKeyValueCategory{itr.key(), native_client_});
         category_types_[itr.key()] = CATEGORY_TYPE::immutable;
@@ -152,14 +236,34 @@ void KeyValueBlockchain::loadCategories() {
 // 4) add the category block data into the new block
 BlockId KeyValueBlockchain::addBlock(Updates&& updates) {
   diagnostics::TimeRecorder scoped_timer(*histograms_.addBlock);
+  if (updates_capture_) {
+    updates_capture_->write(updates.categoryUpdates());
+  }
   // Use new client batch and column families
   auto write_batch = native_client_->getBatch();
   auto block_id = addBlock(std::move(updates.category_updates_), write_batch);
-  native_client_->write(std::move(write_batch));
+  {
+    diagnostics::TimeRecorder db_write_timer(*histograms_.addBlockDbWrite);
+    native_client_->write(std::move(write_batch));
+  }
   block_chain_.setAddedBlockId(block_id);
   return block_id;
 }
 
+void KeyValueBlockchain::startUpdatesCapture(const std::string& path) {
+  updates_capture_ = std::make_unique<UpdatesCaptureWriter>(path, category_types_);
+  LOG_INFO(CAT_BLOCK_LOG, "Capturing the updates of added blocks to " << path);
+}
+
+void KeyValueBlockchain::stopUpdatesCapture() {
+  if (!updates_capture_) {
+    return;
+  }
+  updates_capture_->flush();
+  updates_capture_.reset();
+  LOG_INFO(CAT_BLOCK_LOG, "Stopped capturing the updates of added blocks");
+}
+
 BlockId KeyValueBlockchain::addBlock(CategoryInput&& category_updates,
                                      concord::storage::rocksdb::NativeWriteBatch& write_batch) {
   // Use new client batch and column families
@@ -170,21 +274,27 @@ BlockId KeyValueBlockchain::addBlock(CategoryInput&& category_updates,
   last_raw_block_.first = new_block.id();
   last_raw_block.updates = category_updates;
   // Per category updates
-  for (auto&& [category_id, update] : category_updates.kv) {
-    std::visit(
-        [&new_block, category_id = category_id, &write_batch, &last_raw_block, this](auto&& update) {
-          auto block_updates =
-              handleCategoryUpdates(new_block.id(), category_id, std::forward<decltype(update)>(update), write_batch);
-          addRootHash(category_id, last_raw_block, block_updates);
-          new_block.add(category_id, std::move(block_updates));
-        },
-        std::move(update));
+  {
+    diagnostics::TimeRecorder category_updates_timer(*histograms_.addBlockCategoryUpdates);
+    for (auto&& [category_id, update] : category_updates.kv) {
+      std::visit(
+          [&new_block, category_id = category_id, &write_batch, &last_raw_block, this](auto&& update) {
+            auto block_updates =
+                handleCategoryUpdates(new_block.id(), category_id, std::forward<decltype(update)>(update), write_batch);
+            addRootHash(category_id, last_raw_block, block_updates);
+            new_block.add(category_id, std::move(block_updates));
+          },
+          std::move(update));
+    }
   }
   new_block.data.parent_digest = parent_digest_future.get();
   last_raw_block.parent_digest = new_block.data.parent_digest;
-  block_chain_.addBlock(new_block, write_batch);
-  LOG_DEBUG(CAT_BLOCK_LOG, "Writing block [" << new_block.id() << "] to the blocks cf");
-  write_batch.put(detail::BLOCKS_CF, Block::generateKey(new_block.id()), Block::serialize(new_block));
+  {
+    diagnostics::TimeRecorder write_batch_timer(*histograms_.addBlockWriteBatch);
+    block_chain_.addBlock(new_block, write_batch);
+    LOG_DEBUG(CAT_BLOCK_LOG, "Writing block [" << new_block.id() << "] to the blocks cf");
+    write_batch.put(detail::BLOCKS_CF, Block::generateKey(new_block.id()), Block::serialize(new_block));
+  }
   add_metrics_comp_.UpdateAggregator();
   return new_block.id();
 }
@@ -212,10 +322,8 @@ std::future<BlockDigest> KeyValueBlockchain::computeParentBlockDigest(const Bloc
         // Make sure the digest is zero-initialized by using {} initialization.
         auto parent_block_digest = BlockDigest{};
         if (cached_raw_block.second) {
-          // histograms.dba_hashed_parent_block_size->recordAtomic(parentBlock->length());
-          // static constexpr bool is_atomic = true;
-          // TimeRecorder<is_atomic> scoped(*histograms.dba_hash_parent_block);
-
+          // Runs on the thread pool, concurrently with the category updates
+          diagnostics::TimeRecorder<true> scoped_timer(*histograms_.hashParentBlock);
           const auto& raw_buffer = detail::serialize(cached_raw_block.second.value());
           parent_block_digest =
               computeBlockDigest(parent_block_id, reinterpret_cast<const char*>(raw_buffer.data()), raw_buffer.size());
@@ -225,6 +333,188 @@ std::future<BlockDigest> KeyValueBlockchain::computeParentBlockDigest(const Bloc
       std::move(cached_raw_block));
 }
 
+/////////////////////// Snapshots ///////////////////////
+
+BlockId KeyValueBlockchain::exportSnapshot(const std::string& dir,
+                                           const std::optional<std::uint64_t>& num_blocks) const {
+  if (num_blocks && *num_blocks == 0) {
+    throw std::invalid_argument{"A snapshot must contain at least one block"};
+  }
+  if (!fs::create_directories(dir)) {
+    throw std::invalid_argument{"Snapshot directory already exists: " + dir};
+  }
+
+  // The state transfer chain is not linked to the blockchain and is therefore not exported.
+  auto column_families = std::vector<std::string>{};
+  for (const auto& cf : native_client_->columnFamilies()) {
+    if (cf != native_client_->defaultColumnFamily() && cf != detail::ST_CHAIN_CF) {
+      column_families.push_back(cf);
+    }
+  }
+  // Iterators into the same state of all column families, so that blocks added during the export are not included.
+  auto iterators = native_client_->getIterators(column_families);
+  const auto blocks_idx = std::distance(column_families.cbegin(),
+                                        std::find(column_families.cbegin(), column_families.cend(), detail::BLOCKS_CF));
+  auto& blocks_iter = iterators.at(blocks_idx);
+  blocks_iter.last();
+  if (!blocks_iter) {
+    throw std::logic_error{"Cannot export a snapshot of an empty blockchain"};
+  }
+  auto manifest = SnapshotManifest{};
+  auto key = BlockKey{};
+  detail::deserialize(blocks_iter.keyView(), key);
+  manifest.last_block_id = key.block_id;
+  blocks_iter.first();
+  detail::deserialize(blocks_iter.keyView(), key);
+  manifest.genesis_block_id = key.block_id;
+  if (num_blocks && *num_blocks < manifest.last_block_id - manifest.genesis_block_id + 1) {
+    manifest.genesis_block_id = manifest.last_block_id - *num_blocks + 1;
+  }
+  for (const auto& [category_id, type] : category_types_) {
+    manifest.category_types[category_id] = static_cast<uint8_t>(type);
+  }
+
+  for (auto i = 0u; i < column_families.size(); ++i) {
+    const auto& cf = column_families[i];
+    if (cf == detail::BLOCKS_CF) {
+      iterators[i].seekAtLeast(Block::generateKey(manifest.genesis_block_id));
+    } else {
+      iterators[i].first();
+    }
+    if (native_client_->writeSstFile(cf, iterators[i], snapshotSstFile(dir, cf)) > 0) {
+      manifest.column_families.push_back(cf);
+    }
+  }
+
+  auto out = std::ofstream{fs::path{dir} / kSnapshotManifestFile, std::ios::binary};
+  const auto ser_manifest = detail::serialize(manifest);
+  out.write(reinterpret_cast<const char*>(ser_manifest.data()), ser_manifest.size());
+  if (!out.flush()) {
+    throw std::runtime_error{"Failed to write the manifest of snapshot " + dir};
+  }
+  LOG_INFO(CAT_BLOCK_LOG, "Exported snapshot to " << dir << KVLOG(manifest.genesis_block_id, manifest.last_block_id));
+  return manifest.last_block_id;
+}
+
+BlockId KeyValueBlockchain::importSnapshot(
+    const std::shared_ptr<concord::storage::rocksdb::NativeClient>& native_client,
+    const std::string& dir,
+    const BlockDigest& expected_last_block_digest) {
+  auto in = std::ifstream{fs::path{dir} / kSnapshotManifestFile, std::ios::binary};
+  if (!in) {
+    throw std::invalid_argument{"No snapshot manifest in " + dir};
+  }
+  const auto ser_manifest = std::vector<uint8_t>{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+  auto manifest = SnapshotManifest{};
+  deserialize(ser_manifest, manifest);
+  auto category_types = std::map<std::string, CATEGORY_TYPE>{};
+  for (const auto& [category_id, type] : manifest.category_types) {
+    if (type >= static_cast<uint8_t>(CATEGORY_TYPE::end_of_types)) {
+      throw std::runtime_error{"Invalid type of category " + category_id + " in snapshot " + dir};
+    }
+    category_types[category_id] = static_cast<CATEGORY_TYPE>(type);
+  }
+
+  // Create the column families of the categories as a KeyValueBlockchain would, before ingesting into them.
+  {
+    const auto kvbc = KeyValueBlockchain{native_client, false, category_types};
+    if (kvbc.getLastReachableBlockId() != 0) {
+      throw std::logic_error{"Cannot import a snapshot into a database with blocks"};
+    }
+  }
+  for (const auto& cf : manifest.column_families) {
+    if (!native_client->hasColumnFamily(cf)) {
+      native_client->createColumnFamily(cf);
+    }
+    native_client->ingestSstFiles(cf, {snapshotSstFile(dir, cf)});
+  }
+
+  // Verify that the last block is the trusted one, that the blocks form a chain ending in it and that the block merkle
+  // state matches the last block. Everything else is verified against the blocks and is only as trusted as they are.
+  const auto kvbc = KeyValueBlockchain{native_client, false};
+  if (kvbc.getGenesisBlockId() != manifest.genesis_block_id ||
+      kvbc.getLastReachableBlockId() != manifest.last_block_id) {
+    throw std::runtime_error{"The blocks of snapshot " + dir + " don't match its manifest"};
+  }
+  {
+    const auto& raw_buffer = detail::serialize(kvbc.getRawBlock(manifest.last_block_id)->data);
+    const auto digest = computeBlockDigest(
+        manifest.last_block_id, reinterpret_cast<const char*>(raw_buffer.data()), raw_buffer.size());
+    if (digest != expected_last_block_digest) {
+      throw std::runtime_error{"Digest mismatch of the last block " + std::to_string(manifest.last_block_id) +
+                               " in snapshot " + dir};
+    }
+  }
+  for (auto block_id = manifest.genesis_block_id + 1; block_id <= manifest.last_block_id; ++block_id) {
+    const auto& raw_buffer = detail::serialize(kvbc.getRawBlock(block_id - 1)->data);
+    const auto digest =
+        computeBlockDigest(block_id - 1, reinterpret_cast<const char*>(raw_buffer.data()), raw_buffer.size());
+    if (kvbc.parentDigest(block_id) != digest) {
+      throw std::runtime_error{"Parent digest mismatch of block " + std::to_string(block_id) + " in snapshot " + dir};
+    }
+  }
+  // Verify the root hashes of the categories that calculate them. A root hash that can't be verified fails the import.
+  const auto cannot_verify = [&dir](const std::string& category_id, BlockId block_id, const std::string& reason) {
+    return std::runtime_error{"Cannot verify the root hash of category " + category_id + " in block " +
+                              std::to_string(block_id) + " of snapshot " + dir + ": " + reason};
+  };
+  const auto mismatch = [&dir](const std::string& category_id, BlockId block_id) {
+    return std::runtime_error{"Root hash mismatch of category " + category_id + " in block " +
+                              std::to_string(block_id) + " of snapshot " + dir};
+  };
+  for (const auto& [category_id, type] : category_types) {
+    if (type != CATEGORY_TYPE::block_merkle) {
+      continue;
+    }
+    const auto& category = std::get<detail::BlockMerkleCategory>(kvbc.getCategoryRef(category_id));
+    // The last block that updated the category holds the state root hash.
+    for (auto block_id = manifest.last_block_id; block_id >= manifest.genesis_block_id; --block_id) {
+      const auto block = kvbc.block_chain_.getBlock(block_id);
+      const auto it = block->data.categories_updates_info.find(category_id);
+      if (it == block->data.categories_updates_info.cend()) {
+        continue;
+      }
+      const auto& output = std::get<BlockMerkleOutput>(it->second);
+      // Pruning after the block was added changes the state root without adding a block.
+      if (output.state_root_version != category.getLatestTreeVersion()) {
+        throw cannot_verify(category_id, block_id, "the category was pruned after the block was added");
+      }
+      if (output.root_hash != category.getRootHash()) {
+        throw mismatch(category_id, block_id);
+      }
+      break;
+    }
+  }
+  // The versioned and immutable root hashes cover the updates of a single block.
+  for (auto block_id = manifest.genesis_block_id; block_id <= manifest.last_block_id; ++block_id) {
+    const auto block = kvbc.block_chain_.getBlock(block_id);
+    for (const auto& [category_id, update_info] : block->data.categories_updates_info) {
+      if (const auto versioned = std::get_if<VersionedOutput>(&update_info); versioned && versioned->root_hash) {
+        const auto& category = std::get<detail::VersionedKeyValueCategory>(kvbc.getCategoryRef(category_id));
+        const auto root_hash = versionedRootHash(category, block_id, *versioned);
+        if (!root_hash) {
+          throw cannot_verify(category_id, block_id, "a value is missing");
+        }
+        if (*root_hash != *versioned->root_hash) {
+          throw mismatch(category_id, block_id);
+        }
+      } else if (const auto immutable = std::get_if<ImmutableOutput>(&update_info);
+                 immutable && immutable->tag_root_hashes) {
+        const auto& category = std::get<detail::ImmutableKeyValueCategory>(kvbc.getCategoryRef(category_id));
+        const auto tag_root_hashes = immutableTagRootHashes(category, block_id, *immutable);
+        if (!tag_root_hashes) {
+          throw cannot_verify(category_id, block_id, "a value is missing");
+        }
+        if (*tag_root_hashes != *immutable->tag_root_hashes) {
+          throw mismatch(category_id, block_id);
+        }
+      }
+    }
+  }
+  LOG_INFO(CAT_BLOCK_LOG, "Imported snapshot from " << dir << KVLOG(manifest.genesis_block_id, manifest.last_block_id));
+  return manifest.last_block_id;
+}
+
 /////////////////////// Readers ///////////////////////
 
 const Category* KeyValueBlockchain::getCategoryPtr(const std::string& cat_id) const {
@@ -340,6 +630,28 @@ std::optional<Updates> KeyValueBlockchain::getBlockUpdates(BlockId block_id) con
   return Updates{std::move(raw->data.updates)};
 }
 
+std::optional<Updates> KeyValueBlockchain::getBlockUpdates(BlockId block_id,
+                                                           const std::set<std::string>& category_ids) const {
+  diagnostics::TimeRecorder<true> scoped_timer(*histograms_.getRawBlock);
+  // Blocks in the ST chain are stored as raw blocks, i.e. all the values are there anyway.
+  if (block_id > getLastReachableBlockId()) {
+    auto raw = state_transfer_block_chain_.getRawBlock(block_id);
+    if (!raw) {
+      return std::nullopt;
+    }
+    auto& kv = raw->data.updates.kv;
+    for (auto it = kv.begin(); it != kv.end();) {
+      it = category_ids.count(it->first) ? std::next(it) : kv.erase(it);
+    }
+    return Updates{std::move(raw->data.updates)};
+  }
+  auto raw = block_chain_.getRawBlock(block_id, categories_, category_ids);
+  if (!raw) {
+    return std::nullopt;
+  }
+  return Updates{std::move(raw->data.updates)};
+}
+
 std::map<std::string, std::vector<std::string>> KeyValueBlockchain::getBlockStaleKeys(BlockId block_id) const {
   // Get block node from storage
   auto block = block_chain_.getBlock(block_id);
@@ -462,6 +774,110 @@ void KeyValueBlockchain::deleteGenesisBlock() {
   native_client_->write(std::move(write_batch));
   // Increment the genesis block ID cache.
   block_chain_.setGenesisBlockId(genesis_id + 1);
+
+  // The stale data of the block merkle categories is deleted once the pruned block is on disk.
+  if (background_stale_data_deletion_) {
+    for (const auto& [category_id, update_info] : (*block).data.categories_updates_info) {
+      if (const auto merkle_info = std::get_if<BlockMerkleOutput>(&update_info)) {
+        scheduleStaleDataDeletion(category_id, merkle_info->state_root_version);
+      }
+    }
+  }
+}
+
+void KeyValueBlockchain::startStaleDataDeletion() {
+  LOG_INFO(CAT_BLOCK_LOG,
+           "Starting background stale data deletion, rate limit = " << stale_data_deletion_rate_limit_
+                                                                     << " bytes/s");
+  stale_data_deletion_thread_ = std::thread{[this]() { staleDataDeletionLoop(); }};
+}
+
+void KeyValueBlockchain::stopStaleDataDeletion() {
+  if (!stale_data_deletion_thread_.joinable()) {
+    return;
+  }
+  {
+    auto lock = std::lock_guard{stale_data_deletion_mutex_};
+    stop_stale_data_deletion_ = true;
+  }
+  stale_data_deletion_cv_.notify_one();
+  stale_data_deletion_thread_.join();
+  // Wake up waiters on targets that won't be reached.
+  stale_data_deleted_cv_.notify_all();
+}
+
+void KeyValueBlockchain::scheduleStaleDataDeletion(const std::string& category_id, uint64_t tree_version) {
+  auto& category = std::get<detail::BlockMerkleCategory>(getCategoryRef(category_id));
+  {
+    auto lock = std::lock_guard{stale_data_deletion_mutex_};
+    auto& target = stale_data_deletion_targets_[category_id];
+    target.first = &category;
+    target.second = std::max(target.second, tree_version);
+  }
+  stale_data_deletion_cv_.notify_one();
+}
+
+void KeyValueBlockchain::waitForStaleDataDeletion() {
+  auto lock = std::unique_lock{stale_data_deletion_mutex_};
+  stale_data_deleted_cv_.wait(
+      lock, [this]() { return stale_data_deletion_targets_.empty() || stop_stale_data_deletion_; });
+}
+
+// Delete stale data in batches of tree versions, round-robin over the block merkle categories. After each batch, sleep
+// for the time it takes to write the batch at the rate limit. Once a category reaches its target, optionally compact
+// the deleted ranges so that their disk space is reclaimed right away.
+void KeyValueBlockchain::staleDataDeletionLoop() {
+  static constexpr uint64_t batch_size = 50;
+  auto last_category_id = std::string{};
+  auto lock = std::unique_lock{stale_data_deletion_mutex_};
+  while (true) {
+    stale_data_deletion_cv_.wait(
+        lock, [this]() { return stop_stale_data_deletion_ || !stale_data_deletion_targets_.empty(); });
+    if (stop_stale_data_deletion_) {
+      return;
+    }
+    auto it = stale_data_deletion_targets_.upper_bound(last_category_id);
+    if (it == stale_data_deletion_targets_.end()) {
+      it = stale_data_deletion_targets_.begin();
+    }
+    last_category_id = it->first;
+    const auto [category, tree_version] = it->second;
+    lock.unlock();
+
+    const auto start = std::chrono::steady_clock::now();
+    auto written = std::size_t{0};
+    auto failed = false;
+    try {
+      diagnostics::TimeRecorder scoped_timer(*histograms_.deleteStaleDataBatch);
+      written = category->deleteStaleDataBatch(tree_version, batch_size);
+      if (written == 0 && compact_deleted_stale_data_) {
+        category->compactDeletedStaleData();
+      }
+    } catch (const std::exception& e) {
+      LOG_ERROR(CAT_BLOCK_LOG,
+                "Failed to delete stale data of category [" << last_category_id << "] up to tree version "
+                                                            << tree_version << ": " << e.what());
+      failed = true;
+    }
+
+    lock.lock();
+    if (written == 0 || failed) {
+      // Keep the target if it has been raised in the meantime.
+      it = stale_data_deletion_targets_.find(last_category_id);
+      if (it != stale_data_deletion_targets_.end() && (failed || it->second.second == tree_version)) {
+        stale_data_deletion_targets_.erase(it);
+      }
+      if (stale_data_deletion_targets_.empty()) {
+        stale_data_deleted_cv_.notify_all();
+      }
+    } else if (stale_data_deletion_rate_limit_ > 0) {
+      const auto budget = std::chrono::microseconds{written * 1000 * 1000 / stale_data_deletion_rate_limit_};
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      if (elapsed < budget) {
+        stale_data_deletion_cv_.wait_for(lock, budget - elapsed, [this]() { return stop_stale_data_deletion_; });
+      }
+    }
+  }
 }
 
 // 1 - Get last id block from DB.
@@ -606,8 +1022,12 @@ void KeyValueBlockchain::addNewCategory(const std::string& cat_id, CATEGORY_TYPE
   auto inserted = false;
   switch (type) {
     case CATEGORY_TYPE::block_merkle:
-      inserted = categories_.try_emplace(cat_id, detail::BlockMerkleCategory{native_client_}).second;
+    {
+      auto [it, merkle_inserted] = categories_.try_emplace(cat_id, detail::BlockMerkleCategory{native_client_});
+      std::get<detail::BlockMerkleCategory>(it->second).deferStaleDataDeletion(background_stale_data_deletion_);
+      inserted = merkle_inserted;
       break;
+    }
     case CATEGORY_TYPE::immutable:
       inserted = categories_.try_emplace(cat_id, detail::ImmutableKeyValueCategory{cat_id, native_client_}).second;
       break;
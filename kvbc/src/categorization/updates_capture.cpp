@@ -0,0 +1,103 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "categorization/updates_capture.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace concord::kvbc::categorization {
+
+using RecordSize = uint32_t;
+
+UpdatesCaptureWriter::UpdatesCaptureWriter(const std::string& path,
+                                           const std::map<std::string, CATEGORY_TYPE>& category_types)
+    : path_{path}, out_{path, std::ios::binary | std::ios::trunc}, start_{std::chrono::steady_clock::now()} {
+  if (!out_) {
+    throw std::runtime_error{"Failed to create updates capture file " + path_};
+  }
+  auto header = UpdatesCaptureHeader{};
+  for (const auto& [category_id, type] : category_types) {
+    header.category_types[category_id] = static_cast<uint8_t>(type);
+  }
+  serialize(buffer_, header);
+  writeRecord();
+}
+
+void UpdatesCaptureWriter::write(const CategoryInput& updates) {
+  auto captured = CapturedUpdates{};
+  captured.time_us = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_).count());
+  captured.updates = updates;
+  serialize(buffer_, captured);
+  writeRecord();
+}
+
+void UpdatesCaptureWriter::flush() {
+  if (!out_.flush()) {
+    throw std::runtime_error{"Failed to flush updates capture file " + path_};
+  }
+}
+
+void UpdatesCaptureWriter::writeRecord() {
+  if (buffer_.size() > std::numeric_limits<RecordSize>::max()) {
+    throw std::runtime_error{"Captured updates are too big: " + std::to_string(buffer_.size()) + " bytes"};
+  }
+  const auto size = static_cast<RecordSize>(buffer_.size());
+  out_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  out_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size());
+  if (!out_) {
+    throw std::runtime_error{"Failed to write to updates capture file " + path_};
+  }
+  buffer_.clear();
+}
+
+UpdatesCaptureReader::UpdatesCaptureReader(const std::string& path) : path_{path}, in_{path, std::ios::binary} {
+  if (!in_) {
+    throw std::runtime_error{"Failed to open updates capture file " + path_};
+  }
+  if (!readRecord()) {
+    throw std::runtime_error{"Missing header in updates capture file " + path_};
+  }
+  auto header = UpdatesCaptureHeader{};
+  deserialize(buffer_, header);
+  for (const auto& [category_id, type] : header.category_types) {
+    if (type >= static_cast<uint8_t>(CATEGORY_TYPE::end_of_types)) {
+      throw std::runtime_error{"Invalid type of category " + category_id + " in updates capture file " + path_};
+    }
+    category_types_[category_id] = static_cast<CATEGORY_TYPE>(type);
+  }
+}
+
+std::optional<CapturedUpdates> UpdatesCaptureReader::next() {
+  if (!readRecord()) {
+    return std::nullopt;
+  }
+  auto captured = CapturedUpdates{};
+  deserialize(buffer_, captured);
+  return captured;
+}
+
+bool UpdatesCaptureReader::readRecord() {
+  auto size = RecordSize{0};
+  if (!in_.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    return false;
+  }
+  buffer_.resize(size);
+  if (!in_.read(reinterpret_cast<char*>(buffer_.data()), size)) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace concord::kvbc::categorization
@@ -51,9 +51,9 @@ VersionedKeyValueCategory::VersionedKeyValueCategory(const std::string &category
       latest_ver_cf_{category_id + VERSIONED_KV_LATEST_VER_CF_SUFFIX},
       active_cf_{category_id + VERSIONED_KV_ACTIVE_KEYS_FROM_PRUNED_BLOCKS_CF_SUFFIX},
       db_{db} {
-  createColumnFamilyIfNotExisting(values_cf_, *db_);
-  createColumnFamilyIfNotExisting(latest_ver_cf_, *db_);
-  createColumnFamilyIfNotExisting(active_cf_, *db_);
+  createColumnFamilyIfNotExisting(values_cf_, *db_, ColumnFamilyProfile::LargeValues);
+  createColumnFamilyIfNotExisting(latest_ver_cf_, *db_, ColumnFamilyProfile::PointLookup);
+  createColumnFamilyIfNotExisting(active_cf_, *db_, ColumnFamilyProfile::PointLookup);
 }
 
 VersionedOutput VersionedKeyValueCategory::add(BlockId block_id,
@@ -16,10 +16,10 @@
 #include "kvbc_app_filter/kvbc_app_filter.h"
 
 #include <boost/detail/endian.hpp>
-#include <boost/lockfree/spsc_queue.hpp>
 #include <cassert>
 #include <chrono>
 #include <exception>
+#include <set>
 #include <sstream>
 #include "Logger.hpp"
 
@@ -35,7 +35,6 @@ using std::map;
 using std::string;
 using std::stringstream;
 
-using boost::lockfree::spsc_queue;
 
 using com::vmware::concord::kvbc::ValueWithTrids;
 using concord::kvbc::BlockId;
@@ -43,14 +42,25 @@ using concord::kvbc::categorization::ImmutableInput;
 using concord::kvbc::InvalidBlockRange;
 using concord::util::openssl_utils::computeSHA256Hash;
 using concord::util::openssl_utils::kExpectedSHA256HashLengthInBytes;
+using concord::util::openssl_utils::SHA256Hasher;
 
 namespace concord {
 namespace kvbc {
 
 KvbFilteredUpdate::OrderedKVPairs KvbAppFilter::filterKeyValuePairs(const kvbc::categorization::ImmutableInput &kvs) {
+  KvbDecodedValues decoded;
+  return filterKeyValuePairs(kvs, decoded);
+}
+
+KvbFilteredUpdate::OrderedKVPairs KvbAppFilter::filterKeyValuePairs(const kvbc::categorization::ImmutableInput &kvs,
+                                                                    KvbDecodedValues &decoded) {
   KvbFilteredUpdate::OrderedKVPairs filtered_kvs;
+  decoded.values.resize(kvs.kv.size());
 
+  size_t index = 0;
   for (auto &[prefixed_key, value] : kvs.kv) {
+    auto &decoded_value = decoded.values[index++];
+
     // Remove the Block ID prefix from the key before using it.
     ConcordAssertGE(prefixed_key.size(), sizeof(kvbc::BlockId));
     auto key = prefixed_key.size() == sizeof(kvbc::BlockId) ? std::string{} : prefixed_key.substr(sizeof(BlockId));
@@ -75,21 +85,29 @@ KvbFilteredUpdate::OrderedKVPairs KvbAppFilter::filterKeyValuePairs(const kvbc::
       }
     }
 
-    ValueWithTrids proto;
-    if (!proto.ParseFromArray(value.data.c_str(), value.data.length())) {
-      continue;
-    }
+    if (!decoded_value) {
+      ValueWithTrids proto;
+      if (!proto.ParseFromArray(value.data.c_str(), value.data.length())) {
+        decoded_value.emplace(std::nullopt);
+        continue;
+      }
+
+      // We expect a value - this should never trigger
+      if (!proto.has_value()) {
+        std::stringstream msg;
+        msg << "Couldn't decode value with trids " << key;
+        throw KvbReadError(msg.str());
+      }
 
-    // We expect a value - this should never trigger
-    if (!proto.has_value()) {
-      std::stringstream msg;
-      msg << "Couldn't decode value with trids " << key;
-      throw KvbReadError(msg.str());
+      auto val = proto.release_value();
+      decoded_value.emplace(std::move(*val));
+      delete val;
+    }
+    if (!*decoded_value) {
+      continue;
     }
 
-    auto val = proto.release_value();
-    filtered_kvs.push_back({std::move(key), std::move(*val)});
-    delete val;
+    filtered_kvs.push_back({std::move(key), **decoded_value});
   }
 
   return filtered_kvs;
@@ -100,6 +118,11 @@ KvbFilteredUpdate KvbAppFilter::filterUpdate(const KvbUpdate &update) {
   return KvbFilteredUpdate{block_id, cid, filterKeyValuePairs(updates)};
 }
 
+KvbFilteredUpdate KvbAppFilter::filterUpdate(const KvbUpdate &update, KvbDecodedValues &decoded) {
+  auto &[block_id, cid, updates, _] = update;
+  return KvbFilteredUpdate{block_id, cid, filterKeyValuePairs(updates, decoded)};
+}
+
 string KvbAppFilter::hashUpdate(const KvbFilteredUpdate &update) {
   // Note we store the hashes of the keys and values in an std::map as an
   // intermediate step in the computation of the update hash so the map can be
@@ -142,56 +165,22 @@ string KvbAppFilter::hashUpdate(const KvbFilteredUpdate &update) {
   return computeSHA256Hash(concatenated_entry_hashes);
 }
 
-void KvbAppFilter::readBlockRange(BlockId block_id_start,
-                                  BlockId block_id_end,
-                                  spsc_queue<KvbFilteredUpdate> &queue_out,
-                                  const std::atomic_bool &stop_execution) {
-  if (block_id_start > block_id_end || block_id_end > rostorage_->getLastBlockId()) {
-    throw InvalidBlockRange(block_id_start, block_id_end);
-  }
-
-  BlockId block_id(block_id_start);
-
-  LOG_DEBUG(logger_, "readBlockRange block " << block_id << " to " << block_id_end);
-
-  for (; block_id <= block_id_end; ++block_id) {
-    std::string cid;
-    auto events = getBlockEvents(block_id, cid);
-    if (!events) {
-      std::stringstream msg;
-      msg << "Couldn't retrieve block data for block id " << block_id;
-      throw KvbReadError(msg.str());
-    }
-
-    KvbFilteredUpdate update{block_id, cid, filterKeyValuePairs(*events)};
-    while (!stop_execution) {
-      if (queue_out.push(update)) {
-        break;
-      }
-    }
-
-    if (stop_execution) {
-      LOG_WARN(logger_, "readBlockRange was stopped");
-      break;
-    }
-  }
-}
-
 string KvbAppFilter::readBlockHash(BlockId block_id) {
   if (block_id > rostorage_->getLastBlockId()) {
     throw InvalidBlockRange(block_id, block_id);
   }
+  return hashUpdate(readBlock(block_id));
+}
 
+KvbFilteredUpdate KvbAppFilter::readBlock(BlockId block_id) {
   std::string cid;
   auto events = getBlockEvents(block_id, cid);
   if (!events) {
     std::stringstream msg;
-    msg << "Couldn't retrieve block events for block id " << block_id;
+    msg << "Couldn't retrieve block data for block id " << block_id;
     throw KvbReadError(msg.str());
   }
-
-  KvbFilteredUpdate filtered_update{block_id, cid, filterKeyValuePairs(*events)};
-  return hashUpdate(filtered_update);
+  return KvbFilteredUpdate{block_id, cid, filterKeyValuePairs(*events)};
 }
 
 string KvbAppFilter::readBlockRangeHash(BlockId block_id_start, BlockId block_id_end) {
@@ -200,28 +189,43 @@ string KvbAppFilter::readBlockRangeHash(BlockId block_id_start, BlockId block_id
   }
   BlockId block_id(block_id_start);
 
+  // The state hash is the hash of the concatenated update hashes. Hence, a
+  // checkpoint of the hasher lets us continue the computation from there.
+  SHA256Hasher hasher;
+  const auto index_key = KvbStateHashIndex::Key{client_id_, key_prefix_, block_id_start};
+  if (state_hash_index_) {
+    if (auto checkpoint = state_hash_index_->nearest(index_key, block_id_end)) {
+      block_id = checkpoint->first + 1;
+      hasher = std::move(checkpoint->second);
+    }
+  }
+
   LOG_DEBUG(logger_, "readBlockRangeHash block " << block_id << " to " << block_id_end);
 
-  string concatenated_update_hashes;
-  concatenated_update_hashes.reserve((1 + block_id_end - block_id) * kExpectedSHA256HashLengthInBytes);
   for (; block_id <= block_id_end; ++block_id) {
-    std::string cid;
-    auto events = getBlockEvents(block_id, cid);
-    if (!events) {
-      std::stringstream msg;
-      msg << "Couldn't retrieve block events for block id " << block_id;
-      throw KvbReadError(msg.str());
+    hasher.update(hashUpdate(readBlock(block_id)));
+    if (state_hash_index_ && (block_id - block_id_start + 1) % state_hash_index_->interval() == 0) {
+      state_hash_index_->add(index_key, block_id, hasher);
     }
+  }
+  if (state_hash_index_) {
+    state_hash_index_->setLatest(index_key, block_id_end, hasher);
+  }
+  return hasher.finish();
+}
 
-    KvbFilteredUpdate filtered_update{block_id, cid, filterKeyValuePairs(*events)};
-    concatenated_update_hashes.append(hashUpdate(filtered_update));
+void KvbAppFilter::extendStateHash(BlockId block_id, const std::function<std::string()> &update_hash) {
+  if (state_hash_index_) {
+    state_hash_index_->extend(client_id_, key_prefix_, block_id, update_hash);
   }
-  return computeSHA256Hash(concatenated_update_hashes);
 }
 
 std::optional<kvbc::categorization::ImmutableInput> KvbAppFilter::getBlockEvents(kvbc::BlockId block_id,
                                                                                  std::string &cid) {
-  const auto updates = rostorage_->getBlockUpdates(block_id);
+  // Only the events and the correlation ID are needed - don't read the values of the other categories.
+  static const auto kCategories = std::set<std::string>{concord::kvbc::categorization::kExecutionEventsCategory,
+                                                        concord::kvbc::kConcordInternalCategoryId};
+  const auto updates = rostorage_->getBlockUpdates(block_id, kCategories);
   if (!updates) {
     LOG_ERROR(logger_, "Couldn't get block updates");
     return {};
@@ -241,5 +245,107 @@ std::optional<kvbc::categorization::ImmutableInput> KvbAppFilter::getBlockEvents
   return std::get<kvbc::categorization::ImmutableInput>(immutable->get());
 }
 
+std::optional<std::pair<BlockId, SHA256Hasher>> KvbStateHashIndex::nearest(const Key &key, BlockId block_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto filter_it = checkpoints_.find(key);
+  if (filter_it == checkpoints_.end()) {
+    return std::nullopt;
+  }
+  markUsed(filter_it->second);
+  const auto &latest = filter_it->second.latest;
+  if (latest && latest->first <= block_id) {
+    return latest;
+  }
+  // The first checkpoint after the given block
+  const auto &by_block = filter_it->second.by_block;
+  auto it = by_block.upper_bound(block_id);
+  if (it == by_block.begin()) {
+    return std::nullopt;
+  }
+  --it;
+  return std::make_pair(it->first, it->second);
+}
+
+KvbStateHashIndex::Checkpoints *KvbStateHashIndex::checkpoints(const Key &key) {
+  auto filter_it = checkpoints_.find(key);
+  if (filter_it != checkpoints_.end()) {
+    markUsed(filter_it->second);
+    return &filter_it->second;
+  }
+  if (max_filters_ == 0) {
+    return nullptr;
+  }
+  // Bound the memory used by clients with many different filters
+  if (checkpoints_.size() >= max_filters_) {
+    checkpoints_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  filter_it = checkpoints_.emplace(key, Checkpoints{}).first;
+  filter_it->second.lru_it = lru_.begin();
+  return &filter_it->second;
+}
+
+void KvbStateHashIndex::addCheckpoint(Checkpoints &filter_checkpoints,
+                                      BlockId block_id,
+                                      const SHA256Hasher &hasher) const {
+  auto &by_block = filter_checkpoints.by_block;
+  by_block.emplace(block_id, hasher);
+  if (by_block.size() > max_checkpoints_per_filter_) {
+    by_block.erase(by_block.begin());
+  }
+}
+
+void KvbStateHashIndex::markUsed(const Checkpoints &filter_checkpoints) const {
+  lru_.splice(lru_.begin(), lru_, filter_checkpoints.lru_it);
+}
+
+void KvbStateHashIndex::add(const Key &key, BlockId block_id, const SHA256Hasher &hasher) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (auto filter_checkpoints = checkpoints(key)) {
+    addCheckpoint(*filter_checkpoints, block_id, hasher);
+  }
+}
+
+void KvbStateHashIndex::setLatest(const Key &key, BlockId block_id, const SHA256Hasher &hasher) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto filter_checkpoints = checkpoints(key);
+  if (!filter_checkpoints) {
+    return;
+  }
+  // Live updates might have extended the computation further in the meantime
+  auto &latest = filter_checkpoints->latest;
+  if (!latest || latest->first < block_id) {
+    latest = std::make_pair(block_id, hasher);
+  }
+}
+
+void KvbStateHashIndex::extend(const std::string &client_id,
+                               const std::string &key_prefix,
+                               BlockId block_id,
+                               const std::function<std::string()> &update_hash) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::optional<std::string> hash;
+  // The computations of a filter are ordered by their start block
+  for (auto it = checkpoints_.lower_bound(Key{client_id, key_prefix, 0});
+       it != checkpoints_.end() && std::get<0>(it->first) == client_id && std::get<1>(it->first) == key_prefix;
+       ++it) {
+    auto &latest = it->second.latest;
+    // A computation that didn't get up to the previous block would leave a gap
+    if (!latest || latest->first + 1 != block_id) {
+      continue;
+    }
+    if (!hash) {
+      hash = update_hash();
+    }
+    latest->first = block_id;
+    latest->second.update(*hash);
+    const auto start = std::get<2>(it->first);
+    if ((block_id - start + 1) % interval_ == 0) {
+      addCheckpoint(it->second, block_id, latest->second);
+    }
+  }
+}
+
 }  // namespace kvbc
 }  // namespace concord
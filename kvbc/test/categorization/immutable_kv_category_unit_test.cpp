@@ -730,6 +730,25 @@ TEST_F(immutable_kv_category, multi_get) {
   }
 }
 
+TEST_F(immutable_kv_category, value_view_points_into_the_stored_value) {
+  auto update = ImmutableInput{};
+  update.kv["k1"] = ImmutableValueUpdate{"v1", {"t"}};
+  add(1, std::move(update));
+
+  const auto slice = db->getSlice(column_family, "k1"s);
+  ASSERT_TRUE(slice);
+  auto view = ImmutableDbValueView{};
+  deserialize(*slice, view);
+  ASSERT_EQ(view.block_id, 1);
+  ASSERT_EQ(view.data, "v1");
+  ASSERT_GE(view.data.data(), slice->data());
+  ASSERT_LE(view.data.data() + view.data.size(), slice->data() + slice->size());
+
+  auto value = ImmutableDbValue{};
+  deserialize(*slice, value);
+  ASSERT_EQ(value.data, view.data);
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
@@ -15,6 +15,8 @@
 #include "categorization/column_families.h"
 #include "categorization/updates.h"
 #include "categorization/kv_blockchain.h"
+#include "bcstatetransfer/SimpleBCStateTransfer.hpp"
+#include "scope_exit.hpp"
 #include <iostream>
 #include <string>
 #include <utility>
@@ -22,6 +24,8 @@
 #include <random>
 #include "storage/test/storage_test_common.h"
 
+#include <rocksdb/table.h>
+
 using concord::storage::rocksdb::NativeClient;
 using namespace concord::kvbc::categorization;
 using namespace concord::kvbc::categorization::detail;
@@ -40,6 +44,12 @@ class categorized_kvbc : public ::testing::Test {
   std::shared_ptr<NativeClient> db;
 };
 
+BlockDigest blockDigest(const KeyValueBlockchain& kvbc, BlockId block_id) {
+  const auto& raw_buffer = serialize(kvbc.getRawBlock(block_id)->data);
+  return bftEngine::bcst::computeBlockDigest(
+      block_id, reinterpret_cast<const char*>(raw_buffer.data()), raw_buffer.size());
+}
+
 TEST_F(categorized_kvbc, merkle_update) {
   std::string key{"key"};
   std::string val{"val"};
@@ -654,6 +664,36 @@ TEST_F(categorized_kvbc, creation_of_category_type_cf) {
   ASSERT_TRUE(db->hasColumnFamily(detail::CAT_ID_TYPE_CF));
 }
 
+TEST_F(categorized_kvbc, column_family_profiles) {
+  KeyValueBlockchain block_chain{db,
+                                 true,
+                                 std::map<std::string, CATEGORY_TYPE>{{"merkle", CATEGORY_TYPE::block_merkle},
+                                                                      {"versioned", CATEGORY_TYPE::versioned_kv}}};
+  const auto table_options = [this](const std::string &cf) {
+    return *reinterpret_cast<::rocksdb::BlockBasedTableOptions *>(
+        db->columnFamilyOptions(cf).table_factory->GetOptions());
+  };
+
+  // Blocks are appended, so no filter is needed
+  ASSERT_EQ(table_options(detail::BLOCKS_CF).block_size, 32 * 1024);
+  ASSERT_FALSE(table_options(detail::BLOCKS_CF).filter_policy);
+
+  // Latest versions are looked up by key
+  const auto latest_cf = "versioned" + detail::VERSIONED_KV_LATEST_VER_CF_SUFFIX;
+  ASSERT_TRUE(table_options(latest_cf).filter_policy);
+  ASSERT_EQ(table_options(latest_cf).data_block_index_type,
+            ::rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash);
+
+  // Merkle nodes are hashes in a large table
+  ASSERT_EQ(table_options(detail::BLOCK_MERKLE_INTERNAL_NODES_CF).index_type,
+            ::rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch);
+  ASSERT_TRUE(table_options(detail::BLOCK_MERKLE_INTERNAL_NODES_CF).partition_filters);
+  ASSERT_EQ(db->columnFamilyOptions(detail::BLOCK_MERKLE_INTERNAL_NODES_CF).compression, ::rocksdb::kNoCompression);
+
+  // Versioned merkle keys start with the key hash
+  ASSERT_TRUE(db->columnFamilyOptions(detail::BLOCK_MERKLE_KEYS_CF).prefix_extractor);
+}
+
 TEST_F(categorized_kvbc, instantiation_of_categories) {
   auto wb = db->getBatch();
   db->createColumnFamily(detail::CAT_ID_TYPE_CF);
@@ -789,6 +829,46 @@ TEST_F(categorized_kvbc, get_block_data) {
   ASSERT_FALSE(block_chain.getBlockUpdates(887));
 }
 
+TEST_F(categorized_kvbc, get_block_data_of_categories) {
+  KeyValueBlockchain block_chain{db,
+                                 true,
+                                 std::map<std::string, CATEGORY_TYPE>{{"merkle", CATEGORY_TYPE::block_merkle},
+                                                                      {"versioned", CATEGORY_TYPE::versioned_kv},
+                                                                      {"immutable", CATEGORY_TYPE::immutable}}};
+
+  Updates updates;
+  BlockMerkleUpdates merkle_updates;
+  merkle_updates.addUpdate("merkle_key1", "merkle_value1");
+  updates.add("merkle", std::move(merkle_updates));
+
+  VersionedUpdates ver_updates;
+  ver_updates.addUpdate("ver_key1", "ver_val1");
+  updates.add("versioned", std::move(ver_updates));
+
+  ImmutableUpdates immutable_updates;
+  immutable_updates.addUpdate("immutable_key1", {"immutable_val1", {"1", "2"}});
+  updates.add("immutable", std::move(immutable_updates));
+  ASSERT_EQ(block_chain.addBlock(std::move(updates)), (BlockId)1);
+
+  auto all_updates = block_chain.getBlockUpdates(1);
+  ASSERT_TRUE(all_updates);
+
+  auto reconstructed_updates = block_chain.getBlockUpdates(1, {"immutable", "versioned", "non-existent"});
+  ASSERT_TRUE(reconstructed_updates);
+  ASSERT_EQ(reconstructed_updates->categoryUpdates().kv.size(), 2);
+  ASSERT_FALSE(reconstructed_updates->categoryUpdates("merkle"));
+  ASSERT_EQ(reconstructed_updates->categoryUpdates("immutable")->get(),
+            all_updates->categoryUpdates("immutable")->get());
+  ASSERT_EQ(reconstructed_updates->categoryUpdates("versioned")->get(),
+            all_updates->categoryUpdates("versioned")->get());
+
+  auto no_updates = block_chain.getBlockUpdates(1, {});
+  ASSERT_TRUE(no_updates);
+  ASSERT_TRUE(no_updates->categoryUpdates().kv.empty());
+
+  ASSERT_FALSE(block_chain.getBlockUpdates(2, {"immutable"}));
+}
+
 TEST_F(categorized_kvbc, validate_category_creation) {
   KeyValueBlockchain block_chain{db, true, std::map<std::string, CATEGORY_TYPE>{{"imm", CATEGORY_TYPE::immutable}}};
   ImmutableUpdates imm_up;
@@ -833,6 +913,218 @@ TEST_F(categorized_kvbc, compare_raw_blocks) {
   // ASSERT_EQ(raw_from_api.data, last_raw.second.value().data);
 }
 
+TEST_F(categorized_kvbc, capture_and_replay_updates) {
+  const auto capture_path = rocksDbPathPrefix + "_updates_capture";
+  const auto category_types = std::map<std::string, CATEGORY_TYPE>{{"merkle", CATEGORY_TYPE::block_merkle},
+                                                                    {"versioned", CATEGORY_TYPE::versioned_kv},
+                                                                    {"immutable", CATEGORY_TYPE::immutable}};
+  KeyValueBlockchain block_chain{db, true, category_types};
+  block_chain.startUpdatesCapture(capture_path);
+  for (auto i = 1; i <= 3; ++i) {
+    const auto suffix = std::to_string(i);
+    Updates updates;
+    BlockMerkleUpdates merkle_updates;
+    merkle_updates.addUpdate("merkle_key" + suffix, "merkle_value" + suffix);
+    if (i > 1) {
+      merkle_updates.addDelete("merkle_key1");
+    }
+    updates.add("merkle", std::move(merkle_updates));
+    VersionedUpdates ver_updates;
+    ver_updates.addUpdate("ver_key", "ver_val" + suffix);
+    updates.add("versioned", std::move(ver_updates));
+    ImmutableUpdates imm_updates;
+    imm_updates.addUpdate("imm_key" + suffix, {"imm_val", {"tag"}});
+    updates.add("immutable", std::move(imm_updates));
+    block_chain.addBlock(std::move(updates));
+  }
+  block_chain.stopUpdatesCapture();
+
+  // Replay the capture into a second blockchain
+  cleanup(1);
+  auto replay_db = TestRocksDb::createNative(1);
+  UpdatesCaptureReader reader{capture_path};
+  ASSERT_EQ(reader.categoryTypes(), category_types);
+  KeyValueBlockchain replay_chain{replay_db, true, reader.categoryTypes()};
+  auto last_time_us = uint64_t{0};
+  while (auto captured = reader.next()) {
+    ASSERT_GE(captured->time_us, last_time_us);
+    last_time_us = captured->time_us;
+    replay_chain.addBlock(Updates{std::move(captured->updates)});
+  }
+  ASSERT_EQ(replay_chain.getLastReachableBlockId(), 3);
+  for (BlockId id = 1; id <= 3; ++id) {
+    ASSERT_EQ(replay_chain.getRawBlock(id)->data, block_chain.getRawBlock(id)->data);
+  }
+
+  // A truncated last block ends the capture
+  fs::resize_file(capture_path, fs::file_size(capture_path) - 1);
+  UpdatesCaptureReader truncated_reader{capture_path};
+  auto num_blocks = 0;
+  while (truncated_reader.next()) {
+    ++num_blocks;
+  }
+  ASSERT_EQ(num_blocks, 2);
+
+  replay_db.reset();
+  cleanup(1);
+  fs::remove(capture_path);
+}
+
+TEST_F(categorized_kvbc, export_and_import_snapshot) {
+  const auto snapshot_dir = rocksDbPathPrefix + "_snapshot";
+  fs::remove_all(snapshot_dir);
+  KeyValueBlockchain block_chain{db,
+                                 true,
+                                 std::map<std::string, CATEGORY_TYPE>{{"merkle", CATEGORY_TYPE::block_merkle},
+                                                                      {"versioned", CATEGORY_TYPE::versioned_kv},
+                                                                      {"immutable", CATEGORY_TYPE::immutable}}};
+  for (auto i = 1; i <= 5; ++i) {
+    const auto suffix = std::to_string(i);
+    Updates updates;
+    BlockMerkleUpdates merkle_updates;
+    merkle_updates.addUpdate("merkle_key" + suffix, "merkle_value" + suffix);
+    updates.add("merkle", std::move(merkle_updates));
+    VersionedUpdates ver_updates;
+    ver_updates.addUpdate("ver_key", "ver_val" + suffix);
+    ver_updates.calculateRootHash(true);
+    updates.add("versioned", std::move(ver_updates));
+    ImmutableUpdates imm_updates;
+    imm_updates.addUpdate("imm_key" + suffix, {"imm_val" + suffix, {"tag"}});
+    imm_updates.calculateRootHash(true);
+    updates.add("immutable", std::move(imm_updates));
+    block_chain.addBlock(std::move(updates));
+  }
+
+  // Export the last 3 blocks
+  const auto last_block_digest = blockDigest(block_chain, 5);
+  ASSERT_EQ(block_chain.exportSnapshot(snapshot_dir, 3), 5);
+  ASSERT_THROW(block_chain.exportSnapshot(snapshot_dir), std::invalid_argument);
+
+  cleanup(1);
+  {
+    auto snapshot_db = TestRocksDb::createNative(1);
+    ASSERT_EQ(KeyValueBlockchain::importSnapshot(snapshot_db, snapshot_dir, last_block_digest), 5);
+    const auto imported = KeyValueBlockchain{snapshot_db, true};
+    ASSERT_EQ(imported.blockchainCategories(), block_chain.blockchainCategories());
+    ASSERT_EQ(imported.getGenesisBlockId(), 3);
+    ASSERT_EQ(imported.getLastReachableBlockId(), 5);
+    for (BlockId id = 3; id <= 5; ++id) {
+      ASSERT_EQ(imported.getRawBlock(id)->data, block_chain.getRawBlock(id)->data);
+    }
+    ASSERT_FALSE(imported.getRawBlock(2));
+    // The latest state includes the keys updated by blocks that were not exported.
+    for (auto i = 1; i <= 5; ++i) {
+      const auto suffix = std::to_string(i);
+      ASSERT_EQ(imported.getLatest("merkle", "merkle_key" + suffix),
+                block_chain.getLatest("merkle", "merkle_key" + suffix));
+      ASSERT_EQ(imported.getLatest("immutable", "imm_key" + suffix),
+                block_chain.getLatest("immutable", "imm_key" + suffix));
+    }
+    ASSERT_EQ(imported.getLatest("versioned", "ver_key"), block_chain.getLatest("versioned", "ver_key"));
+
+    // A database with blocks cannot import a snapshot.
+    ASSERT_THROW(KeyValueBlockchain::importSnapshot(db, snapshot_dir, last_block_digest), std::logic_error);
+  }
+  cleanup(1);
+  fs::remove_all(snapshot_dir);
+
+  // A value that doesn't match the immutable root hash of its block fails the import.
+  db->put("immutable" + IMMUTABLE_KV_CF_SUFFIX,
+          std::string{"imm_key4"},
+          serialize(ImmutableDbValue{4, "imm_val_tampered"}));
+  ASSERT_EQ(block_chain.exportSnapshot(snapshot_dir, 3), 5);
+  {
+    auto snapshot_db = TestRocksDb::createNative(1);
+    ASSERT_THROW(KeyValueBlockchain::importSnapshot(snapshot_db, snapshot_dir, last_block_digest), std::runtime_error);
+  }
+  cleanup(1);
+  fs::remove_all(snapshot_dir);
+}
+
+TEST_F(categorized_kvbc, import_snapshot_verifies_last_block_digest) {
+  const auto snapshot_dir = rocksDbPathPrefix + "_snapshot";
+  fs::remove_all(snapshot_dir);
+  KeyValueBlockchain block_chain{db,
+                                 true,
+                                 std::map<std::string, CATEGORY_TYPE>{{"merkle", CATEGORY_TYPE::block_merkle},
+                                                                      {"immutable", CATEGORY_TYPE::immutable}}};
+  const auto add_block = [&block_chain](const std::string& value) {
+    Updates updates;
+    BlockMerkleUpdates merkle_updates;
+    merkle_updates.addUpdate("merkle_key", std::string{value});
+    updates.add("merkle", std::move(merkle_updates));
+    ImmutableUpdates imm_updates;
+    imm_updates.addUpdate("imm_key" + value, {std::string{value}, {"tag"}});
+    imm_updates.calculateRootHash(true);
+    updates.add("immutable", std::move(imm_updates));
+    return block_chain.addBlock(std::move(updates));
+  };
+  for (auto i = 1; i <= 3; ++i) {
+    add_block(std::to_string(i));
+  }
+  const auto trusted_digest = blockDigest(block_chain, 3);
+
+  // Replace the last block by one with different data and the root hashes that match it. The snapshot is consistent
+  // in itself and only the trusted digest can reveal the tampering.
+  block_chain.deleteLastReachableBlock();
+  ASSERT_EQ(add_block("tampered"), 3);
+  const auto tampered_digest = blockDigest(block_chain, 3);
+  ASSERT_NE(tampered_digest, trusted_digest);
+  ASSERT_EQ(block_chain.exportSnapshot(snapshot_dir), 3);
+  {
+    auto snapshot_db = TestRocksDb::createNative(1);
+    ASSERT_THROW(KeyValueBlockchain::importSnapshot(snapshot_db, snapshot_dir, trusted_digest), std::runtime_error);
+  }
+  cleanup(1);
+  {
+    auto snapshot_db = TestRocksDb::createNative(1);
+    ASSERT_EQ(KeyValueBlockchain::importSnapshot(snapshot_db, snapshot_dir, tampered_digest), 3);
+  }
+  cleanup(1);
+  fs::remove_all(snapshot_dir);
+}
+
+TEST_F(categorized_kvbc, background_stale_data_deletion) {
+  // The config is global, so restore it even if an assertion fails, for the tests that run next.
+  auto& config = bftEngine::ReplicaConfig::instance();
+  const auto background_deletion = config.get("concord.kvbc.backgroundStaleDataDeletion", false);
+  const auto rate_limit = config.get<uint64_t>("concord.kvbc.staleDataDeletionRateLimitBytesPerSec", 32 * 1024 * 1024);
+  const auto compact = config.get("concord.kvbc.compactDeletedStaleData", false);
+  const auto restore_config = concord::util::ScopeExit{[&]() {
+    config.set("concord.kvbc.backgroundStaleDataDeletion", background_deletion);
+    config.set("concord.kvbc.staleDataDeletionRateLimitBytesPerSec", rate_limit);
+    config.set("concord.kvbc.compactDeletedStaleData", compact);
+  }};
+  config.set("concord.kvbc.backgroundStaleDataDeletion", true);
+  config.set("concord.kvbc.staleDataDeletionRateLimitBytesPerSec", 1024);
+  config.set("concord.kvbc.compactDeletedStaleData", true);
+  {
+    KeyValueBlockchain block_chain{
+        db, true, std::map<std::string, CATEGORY_TYPE>{{"merkle", CATEGORY_TYPE::block_merkle}}};
+    for (auto i = 1; i <= 5; ++i) {
+      Updates updates;
+      BlockMerkleUpdates merkle_updates;
+      merkle_updates.addUpdate("merkle_key", "merkle_value" + std::to_string(i));
+      updates.add("merkle", std::move(merkle_updates));
+      block_chain.addBlock(std::move(updates));
+    }
+    for (BlockId id = 1; id <= 3; ++id) {
+      ASSERT_TRUE(block_chain.deleteBlock(id));
+    }
+    block_chain.waitForStaleDataDeletion();
+
+    // Stale data is deleted up to the tree version of the last pruned block.
+    KeyValueBlockchain::KeyValueBlockchain_tester tester;
+    const auto& merkle = std::get<BlockMerkleCategory>(tester.getCategory("merkle", block_chain));
+    ASSERT_EQ(merkle.getLastDeletedTreeVersion(), 3);
+    for (auto version = 1; version <= 3; ++version) {
+      ASSERT_FALSE(db->get(BLOCK_MERKLE_STALE_CF, serialize(TreeVersion{static_cast<uint64_t>(version)})));
+    }
+    ASSERT_TRUE(db->get(BLOCK_MERKLE_STALE_CF, serialize(TreeVersion{4})));
+    ASSERT_EQ(asMerkle(*block_chain.getLatest("merkle", "merkle_key")).data, "merkle_value5");
+  }
+}
+
 TEST_F(categorized_kvbc, single_read_with_version) {
   KeyValueBlockchain block_chain{db,
                                  true,
@@ -12,7 +12,7 @@
 // file.
 
 #include <boost/detail/endian.hpp>
-#include <boost/lockfree/spsc_queue.hpp>
+#include <atomic>
 #include <cassert>
 #include <exception>
 #include <memory>
@@ -37,16 +37,19 @@
 #include <vector>
 #include "kvbc_app_filter/kvbc_app_filter.h"
 #include "storage/test/storage_test_common.h"
+#include "thin-replica-server/block_read_ahead.hpp"
 
 using com::vmware::concord::kvbc::ValueWithTrids;
 
-using boost::lockfree::spsc_queue;
 using concord::kvbc::BlockId;
 using concord::kvbc::InvalidBlockRange;
 using concord::kvbc::KvbAppFilter;
 using concord::kvbc::KvbFilteredUpdate;
+using concord::kvbc::KvbStateHashIndex;
 using concord::kvbc::KvbUpdate;
+using concord::thin_replica::BlockReadAhead;
 using concord::util::openssl_utils::computeSHA256Hash;
+using concord::util::openssl_utils::SHA256Hasher;
 
 namespace {
 
@@ -110,6 +113,7 @@ class FakeStorage : public concord::kvbc::IReader {
     ADD_FAILURE() << "multiGetLatestVersion() should not be called by this test";
   }
 
+  using concord::kvbc::IReader::getBlockUpdates;
   std::optional<concord::kvbc::categorization::Updates> getBlockUpdates(BlockId block_id) const override {
     if (block_id >= 0 && block_id < blockId_) {
       auto data = data_.at(block_id).immutable_kv_pairs;
@@ -329,6 +333,17 @@ TEST(kvbc_filter_test, kvbfilter_hash_update_success) {
   EXPECT_EQ(hash_val, computeSHA256Hash(concatenated_entry_hashes));
 }
 
+// Read and filter the blocks [start, end] the way the thin replica server does
+std::vector<KvbFilteredUpdate> readBlocks(KvbAppFilter &kvb_filter, BlockId start, BlockId end) {
+  BlockReadAhead<KvbFilteredUpdate> read_ahead{
+      start, end, 4, 8, [&kvb_filter](BlockId block_id) { return kvb_filter.readBlock(block_id); }};
+  std::vector<KvbFilteredUpdate> updates;
+  while (auto block = read_ahead.next()) {
+    updates.push_back(std::move(block->second));
+  }
+  return updates;
+}
+
 TEST(kvbc_filter_test, kvbfilter_success_get_blocks_in_range) {
   FakeStorage storage;
   size_t client_id = 123;
@@ -338,19 +353,12 @@ TEST(kvbc_filter_test, kvbfilter_success_get_blocks_in_range) {
 
   BlockId block_id_start = 0;
   BlockId block_id_end = 10;
-  KvbFilteredUpdate temporary;
-  spsc_queue<KvbFilteredUpdate> queue_out{storage.getLastBlockId()};
-  std::atomic_bool stop_exec = false;
-  kvb_filter.readBlockRange(block_id_start, block_id_end, queue_out, stop_exec);
-
-  std::vector<KvbFilteredUpdate> filtered_kv_pairs;
-  while (queue_out.pop(temporary)) {
-    filtered_kv_pairs.push_back(temporary);
-  }
+  auto filtered_kv_pairs = readBlocks(kvb_filter, block_id_start, block_id_end);
 
   EXPECT_EQ(filtered_kv_pairs.size(), block_id_end - block_id_start + 1);
   for (size_t i = 0; i < filtered_kv_pairs.size(); i++) {
     const auto &x = filtered_kv_pairs.at(i);
+    EXPECT_EQ(x.block_id, block_id_start + i);
     if (i != client_id)
       EXPECT_EQ(x.kv_pairs.size(), 0);
     else
@@ -364,29 +372,21 @@ TEST(kvbc_filter_test, kvbfilter_stop_exec_in_the_middle) {
   std::string key_prefix = "";
   auto kvb_filter = KvbAppFilter(&storage, std::to_string(client_id), key_prefix);
   storage.fillWithData(1000);
-  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(30);
-  KvbFilteredUpdate temporary;
-  spsc_queue<KvbFilteredUpdate> queue_out{storage.getLastBlockId()};
-  std::atomic_bool stop_exec = false;
-  auto kvb_reader = std::async(std::launch::async,
-                               &KvbAppFilter::readBlockRange,
-                               kvb_filter,
-                               0,
-                               kLastBlockId,
-                               std::ref(queue_out),
-                               std::ref(stop_exec));
-  while (queue_out.read_available() < 5) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    if (end < std::chrono::steady_clock::now()) ConcordAssert(false);
-  }
-  stop_exec = true;
-  kvb_reader.get();
-  int num_of_blocks = 0;
-  while (queue_out.pop(temporary)) {
-    num_of_blocks++;
+  std::atomic_size_t num_read{0};
+  {
+    BlockReadAhead<KvbFilteredUpdate> read_ahead{0, 999, 4, 8, [&kvb_filter, &num_read](BlockId block_id) {
+                                                   ++num_read;
+                                                   return kvb_filter.readBlock(block_id);
+                                                 }};
+    for (BlockId block_id = 0; block_id < 5; ++block_id) {
+      auto block = read_ahead.next();
+      ASSERT_TRUE(block);
+      EXPECT_EQ(block->second.block_id, block_id);
+    }
   }
-  EXPECT_GT(num_of_blocks, 0);
-  EXPECT_LE(num_of_blocks, 1000);
+  // Destroying the read-ahead stops reading ahead of the consumed blocks
+  EXPECT_GE(num_read, 5);
+  EXPECT_LE(num_read, 5 + 8);
 }
 
 TEST(kvbc_filter_test, kvbfilter_block_out_of_range) {
@@ -395,10 +395,7 @@ TEST(kvbc_filter_test, kvbfilter_block_out_of_range) {
   std::string key_prefix = "";
   auto kvb_filter = KvbAppFilter(&storage, std::to_string(client_id), key_prefix);
   BlockId block_id = kLastBlockId + 5;
-  KvbFilteredUpdate temporary;
-  spsc_queue<KvbFilteredUpdate> queue_out{storage.getLastBlockId()};
-  std::atomic_bool stop_exec = false;
-  EXPECT_THROW(kvb_filter.readBlockRange(block_id, block_id, queue_out, stop_exec);, InvalidBlockRange);
+  EXPECT_THROW(kvb_filter.readBlockHash(block_id);, InvalidBlockRange);
 }
 
 TEST(kvbc_filter_test, kvbfilter_end_block_greater_then_start_block) {
@@ -409,10 +406,8 @@ TEST(kvbc_filter_test, kvbfilter_end_block_greater_then_start_block) {
   storage.fillWithData(kLastBlockId);
   BlockId block_id_end = 0;
   BlockId block_id_start = 10;
-  KvbFilteredUpdate temporary;
-  spsc_queue<KvbFilteredUpdate> queue_out{storage.getLastBlockId()};
-  std::atomic_bool stop_exec = false;
-  EXPECT_THROW(kvb_filter.readBlockRange(block_id_start, block_id_end, queue_out, stop_exec);, InvalidBlockRange);
+  EXPECT_THROW(kvb_filter.readBlockRangeHash(block_id_start, block_id_end);, InvalidBlockRange);
+  EXPECT_TRUE(readBlocks(kvb_filter, block_id_start, block_id_end).empty());
 }
 
 TEST(kvbc_filter_test, kvbfilter_success_hash_of_blocks_in_range) {
@@ -434,14 +429,7 @@ TEST(kvbc_filter_test, kvbfilter_success_hash_of_blocks_in_range) {
 
   BlockId block_id_start = 0;
   BlockId block_id_end = 10;
-  KvbFilteredUpdate temporary;
-  spsc_queue<KvbFilteredUpdate> queue_out{storage.getLastBlockId()};
-  std::atomic_bool stop_exec = false;
-  kvb_filter.readBlockRange(block_id_start, block_id_end, queue_out, stop_exec);
-  std::vector<KvbFilteredUpdate> filtered_kv_pairs;
-  while (queue_out.pop(temporary)) {
-    filtered_kv_pairs.push_back(temporary);
-  }
+  auto filtered_kv_pairs = readBlocks(kvb_filter, block_id_start, block_id_end);
 
   auto hash_value = kvb_filter.readBlockRangeHash(block_id_start, block_id_end);
   std::string concatenated_update_hashes;
@@ -452,6 +440,85 @@ TEST(kvbc_filter_test, kvbfilter_success_hash_of_blocks_in_range) {
   EXPECT_EQ(hash_value, computeSHA256Hash(concatenated_update_hashes));
 }
 
+// The state hash is the same whether it is computed from checkpoints or not
+TEST(kvbc_filter_test, kvbfilter_hash_of_blocks_in_range_with_index) {
+  FakeStorage storage;
+  storage.fillWithData(kLastBlockId);
+  auto kvb_filter = KvbAppFilter(&storage, "1", "");
+  KvbStateHashIndex index{3, 10, 100};
+  auto indexed_filter = KvbAppFilter(&storage, "1", "", &index);
+
+  for (BlockId block_id_end : {BlockId{2}, BlockId{7}, BlockId{5}, BlockId{9}, BlockId{100}, BlockId{6}}) {
+    EXPECT_EQ(indexed_filter.readBlockRangeHash(0, block_id_end), kvb_filter.readBlockRangeHash(0, block_id_end));
+    EXPECT_EQ(indexed_filter.readBlockRangeHash(2, block_id_end), kvb_filter.readBlockRangeHash(2, block_id_end));
+  }
+
+  // Checkpoints are kept per start block
+  auto checkpoint = index.nearest({"1", "", 0}, 7);
+  ASSERT_TRUE(checkpoint);
+  EXPECT_EQ(checkpoint->first, 5);
+  checkpoint = index.nearest({"1", "", 2}, 7);
+  ASSERT_TRUE(checkpoint);
+  EXPECT_EQ(checkpoint->first, 7);
+  EXPECT_FALSE(index.nearest({"2", "", 0}, 7));
+}
+
+// Live updates extend the state hash computations that got up to the previous block
+TEST(kvbc_filter_test, kvbfilter_hash_of_blocks_in_range_extended_by_live_updates) {
+  FakeStorage storage;
+  storage.fillWithData(kLastBlockId);
+  auto kvb_filter = KvbAppFilter(&storage, "1", "");
+  KvbStateHashIndex index{3, 10, 100};
+  auto indexed_filter = KvbAppFilter(&storage, "1", "", &index);
+  // Live updates are filtered without storage
+  auto live_filter = KvbAppFilter(nullptr, "1", "", &index);
+  auto live_hash = [&kvb_filter](BlockId block_id) {
+    return [&kvb_filter, block_id]() { return kvb_filter.hashUpdate(kvb_filter.readBlock(block_id)); };
+  };
+
+  EXPECT_EQ(indexed_filter.readBlockRangeHash(0, 50), kvb_filter.readBlockRangeHash(0, 50));
+  for (BlockId block_id = 51; block_id <= 60; ++block_id) {
+    live_filter.extendStateHash(block_id, live_hash(block_id));
+  }
+  auto checkpoint = index.nearest({"1", "", 0}, 100);
+  ASSERT_TRUE(checkpoint);
+  EXPECT_EQ(checkpoint->first, 60);
+  // The checkpoints in between are added too
+  checkpoint = index.nearest({"1", "", 0}, 59);
+  ASSERT_TRUE(checkpoint);
+  EXPECT_EQ(checkpoint->first, 59);
+  EXPECT_EQ(indexed_filter.readBlockRangeHash(0, 60), kvb_filter.readBlockRangeHash(0, 60));
+  EXPECT_EQ(indexed_filter.readBlockRangeHash(0, 57), kvb_filter.readBlockRangeHash(0, 57));
+
+  // A live update after a gap doesn't extend the computation and isn't hashed
+  live_filter.extendStateHash(70, []() -> std::string {
+    ADD_FAILURE() << "The update shouldn't be hashed";
+    return {};
+  });
+  EXPECT_EQ(index.nearest({"1", "", 0}, 100)->first, 60);
+  EXPECT_EQ(indexed_filter.readBlockRangeHash(0, 100), kvb_filter.readBlockRangeHash(0, 100));
+}
+
+// Only the latest checkpoints of the most recently used filters are kept
+TEST(kvbc_filter_test, kvbfilter_state_hash_index_is_bounded) {
+  KvbStateHashIndex index{1, 2, 3};
+  SHA256Hasher hasher;
+  for (BlockId block_id = 1; block_id <= 5; ++block_id) {
+    index.add({"1", "", 0}, block_id, hasher);
+  }
+  EXPECT_EQ(index.nearest({"1", "", 0}, 5)->first, 5);
+  EXPECT_EQ(index.nearest({"1", "", 0}, 3)->first, 3);
+  EXPECT_FALSE(index.nearest({"1", "", 0}, 2));
+
+  index.add({"2", "", 0}, 1, hasher);
+  // Filter "1" is used after filter "2" is added, so filter "2" is evicted to make room for filter "3"
+  EXPECT_TRUE(index.nearest({"1", "", 0}, 5));
+  index.add({"3", "", 0}, 1, hasher);
+  EXPECT_FALSE(index.nearest({"2", "", 0}, 1));
+  EXPECT_TRUE(index.nearest({"1", "", 0}, 5));
+  EXPECT_TRUE(index.nearest({"3", "", 0}, 1));
+}
+
 TEST(kvbc_filter_test, kvbfilter_success_hash_of_block) {
   FakeStorage storage;
   int client_id = 1;
@@ -401,6 +401,11 @@ class TestStorage : public IReader, public IBlockAdder, public IBlocksDeleter {
     return bc_.getBlockUpdates(block_id);
   }
 
+  std::optional<categorization::Updates> getBlockUpdates(BlockId block_id,
+                                                         const std::set<std::string> &category_ids) const override {
+    return bc_.getBlockUpdates(block_id, category_ids);
+  }
+
   BlockId getGenesisBlockId() const override {
     if (mockGenesisBlockId.has_value()) return mockGenesisBlockId.value();
     return bc_.getGenesisBlockId();
@@ -560,6 +560,26 @@ struct CompareTo {
   }
 };
 
+struct ExportSnapshot {
+  const bool read_only = true;
+  std::string description() const {
+    return "exportSnapshot SNAPSHOT-DIR [NUM-BLOCKS]\n"
+           "  Exports the state of all categories and the last NUM-BLOCKS blocks (all blocks if not given) as SST\n"
+           "  files to the new SNAPSHOT-DIR directory. Returns the ID of the last exported block.";
+  }
+
+  std::string execute(const KeyValueBlockchain &adapter, const CommandArguments &args) const {
+    if (args.values.empty()) {
+      throw std::invalid_argument{"Missing SNAPSHOT-DIR argument"};
+    }
+    auto num_blocks = std::optional<std::uint64_t>{};
+    if (args.values.size() > 1) {
+      num_blocks = toBlockId(args.values[1]);
+    }
+    return toJson("lastBlockID", adapter.exportSnapshot(args.values.front(), num_blocks));
+  }
+};
+
 struct RemoveMetadata {
   const bool read_only = false;
   std::string description() const {
@@ -598,6 +618,7 @@ using Command = std::variant<GetGenesisBlockID,
                              GetStaleKeysSummary,
                              GetValue,
                              CompareTo,
+                             ExportSnapshot,
                              RemoveMetadata>;
 inline const auto commands_map = std::map<std::string, Command>{
     std::make_pair("getGenesisBlockID", GetGenesisBlockID{}),
@@ -614,6 +635,7 @@ inline const auto commands_map = std::map<std::string, Command>{
     std::make_pair("getStaleKeysSummary", GetStaleKeysSummary{}),
     std::make_pair("getValue", GetValue{}),
     std::make_pair("compareTo", CompareTo{}),
+    std::make_pair("exportSnapshot", ExportSnapshot{}),
     std::make_pair("removeMetadata", RemoveMetadata{}),
 };
 
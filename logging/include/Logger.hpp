@@ -19,10 +19,12 @@
 #define MDC_PRIMARY_KEY "pri"
 #define MDC_PATH_KEY "path"
 
-#ifndef USE_LOG4CPP
-#include "Logging.hpp"
-#else
+#if defined(USE_LOG4CPP)
 #include "Logging4cplus.hpp"
+#elif defined(USE_ASYNC_LOGGING)
+#include "LoggingAsync.hpp"
+#else
+#include "Logging.hpp"
 #endif
 
 extern logging::Logger GL;
@@ -45,7 +47,12 @@ void initLogger(const std::string& configFileName);
 
 class ScopedMdc {
  public:
+#ifdef USE_ASYNC_LOGGING
+  // The async MDC copies the value into its fixed storage, no need to materialize a std::string.
+  ScopedMdc(std::string_view key, std::string_view val);
+#else
   ScopedMdc(const std::string& key, const std::string& val);
+#endif
   ~ScopedMdc();
 
  private:
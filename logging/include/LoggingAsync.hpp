@@ -0,0 +1,222 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+/**
+ * Asynchronous logging backend.
+ *
+ * - The MDC is a fixed size thread local array of key/value slots with inline value storage, so putting and removing
+ *   values doesn't allocate.
+ * - The message (the streamed part of LOG_*) is written into a reusable thread local buffer. It is then copied,
+ *   together with the level, logger, function, timestamp and the MDC values that appear in the output, into a
+ *   lock-free single producer/single consumer ring owned by the logging thread.
+ * - A background thread drains the rings of all threads, formats the records and writes them to stdout.
+ *
+ * Records of the same thread are written in order. A full ring makes the logging thread wait for the background
+ * thread, i.e. records are never dropped. FATAL records are flushed before the LOG_FATAL statement returns. At exit
+ * the background thread is stopped once the threads that are pushing records are done, and later records are
+ * written synchronously.
+ */
+namespace logging {
+
+/**
+ *  Logging Levels
+ */
+enum LogLevel { trace, debug, info, warn, error, fatal };
+
+/**
+ * Mapped Diagnostic Context
+ * A fixed number of slots. Values longer than kMaxValueSize are truncated and puts beyond kNumSlots keys are ignored.
+ */
+class MDC {
+ public:
+  static constexpr size_t kNumSlots = 8;
+  static constexpr size_t kMaxKeySize = 15;
+  static constexpr size_t kMaxValueSize = 55;
+
+  void put(std::string_view key, std::string_view val) {
+    auto* slot = find(key);
+    if (!slot) slot = find({});
+    if (!slot) return;
+    slot->key_size = static_cast<uint8_t>(std::min(key.size(), kMaxKeySize));
+    std::memcpy(slot->key, key.data(), slot->key_size);
+    slot->value_size = static_cast<uint8_t>(std::min(val.size(), kMaxValueSize));
+    std::memcpy(slot->value, val.data(), slot->value_size);
+  }
+  // Returns a view into the MDC storage - valid until the key is modified.
+  std::string_view view(std::string_view key) const {
+    const auto* slot = find(key);
+    return slot ? std::string_view{slot->value, slot->value_size} : std::string_view{};
+  }
+  std::string get(std::string_view key) const { return std::string{view(key)}; }
+  void remove(std::string_view key) {
+    if (auto* slot = find(key)) slot->key_size = slot->value_size = 0;
+  }
+  void clear() {
+    for (auto& slot : slots_) slot.key_size = slot.value_size = 0;
+  }
+
+ private:
+  struct Slot {
+    uint8_t key_size = 0;
+    uint8_t value_size = 0;
+    char key[kMaxKeySize];
+    char value[kMaxValueSize];
+  };
+
+  // An empty key finds a free slot.
+  const Slot* find(std::string_view key) const {
+    key = key.substr(0, kMaxKeySize);
+    for (const auto& slot : slots_) {
+      if (slot.key_size == key.size() && (key.empty() || std::memcmp(slot.key, key.data(), key.size()) == 0))
+        return &slot;
+    }
+    return nullptr;
+  }
+  Slot* find(std::string_view key) { return const_cast<Slot*>(static_cast<const MDC*>(this)->find(key)); }
+
+  std::array<Slot, kNumSlots> slots_;
+};
+
+/**
+ * Logger Thread Context
+ * thread local
+ */
+class ThreadContext {
+ public:
+  MDC& getMDC() { return mdc_; }
+
+ private:
+  MDC mdc_;
+};
+
+/**
+ * Logger implementation
+ */
+class LoggerImpl {
+ public:
+  LoggerImpl(const std::string& name) : name_(name) {}
+  LoggerImpl(const LoggerImpl&) = delete;
+  LoggerImpl& operator=(const LoggerImpl&) = delete;
+  ~LoggerImpl() = default;
+
+  const std::string& name() const { return name_; }
+
+ private:
+  friend class Logger;
+
+  static ThreadContext& getThreadContext() {
+    static thread_local ThreadContext t_;
+    return t_;
+  }
+
+  std::string name_;
+  LogLevel level_ = LogLevel::info;
+
+ public:
+  static std::array<std::string, 6> LEVELS_STRINGS;
+};
+
+/**
+ * Main logger class - is a wrapper around LoggerImpl
+ * since this class is copied around.
+ */
+class Logger {
+ public:
+  Logger(LoggerImpl& logger) : logger_{&logger} {}
+  LogLevel getLogLevel() const { return logger_->level_; }
+  void setLogLevel(LogLevel l) { logger_->level_ = l; }
+  const LoggerImpl* impl() const { return logger_; }
+  static ThreadContext& getThreadContext() { return LoggerImpl::getThreadContext(); }
+  static bool config(const std::string& configFileName);
+
+ private:
+  LoggerImpl* logger_;
+};
+
+namespace async {
+
+// A stream buffer over a std::string whose capacity is kept between records.
+class MessageBuffer : public std::streambuf {
+ public:
+  void clear() { msg_.clear(); }
+  std::string_view view() const { return msg_; }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (ch != traits_type::eof()) msg_.push_back(static_cast<char>(ch));
+    return ch;
+  }
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    msg_.append(s, static_cast<size_t>(n));
+    return n;
+  }
+
+ private:
+  std::string msg_;
+};
+
+class MessageStream : public std::ostream {
+ public:
+  MessageStream() : std::ostream(&buf_) {}
+  MessageBuffer& buffer() { return buf_; }
+
+ private:
+  MessageBuffer buf_;
+};
+
+// Returns a cleared thread local message stream. Nested log statements (e.g. from an operator<<) get their own stream.
+MessageStream& beginRecord();
+
+// Pushes the message streamed since beginRecord() to the thread's ring.
+void commitRecord(const Logger& logger, LogLevel level, const char* func);
+
+// Waits until all the records logged so far by the calling thread are written.
+void flush();
+
+// Writes the records logged so far and stops the background thread. Later records are written synchronously by the
+// logging thread. Called at exit.
+void stop();
+
+}  // namespace async
+
+}  // namespace logging
+
+#define LOG_COMMON(logger, level, s)                                   \
+  if (logger.getLogLevel() <= level) {                                 \
+    logging::async::beginRecord() << s;                                \
+    logging::async::commitRecord(logger, level, __PRETTY_FUNCTION__); \
+  }
+
+#define LOG_TRACE(l, s) LOG_COMMON(l, logging::LogLevel::trace, s)
+#define LOG_DEBUG(l, s) LOG_COMMON(l, logging::LogLevel::debug, s)
+#define LOG_INFO(l, s) LOG_COMMON(l, logging::LogLevel::info, s)
+#define LOG_WARN(l, s) LOG_COMMON(l, logging::LogLevel::warn, s)
+#define LOG_ERROR(l, s) LOG_COMMON(l, logging::LogLevel::error, s)
+#define LOG_FATAL(l, s) LOG_COMMON(l, logging::LogLevel::fatal, s)
+
+#define MDC_PUT(k, v) logging::Logger::getThreadContext().getMDC().put(k, v);
+#define MDC_REMOVE(k) logging::Logger::getThreadContext().getMDC().remove(k);
+#define MDC_CLEAR logging::Logger::getThreadContext().getMDC().clear();
+#define MDC_GET(k) logging::Logger::getThreadContext().getMDC().get(k)
+
+#define LOG_CONFIGURE_AND_WATCH(config_file, millis) logging::initLogger(config_file)
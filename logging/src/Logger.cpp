@@ -16,7 +16,11 @@
 
 namespace logging {
 
+#ifdef USE_ASYNC_LOGGING
+ScopedMdc::ScopedMdc(std::string_view key, std::string_view val) : key_{key} { MDC_PUT(key, val); }
+#else
 ScopedMdc::ScopedMdc(const std::string& key, const std::string& val) : key_{key} { MDC_PUT(key, val); }
+#endif
 ScopedMdc::~ScopedMdc() { MDC_REMOVE(key_); }
 
 }  // namespace logging
@@ -0,0 +1,330 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license,
+// as noted in the LICENSE file.
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging::async {
+
+namespace {
+
+// The MDC values that appear in the output, in output order.
+constexpr std::array<const char*, 4> kMdcKeys = {MDC_REPLICA_ID_KEY, MDC_THREAD_KEY, MDC_CID_KEY, MDC_SEQ_NUM_KEY};
+
+// Ring size per logging thread. Must be a power of 2.
+constexpr size_t kRingSize = 256 * 1024;
+// Longer messages are truncated.
+constexpr size_t kMaxMessageSize = kRingSize / 4;
+constexpr size_t kMaxNestedRecords = 4;
+constexpr auto kIdleSleep = std::chrono::milliseconds(1);
+
+struct RecordHeader {
+  uint32_t size;  // including the header
+  LogLevel level;
+  const LoggerImpl* logger;
+  const char* func;
+  int64_t time_us;  // since epoch
+  std::array<uint8_t, kMdcKeys.size()> mdc_sizes;
+  uint32_t msg_size;
+  // followed by the MDC values and the message
+};
+
+// A single producer/single consumer ring of variable sized records.
+class Ring {
+ public:
+  Ring() : data_(new char[kRingSize]) {}
+
+  // Producer side. Waits while the ring is full. Returns false without pushing if `stopped` is set while waiting.
+  bool push(const RecordHeader& header,
+            const std::array<std::string_view, kMdcKeys.size()>& mdc,
+            std::string_view msg,
+            const std::atomic_bool& stopped) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    while (head + header.size - tail_cache_ > kRingSize) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head + header.size - tail_cache_ <= kRingSize) break;
+      if (stopped.load(std::memory_order_acquire)) return false;
+      std::this_thread::yield();
+    }
+    uint64_t pos = head;
+    write(pos, reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& v : mdc) write(pos, v.data(), v.size());
+    write(pos, msg.data(), msg.size());
+    head_.store(head + header.size, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Calls f(header, mdc, msg) for each available record. Returns the number of records consumed.
+  template <typename F>
+  size_t consume(std::string& scratch, F&& f) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (tail < head) {
+      RecordHeader header;
+      uint64_t pos = tail;
+      read(pos, reinterpret_cast<char*>(&header), sizeof(header));
+      scratch.resize(header.size - sizeof(header));
+      read(pos, scratch.data(), scratch.size());
+      std::array<std::string_view, kMdcKeys.size()> mdc;
+      size_t offset = 0;
+      for (size_t i = 0; i < mdc.size(); ++i) {
+        mdc[i] = std::string_view{scratch.data() + offset, header.mdc_sizes[i]};
+        offset += header.mdc_sizes[i];
+      }
+      f(header, mdc, std::string_view{scratch.data() + offset, header.msg_size});
+      tail += header.size;
+      tail_.store(tail, std::memory_order_release);
+      ++count;
+    }
+    return count;
+  }
+
+  // Consumer side. Called once the consumed records are written.
+  void markWritten() { written_.store(tail_.load(std::memory_order_relaxed), std::memory_order_release); }
+
+  uint64_t head() const { return head_.load(std::memory_order_acquire); }
+  uint64_t tail() const { return tail_.load(std::memory_order_acquire); }
+  uint64_t written() const { return written_.load(std::memory_order_acquire); }
+  bool empty() const { return head() == tail(); }
+
+  // Set when the owning thread exits.
+  std::atomic_bool closed{false};
+
+ private:
+  void write(uint64_t& pos, const char* src, size_t len) {
+    const size_t offset = pos & (kRingSize - 1);
+    const size_t first = std::min(len, kRingSize - offset);
+    std::memcpy(data_.get() + offset, src, first);
+    std::memcpy(data_.get(), src + first, len - first);
+    pos += len;
+  }
+  void read(uint64_t& pos, char* dst, size_t len) const {
+    const size_t offset = pos & (kRingSize - 1);
+    const size_t first = std::min(len, kRingSize - offset);
+    std::memcpy(dst, data_.get() + offset, first);
+    std::memcpy(dst + first, data_.get(), len - first);
+    pos += len;
+  }
+
+  std::unique_ptr<char[]> data_;
+  alignas(64) std::atomic_uint64_t head_{0};
+  uint64_t tail_cache_ = 0;  // producer's view of tail_
+  alignas(64) std::atomic_uint64_t tail_{0};
+  std::atomic_uint64_t written_{0};
+};
+
+// Owns the rings and the background writer thread. Never destroyed, as loggers are used during static destruction.
+using ThreadRing = std::shared_ptr<Ring>;
+
+class Backend {
+ public:
+  static Backend& instance() {
+    static Backend* backend = new Backend();
+    return *backend;
+  }
+
+  std::shared_ptr<Ring> registerRing() {
+    auto ring = std::make_shared<Ring>();
+    std::lock_guard<std::mutex> g(lock_);
+    rings_.push_back(ring);
+    return ring;
+  }
+
+  // After stop() records are written synchronously by the logging thread.
+  bool stopped() const { return stopped_.load(std::memory_order_acquire); }
+
+  // Push a record to the ring of the calling thread, or write it synchronously after stop().
+  void log(ThreadRing& ring,
+           const RecordHeader& header,
+           const std::array<std::string_view, kMdcKeys.size()>& mdc,
+           std::string_view msg) {
+    // Either stop() sees this producer and keeps draining until it is done, or this producer sees stopped_ (both are
+    // sequentially consistent).
+    producers_.fetch_add(1);
+    if (!stopped_.load()) {
+      if (!ring) ring = registerRing();
+      if (ring->push(header, mdc, msg, stopped_)) {
+        producers_.fetch_sub(1, std::memory_order_release);
+        return;
+      }
+    }
+    // Keep the records of the thread in order: the background thread writes the pushed ones before exiting.
+    if (ring) {
+      while (ring->written() < ring->head()) std::this_thread::sleep_for(kIdleSleep);
+    }
+    producers_.fetch_sub(1, std::memory_order_release);
+    writeSync(header, mdc, msg);
+  }
+
+  // Write the records pushed so far and stop the background thread.
+  void stop() {
+    std::lock_guard<std::mutex> g(stop_lock_);
+    stopped_.store(true);
+    if (thread_.joinable()) thread_.join();
+  }
+
+  void writeSync(const RecordHeader& header,
+                 const std::array<std::string_view, kMdcKeys.size()>& mdc,
+                 std::string_view msg) {
+    std::lock_guard<std::mutex> g(write_lock_);
+    std::string out;
+    format(header, mdc, msg, out);
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+  }
+
+ private:
+  Backend() {
+    thread_ = std::thread([this]() { run(); });
+    std::atexit([]() { instance().stop(); });
+  }
+
+  void run() {
+    std::string scratch;
+    std::string out;
+    std::vector<std::shared_ptr<Ring>> rings;
+    while (true) {
+      // Check before draining, so that the records pushed before stop() and by the producers that were pushing at the
+      // time are written. Later records are written synchronously.
+      const bool stop = stopped() && producers_.load() == 0;
+      {
+        std::lock_guard<std::mutex> g(lock_);
+        // Rings of exited threads are dropped once drained.
+        rings_.erase(std::remove_if(rings_.begin(),
+                                    rings_.end(),
+                                    [](const auto& r) { return r->closed.load() && r->empty(); }),
+                     rings_.end());
+        rings = rings_;
+      }
+      size_t count = 0;
+      for (auto& ring : rings) {
+        count += ring->consume(scratch, [&](const RecordHeader& h, const auto& mdc, std::string_view msg) {
+          format(h, mdc, msg, out);
+        });
+      }
+      if (!out.empty()) {
+        std::lock_guard<std::mutex> g(write_lock_);
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+        out.clear();
+      }
+      for (auto& ring : rings) ring->markWritten();
+      if (stop) return;
+      if (count == 0) std::this_thread::sleep_for(kIdleSleep);
+    }
+  }
+
+  // Same layout as the synchronous backend.
+  static void format(const RecordHeader& h,
+                     const std::array<std::string_view, kMdcKeys.size()>& mdc,
+                     std::string_view msg,
+                     std::string& out) {
+    const std::time_t sec = h.time_us / 1000000;
+    const int ms = static_cast<int>((h.time_us % 1000000) / 1000);
+    std::tm tm;
+    localtime_r(&sec, &tm);
+    char time_buf[32];
+    const auto time_len = std::strftime(time_buf, sizeof(time_buf), "%F %T.", &tm);
+
+    out.append(mdc[0]).append("|");
+    out.append(time_buf, time_len).append(std::to_string(ms)).append("|");
+    out.append(LoggerImpl::LEVELS_STRINGS[h.level]).append("|");
+    out.append(h.logger->name()).append("|");
+    out.append(mdc[1]).append("|").append(mdc[2]).append("|").append(mdc[3]).append("|");
+    out.append(h.func).append("|");
+    out.append(msg).append("\n");
+  }
+
+  std::mutex lock_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  std::mutex write_lock_;
+  std::atomic_bool stopped_{false};
+  // The number of threads that are pushing a record
+  std::atomic_int producers_{0};
+  std::mutex stop_lock_;
+  std::thread thread_;
+};
+
+// The ring and message streams of a logging thread.
+struct ThreadState {
+  ~ThreadState() {
+    if (ring) ring->closed = true;
+  }
+
+  std::shared_ptr<Ring> ring;
+  std::array<MessageStream, kMaxNestedRecords> streams;
+  size_t depth = 0;
+};
+
+ThreadState& threadState() {
+  static thread_local ThreadState state;
+  return state;
+}
+
+}  // namespace
+
+MessageStream& beginRecord() {
+  auto& state = threadState();
+  // A record that was begun but not committed (e.g. its message threw) is discarded.
+  if (state.depth == kMaxNestedRecords) state.depth = 0;
+  auto& stream = state.streams[state.depth++];
+  stream.buffer().clear();
+  return stream;
+}
+
+void commitRecord(const Logger& logger, LogLevel level, const char* func) {
+  auto& state = threadState();
+  if (state.depth == 0) return;
+  const auto msg = state.streams[--state.depth].buffer().view().substr(0, kMaxMessageSize);
+
+  RecordHeader header;
+  header.level = level;
+  header.logger = logger.impl();
+  header.func = func;
+  header.time_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  std::array<std::string_view, kMdcKeys.size()> mdc;
+  const auto& mdc_storage = Logger::getThreadContext().getMDC();
+  uint32_t size = sizeof(header);
+  for (size_t i = 0; i < kMdcKeys.size(); ++i) {
+    mdc[i] = mdc_storage.view(kMdcKeys[i]);
+    header.mdc_sizes[i] = static_cast<uint8_t>(mdc[i].size());
+    size += mdc[i].size();
+  }
+  header.msg_size = static_cast<uint32_t>(msg.size());
+  header.size = size + header.msg_size;
+
+  Backend::instance().log(state.ring, header, mdc, msg);
+  if (level == LogLevel::fatal) flush();
+}
+
+void flush() {
+  auto& ring = threadState().ring;
+  if (!ring) return;
+  const auto head = ring->head();
+  while (ring->written() < head && !Backend::instance().stopped()) std::this_thread::sleep_for(kIdleSleep);
+}
+
+void stop() { Backend::instance().stop(); }
+
+}  // namespace logging::async
@@ -0,0 +1,101 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "Logger.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using testing::internal::CaptureStdout;
+using testing::internal::GetCapturedStdout;
+
+auto logger = logging::getLogger("concord.logging.test");
+
+// Bigger than the ring of a thread
+constexpr size_t kRecordsPerThread = 2000;
+const auto kPadding = std::string(1000, 'x');
+
+// Log kRecordsPerThread records tagged with `thread`.
+void logRecords(int thread) {
+  for (size_t i = 0; i < kRecordsPerThread; ++i) {
+    LOG_INFO(logger, "record " << thread << ":" << i << " " << kPadding);
+  }
+}
+
+// Returns the indexes of the records of each thread, in output order.
+std::vector<std::vector<size_t>> parseRecords(const std::string& output, int threads) {
+  auto records = std::vector<std::vector<size_t>>(threads);
+  auto lines = std::istringstream{output};
+  auto line = std::string{};
+  while (std::getline(lines, line)) {
+    const auto pos = line.find("record ");
+    if (pos == std::string::npos) continue;
+    auto thread = 0;
+    auto index = size_t{0};
+    auto sep = char{};
+    std::istringstream{line.substr(pos + 7)} >> thread >> sep >> index;
+    records.at(thread).push_back(index);
+  }
+  return records;
+}
+
+void expectAllRecordsInOrder(const std::vector<size_t>& records) {
+  ASSERT_EQ(records.size(), kRecordsPerThread);
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(records[i], i);
+  }
+}
+
+TEST(async_logging_test, full_ring_waits_for_background_thread) {
+  CaptureStdout();
+  logRecords(0);
+  logging::async::flush();
+  const auto records = parseRecords(GetCapturedStdout(), 1);
+  expectAllRecordsInOrder(records[0]);
+}
+
+// Stops the backend, so the tests below must come last.
+TEST(async_logging_test, stop_writes_records_of_concurrent_threads) {
+  constexpr auto kThreads = 4;
+  CaptureStdout();
+  auto threads = std::vector<std::thread>{};
+  for (auto i = 0; i < kThreads; ++i) {
+    threads.emplace_back([i]() { logRecords(i); });
+  }
+  // Stop while the threads are logging, some of them waiting for a full ring.
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  logging::async::stop();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto records = parseRecords(GetCapturedStdout(), kThreads);
+  for (const auto& thread_records : records) {
+    expectAllRecordsInOrder(thread_records);
+  }
+}
+
+TEST(async_logging_test, records_after_stop_are_written_synchronously) {
+  logging::async::stop();
+  CaptureStdout();
+  LOG_INFO(logger, "record 0:0");
+  LOG_INFO(logger, "record 0:1");
+  const auto records = parseRecords(GetCapturedStdout(), 1);
+  ASSERT_EQ(records[0], (std::vector<size_t>{0, 1}));
+}
+
+}  // namespace
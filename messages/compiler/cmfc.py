@@ -21,11 +21,11 @@ def parse(grammar, cmf):
     return ast, symbol_table
 
 
-def translate(ast, language, namespace, output):
+def translate(ast, language, namespace, output, views=False):
     if language == "cpp":
         print("Generating C++ source code")
         from cpp import cppgen
-        header, impl = cppgen.translate(ast, output + ".hpp", namespace)
+        header, impl = cppgen.translate(ast, output + ".hpp", namespace, views)
         with open(output + ".hpp", "w") as f:
             f.write(header)
         with open(output + ".cpp", "w") as f:
@@ -53,6 +53,10 @@ def parse_args():
     parser.add_argument(
         "--namespace",
         help="Add a namespace if required by the given language")
+    parser.add_argument(
+        "--views",
+        action="store_true",
+        help="Also generate view types that deserialize strings and bytes without copying (C++ only)")
     return parser.parse_args()
 
 
@@ -67,4 +71,4 @@ if __name__ == "__main__":
         ast, symbol_table = parse(grammar, cmf)
         # Uncomment to show the generated AST for debugging purposes
         # pprint(ast)
-        translate(ast, args.language, args.namespace, args.output)
+        translate(ast, args.language, args.namespace, args.output, args.views)
@@ -21,15 +21,61 @@ struct {name} {{
 """
 
 
-serialize_fn = "void serialize(std::vector<uint8_t>& output, const {name}& t)"
+def view_name(name):
+    """ The name of the view struct of message `name` """
+    return name + "View"
+
+
+serialized_size_fn = "size_t serializedSize(const {name}& t)"
+
+
+def serialized_size_declaration(name):
+    return serialized_size_fn.format(name=name) + ";\n"
+
+
+def serialized_size(name, fields):
+    terms = "\n         + ".join([serialized_size_field(f, type) for (f, type) in fields])
+    return serialized_size_fn.format(name=name) + f""" {{
+  return {terms};
+}}
+"""
+
+
+def serialized_size_field(name, type):
+    # All messages except oneofs and messages exist in the cmf namespace, and are provided in
+    # serialize.h
+    if type in ["oneof", "msg"]:
+        return f"serializedSize(t.{name})"
+    return f"cmf::serializedSize(t.{name})"
+
+
+serialize_fn = "void serialize(uint8_t*& output, const {name}& t)"
 
 
 def serialize_declaration(name):
     return serialize_fn.format(name=name) + ";\n"
 
 
-def serialize_start(name):
-    return serialize_fn.format(name=name) + " {\n"
+def serialize(name, fields):
+    return serialize_fn.format(name=name) + " {\n" + "".join(
+        [serialize_field(f, type) for (f, type) in fields]) + "}\n"
+
+
+serialize_byte_buffer_fn = "void serialize(std::vector<uint8_t>& output, const {name}& t)"
+
+
+def serialize_byte_buffer_declaration(name):
+    return serialize_byte_buffer_fn.format(name=name) + ";\n"
+
+
+def serialize_byte_buffer(name):
+    return serialize_byte_buffer_fn.format(name=name) + """ {
+  const auto offset = output.size();
+  output.resize(offset + serializedSize(t));
+  auto out = output.data() + offset;
+  serialize(out, t);
+}
+"""
 
 
 deserialize_fn = "void deserialize(const uint8_t*& input, const uint8_t* end, {name}& t)"
@@ -39,8 +85,9 @@ def deserialize_declaration(name):
     return deserialize_fn.format(name=name) + ";\n"
 
 
-def deserialize_start(name):
-    return deserialize_fn.format(name=name) + " {\n"
+def deserialize(name, fields):
+    return deserialize_fn.format(name=name) + " {\n" + "".join(
+        [deserialize_field(f, type) for (f, type) in fields]) + "}\n"
 
 
 deserialize_byte_buffer_fn = "void deserialize(const std::vector<uint8_t>& input, {name}& t)"
@@ -74,7 +121,21 @@ def deserialize_field(name, type):
     return f"  cmf::deserialize(input, end, t.{name});\n"
 
 
-variant_serialize_fn = "void serialize(std::vector<uint8_t>& output, const {variant}& val)"
+variant_serialized_size_fn = "size_t serializedSize(const {variant}& val)"
+
+
+def variant_serialized_size_declaration(variant):
+    return variant_serialized_size_fn.format(variant=variant) + ";\n"
+
+
+def variant_serialized_size(variant):
+    return variant_serialized_size_fn.format(variant=variant) + """ {
+  return sizeof(uint32_t) + std::visit([](auto&& arg){ return serializedSize(arg); }, val);
+}
+"""
+
+
+variant_serialize_fn = "void serialize(uint8_t*& output, const {variant}& val)"
 
 
 def variant_serialize_declaration(variant):
@@ -87,7 +148,8 @@ def variant_serialize(variant):
     cmf::serialize(output, arg.id);
     serialize(output, arg);
   }, val);
-}"""
+}
+"""
 
 
 variant_deserialize_fn = "void deserialize(const uint8_t*& start, const uint8_t* end, {variant}& val)"
@@ -105,9 +167,7 @@ def variant_deserialize(variant, msgs):
     for (name, id) in msgs.items():
         s += f"""
   if (id == {id}) {{
-    {name} value;
-    deserialize(start, end, value);
-    val = value;
+    deserialize(start, end, val.emplace<{name}>());
     return;
   }}
 """
@@ -134,7 +194,11 @@ def equalop_str(msg_name, fields):
 
 class CppVisitor(Visitor):
     """ A visitor that generates C++ code. """
-    def __init__(self):
+    def __init__(self, views=False):
+        # Whether to also generate a view struct for each message, in which strings and bytes
+        # are std::string_view and cmf::ByteView pointing into the deserialized buffer.
+        self.views = views
+
         # All output currently constructed
         self.output = ""
 
@@ -147,17 +211,14 @@ class CppVisitor(Visitor):
         # The current field being processed for a message
         self.field = {'type': '', 'name': ''}
 
-        # All fields currently seen for the given message
+        # All fields currently seen for the given message, as (name, type) tuples
         self.fields_seen = []
 
         # The struct being created for the current message. This includes the fields of the struct.
         self.struct = ""
 
-        # The 'serialize' function for the current message
-        self.serialize = ""
-
-        # The 'deserialize' function for the current message
-        self.deserialize = ""
+        # The view struct being created for the current message.
+        self.view_struct = ""
 
         # Each oneof in a message corresponds to a variant. Since we don't need duplicate
         # serialization functions, in case there are multiple messages or fields with the same
@@ -168,24 +229,44 @@ class CppVisitor(Visitor):
         # deserialization functions generated.
         self.oneofs_seen = set()
 
-        # The `serialize` member functions for all oneofs in the current message
-        self.oneof_serialize = ""
-        self.oneof_serialize_declaration = ""
-
-        # The `deserialize` member functions for all oneofs in the current message
-        self.oneof_deserialize = ""
-        self.oneof_deserialize_declaration = ""
+        # The `serializedSize`, `serialize` and `deserialize` functions for all oneofs in the
+        # current message
+        self.oneof_functions = ""
+        self.oneof_declarations = ""
 
     def _reset(self):
         # output and oneofs_seen accumulate across messages
         output = self.output
         output_declaration = self.output_declaration
         oneofs = self.oneofs_seen
-        self.__init__()
+        self.__init__(self.views)
         self.output = output
         self.output_declaration = output_declaration
         self.oneofs_seen = oneofs
 
+    def _type(self, type, view_type=None):
+        """ Append a type to the struct and view struct of the current message """
+        self.struct += type
+        self.view_struct += type if view_type is None else view_type
+
+    def _functions(self, name):
+        """ Definitions of the serialization functions of struct `name` """
+        return [
+            serialized_size(name, self.fields_seen),
+            serialize(name, self.fields_seen),
+            serialize_byte_buffer(name),
+            deserialize(name, self.fields_seen),
+        ]
+
+    def _declarations(self, name):
+        """ Declarations of the serialization functions of struct `name` """
+        return [
+            serialized_size_declaration(name),
+            serialize_declaration(name),
+            serialize_byte_buffer_declaration(name),
+            deserialize_declaration(name),
+        ]
+
     def create_enum(self, name, tags):
         enumstr = 'enum class {name} : uint8_t {{ {tagstr} }};\n'
         enumsize_decl = 'uint8_t enumSize({name} _);\n'
@@ -197,140 +278,143 @@ class CppVisitor(Visitor):
     def msg_start(self, name, id):
         self.msg_name = name
         self.struct = struct_start(name, id)
-        self.serialize = serialize_start(name)
-        self.deserialize = deserialize_start(name)
+        self.view_struct = struct_start(view_name(name), id)
 
     def msg_end(self):
         self.struct += "};\n"
-        self.serialize += "}"
-        self.deserialize += "}\n"
-        self.deserialize += deserialize_byte_buffer(self.msg_name)
+        self.view_struct += "};\n"
+        functions = self._functions(self.msg_name) + [deserialize_byte_buffer(self.msg_name)]
+        declarations = self._declarations(self.msg_name) + [deserialize_byte_buffer_declaration(self.msg_name)]
+        if self.views:
+            # There is no std::vector overload of deserialize() for views, as the view must not
+            # outlive the buffer.
+            functions += self._functions(view_name(self.msg_name))
+            declarations += self._declarations(view_name(self.msg_name))
         self.output += "\n".join([
             s for s in [
-                self.oneof_serialize,
-                self.oneof_deserialize,
-                equalop_str(self.msg_name, self.fields_seen),
-                self.serialize,
-                self.deserialize,
-            ] if s != ''
+                self.oneof_functions,
+                equalop_str(self.msg_name, [f for (f, _) in self.fields_seen]),
+            ] + functions if s != ''
         ]) + "\n"
         self.output_declaration += "".join([
             s for s in [
                 self.struct,
+                self.view_struct if self.views else '',
                 "\n",
-                serialize_declaration(self.msg_name),
-                deserialize_declaration(self.msg_name),
-                deserialize_byte_buffer_declaration(self.msg_name),
-                self.oneof_serialize_declaration,
-                self.oneof_deserialize_declaration,
+            ] + declarations + [
+                self.oneof_declarations,
                 equalop_str_declaration(self.msg_name),
             ] if s != ''
         ]) + "\n"
         self._reset()
 
     def field_start(self, name, type):
-        self.struct += "  "  # Indent fields
+        self._type("  ")  # Indent fields
         self.field['name'] = name
-        self.fields_seen.append(name)
-        self.serialize += serialize_field(name, type)
-        self.deserialize += deserialize_field(name, type)
+        self.fields_seen.append((name, type))
 
     def field_end(self):
         # The field is preceeded by the type in the struct definition. Close it with the name and
         # necessary syntax.
-        self.struct += f" {self.field['name']}{{}};\n"
+        self._type(f" {self.field['name']}{{}};\n")
 
 
 ### The following callbacks generate types for struct fields, recursively when necessary.
 
     def bool(self):
-        self.struct += "bool"
+        self._type("bool")
 
     def uint8(self):
-        self.struct += "uint8_t"
+        self._type("uint8_t")
 
     def uint16(self):
-        self.struct += "uint16_t"
+        self._type("uint16_t")
 
     def uint32(self):
-        self.struct += "uint32_t"
+        self._type("uint32_t")
 
     def uint64(self):
-        self.struct += "uint64_t"
+        self._type("uint64_t")
 
     def int8(self):
-        self.struct += "int8_t"
+        self._type("int8_t")
 
     def int16(self):
-        self.struct += "int16_t"
+        self._type("int16_t")
 
     def int32(self):
-        self.struct += "int32_t"
+        self._type("int32_t")
 
     def int64(self):
-        self.struct += "int64_t"
+        self._type("int64_t")
 
     def string(self):
-        self.struct += "std::string"
+        self._type("std::string", "std::string_view")
 
     def bytes(self):
-        self.struct += "std::vector<uint8_t>"
+        self._type("std::vector<uint8_t>", "cmf::ByteView")
 
     def msgname_ref(self, name):
-        self.struct += name
+        self._type(name, view_name(name))
 
     def kvpair_start(self):
-        self.struct += "std::pair<"
+        self._type("std::pair<")
 
     def kvpair_key_end(self):
-        self.struct += ", "
+        self._type(", ")
 
     def kvpair_end(self):
-        self.struct += ">"
+        self._type(">")
 
     def list_start(self):
-        self.struct += "std::vector<"
+        self._type("std::vector<")
 
     def list_end(self):
-        self.struct += ">"
+        self._type(">")
 
     def fixedlist_start(self):
-        self.struct += "std::array<"
+        self._type("std::array<")
 
     def fixedlist_type_end(self):
-        self.struct += ", "
+        self._type(", ")
 
     def fixedlist_end(self, size):
-        self.struct += f"{size}>"
+        self._type(f"{size}>")
 
     def map_start(self):
-        self.struct += "std::map<"
+        self._type("std::map<")
 
     def map_key_end(self):
-        self.struct += ", "
+        self._type(", ")
 
     def map_end(self):
-        self.struct += ">"
+        self._type(">")
 
     def optional_start(self):
-        self.struct += "std::optional<"
+        self._type("std::optional<")
 
     def optional_end(self):
-        self.struct += ">"
+        self._type(">")
 
     def oneof(self, msgs):
         variant = "std::variant<" + ", ".join(msgs.keys()) + ">"
-        self.struct += variant
+        view_variant = "std::variant<" + ", ".join([view_name(m) for m in msgs.keys()]) + ">"
+        self._type(variant, view_variant)
         oneof = frozenset(msgs.keys())
         if oneof in self.oneofs_seen:
             return
         self.oneofs_seen.add(oneof)
-        self.oneof_serialize += variant_serialize(variant)
-        self.oneof_serialize_declaration += variant_serialize_declaration(
-            variant)
-        self.oneof_deserialize += variant_deserialize(variant, msgs)
-        self.oneof_deserialize_declaration += variant_deserialize_declaration(
-            variant)
+        self._oneof_functions(variant, msgs)
+        if self.views:
+            self._oneof_functions(view_variant, {view_name(m): id for (m, id) in msgs.items()})
+
+    def _oneof_functions(self, variant, msgs):
+        self.oneof_functions += variant_serialized_size(variant) + "\n"
+        self.oneof_functions += variant_serialize(variant) + "\n"
+        self.oneof_functions += variant_deserialize(variant, msgs)
+        self.oneof_declarations += variant_serialized_size_declaration(variant)
+        self.oneof_declarations += variant_serialize_declaration(variant)
+        self.oneof_declarations += variant_deserialize_declaration(variant)
 
     def enum(self, type_name):
-        self.struct += type_name
+        self._type(type_name)
@@ -53,10 +53,14 @@ def header_includes():
     definitions make use of C++ types
     """
     return """
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -80,17 +84,20 @@ def file_trailer(namespace):
     return "\n"
 
 
-def translate(ast, output_header, namespace=None):
+def translate(ast, output_header, namespace=None, views=False):
     """
     Walk concord message format(CMF) AST and generate C++ code.
 
+    If `views` is set, a `<Msg>View` struct is generated for each message as well. View structs are
+    deserialized without copying strings and bytes.
+
     Return C++ code as a string.
     """
     with open(os.path.join(os.path.dirname(__file__), "serialize.hpp")) as f:
         cmf_base_header = f.read()
     with open(os.path.join(os.path.dirname(__file__), "serialize.cpp")) as f:
         cmf_base_serialization = f.read()
-    visitor = CppVisitor()
+    visitor = CppVisitor(views)
     walker = Walker(ast, visitor)
     walker.walk()
 
@@ -2,10 +2,12 @@
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <map>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -41,28 +43,61 @@ class BadDataError : public DeserializeError {
   }
 };
 
+/******************************************************************************
+ * Serialization writes into a buffer of at least serializedSize() bytes, i.e.
+ * the generated `serialize(std::vector<uint8_t>&, const Msg&)` grows the output
+ * once and the rest of the serialization is unchecked stores.
+ ******************************************************************************/
+[[maybe_unused]] static inline void checkDataLeft(const uint8_t* start, const uint8_t* end, std::size_t size) {
+  if (static_cast<std::size_t>(end - start) < size) {
+    throw NoDataLeftError();
+  }
+}
+
 /******************************************************************************
  * Integers
  *
  * All integers are encoded in big-endian
  ******************************************************************************/
+template <typename T>
+T hostToBigEndian(T t) {
+  static_assert(std::is_unsigned_v<T>);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return t;
+#else
+  if constexpr (sizeof(T) == 1) {
+    return t;
+  } else if constexpr (sizeof(T) == 2) {
+    return __builtin_bswap16(t);
+  } else if constexpr (sizeof(T) == 4) {
+    return __builtin_bswap32(t);
+  } else {
+    static_assert(sizeof(T) == 8);
+    return __builtin_bswap64(t);
+  }
+#endif
+}
+
 template <typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
-void serialize(std::vector<uint8_t>& output, const T& t) {
+constexpr std::size_t serializedSize(const T&) {
+  return sizeof(T);
+}
+
+template <typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+void serialize(uint8_t*& output, const T& t) {
   if constexpr (std::is_same_v<T, bool>) {
-    output.push_back(t ? 1 : 0);
+    *output++ = t ? 1 : 0;
   } else {
-    for (auto i = sizeof(T); i > 0; i--) {
-      output.push_back(255 & (t >> ((i - 1) * 8)));
-    }
+    const auto be = hostToBigEndian(static_cast<std::make_unsigned_t<T>>(t));
+    std::memcpy(output, &be, sizeof(be));
+    output += sizeof(be);
   }
 }
 
 template <typename T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
 void deserialize(const uint8_t*& start, const uint8_t* end, T& t) {
   if constexpr (std::is_same_v<T, bool>) {
-    if (start + 1 > end) {
-      throw NoDataLeftError();
-    }
+    checkDataLeft(start, end, 1);
     if (*start == 0) {
       t = false;
     } else if (*start == 1) {
@@ -72,13 +107,10 @@ void deserialize(const uint8_t*& start, const uint8_t* end, T& t) {
     }
     start += 1;
   } else {
-    if (start + sizeof(T) > end) {
-      throw NoDataLeftError();
-    }
-    t = 0;
-    for (auto i = 0u; i < sizeof(T); i++) {
-      t |= (static_cast<std::make_unsigned_t<T>>(*(start + sizeof(T) - 1 - i)) << (i * 8));
-    }
+    checkDataLeft(start, end, sizeof(T));
+    std::make_unsigned_t<T> be;
+    std::memcpy(&be, start, sizeof(be));
+    t = static_cast<T>(hostToBigEndian(be));
     start += sizeof(T);
   }
 }
@@ -89,7 +121,12 @@ void deserialize(const uint8_t*& start, const uint8_t* end, T& t) {
  * Enums are type wrappers around uint8_t
  ******************************************************************************/
 template <typename T, typename std::enable_if<std::is_enum<T>::value>::type* = nullptr>
-void serialize(std::vector<uint8_t>& output, const T& t) {
+constexpr std::size_t serializedSize(const T&) {
+  return sizeof(uint8_t);
+}
+
+template <typename T, typename std::enable_if<std::is_enum<T>::value>::type* = nullptr>
+void serialize(uint8_t*& output, const T& t) {
   serialize(output, static_cast<uint8_t>(t));
 }
 
@@ -103,26 +140,74 @@ void deserialize(const uint8_t*& start, const uint8_t* end, T& t) {
   }
 }
 
+// Integers and enums have a fixed serialized size, which allows computing the size of lists of them without iterating.
+template <typename T>
+constexpr bool kIsFixedSize = std::is_integral_v<T> || std::is_enum_v<T>;
+
+// Lists of these are copied as a single block.
+template <typename T>
+constexpr bool kIsByte = std::is_integral_v<T> && !std::is_same_v<T, bool> && sizeof(T) == 1;
+
 /******************************************************************************
- * Strings
+ * Strings and bytes
  *
- * Strings are preceded by a uint32_t length
+ * Strings are preceded by a uint32_t length. std::string_view and ByteView
+ * are the types of string and bytes fields in view messages.
  ******************************************************************************/
-[[maybe_unused]] static inline void serialize(std::vector<uint8_t>& output, const std::string& s) {
-  cmfAssert(s.size() <= 0xFFFFFFFF);
-  uint32_t length = s.size() & 0xFFFFFFFF;
+[[maybe_unused]] static inline void serializeBlock(uint8_t*& output, const void* data, std::size_t size) {
+  cmfAssert(size <= 0xFFFFFFFF);
+  uint32_t length = size & 0xFFFFFFFF;
   serialize(output, length);
-  std::copy(s.begin(), s.end(), std::back_inserter(output));
+  if (length > 0) {
+    std::memcpy(output, data, length);
+    output += length;
+  }
 }
 
-[[maybe_unused]] static inline void deserialize(const uint8_t*& start, const uint8_t* end, std::string& s) {
-  uint32_t length;
+[[maybe_unused]] static inline const uint8_t* deserializeBlock(const uint8_t*& start,
+                                                                const uint8_t* end,
+                                                                uint32_t& length) {
   deserialize(start, end, length);
-  if (start + length > end) {
-    throw NoDataLeftError();
-  }
-  std::copy_n(start, length, std::back_inserter(s));
+  checkDataLeft(start, end, length);
+  const auto block = start;
   start += length;
+  return block;
+}
+
+[[maybe_unused]] static inline std::size_t serializedSize(std::string_view s) { return sizeof(uint32_t) + s.size(); }
+
+[[maybe_unused]] static inline void serialize(uint8_t*& output, std::string_view s) {
+  serializeBlock(output, s.data(), s.size());
+}
+
+[[maybe_unused]] static inline void deserialize(const uint8_t*& start, const uint8_t* end, std::string_view& s) {
+  uint32_t length;
+  const auto block = deserializeBlock(start, end, length);
+  s = std::string_view{reinterpret_cast<const char*>(block), length};
+}
+
+[[maybe_unused]] static inline std::size_t serializedSize(const std::string& s) { return sizeof(uint32_t) + s.size(); }
+
+[[maybe_unused]] static inline void serialize(uint8_t*& output, const std::string& s) {
+  serializeBlock(output, s.data(), s.size());
+}
+
+[[maybe_unused]] static inline void deserialize(const uint8_t*& start, const uint8_t* end, std::string& s) {
+  uint32_t length;
+  const auto block = deserializeBlock(start, end, length);
+  s.assign(reinterpret_cast<const char*>(block), length);
+}
+
+[[maybe_unused]] static inline std::size_t serializedSize(const ByteView& b) { return sizeof(uint32_t) + b.size(); }
+
+[[maybe_unused]] static inline void serialize(uint8_t*& output, const ByteView& b) {
+  serializeBlock(output, b.data(), b.size());
+}
+
+[[maybe_unused]] static inline void deserialize(const uint8_t*& start, const uint8_t* end, ByteView& b) {
+  uint32_t length;
+  const auto block = deserializeBlock(start, end, length);
+  b = ByteView{block, length};
 }
 
 /******************************************************************************
@@ -130,31 +215,41 @@ void deserialize(const uint8_t*& start, const uint8_t* end, T& t) {
  ******************************************************************************/
 // Lists
 template <typename T>
-void serialize(std::vector<uint8_t>& output, const std::vector<T>& v);
+std::size_t serializedSize(const std::vector<T>& v);
+template <typename T>
+void serialize(uint8_t*& output, const std::vector<T>& v);
 template <typename T>
 void deserialize(const uint8_t*& start, const uint8_t* end, std::vector<T>& v);
 
 // Fixed Lists
 template <typename T, std::size_t N>
-void serialize(std::vector<uint8_t>& output, const std::array<T, N>& v);
+std::size_t serializedSize(const std::array<T, N>& v);
+template <typename T, std::size_t N>
+void serialize(uint8_t*& output, const std::array<T, N>& v);
 template <typename T, std::size_t N>
 void deserialize(const uint8_t*& start, const uint8_t* end, std::array<T, N>& v);
 
 // KVPairs
 template <typename K, typename V>
-void serialize(std::vector<uint8_t>& output, const std::pair<K, V>& kvpair);
+std::size_t serializedSize(const std::pair<K, V>& kvpair);
+template <typename K, typename V>
+void serialize(uint8_t*& output, const std::pair<K, V>& kvpair);
 template <typename K, typename V>
 void deserialize(const uint8_t*& start, const uint8_t* end, std::pair<K, V>& kvpair);
 
 // Maps
 template <typename K, typename V>
-void serialize(std::vector<uint8_t>& output, const std::map<K, V>& m);
+std::size_t serializedSize(const std::map<K, V>& m);
+template <typename K, typename V>
+void serialize(uint8_t*& output, const std::map<K, V>& m);
 template <typename K, typename V>
 void deserialize(const uint8_t*& start, const uint8_t* end, std::map<K, V>& m);
 
 // Optionals
 template <typename T>
-void serialize(std::vector<uint8_t>& output, const std::optional<T>& t);
+std::size_t serializedSize(const std::optional<T>& t);
+template <typename T>
+void serialize(uint8_t*& output, const std::optional<T>& t);
 template <typename T>
 void deserialize(const uint8_t*& start, const uint8_t* end, std::optional<T>& t);
 
@@ -164,49 +259,88 @@ void deserialize(const uint8_t*& start, const uint8_t* end, std::optional<T>& t)
  * Lists are preceded by a uint32_t length
  ******************************************************************************/
 template <typename T>
-void serialize(std::vector<uint8_t>& output, const std::vector<T>& v) {
-  cmfAssert(v.size() <= 0xFFFFFFFF);
-  uint32_t length = v.size() & 0xFFFFFFFF;
-  serialize(output, length);
-  for (auto& it : v) {
-    serialize(output, it);
+std::size_t serializedSize(const std::vector<T>& v) {
+  if constexpr (kIsFixedSize<T>) {
+    return sizeof(uint32_t) + v.size() * serializedSize(T{});
+  } else {
+    std::size_t size = sizeof(uint32_t);
+    for (auto& it : v) {
+      size += serializedSize(it);
+    }
+    return size;
   }
 }
 
 template <typename T>
-void deserialize(const uint8_t*& start, const uint8_t* end, std::vector<T>& v) {
-  uint32_t length;
-  deserialize(start, end, length);
-  if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+void serialize(uint8_t*& output, const std::vector<T>& v) {
+  if constexpr (kIsByte<T>) {
     // Optimized for bytes
-    if (start + length > end) {
-      throw NoDataLeftError();
+    serializeBlock(output, v.data(), v.size());
+  } else {
+    cmfAssert(v.size() <= 0xFFFFFFFF);
+    uint32_t length = v.size() & 0xFFFFFFFF;
+    serialize(output, length);
+    for (const auto& it : v) {
+      serialize(output, static_cast<const T&>(it));
     }
-    std::copy_n(start, length, std::back_inserter(v));
-    start += length;
+  }
+}
+
+template <typename T>
+void deserialize(const uint8_t*& start, const uint8_t* end, std::vector<T>& v) {
+  if constexpr (kIsByte<T>) {
+    // Optimized for bytes
+    uint32_t length;
+    const auto block = deserializeBlock(start, end, length);
+    v.insert(v.end(), block, block + length);
   } else {
+    uint32_t length;
+    deserialize(start, end, length);
+    // Every element takes at least one byte - don't trust the length beyond the data that is left.
+    v.reserve(v.size() + std::min<std::size_t>(length, end - start));
     for (auto i = 0u; i < length; i++) {
-      T t;
-      deserialize(start, end, t);
-      v.push_back(t);
+      if constexpr (std::is_same_v<T, bool>) {
+        bool t;
+        deserialize(start, end, t);
+        v.push_back(t);
+      } else {
+        deserialize(start, end, v.emplace_back());
+      }
     }
   }
 }
 
 template <typename T, std::size_t N>
-void serialize(std::vector<uint8_t>& output, const std::array<T, N>& a) {
-  for (auto& it : a) {
-    serialize(output, it);
+std::size_t serializedSize(const std::array<T, N>& a) {
+  if constexpr (kIsFixedSize<T>) {
+    return N * serializedSize(T{});
+  } else {
+    std::size_t size = 0;
+    for (auto& it : a) {
+      size += serializedSize(it);
+    }
+    return size;
   }
 }
 
 template <typename T, std::size_t N>
-void deserialize(const uint8_t*& start, const uint8_t* end, std::array<T, N>& a) {
-  if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+void serialize(uint8_t*& output, const std::array<T, N>& a) {
+  if constexpr (kIsByte<T>) {
     // Optimized for bytes
-    if (start + a.size() > end) {
-      throw NoDataLeftError();
+    std::memcpy(output, a.data(), N);
+    output += N;
+  } else {
+    for (auto& it : a) {
+      serialize(output, it);
     }
+  }
+}
+
+template <typename T, std::size_t N>
+void deserialize(const uint8_t*& start, const uint8_t* end, std::array<T, N>& a) {
+  if constexpr (kIsByte<T>) {
+    // Optimized for bytes
+    checkDataLeft(start, end, a.size());
     std::copy_n(start, a.size(), a.begin());
     start += a.size();
   } else {
@@ -220,7 +354,12 @@ void deserialize(const uint8_t*& start, const uint8_t* end, std::array<T, N>& a)
  * KVPairs are modeled as std::pairs.
  ******************************************************************************/
 template <typename K, typename V>
-void serialize(std::vector<uint8_t>& output, const std::pair<K, V>& kvpair) {
+std::size_t serializedSize(const std::pair<K, V>& kvpair) {
+  return serializedSize(kvpair.first) + serializedSize(kvpair.second);
+}
+
+template <typename K, typename V>
+void serialize(uint8_t*& output, const std::pair<K, V>& kvpair) {
   serialize(output, kvpair.first);
   serialize(output, kvpair.second);
 }
@@ -237,7 +376,16 @@ void deserialize(const uint8_t*& start, const uint8_t* end, std::pair<K, V>& kvp
  * Maps are preceded by a uint32_t size
  ******************************************************************************/
 template <typename K, typename V>
-void serialize(std::vector<uint8_t>& output, const std::map<K, V>& m) {
+std::size_t serializedSize(const std::map<K, V>& m) {
+  std::size_t size = sizeof(uint32_t);
+  for (auto& it : m) {
+    size += serializedSize(it.first) + serializedSize(it.second);
+  }
+  return size;
+}
+
+template <typename K, typename V>
+void serialize(uint8_t*& output, const std::map<K, V>& m) {
   cmfAssert(m.size() <= 0xFFFFFFFF);
   uint32_t size = m.size() & 0xFFFFFFFF;
   serialize(output, size);
@@ -253,7 +401,7 @@ void deserialize(const uint8_t*& start, const uint8_t* end, std::map<K, V>& m) {
   for (auto i = 0u; i < size; i++) {
     std::pair<K, V> kvpair;
     deserialize(start, end, kvpair);
-    m.insert(kvpair);
+    m.insert(std::move(kvpair));
   }
 }
 
@@ -263,7 +411,12 @@ void deserialize(const uint8_t*& start, const uint8_t* end, std::map<K, V>& m) {
  * Optionals are preceded by a bool indicating whether a value is present or not.
  ******************************************************************************/
 template <typename T>
-void serialize(std::vector<uint8_t>& output, const std::optional<T>& t) {
+std::size_t serializedSize(const std::optional<T>& t) {
+  return serializedSize(t.has_value()) + (t.has_value() ? serializedSize(t.value()) : 0);
+}
+
+template <typename T>
+void serialize(uint8_t*& output, const std::optional<T>& t) {
   serialize(output, t.has_value());
   if (t.has_value()) {
     serialize(output, t.value());
@@ -275,9 +428,7 @@ void deserialize(const uint8_t*& start, const uint8_t* end, std::optional<T>& t)
   bool has_value;
   deserialize(start, end, has_value);
   if (has_value) {
-    T value;
-    deserialize(start, end, value);
-    t = value;
+    deserialize(start, end, t.emplace());
   } else {
     t = std::nullopt;
   }
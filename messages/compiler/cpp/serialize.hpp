@@ -2,4 +2,33 @@ namespace cmf {
 class DeserializeError;
 class NoDataLeftError;
 class BadDataError;
-}  // namespace cmf
+
+// A non-owning view of a bytes field, pointing into the buffer it was deserialized from.
+class ByteView {
+ public:
+  ByteView() = default;
+  ByteView(const uint8_t* data, std::size_t size) : data_{data}, size_{size} {}
+  explicit ByteView(const std::vector<uint8_t>& v) : data_{v.data()}, size_{v.size()} {}
+
+  const uint8_t* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const uint8_t* begin() const { return data_; }
+  const uint8_t* end() const { return data_ + size_; }
+  const uint8_t& operator[](std::size_t i) const { return data_[i]; }
+  std::vector<uint8_t> toVector() const { return std::vector<uint8_t>(begin(), end()); }
+
+  friend bool operator==(const ByteView& l, const ByteView& r) {
+    return l.size_ == r.size_ && (l.size_ == 0 || std::memcmp(l.data_, r.data_, l.size_) == 0);
+  }
+  friend bool operator!=(const ByteView& l, const ByteView& r) { return !(l == r); }
+  friend bool operator<(const ByteView& l, const ByteView& r) {
+    return std::lexicographical_compare(l.begin(), l.end(), r.begin(), r.end());
+  }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace cmf
\ No newline at end of file
@@ -220,12 +220,22 @@ def testSerializationStr(msg_name):
         s += """
   {{
     std::vector<uint8_t> output;
-    serialize(output, {});
-    {} {}_computed;
-    deserialize(output, {}_computed);
-    assert({} == {}_computed);
+    serialize(output, {instance});
+    assert(output.size() == serializedSize({instance}));
+    {msg_name} {instance}_computed;
+    deserialize(output, {instance}_computed);
+    assert({instance} == {instance}_computed);
+
+    // Views point into the output and serialize to the same bytes
+    {msg_name}View {instance}_view;
+    const uint8_t* begin = output.data();
+    deserialize(begin, begin + output.size(), {instance}_view);
+    assert(begin == output.data() + output.size());
+    std::vector<uint8_t> view_output;
+    serialize(view_output, {instance}_view);
+    assert(output == view_output);
   }}
-""".format(instance, msg_name, instance, instance, instance, instance)
+""".format(instance=instance, msg_name=msg_name)
     s += "}\n"
     return s
 
@@ -272,7 +282,7 @@ def generate_code_and_tests(ast, header_file):
     """ Walk concord message format(CMF) AST and generate C++ code and C++ tests"""
     namespace = "cmf::test"
     print("Generating C++ Message structs and serialization code")
-    header, code = cppgen.translate(ast, header_file, namespace)
+    header, code = cppgen.translate(ast, header_file, namespace, views=True)
     test_code = file_header(namespace)
     print("Generating C++ Message instances and serialization tests")
     visitor = InstanceVisitor()
@@ -18,6 +18,7 @@
 #include "client.h"
 #include "rocksdb_exception.h"
 
+#include <rocksdb/options.h>
 #include <rocksdb/slice.h>
 #include <rocksdb/status.h>
 
@@ -68,6 +69,14 @@ inline void throwOnError(std::string_view msg1, std::string_view msg2, ::rocksdb
 
 inline void throwOnError(std::string_view msg, ::rocksdb::Status &&s) { return throwOnError(msg, ""sv, std::move(s)); }
 
+// Iterators go over the whole column family in key order. Column families with a prefix extractor would otherwise
+// only iterate within the prefix of the seek key.
+inline ::rocksdb::ReadOptions iteratorReadOptions() {
+  auto opts = ::rocksdb::ReadOptions{};
+  opts.total_order_seek = true;
+  return opts;
+}
+
 }  // namespace concord::storage::rocksdb::detail
 
 #endif  // USE_ROCKSDB
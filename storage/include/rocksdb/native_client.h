@@ -23,6 +23,7 @@
 #include "client.h"
 
 #include <rocksdb/slice.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/utilities/options_util.h>
 #include <rocksdb/utilities/transaction_db.h>
 
@@ -125,6 +126,7 @@ class NativeClient : public std::enable_shared_from_this<NativeClient> {
 
   // Iterator interface.
   // Iterators initially don't point to a key value, i.e. they convert to false.
+  // Iterators are in total order, also in column families with a prefix extractor.
   // Important note - RocksDB requires that iterators are destroyed before the DB client that created them.
   //
   // Get an iterator into the default column family.
@@ -135,6 +137,20 @@ class NativeClient : public std::enable_shared_from_this<NativeClient> {
   // match the families input.
   std::vector<NativeIterator> getIterators(const std::vector<std::string> &cFamilies) const;
 
+  // Bulk loading interface.
+  //
+  // Write the key-values from the current position of `iter`, an iterator into `cFamily`, to the last key to a new SST
+  // file at `path` that can be ingested into `cFamily`. Return the number of written key-values. No file is created if
+  // there are none.
+  std::size_t writeSstFile(const std::string &cFamily, NativeIterator &iter, const std::string &path) const;
+  // Ingest SST files, as created by writeSstFile(), into `cFamily`. The files are moved into the DB.
+  void ingestSstFiles(const std::string &cFamily, const std::vector<std::string> &paths);
+
+  // Compact the [beginKey, endKey] range of `cFamily`, e.g. to reclaim the space of deleted keys without waiting for
+  // automatic compactions. Blocks until the compaction is done. Automatic compactions keep running in the meantime.
+  template <typename BeginSpan, typename EndSpan>
+  void compactRange(const std::string &cFamily, const BeginSpan &beginKey, const EndSpan &endKey);
+
   ::rocksdb::Options options() const;
 
   // Return the DB path.
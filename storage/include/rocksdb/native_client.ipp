@@ -117,6 +117,17 @@ void NativeClient::del(const std::string &cFamily, const KeySpan &key) {
   detail::throwOnError("del() failed"sv, std::move(s));
 }
 
+template <typename BeginSpan, typename EndSpan>
+void NativeClient::compactRange(const std::string &cFamily, const BeginSpan &beginKey, const EndSpan &endKey) {
+  const auto begin = detail::toSlice(beginKey);
+  const auto end = detail::toSlice(endKey);
+  auto opts = ::rocksdb::CompactRangeOptions{};
+  // Run alongside the automatic compactions instead of waiting for them to finish and holding them back.
+  opts.exclusive_manual_compaction = false;
+  auto s = client_->dbInstance_->CompactRange(opts, columnFamilyHandle(cFamily), &begin, &end);
+  detail::throwOnError("compactRange() failed"sv, cFamily, std::move(s));
+}
+
 template <typename KeySpan, typename ValueSpan>
 void NativeClient::put(const KeySpan &key, const ValueSpan &value) {
   put(defaultColumnFamily(), key, value);
@@ -166,12 +177,12 @@ void NativeClient::multiGet(const std::string &cFamily,
 inline NativeWriteBatch NativeClient::getBatch() const { return NativeWriteBatch{shared_from_this()}; }
 
 inline NativeIterator NativeClient::getIterator() const {
-  return std::unique_ptr<::rocksdb::Iterator>{client_->dbInstance_->NewIterator(::rocksdb::ReadOptions{})};
+  return std::unique_ptr<::rocksdb::Iterator>{client_->dbInstance_->NewIterator(detail::iteratorReadOptions())};
 }
 
 inline NativeIterator NativeClient::getIterator(const std::string &cFamily) const {
   return std::unique_ptr<::rocksdb::Iterator>{
-      client_->dbInstance_->NewIterator(::rocksdb::ReadOptions{}, columnFamilyHandle(cFamily))};
+      client_->dbInstance_->NewIterator(detail::iteratorReadOptions(), columnFamilyHandle(cFamily))};
 }
 
 inline std::vector<NativeIterator> NativeClient::getIterators(const std::vector<std::string> &cFamilies) const {
@@ -181,7 +192,7 @@ inline std::vector<NativeIterator> NativeClient::getIterators(const std::vector<
   }
 
   auto rawPtrIterators = std::vector<::rocksdb::Iterator *>{};
-  auto status = client_->dbInstance_->NewIterators(::rocksdb::ReadOptions{}, cfHandles, &rawPtrIterators);
+  auto status = client_->dbInstance_->NewIterators(detail::iteratorReadOptions(), cfHandles, &rawPtrIterators);
 
   // Wrap RocksDB iterators in unique pointers so that they are freed, irrespective of the returned status.
   // Note: NewIterators()'s interface is bad and the caller doesn't have enough info by just looking at it. One has to
@@ -250,6 +261,33 @@ inline void NativeClient::dropColumnFamily(const std::string &cFamily) {
   client_->cf_handles_.erase(it);
 }
 
+inline std::size_t NativeClient::writeSstFile(const std::string &cFamily,
+                                              NativeIterator &iter,
+                                              const std::string &path) const {
+  const auto sstOptions = ::rocksdb::Options{options(), columnFamilyOptions(cFamily)};
+  auto writer = ::rocksdb::SstFileWriter{::rocksdb::EnvOptions{}, sstOptions, columnFamilyHandle(cFamily)};
+  auto count = std::size_t{0};
+  for (; iter; iter.next()) {
+    // SstFileWriter refuses to finish empty files, hence only open one for the first key.
+    if (count == 0) {
+      detail::throwOnError("failed to open SST file"sv, path, writer.Open(path));
+    }
+    detail::throwOnError("failed to write to SST file"sv, path, writer.Put(iter.iter_->key(), iter.iter_->value()));
+    ++count;
+  }
+  if (count > 0) {
+    detail::throwOnError("failed to finish SST file"sv, path, writer.Finish());
+  }
+  return count;
+}
+
+inline void NativeClient::ingestSstFiles(const std::string &cFamily, const std::vector<std::string> &paths) {
+  auto opts = ::rocksdb::IngestExternalFileOptions{};
+  opts.move_files = true;
+  auto s = client_->dbInstance_->IngestExternalFile(columnFamilyHandle(cFamily), paths, opts);
+  detail::throwOnError("failed to ingest SST files"sv, cFamily, std::move(s));
+}
+
 inline ::rocksdb::Options NativeClient::options() const { return client_->dbInstance_->GetOptions(); }
 
 inline ::rocksdb::ColumnFamilyHandle *NativeClient::defaultColumnFamilyHandle() const {
@@ -15,13 +15,19 @@
 
 #include <libs3.h>
 #include <cstring>
+#include <exception>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <random>
 #include <thread>
 #include <mutex>
+#include <vector>
 #include "Logger.hpp"
 #include "assertUtils.hpp"
 #include "storage/db_interface.h"
 #include "s3_metrics.hpp"
+#include "thread_pool.hpp"
 
 #pragma once
 
@@ -35,6 +41,8 @@ struct StoreConfig {
   std::string accessKey;      // from the customer
   std::uint32_t maxWaitTime;  // in milliseconds
   std::string pathPrefix;     // optional path prefix used in the bucket
+  // maximum number of requests in flight for multiGet(), multiPut() and transaction commits
+  std::uint32_t maxConcurrentRequests = 8;
 };
 
 /**
@@ -51,15 +59,27 @@ class Client : public concord::storage::IDBClient {
   class Transaction : public ITransaction {
    public:
     Transaction(Client* client) : ITransaction(nextId()), client_{client} {}
+    // Puts and deletes are issued concurrently. All puts complete before the first delete is issued.
     void commit() override {
-      for (auto& pair : multiput_)
-        if (concordUtils::Status s = client_->put(pair.first, pair.second); !s.isOK())
-          throw std::runtime_error("S3 commit failed while putting a value for key: " + pair.first.toString() +
+      std::vector<const SetOfKeyValuePairs::value_type*> puts;
+      puts.reserve(multiput_.size());
+      for (auto& pair : multiput_) puts.push_back(&pair);
+      client_->run_concurrently(puts.size(), [this, &puts](size_t i) {
+        if (concordUtils::Status s = client_->put(puts[i]->first, puts[i]->second); !s.isOK())
+          throw std::runtime_error("S3 commit failed while putting a value for key: " + puts[i]->first.toString() +
                                    std::string(" txn id[") + getIdStr() + std::string("], reason: ") + s.toString());
-      for (auto& key : keys_to_delete_)
-        if (concordUtils::Status s = client_->del(key); !s.isOK())
-          throw std::runtime_error("S3 commit failed while deleting a vallue for key: " + key.toString() +
+        return concordUtils::Status::OK();
+      });
+
+      std::vector<const concordUtils::Sliver*> dels;
+      dels.reserve(keys_to_delete_.size());
+      for (auto& key : keys_to_delete_) dels.push_back(&key);
+      client_->run_concurrently(dels.size(), [this, &dels](size_t i) {
+        if (concordUtils::Status s = client_->del(*dels[i]); !s.isOK())
+          throw std::runtime_error("S3 commit failed while deleting a vallue for key: " + dels[i]->toString() +
                                    std::string(" txn id[") + getIdStr() + std::string("], reason: ") + s.toString());
+        return concordUtils::Status::OK();
+      });
     }
     void rollback() override { multiput_.clear(); }
     void put(const concordUtils::Sliver& key, const concordUtils::Sliver& value) override { multiput_[key] = value; }
@@ -79,9 +99,15 @@ class Client : public concord::storage::IDBClient {
     }
   };
 
-  Client(const StoreConfig& config) : config_{config} { LOG_INFO(logger_, "S3 client created"); }
+  Client(const StoreConfig& config)
+      : config_{config}, requestPool_{std::make_unique<concord::util::ThreadPool>(
+                             std::max<std::uint32_t>(config.maxConcurrentRequests, 1))} {
+    LOG_INFO(logger_, "S3 client created, max concurrent requests: " << config_.maxConcurrentRequests);
+  }
 
   ~Client() {
+    // Stop the request threads before libs3 is deinitialized
+    requestPool_.reset();
     /* Destroy LibS3 */
     S3_deinitialize();
     init_ = false;
@@ -169,10 +195,7 @@ class Client : public concord::storage::IDBClient {
   concordUtils::Status multiGet(const KeysVector& _keysVec, OUT ValuesVector& _valuesVec) override {
     ConcordAssert(_keysVec.size() == _valuesVec.size());
 
-    for (KeysVector::size_type i = 0; i < _keysVec.size(); ++i)
-      if (Status s = get(_keysVec[i], _valuesVec[i]); !s.isOK()) return s;
-
-    return concordUtils::Status::OK();
+    return run_concurrently(_keysVec.size(), [&](size_t i) { return get(_keysVec[i], _valuesVec[i]); });
   }
 
   concordUtils::Status multiPut(const SetOfKeyValuePairs& _keyValueMap) override {
@@ -206,6 +229,7 @@ class Client : public concord::storage::IDBClient {
   }
 
   void setAggregator(std::shared_ptr<concordMetrics::Aggregator> aggregator) override {
+    std::lock_guard<std::mutex> g(metricsLock_);
     metrics_.metrics_component.SetAggregator(aggregator);
     metrics_.metrics_component.UpdateAggregator();
   }
@@ -213,25 +237,53 @@ class Client : public concord::storage::IDBClient {
   ///////////////////////// protected /////////////////////////////
  protected:
   // retry forever, increasing the waiting timeout until it reaches the defined maximum
+  // The delay is randomized, so that concurrent requests that failed together don't retry together.
   template <typename F, typename... Args>
   void do_with_retry(const std::string_view msg, Status& r, F&& f, Args&&... args) const {
-    uint16_t delay = initialDelay_;
+    static thread_local std::mt19937 gen{std::random_device{}()};
+    uint32_t delay = initialDelay_;
     do {
       r = std::forward<F>(f)(std::forward<Args>(args)...);
       if (!r.isGeneralError()) break;
       if (delay < config_.maxWaitTime) delay *= delayFactor_;
-      LOG_INFO(logger_, "retrying " << msg << " after delay: " << delay);
-      std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+      const auto jittered_delay = std::uniform_int_distribution<uint32_t>{delay / 2, delay}(gen);
+      LOG_INFO(logger_, "retrying " << msg << " after delay: " << jittered_delay);
+      std::this_thread::sleep_for(std::chrono::milliseconds(jittered_delay));
     } while (!r.isOK() || !r.isNotFound());
   }
 
-  concordUtils::Status get_internal(const concordUtils::Sliver& _key, OUT concordUtils::Sliver& _outValue) const;
+  // Calls f(i) for i in [0, count) on the request threads and waits for all the calls to complete.
+  // Returns the first non-OK status in index order. If a call throws, the exception of the first such call in index
+  // order is rethrown after all the calls complete.
+  // Mustn't be called from a request thread.
+  template <typename F>
+  concordUtils::Status run_concurrently(size_t count, const F& f) const {
+    std::vector<std::future<concordUtils::Status>> results;
+    results.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      results.push_back(requestPool_->async([&f, i]() { return f(i); }));
+    }
+    concordUtils::Status res = concordUtils::Status::OK();
+    std::exception_ptr error;
+    for (auto& result : results) {
+      try {
+        if (concordUtils::Status s = result.get(); !s.isOK() && res.isOK()) res = s;
+      } catch (...) {
+        if (!error) error = std::current_exception();
+      }
+    }
+    if (error) std::rethrow_exception(error);
+    return res;
+  }
 
-  concordUtils::Status put_internal(const concordUtils::Sliver& _key, const concordUtils::Sliver& _value);
+  virtual concordUtils::Status get_internal(const concordUtils::Sliver& _key,
+                                            OUT concordUtils::Sliver& _outValue) const;
 
-  concordUtils::Status object_exists_internal(const concordUtils::Sliver& key) const;
+  virtual concordUtils::Status put_internal(const concordUtils::Sliver& _key, const concordUtils::Sliver& _value);
 
-  concordUtils::Status test_bucket_internal();
+  virtual concordUtils::Status object_exists_internal(const concordUtils::Sliver& key) const;
+
+  virtual concordUtils::Status test_bucket_internal();
 
   struct ResponseData {
     S3Status status = S3Status::S3StatusOK;
@@ -307,10 +359,16 @@ class Client : public concord::storage::IDBClient {
   std::mutex initLock_;
   logging::Logger logger_ = logging::getLogger("concord.storage.s3");
 
-  uint16_t initialDelay_ = 100;
+  uint32_t initialDelay_ = 100;
   const double delayFactor_ = 1.5;
 
+  // Metrics are updated from the request threads
+  std::mutex metricsLock_;
   Metrics metrics_;
+
+  // Runs the requests of multiGet(), multiPut() and transaction commits. libs3 keeps a stack of idle connections, so
+  // connections are reused across requests.
+  std::unique_ptr<concord::util::ThreadPool> requestPool_;
 };
 
 }  // namespace concord::storage::s3
@@ -27,6 +27,7 @@ class STKeyManipulator : public concord::storage::ISTKeyManipulator {
   concordUtils::Sliver generateSTCheckpointDescriptorKey(uint64_t chkpt) const override;
   concordUtils::Sliver generateSTReservedPageDynamicKey(uint32_t pageId, uint64_t chkpt) const override;
   concordUtils::Sliver getReservedPageKeyPrefix() const override;
+  concordUtils::Sliver getSTPendingPageKeyPrefix() const override;
 
  protected:
   static logging::Logger& logger() {
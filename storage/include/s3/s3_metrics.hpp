@@ -52,7 +52,10 @@ class Metrics {
                                                                                << ") to numeric value.");
       return;
     }
-    last_saved_block_id_.Get().Set(lastSavedBlockVal);
+    // Concurrent puts can complete out of order - an older block doesn't move the metric back
+    if (lastSavedBlockVal > last_saved_block_id_.Get().Get()) {
+      last_saved_block_id_.Get().Set(lastSavedBlockVal);
+    }
   }
 
   uint64_t getLastSavedBlockId() { return last_saved_block_id_.Get().Get(); }
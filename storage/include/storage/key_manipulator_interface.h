@@ -33,6 +33,7 @@ class ISTKeyManipulator {
   virtual concordUtils::Sliver generateSTCheckpointDescriptorKey(uint64_t chkpt) const = 0;
   virtual concordUtils::Sliver generateSTReservedPageDynamicKey(uint32_t pageId, uint64_t chkpt) const = 0;
   virtual concordUtils::Sliver getReservedPageKeyPrefix() const = 0;
+  virtual concordUtils::Sliver getSTPendingPageKeyPrefix() const = 0;
   virtual ~ISTKeyManipulator() = default;
 };
 
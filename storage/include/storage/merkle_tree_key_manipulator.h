@@ -29,6 +29,7 @@ class STKeyManipulator : public ISTKeyManipulator {
   concordUtils::Sliver generateSTCheckpointDescriptorKey(uint64_t chkpt) const override;
   concordUtils::Sliver generateSTReservedPageDynamicKey(uint32_t pageId, uint64_t chkpt) const override;
   concordUtils::Sliver getReservedPageKeyPrefix() const override;
+  concordUtils::Sliver getSTPendingPageKeyPrefix() const override;
 };
 
 }  // namespace concord::storage::v2MerkleTree
@@ -96,6 +96,11 @@ Sliver STKeyManipulator::getReservedPageKeyPrefix() const {
   static Sliver s(std::string(1, static_cast<char>(EDBKeyType::E_DB_KEY_TYPE_BFT_ST_RESERVED_PAGE_DYNAMIC_KEY)));
   return s;
 }
+
+Sliver STKeyManipulator::getSTPendingPageKeyPrefix() const {
+  static Sliver s(std::string(1, static_cast<char>(EDBKeyType::E_DB_KEY_TYPE_BFT_ST_PENDING_PAGE_KEY)));
+  return s;
+}
 /**
  * Format : Key Type | Page Id | Checkpoint
  */
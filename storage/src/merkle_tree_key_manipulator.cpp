@@ -57,5 +57,9 @@ Sliver STKeyManipulator::getReservedPageKeyPrefix() const {
   static Sliver s(serialize(EBFTSubtype::STReservedPageDynamic));
   return s;
 }
+Sliver STKeyManipulator::getSTPendingPageKeyPrefix() const {
+  static Sliver s(serialize(EBFTSubtype::STPendingPage));
+  return s;
+}
 
 }  // namespace concord::storage::v2MerkleTree
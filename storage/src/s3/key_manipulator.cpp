@@ -42,5 +42,8 @@ Sliver STKeyManipulator::generateSTReservedPageDynamicKey(uint32_t pageId, uint6
 Sliver STKeyManipulator::getReservedPageKeyPrefix() const {
   throw std::runtime_error(__PRETTY_FUNCTION__ + std::string(" not implemented"));
 }
+Sliver STKeyManipulator::getSTPendingPageKeyPrefix() const {
+  throw std::runtime_error(__PRETTY_FUNCTION__ + std::string(" not implemented"));
+}
 
 }  // namespace concord::storage::s3
@@ -20,6 +20,8 @@
 #include "sliver.hpp"
 #include "storage/test/storage_test_common.h"
 
+#include <rocksdb/slice_transform.h>
+
 #include <string_view>
 #include <utility>
 
@@ -633,6 +635,33 @@ TEST_F(native_rocksdb_test, iterator_seek_at_most_in_a_family) {
   ASSERT_EQ(it.value(), value1);
 }
 
+TEST_F(native_rocksdb_test, iterator_is_in_total_order_in_a_family_with_prefix_extractor) {
+  const auto cf = "cf"s;
+  auto opts = ::rocksdb::ColumnFamilyOptions{};
+  opts.prefix_extractor.reset(::rocksdb::NewFixedPrefixTransform(2));
+  db->createColumnFamily(cf, opts);
+  db->put(cf, "aa1"sv, value1);
+  db->put(cf, "ab1"sv, value2);
+  db->put(cf, "bb1"sv, value3);
+
+  // Open the DB again so that the keys are read from SST files with prefix bloom filters.
+  db.reset();
+  db = TestRocksDb::createNative(NativeClient::ExistingOptions{});
+  ASSERT_TRUE(db->columnFamilyOptions(cf).prefix_extractor);
+
+  auto it = db->getIterator(cf);
+  auto keys = std::vector<std::string>{};
+  for (it.first(); it; it.next()) {
+    keys.push_back(it.key());
+  }
+  ASSERT_THAT(keys, ContainerEq(std::vector<std::string>{"aa1", "ab1", "bb1"}));
+
+  // Seeking doesn't stop at the end of the prefix
+  it.seekAtLeast("aa2"sv);
+  ASSERT_TRUE(it);
+  ASSERT_EQ(it.key(), "ab1");
+}
+
 TEST_F(native_rocksdb_test, iterator_seek_success_after_unsuccessful_seeks) {
   const auto cf = "cf"s;
   db->createColumnFamily(cf);
@@ -894,6 +923,41 @@ TEST_F(native_rocksdb_test, multiget_resize_values_and_statuses) {
   ASSERT_EQ(value2, *values[2].GetSelf());
 }
 
+TEST_F(native_rocksdb_test, write_and_ingest_sst_file) {
+  const auto cf = "cf"s;
+  const auto sst_path = rocksDbPathPrefix + "_cf.sst";
+  db->createColumnFamily(cf);
+  db->put(cf, key1, value1);
+  db->put(cf, key2, value2);
+  db->put(cf, key3, value3);
+
+  // Write from key2 onwards
+  auto iter = db->getIterator(cf);
+  iter.seekAtLeast(key2);
+  ASSERT_EQ(db->writeSstFile(cf, iter, sst_path), 2);
+  ASSERT_FALSE(iter);
+
+  // Nothing is written from the end of the column family
+  const auto empty_sst_path = rocksDbPathPrefix + "_empty.sst";
+  ASSERT_EQ(db->writeSstFile(cf, iter, empty_sst_path), 0);
+  ASSERT_FALSE(fs::exists(empty_sst_path));
+
+  const auto other_db_id = 1;
+  cleanup(other_db_id);
+  {
+    auto other_db = TestRocksDb::createNative(other_db_id);
+    other_db->createColumnFamily(cf);
+    other_db->put(cf, key, value);
+    other_db->ingestSstFiles(cf, {sst_path});
+    ASSERT_FALSE(fs::exists(sst_path));
+    ASSERT_EQ(other_db->get(cf, key), value);
+    ASSERT_FALSE(other_db->get(cf, key1));
+    ASSERT_EQ(other_db->get(cf, key2), value2);
+    ASSERT_EQ(other_db->get(cf, key3), value3);
+  }
+  cleanup(other_db_id);
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
@@ -0,0 +1,186 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "gtest/gtest.h"
+
+#include "s3/client.hpp"
+#include "sliver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace {
+
+using namespace concord::storage;
+using namespace std::chrono_literals;
+using concordUtils::Sliver;
+using concordUtils::Status;
+
+// An in-memory object store standing in for the S3 server. Every request takes some time, the first get or put of a
+// key fails with a network error and the maximum number of requests in flight is recorded.
+class InMemoryS3Client : public s3::Client {
+ public:
+  InMemoryS3Client(const s3::StoreConfig& config) : s3::Client(config) { initialDelay_ = 1; }
+
+  Status del(const Sliver& key) override {
+    auto g = request();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!objects_.erase(key.toString())) return Status::NotFound("no such key");
+    return Status::OK();
+  }
+
+  Status get_internal(const Sliver& key, OUT Sliver& value) const override {
+    auto g = request();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failOnce(key)) return Status::GeneralError("Network failure simulated");
+    auto it = objects_.find(key.toString());
+    if (it == objects_.end()) return Status::NotFound("no such key");
+    value = Sliver::copy(it->second.data(), it->second.size());
+    return Status::OK();
+  }
+
+  Status put_internal(const Sliver& key, const Sliver& value) override {
+    auto g = request();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failOnce(key)) return Status::GeneralError("Network failure simulated");
+    objects_[key.toString()] = value.toString();
+    return Status::OK();
+  }
+
+  Status object_exists_internal(const Sliver& key) const override {
+    auto g = request();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return objects_.count(key.toString()) ? Status::OK() : Status::NotFound("no such key");
+  }
+
+  Status test_bucket_internal() override { return Status::OK(); }
+
+  size_t maxInFlight() const { return max_in_flight_; }
+  size_t numObjects() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return objects_.size();
+  }
+
+ private:
+  struct InFlight {
+    InFlight(const InMemoryS3Client& c) : client{c} {
+      auto in_flight = ++client.in_flight_;
+      auto max = client.max_in_flight_.load();
+      while (in_flight > max && !client.max_in_flight_.compare_exchange_weak(max, in_flight)) {
+      }
+      std::this_thread::sleep_for(5ms);
+    }
+    ~InFlight() { --client.in_flight_; }
+    const InMemoryS3Client& client;
+  };
+  InFlight request() const { return InFlight{*this}; }
+
+  bool failOnce(const Sliver& key) const { return failed_keys_.insert(key.toString()).second; }
+
+  mutable std::mutex mutex_;
+  std::map<std::string, std::string> objects_;
+  mutable std::set<std::string> failed_keys_;
+  mutable std::atomic_size_t in_flight_{0};
+  mutable std::atomic_size_t max_in_flight_{0};
+};
+
+class s3_client_test : public ::testing::Test {
+ protected:
+  s3_client_test() {
+    config.bucketName = "blockchain";
+    config.protocol = "HTTP";
+    config.url = "127.0.0.1:9000";
+    config.maxWaitTime = 10;
+    config.maxConcurrentRequests = 4;
+    client = std::make_unique<InMemoryS3Client>(config);
+    client->init(false);
+  }
+
+  static std::string key(size_t i) { return "blocks/" + std::to_string(i) + "/raw"; }
+
+  s3::StoreConfig config;
+  std::unique_ptr<InMemoryS3Client> client;
+};
+
+TEST_F(s3_client_test, multi_put_and_multi_get) {
+  SetOfKeyValuePairs kvs;
+  KeysVector keys;
+  for (size_t i = 0; i < 32; ++i) {
+    kvs[Sliver{key(i)}] = Sliver{"value" + std::to_string(i)};
+    keys.push_back(Sliver{key(i)});
+  }
+  ASSERT_TRUE(client->multiPut(kvs).isOK());
+  ASSERT_EQ(client->numObjects(), 32);
+
+  ValuesVector values(keys.size());
+  ASSERT_TRUE(client->multiGet(keys, values).isOK());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(values[i].toString(), "value" + std::to_string(i));
+  }
+
+  // Requests run concurrently, but not more than configured
+  ASSERT_GT(client->maxInFlight(), 1);
+  ASSERT_LE(client->maxInFlight(), config.maxConcurrentRequests);
+}
+
+TEST_F(s3_client_test, multi_get_reports_missing_key) {
+  ASSERT_TRUE(client->put(Sliver{key(0)}, Sliver{std::string{"value"}}).isOK());
+  KeysVector keys{Sliver{key(0)}, Sliver{key(1)}};
+  ValuesVector values(keys.size());
+  ASSERT_TRUE(client->multiGet(keys, values).isNotFound());
+  ASSERT_EQ(values[0].toString(), "value");
+}
+
+TEST_F(s3_client_test, transaction_puts_and_deletes) {
+  for (size_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(client->put(Sliver{key(i)}, Sliver{std::string{"old"}}).isOK());
+  }
+  {
+    ITransaction::Guard g(client->beginTransaction());
+    for (size_t i = 0; i < 8; ++i) {
+      g.txn()->del(Sliver{key(i)});
+    }
+    for (size_t i = 8; i < 16; ++i) {
+      g.txn()->put(Sliver{key(i)}, Sliver{std::string{"new"}});
+    }
+  }
+  ASSERT_EQ(client->numObjects(), 8);
+  for (size_t i = 8; i < 16; ++i) {
+    Sliver value;
+    ASSERT_TRUE(client->get(Sliver{key(i)}, value).isOK());
+    ASSERT_EQ(value.toString(), "new");
+  }
+}
+
+TEST_F(s3_client_test, transaction_commit_failure_throws) {
+  ITransaction* txn = client->beginTransaction();
+  txn->put(Sliver{key(0)}, Sliver{std::string{"value"}});
+  // Deleting a key that doesn't exist fails
+  txn->del(Sliver{key(1)});
+  ASSERT_THROW(txn->commit(), std::runtime_error);
+  delete txn;
+  ASSERT_EQ(client->numObjects(), 1);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
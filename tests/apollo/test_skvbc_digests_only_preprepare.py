@@ -0,0 +1,72 @@
+# Concord
+#
+# Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+#
+# This product is licensed to you under the Apache 2.0 license (the "License").
+# You may not use this product except in compliance with the Apache 2.0 License.
+#
+# This product may include a number of subcomponents with separate copyright
+# notices and license terms. Your use of these subcomponents is subject to the
+# terms and conditions of the subcomponent's license, as noted in the LICENSE
+# file.
+
+import os.path
+import unittest
+
+from util.bft import with_trio, with_bft_network, KEY_FILE_PREFIX
+from util import skvbc as kvbc
+
+NUM_OF_WRITES = 10
+
+
+def start_replica_cmd(builddir, replica_id):
+    """
+    Return a command that starts an skvbc replica when passed to
+    subprocess.Popen.
+
+    The primary sends PrePrepare messages with the digests of the requests
+    only, and replicas don't disseminate the requests they get from clients.
+
+    Note each arguments is an element in a list.
+    """
+    statusTimerMilli = "500"
+    path = os.path.join(builddir, "tests", "simpleKVBC", "TesterReplica", "skvbc_replica")
+    return [path,
+            "-k", KEY_FILE_PREFIX,
+            "-i", str(replica_id),
+            "-s", statusTimerMilli,
+            "--preprepare-with-request-digests-only",
+            "--no-client-requests-dissemination"
+            ]
+
+
+class SkvbcDigestsOnlyPrePrepareTest(unittest.TestCase):
+
+    __test__ = False  # so that PyTest ignores this test scenario
+
+    @with_trio
+    @with_bft_network(start_replica_cmd, selected_configs=lambda n, f, c: n == 7)
+    async def test_backups_fetch_missing_request_bodies(self, bft_network):
+        """
+        Once the client knows the primary, it sends its write requests to the
+        primary only. The backups get digests-only PrePrepare messages for
+        requests they have never seen, fetch the request bodies from the primary
+        and commit them.
+        """
+        bft_network.start_all_replicas()
+        skvbc = kvbc.SimpleKVBCProtocol(bft_network)
+        client = bft_network.random_client()
+
+        for _ in range(NUM_OF_WRITES):
+            reply = await client.write(skvbc.write_req([], [(skvbc.random_key(), skvbc.random_value())], 0))
+            self.assertTrue(skvbc.parse_reply(reply).success)
+
+        primary = await bft_network.get_current_primary()
+        last_executed = await bft_network.retrieve_metric(primary, 'replica', 'Gauges', 'lastExecutedSeqNum')
+        self.assertGreaterEqual(last_executed, NUM_OF_WRITES)
+
+        for backup in bft_network.all_replicas(without={primary}):
+            await bft_network.wait_for_last_executed_seq_num(replica_id=backup, expected=last_executed)
+            fetches = await bft_network.retrieve_metric(
+                backup, 'replica', 'Counters', 'sentReqMissingClientRequestsMsgs')
+            self.assertGreater(fetches, 0)
@@ -0,0 +1,337 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// clusterbench runs a whole BFT cluster on one machine - n replicas and M bft clients - and measures the latency and
+// throughput of write requests. All the messages go through an in-memory network with configurable link latency and
+// bandwidth, so that results don't depend on the machine's network stack and are repeatable from one run to the next.
+//
+// Clients run in the benchmark process. Each replica runs in a process of its own, forked from the benchmark process,
+// as the replica library keeps per-process singletons (see ReplicaProcess).
+//
+// Load is either closed-loop - each client sends its next request as soon as it gets the reply to the previous one -
+// or open-loop at a fixed total rate. In open-loop mode the latency of a request is measured from the time it was
+// scheduled to be sent, so that a slow cluster isn't hidden by clients that fall behind their schedule.
+//
+// The replicas need key files, e.g. for f=1, c=0:
+//   GenerateConcordKeys -f 1 -n 4 -o private_replica_
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "bftclient/bft_client.h"
+#include "diagnostics.h"
+#include "replica_process.hpp"
+#include "simulated_network.hpp"
+
+using namespace std;
+
+namespace concord::clusterbench {
+
+namespace po = boost::program_options;
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig {
+  // Requests per second over all the clients. 0 means closed-loop.
+  double rate = 0;
+  std::chrono::seconds duration{10};
+  size_t request_size = 100;
+  std::chrono::milliseconds request_timeout{5000};
+};
+
+std::pair<po::options_description, po::variables_map> parseArgs(int argc, char** argv) {
+  auto desc = po::options_description("Allowed options");
+  // clang-format off
+  desc.add_options()
+    ("help", "show usage")
+
+    /*********************************
+     Cluster Config
+     *********************************/
+    ("f-val",
+     po::value<uint16_t>()->default_value(1),
+     "The number of faulty replicas tolerated. The cluster has 3f + 2c + 1 replicas.")
+
+    ("c-val",
+     po::value<uint16_t>()->default_value(0),
+     "The number of slow replicas tolerated")
+
+    ("clients",
+     po::value<uint16_t>()->default_value(4),
+     "The number of clients")
+
+    ("concurrency-level",
+     po::value<uint16_t>()->default_value(1),
+     "The number of consensus instances the primary runs concurrently")
+
+    ("keys-file-prefix",
+     po::value<std::string>()->default_value("private_replica_"s),
+     "The prefix of the replica key files, as given to GenerateConcordKeys -o")
+
+    ("storage",
+     po::value<std::string>()->default_value("memory"s),
+     "Where replicas keep their metadata: 'memory' or 'rocksdb'")
+
+    ("rocksdb-path",
+     po::value<std::string>()->default_value("./clusterbench_db"s),
+     "The parent directory of the replica databases with --storage=rocksdb. Existing databases are removed.")
+
+    /*********************************
+     Network Config
+     *********************************/
+    ("latency-us",
+     po::value<size_t>()->default_value(0),
+     "One-way latency of every link in microseconds")
+
+    ("bandwidth-mbps",
+     po::value<double>()->default_value(0),
+     "Bandwidth of every link in megabits per second. 0 means unlimited.")
+
+    /*********************************
+     Load Config
+     *********************************/
+    ("rate",
+     po::value<double>()->default_value(0),
+     "Total requests per second sent by the clients in open-loop mode. 0 means closed-loop.")
+
+    ("duration-sec",
+     po::value<size_t>()->default_value(10),
+     "How long to send requests for, after the cluster is up")
+
+    ("request-size",
+     po::value<size_t>()->default_value(100),
+     "The size of a request in bytes")
+
+    ("request-timeout-ms",
+     po::value<size_t>()->default_value(5000),
+     "The timeout of a request");
+  // clang-format on
+
+  auto config = po::variables_map{};
+  po::store(po::parse_command_line(argc, argv, desc), config);
+  po::notify(config);
+  return std::make_pair(desc, config);
+}
+
+ClusterConfig clusterConfig(const po::variables_map& config) {
+  auto cluster = ClusterConfig{};
+  cluster.f_val = config["f-val"].as<uint16_t>();
+  cluster.c_val = config["c-val"].as<uint16_t>();
+  cluster.num_clients = config["clients"].as<uint16_t>();
+  cluster.concurrency_level = config["concurrency-level"].as<uint16_t>();
+  cluster.keys_file_prefix = config["keys-file-prefix"].as<std::string>();
+  const auto storage = config["storage"].as<std::string>();
+  if (storage == "memory") {
+    cluster.storage = StorageType::InMemory;
+  } else if (storage == "rocksdb") {
+    cluster.storage = StorageType::RocksDb;
+  } else {
+    throw po::validation_error{po::validation_error::invalid_option_value, "storage", storage};
+  }
+  cluster.db_path = config["rocksdb-path"].as<std::string>();
+  return cluster;
+}
+
+LinkConfig linkConfig(const po::variables_map& config) {
+  auto link = LinkConfig{};
+  link.latency = std::chrono::microseconds{config["latency-us"].as<size_t>()};
+  link.bandwidth = static_cast<uint64_t>(config["bandwidth-mbps"].as<double>() * 1000 * 1000 / 8);
+  return link;
+}
+
+LoadConfig loadConfig(const po::variables_map& config) {
+  auto load = LoadConfig{};
+  load.rate = config["rate"].as<double>();
+  load.duration = std::chrono::seconds{config["duration-sec"].as<size_t>()};
+  load.request_size = config["request-size"].as<size_t>();
+  load.request_timeout = std::chrono::milliseconds{config["request-timeout-ms"].as<size_t>()};
+  return load;
+}
+
+// A client of the benchmark and its load statistics.
+class BenchClient {
+ public:
+  BenchClient(SimulatedNetwork& network, const ClusterConfig& cluster, uint16_t id) {
+    auto config = bft::client::ClientConfig{};
+    config.id = bft::client::ClientId{id};
+    for (uint16_t i = 0; i < cluster.numReplicas(); ++i) {
+      config.all_replicas.insert(bft::client::ReplicaId{i});
+    }
+    config.f_val = cluster.f_val;
+    config.c_val = cluster.c_val;
+    client_ = std::make_unique<bft::client::Client>(network.endpoint(id), config);
+  }
+
+  // Send requests until one succeeds, i.e. the cluster is up, or the deadline passes.
+  bool waitForCluster(const LoadConfig& load, Clock::time_point deadline) {
+    while (Clock::now() < deadline) {
+      if (send(load)) return true;
+    }
+    return false;
+  }
+
+  // Send requests until `end`. Requests are sent back to back if `interval` is zero or else scheduled every
+  // `interval` from `start`.
+  void run(const LoadConfig& load,
+           Clock::time_point start,
+           Clock::time_point end,
+           Clock::duration interval,
+           concord::diagnostics::Recorder& latency) {
+    auto scheduled = start;
+    while (true) {
+      if (interval > Clock::duration::zero()) {
+        std::this_thread::sleep_until(scheduled);
+      } else {
+        scheduled = Clock::now();
+      }
+      if (scheduled >= end) return;
+      if (send(load)) {
+        ++completed_;
+        latency.recordAtomic(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scheduled).count());
+      } else {
+        ++timeouts_;
+      }
+      scheduled += interval;
+    }
+  }
+
+  void stop() { client_->stop(); }
+
+  uint64_t completed() const { return completed_; }
+  uint64_t timeouts() const { return timeouts_; }
+
+ private:
+  bool send(const LoadConfig& load) {
+    auto write_config = bft::client::WriteConfig{bft::client::RequestConfig{false, ++seq_num_},
+                                                 bft::client::LinearizableQuorum{}};
+    write_config.request.timeout = load.request_timeout;
+    try {
+      client_->send(write_config, bft::client::Msg(load.request_size, 0x42));
+      return true;
+    } catch (const bft::client::TimeoutException&) {
+      return false;
+    }
+  }
+
+  std::unique_ptr<bft::client::Client> client_;
+  uint64_t seq_num_ = 0;
+  uint64_t completed_ = 0;
+  uint64_t timeouts_ = 0;
+};
+
+void printHistograms() {
+  auto& registrar = diagnostics::RegistrarSingleton::getInstance();
+  registrar.perf.snapshot("clusterbench");
+  auto data = registrar.perf.get("clusterbench");
+  cout << registrar.perf.toString(data) << endl;
+}
+
+void runBenchmark(const ClusterConfig& cluster,
+                  const LoadConfig& load,
+                  SimulatedNetwork& network,
+                  std::vector<std::unique_ptr<ReplicaProcess>>& replicas,
+                  concord::diagnostics::Recorder& latency) {
+  for (auto& replica : replicas) {
+    replica->connect(network);
+  }
+  network.start();
+
+  auto clients = std::vector<std::unique_ptr<BenchClient>>{};
+  for (uint16_t i = 0; i < cluster.num_clients; ++i) {
+    clients.push_back(std::make_unique<BenchClient>(network, cluster, cluster.firstClientId() + i));
+  }
+
+  cout << "Waiting for " << cluster.numReplicas() << " replicas to start..." << endl;
+  const auto deadline = Clock::now() + 60s;
+  for (auto& client : clients) {
+    if (!client->waitForCluster(load, deadline)) {
+      throw std::runtime_error("The cluster didn't start processing requests in time");
+    }
+  }
+
+  // Clients send at the same rate, with schedules shifted so that requests are evenly spread in time.
+  auto interval = Clock::duration::zero();
+  if (load.rate > 0) {
+    interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(clients.size() / load.rate));
+  }
+  cout << "Sending " << (load.rate > 0 ? "open-loop at " + std::to_string(load.rate) + " requests/s" : "closed-loop"s)
+       << " for " << load.duration.count() << " seconds..." << endl;
+  const auto start = Clock::now();
+  const auto end = start + load.duration;
+  auto threads = std::vector<std::thread>{};
+  for (size_t i = 0; i < clients.size(); ++i) {
+    const auto client_start = start + interval * i / clients.size();
+    threads.emplace_back([&, i, client_start]() { clients[i]->run(load, client_start, end, interval, latency); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  // Stop the deliveries before the clients and replicas go away
+  network.stop();
+  for (auto& client : clients) {
+    client->stop();
+  }
+
+  auto completed = uint64_t{0};
+  auto timeouts = uint64_t{0};
+  for (const auto& client : clients) {
+    completed += client->completed();
+    timeouts += client->timeouts();
+  }
+  const auto stats = network.stats();
+  printHistograms();
+  cout << "Completed requests = " << completed << ", timeouts = " << timeouts << endl;
+  cout << "Avg. Throughput = " << completed / elapsed << " requests/s" << endl;
+  cout << "Network: " << stats.messages << " messages, " << stats.bytes << " bytes delivered, " << stats.dropped
+       << " dropped" << endl;
+}
+
+}  // namespace concord::clusterbench
+
+using namespace concord::clusterbench;
+using namespace concord;
+
+int main(int argc, char** argv) {
+  try {
+    auto [desc, config] = parseArgs(argc, argv);
+
+    if (config.count("help")) {
+      cout << desc << endl;
+      return 1;
+    }
+
+    const auto cluster = clusterConfig(config);
+    const auto load = loadConfig(config);
+
+    // The network is started by runBenchmark(), after the replicas are forked - before any thread is started.
+    auto network = SimulatedNetwork{linkConfig(config)};
+    auto replicas = ReplicaProcess::spawnCluster(cluster);
+
+    auto& registrar = diagnostics::RegistrarSingleton::getInstance();
+    DEFINE_SHARED_RECORDER(request_latency, 1, 60 * 1000 * 1000, 3, diagnostics::Unit::MICROSECONDS);
+    registrar.perf.registerComponent("clusterbench", {request_latency});
+
+    runBenchmark(cluster, load, network, replicas, *request_latency);
+  } catch (exception& e) {
+    cerr << e.what() << endl;
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,213 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "replica_process.hpp"
+#include "socket_communication.hpp"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include "ControlStateManager.hpp"
+#include "DbMetadataStorage.hpp"
+#include "Logger.hpp"
+#include "Replica.hpp"
+#include "ReplicaConfig.hpp"
+#include "SimpleStateTransfer.hpp"
+#include "storage/direct_kv_key_manipulator.h"
+#include "test_comm_config.hpp"
+#ifdef USE_ROCKSDB
+#include "rocksdb/client.h"
+#endif
+
+namespace concord::clusterbench {
+
+using namespace bftEngine;
+using bftEngine::SimpleInMemoryStateTransfer::ISimpleInMemoryStateTransfer;
+
+namespace {
+
+logging::Logger logger = logging::getLogger("clusterbench");
+
+// The replicated state machine: counts the write requests of each client, whatever their payload, and replies with
+// the count. Read-only requests get the count without changing it.
+class CounterRequestsHandler : public IRequestsHandler {
+ public:
+  CounterRequestsHandler(uint16_t first_client_id, uint16_t num_clients)
+      : first_client_id_{first_client_id}, counters_(num_clients, 0) {}
+
+  void execute(ExecutionRequestsQueue& requests,
+               const std::string& batchCid,
+               concordUtils::SpanWrapper& parent_span) override {
+    for (auto& req : requests) {
+      req.outReplicaSpecificInfoSize = 0;
+      if (req.clientId < first_client_id_ || static_cast<size_t>(req.clientId - first_client_id_) >= counters_.size() ||
+          req.maxReplySize < sizeof(uint64_t)) {
+        req.outActualReplySize = 0;
+        req.outExecutionStatus = 1;
+        continue;
+      }
+      auto& counter = counters_[req.clientId - first_client_id_];
+      if (!(req.flags & READ_ONLY_FLAG)) {
+        ++counter;
+        st_->markUpdate(&counter, sizeof(counter));
+      }
+      std::memcpy(req.outReply, &counter, sizeof(counter));
+      req.outActualReplySize = sizeof(counter);
+      req.outExecutionStatus = 0;
+    }
+  }
+
+  void* state() { return counters_.data(); }
+  uint32_t stateSize() const { return counters_.size() * sizeof(uint64_t); }
+  void setStateTransfer(ISimpleInMemoryStateTransfer* st) { st_ = st; }
+
+ private:
+  const uint16_t first_client_id_;
+  std::vector<uint64_t> counters_;
+  ISimpleInMemoryStateTransfer* st_ = nullptr;
+};
+
+// Run replica `id` in the current (child) process until the benchmark process disconnects.
+void runReplica(uint16_t id, int fd, const ClusterConfig& config) {
+  auto& replica_config = ReplicaConfig::instance();
+  TestCommConfig test_comm_config(logger);
+  test_comm_config.GetReplicaConfig(id, config.keys_file_prefix, &replica_config);
+  if (replica_config.numReplicas != config.numReplicas() || replica_config.fVal != config.f_val ||
+      replica_config.cVal != config.c_val) {
+    throw std::runtime_error("The keys with prefix " + config.keys_file_prefix + " are for a cluster of " +
+                             std::to_string(replica_config.numReplicas) + " replicas, f=" +
+                             std::to_string(replica_config.fVal) + ", c=" + std::to_string(replica_config.cVal));
+  }
+  replica_config.replicaId = id;
+  replica_config.numOfClientProxies = config.num_clients;
+  replica_config.concurrencyLevel = config.concurrency_level;
+  replica_config.statusReportTimerMillisec = 10000;
+  replica_config.debugPersistentStorageEnabled = config.storage == StorageType::InMemory;
+
+  auto handler = std::make_shared<CounterRequestsHandler>(config.firstClientId(), config.num_clients);
+  auto st = SimpleInMemoryStateTransfer::create(
+      handler->state(), handler->stateSize(), id, replica_config.fVal, replica_config.cVal, true);
+  handler->setStateTransfer(st);
+
+  // The replica takes ownership of the metadata storage but not of its database.
+  MetadataStorage* metadata_storage = nullptr;
+  std::unique_ptr<storage::IDBClient> db;
+  if (config.storage == StorageType::RocksDb) {
+#ifdef USE_ROCKSDB
+    const auto db_path = std::filesystem::path{config.db_path} / ("replica_" + std::to_string(id));
+    std::filesystem::remove_all(db_path);
+    std::filesystem::create_directories(db_path);
+    db = std::make_unique<storage::rocksdb::Client>(db_path.string());
+    db->init();
+    metadata_storage = new storage::DBMetadataStorage(
+        db.get(), std::make_unique<storage::v1DirectKeyValue::MetadataKeyManipulator>());
+#else
+    throw std::runtime_error("RocksDB storage is not supported by this build");
+#endif
+  }
+
+  auto comm = std::make_unique<SocketCommunication>(fd);
+  auto replica = IReplica::createNewReplica(replica_config,
+                                            handler,
+                                            st,
+                                            comm.get(),
+                                            metadata_storage,
+                                            std::make_shared<concord::performance::PerformanceManager>(),
+                                            nullptr /*SecretsManagerEnc*/);
+  if (!replica) throw std::runtime_error("Failed to create replica " + std::to_string(id));
+  replica->start();
+  ControlStateManager::setReservedPages(st);
+  ControlStateManager::instance().disable();
+  LOG_INFO(logger, "Replica " << id << " started");
+
+  comm->waitForDisconnect();
+  replica->stop();
+  LOG_INFO(logger, "Replica " << id << " stopped");
+}
+
+}  // namespace
+
+std::vector<std::unique_ptr<ReplicaProcess>> ReplicaProcess::spawnCluster(const ClusterConfig& config) {
+  auto replicas = std::vector<std::unique_ptr<ReplicaProcess>>{};
+  for (uint16_t id = 0; id < config.numReplicas(); ++id) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      throw std::runtime_error(std::string{"socketpair() failed: "} + std::strerror(errno));
+    }
+    const auto pid = ::fork();
+    if (pid < 0) {
+      throw std::runtime_error(std::string{"fork() failed: "} + std::strerror(errno));
+    }
+    if (pid == 0) {
+      // The replica must only see EOF when the benchmark process closes its end, hence close the ends of the
+      // replicas spawned before this one, as well as our own.
+      for (const auto& replica : replicas) {
+        ::close(replica->fd_);
+      }
+      ::close(fds[0]);
+      auto status = 0;
+      try {
+        runReplica(id, fds[1], config);
+      } catch (const std::exception& e) {
+        LOG_FATAL(logger, "Replica " << id << " failed: " << e.what());
+        status = 1;
+      }
+      // Don't run the destructors of the state inherited from the benchmark process
+      ::_exit(status);
+    }
+    ::close(fds[1]);
+    replicas.emplace_back(new ReplicaProcess{id, pid, fds[0]});
+  }
+  return replicas;
+}
+
+void ReplicaProcess::connect(SimulatedNetwork& network) {
+  network_ = &network;
+  network_->attach(id_, this);
+  relay_ = std::thread([this]() { relayLoop(); });
+}
+
+void ReplicaProcess::stop() {
+  if (fd_ < 0) return;
+  if (network_) network_->detach(id_);
+  ::shutdown(fd_, SHUT_RDWR);
+  if (relay_.joinable()) relay_.join();
+  ::close(fd_);
+  fd_ = -1;
+  auto status = 0;
+  ::waitpid(pid_, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    LOG_WARN(logger, "Replica " << id_ << " process exited abnormally, status: " << status);
+  }
+}
+
+void ReplicaProcess::onNewMessage(NodeNum sourceNode, const char* const message, size_t messageLength) {
+  // Only the network's delivery thread writes to the socket
+  if (fd_ < 0) return;
+  writeFrame(fd_, sourceNode, reinterpret_cast<const uint8_t*>(message), messageLength);
+}
+
+void ReplicaProcess::relayLoop() {
+  auto to = NodeNum{0};
+  auto msg = std::vector<uint8_t>{};
+  while (readFrame(fd_, to, msg)) {
+    network_->send(id_, to, std::make_shared<const std::vector<uint8_t>>(std::move(msg)));
+    msg = std::vector<uint8_t>{};
+  }
+}
+
+}  // namespace concord::clusterbench
@@ -0,0 +1,92 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <sys/types.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "communication/ICommunication.hpp"
+#include "simulated_network.hpp"
+
+namespace concord::clusterbench {
+
+enum class StorageType {
+  // Replica metadata is kept in memory (DebugPersistentStorage).
+  InMemory,
+  // Replica metadata is persisted in a RocksDB database per replica.
+  RocksDb,
+};
+
+struct ClusterConfig {
+  uint16_t f_val = 1;
+  uint16_t c_val = 0;
+  uint16_t num_clients = 4;
+  uint16_t concurrency_level = 1;
+  // The replica key files, as generated by GenerateConcordKeys, are <prefix><replica id>.
+  std::string keys_file_prefix = "private_replica_";
+  StorageType storage = StorageType::InMemory;
+  // The parent directory of the replica databases when using RocksDB. Existing databases are removed.
+  std::string db_path = "./clusterbench_db";
+
+  uint16_t numReplicas() const { return 3 * f_val + 2 * c_val + 1; }
+  // Clients come right after the replicas in the node numbering.
+  uint16_t firstClientId() const { return numReplicas(); }
+};
+
+// A replica running in a child process of the benchmark.
+//
+// The replica library keeps its configuration and crypto state in per-process singletons (ReplicaConfig,
+// CryptoManager, SigManager, ...) and so cannot run several replicas in one address space. Instead, each replica gets
+// a child process whose messages are relayed over a socket pair to the benchmark process, where they go through the
+// simulated network like the clients' messages.
+class ReplicaProcess : public bft::communication::IReceiver {
+ public:
+  // Fork the processes of all the replicas. Must be called before the benchmark process starts any thread, as only
+  // the calling thread is carried over to a child process.
+  static std::vector<std::unique_ptr<ReplicaProcess>> spawnCluster(const ClusterConfig& config);
+
+  ~ReplicaProcess() { stop(); }
+
+  ReplicaProcess(const ReplicaProcess&) = delete;
+  ReplicaProcess& operator=(const ReplicaProcess&) = delete;
+
+  // Relay the messages of the replica over `network`, which must outlive the ReplicaProcess.
+  void connect(SimulatedNetwork& network);
+
+  // Disconnect from the network and the replica, which then stops, and wait for its process to exit.
+  void stop();
+
+  uint16_t id() const { return id_; }
+
+  // Called by the network for messages to the replica.
+  void onNewMessage(NodeNum sourceNode, const char* const message, size_t messageLength) override;
+  void onConnectionStatusChanged(NodeNum node, bft::communication::ConnectionStatus newStatus) override {}
+
+ private:
+  ReplicaProcess(uint16_t id, pid_t pid, int fd) : id_{id}, pid_{pid}, fd_{fd} {}
+
+  void relayLoop();
+
+  const uint16_t id_;
+  SimulatedNetwork* network_ = nullptr;
+  pid_t pid_;
+  int fd_;
+  std::thread relay_;
+};
+
+}  // namespace concord::clusterbench
@@ -0,0 +1,136 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "simulated_network.hpp"
+
+#include <algorithm>
+
+namespace concord::clusterbench {
+
+using bft::communication::IReceiver;
+
+void SimulatedNetwork::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!stopped_) return;
+  stopped_ = false;
+  delivery_thread_ = std::thread([this]() { deliveryLoop(); });
+}
+
+void SimulatedNetwork::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) return;
+    stopped_ = true;
+  }
+  cv_.notify_one();
+  delivery_thread_.join();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.dropped += in_flight_.size();
+  in_flight_ = decltype(in_flight_){};
+}
+
+std::unique_ptr<bft::communication::ICommunication> SimulatedNetwork::endpoint(NodeNum node) {
+  return std::make_unique<SimulatedCommunication>(*this, node);
+}
+
+void SimulatedNetwork::attach(NodeNum node, IReceiver* receiver) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  receivers_[node] = receiver;
+}
+
+void SimulatedNetwork::detach(NodeNum node) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  receivers_.erase(node);
+  delivered_cv_.wait(lock, [this, node]() { return delivering_to_ != node; });
+}
+
+void SimulatedNetwork::send(NodeNum from, NodeNum to, std::shared_ptr<const std::vector<uint8_t>> msg) {
+  const auto now = Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& busy_until = link_busy_until_[std::make_pair(from, to)];
+    auto transmitted = std::max(now, busy_until);
+    if (link_.bandwidth > 0) {
+      transmitted += std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(static_cast<double>(msg->size()) / link_.bandwidth));
+    }
+    busy_until = transmitted;
+    in_flight_.push(Delivery{transmitted + link_.latency, next_seq_++, from, to, std::move(msg)});
+  }
+  cv_.notify_one();
+}
+
+void SimulatedNetwork::deliveryLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    if (in_flight_.empty()) {
+      cv_.wait(lock);
+      continue;
+    }
+    const auto arrival = in_flight_.top().arrival;
+    if (Clock::now() < arrival) {
+      // Woken up earlier by a new message, which might arrive before the current top one.
+      cv_.wait_until(lock, arrival);
+      continue;
+    }
+    auto delivery = in_flight_.top();
+    in_flight_.pop();
+    auto it = receivers_.find(delivery.to);
+    if (it == receivers_.cend()) {
+      ++stats_.dropped;
+      continue;
+    }
+    auto receiver = it->second;
+    ++stats_.messages;
+    stats_.bytes += delivery.msg->size();
+    // Senders aren't blocked while a receiver is handling a message.
+    delivering_to_ = delivery.to;
+    lock.unlock();
+    receiver->onNewMessage(delivery.from, reinterpret_cast<const char*>(delivery.msg->data()), delivery.msg->size());
+    lock.lock();
+    delivering_to_.reset();
+    delivered_cv_.notify_all();
+  }
+}
+
+int SimulatedCommunication::Start() {
+  if (running_) return 0;
+  network_.attach(node_, receiver_);
+  running_ = true;
+  return 0;
+}
+
+int SimulatedCommunication::Stop() {
+  if (!running_) return 0;
+  network_.detach(node_);
+  running_ = false;
+  return 0;
+}
+
+int SimulatedCommunication::send(NodeNum destNode, std::vector<uint8_t>&& msg) {
+  if (!running_) return -1;
+  network_.send(node_, destNode, std::make_shared<const std::vector<uint8_t>>(std::move(msg)));
+  return 0;
+}
+
+std::set<NodeNum> SimulatedCommunication::send(std::set<NodeNum> dests, std::vector<uint8_t>&& msg) {
+  if (!running_) return dests;
+  // All the destinations share the same buffer
+  auto shared_msg = std::make_shared<const std::vector<uint8_t>>(std::move(msg));
+  for (auto dest : dests) {
+    network_.send(node_, dest, shared_msg);
+  }
+  return std::set<NodeNum>{};
+}
+
+}  // namespace concord::clusterbench
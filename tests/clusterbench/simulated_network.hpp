@@ -0,0 +1,146 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "communication/ICommunication.hpp"
+
+namespace concord::clusterbench {
+
+using bft::communication::NodeNum;
+
+// The characteristics of every point-to-point link of the simulated network.
+struct LinkConfig {
+  // One-way propagation delay.
+  std::chrono::microseconds latency{0};
+  // Transmission rate of a link in bytes per second. 0 means unlimited.
+  uint64_t bandwidth = 0;
+};
+
+// An in-memory network connecting the nodes of the benchmark.
+//
+// Each ordered pair of nodes is connected by a link with the configured latency and bandwidth. A message waits for
+// the messages sent before it on the same link to be transmitted, takes size / bandwidth to be transmitted and
+// arrives `latency` after that. A single thread delivers the messages in order of arrival time, hence receivers must
+// not block in onNewMessage() - which the replicas and the bft client don't.
+class SimulatedNetwork {
+ public:
+  struct Stats {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;
+  };
+
+  SimulatedNetwork(const LinkConfig& link) : link_{link} {}
+  ~SimulatedNetwork() { stop(); }
+
+  SimulatedNetwork(const SimulatedNetwork&) = delete;
+  SimulatedNetwork& operator=(const SimulatedNetwork&) = delete;
+
+  void start();
+  // Stop the delivery thread. Messages that haven't arrived yet are dropped.
+  void stop();
+
+  // Return an ICommunication for `node`. Its receiver is attached when the owner calls setReceiver().
+  std::unique_ptr<bft::communication::ICommunication> endpoint(NodeNum node);
+
+  // Deliver the messages sent to `node` to `receiver`. Messages to nodes without a receiver are dropped.
+  void attach(NodeNum node, bft::communication::IReceiver* receiver);
+  // Wait for a delivery to `node` in progress, if any, so that its receiver can be destroyed once detached.
+  void detach(NodeNum node);
+
+  void send(NodeNum from, NodeNum to, std::shared_ptr<const std::vector<uint8_t>> msg);
+
+  Stats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Delivery {
+    Clock::time_point arrival;
+    // Breaks ties between messages that arrive at the same time so that messages of a link are never reordered.
+    uint64_t seq;
+    NodeNum from;
+    NodeNum to;
+    std::shared_ptr<const std::vector<uint8_t>> msg;
+
+    bool operator>(const Delivery& other) const { return std::tie(arrival, seq) > std::tie(other.arrival, other.seq); }
+  };
+
+  void deliveryLoop();
+
+  const LinkConfig link_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::priority_queue<Delivery, std::vector<Delivery>, std::greater<Delivery>> in_flight_;
+  // The time at which each link is done transmitting the messages sent on it so far.
+  std::map<std::pair<NodeNum, NodeNum>, Clock::time_point> link_busy_until_;
+  std::map<NodeNum, bft::communication::IReceiver*> receivers_;
+  // The node whose receiver is being called by the delivery thread.
+  std::optional<NodeNum> delivering_to_;
+  std::condition_variable delivered_cv_;
+  uint64_t next_seq_ = 0;
+  Stats stats_;
+  bool stopped_ = true;
+  std::thread delivery_thread_;
+};
+
+// The ICommunication of a node connected to a SimulatedNetwork. The network must outlive it.
+class SimulatedCommunication : public bft::communication::ICommunication {
+ public:
+  SimulatedCommunication(SimulatedNetwork& network, NodeNum node) : network_{network}, node_{node} {}
+  ~SimulatedCommunication() override { Stop(); }
+
+  int getMaxMessageSize() override { return kMaxMessageSize; }
+  int Start() override;
+  int Stop() override;
+  bool isRunning() const override { return running_; }
+  bft::communication::ConnectionStatus getCurrentConnectionStatus(NodeNum node) override {
+    return bft::communication::ConnectionStatus::Connected;
+  }
+
+  int send(NodeNum destNode, std::vector<uint8_t>&& msg) override;
+  std::set<NodeNum> send(std::set<NodeNum> dests, std::vector<uint8_t>&& msg) override;
+
+  void setReceiver(NodeNum receiverNum, bft::communication::IReceiver* receiver) override { receiver_ = receiver; }
+
+  static constexpr int kMaxMessageSize = 1024 * 1024;
+
+ private:
+  SimulatedNetwork& network_;
+  const NodeNum node_;
+  bft::communication::IReceiver* receiver_ = nullptr;
+  std::atomic_bool running_{false};
+};
+
+}  // namespace concord::clusterbench
@@ -0,0 +1,129 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "socket_communication.hpp"
+#include "simulated_network.hpp"
+
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+
+namespace concord::clusterbench {
+
+using bft::communication::ConnectionStatus;
+
+namespace {
+
+constexpr size_t kFrameHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+bool sendAll(int fd, const uint8_t* data, size_t size) {
+  while (size > 0) {
+    // Don't raise SIGPIPE if the other side is gone
+    auto sent = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+bool recvAll(int fd, uint8_t* data, size_t size) {
+  while (size > 0) {
+    auto received = ::recv(fd, data, size, 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received <= 0) return false;
+    data += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+}  // namespace
+
+bool writeFrame(int fd, NodeNum node, const uint8_t* data, uint32_t size) {
+  uint8_t header[kFrameHeaderSize];
+  const uint64_t node64 = node;
+  std::memcpy(header, &node64, sizeof(node64));
+  std::memcpy(header + sizeof(node64), &size, sizeof(size));
+  return sendAll(fd, header, sizeof(header)) && sendAll(fd, data, size);
+}
+
+bool readFrame(int fd, NodeNum& node, std::vector<uint8_t>& data) {
+  uint8_t header[kFrameHeaderSize];
+  if (!recvAll(fd, header, sizeof(header))) return false;
+  uint64_t node64 = 0;
+  uint32_t size = 0;
+  std::memcpy(&node64, header, sizeof(node64));
+  std::memcpy(&size, header + sizeof(node64), sizeof(size));
+  node = node64;
+  data.resize(size);
+  return recvAll(fd, data.data(), size);
+}
+
+int SocketCommunication::getMaxMessageSize() { return SimulatedCommunication::kMaxMessageSize; }
+
+int SocketCommunication::Start() {
+  if (running_) return 0;
+  running_ = true;
+  reader_ = std::thread([this]() { readLoop(); });
+  return 0;
+}
+
+int SocketCommunication::Stop() {
+  if (!running_) return 0;
+  running_ = false;
+  // Unblock the reader
+  ::shutdown(fd_, SHUT_RDWR);
+  reader_.join();
+  return 0;
+}
+
+ConnectionStatus SocketCommunication::getCurrentConnectionStatus(NodeNum node) {
+  std::lock_guard<std::mutex> lock(disconnect_mutex_);
+  return disconnected_ ? ConnectionStatus::Disconnected : ConnectionStatus::Connected;
+}
+
+int SocketCommunication::send(NodeNum destNode, std::vector<uint8_t>&& msg) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  return writeFrame(fd_, destNode, msg.data(), msg.size()) ? 0 : -1;
+}
+
+std::set<NodeNum> SocketCommunication::send(std::set<NodeNum> dests, std::vector<uint8_t>&& msg) {
+  auto failed = std::set<NodeNum>{};
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  for (auto dest : dests) {
+    if (!writeFrame(fd_, dest, msg.data(), msg.size())) failed.insert(dest);
+  }
+  return failed;
+}
+
+void SocketCommunication::waitForDisconnect() {
+  std::unique_lock<std::mutex> lock(disconnect_mutex_);
+  disconnect_cv_.wait(lock, [this]() { return disconnected_; });
+}
+
+void SocketCommunication::readLoop() {
+  auto from = NodeNum{0};
+  auto msg = std::vector<uint8_t>{};
+  while (readFrame(fd_, from, msg)) {
+    receiver_->onNewMessage(from, reinterpret_cast<const char*>(msg.data()), msg.size());
+  }
+  {
+    std::lock_guard<std::mutex> lock(disconnect_mutex_);
+    disconnected_ = true;
+  }
+  disconnect_cv_.notify_all();
+}
+
+}  // namespace concord::clusterbench
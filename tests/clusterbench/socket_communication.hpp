@@ -0,0 +1,72 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "communication/ICommunication.hpp"
+
+namespace concord::clusterbench {
+
+using bft::communication::NodeNum;
+
+// Messages are exchanged over a connected stream socket as frames of a node number, a size and the message bytes.
+// The node is the destination of frames written by a replica process and the source of frames read by it.
+//
+// Return false if the socket is closed.
+bool writeFrame(int fd, NodeNum node, const uint8_t* data, uint32_t size);
+bool readFrame(int fd, NodeNum& node, std::vector<uint8_t>& data);
+
+// The ICommunication of a replica process. All its messages go through the socket connected to the benchmark process,
+// which routes them over the simulated network.
+class SocketCommunication : public bft::communication::ICommunication {
+ public:
+  SocketCommunication(int fd) : fd_{fd} {}
+  ~SocketCommunication() override { Stop(); }
+
+  int getMaxMessageSize() override;
+  int Start() override;
+  int Stop() override;
+  bool isRunning() const override { return running_; }
+  bft::communication::ConnectionStatus getCurrentConnectionStatus(NodeNum node) override;
+
+  int send(NodeNum destNode, std::vector<uint8_t>&& msg) override;
+  std::set<NodeNum> send(std::set<NodeNum> dests, std::vector<uint8_t>&& msg) override;
+
+  void setReceiver(NodeNum receiverNum, bft::communication::IReceiver* receiver) override { receiver_ = receiver; }
+
+  // Block until the benchmark process closes its end of the socket.
+  void waitForDisconnect();
+
+ private:
+  void readLoop();
+
+  const int fd_;
+  bft::communication::IReceiver* receiver_ = nullptr;
+  std::atomic_bool running_{false};
+  std::thread reader_;
+  std::mutex write_mutex_;
+
+  std::mutex disconnect_mutex_;
+  std::condition_variable disconnect_cv_;
+  bool disconnected_ = false;
+};
+
+}  // namespace concord::clusterbench
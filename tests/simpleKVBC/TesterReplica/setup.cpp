@@ -87,11 +87,13 @@ std::unique_ptr<TestSetup> TestSetup::ParseArgs(int argc, char** argv) {
                                           {"principals-mapping", optional_argument, 0, 'p'},
                                           {"txn-signing-key-path", optional_argument, 0, 't'},
                                           {"operator-public-key-path", optional_argument, 0, 'o'},
+                                          {"preprepare-with-request-digests-only", no_argument, 0, 'd'},
+                                          {"no-client-requests-dissemination", no_argument, 0, 'g'},
                                           {0, 0, 0, 0}};
     int o = 0;
     int optionIndex = 0;
     LOG_INFO(GL, "Command line options:");
-    while ((o = getopt_long(argc, argv, "i:k:n:s:v:a:3:l:e:c:b:m:q:z:y:u:p:t:o:", longOptions, &optionIndex)) != -1) {
+    while ((o = getopt_long(argc, argv, "i:k:n:s:v:a:3:l:e:c:b:m:q:z:y:u:p:t:o:dg", longOptions, &optionIndex)) != -1) {
       switch (o) {
         case 'i': {
           replicaConfig.replicaId = concord::util::to<std::uint16_t>(std::string(optarg));
@@ -173,6 +175,14 @@ std::unique_ptr<TestSetup> TestSetup::ParseArgs(int argc, char** argv) {
           replicaConfig.pathToOperatorPublicKey_ = optarg;
           break;
         }
+        case 'd': {
+          replicaConfig.prePrepareWithRequestDigestsOnly = true;
+          break;
+        }
+        case 'g': {
+          replicaConfig.disseminateClientRequests = false;
+          break;
+        }
         case '?': {
           throw std::runtime_error("invalid arguments");
         } break;
@@ -260,11 +270,16 @@ concord::storage::s3::StoreConfig TestSetup::ParseS3Config(const std::string& s3
   } catch (std::runtime_error& e) {
     config.pathPrefix = std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
   }
+  try {
+    config.maxConcurrentRequests = std::stoul(get_config_value("s3-max-concurrent-requests"));
+  } catch (std::runtime_error& e) {
+    // use the default
+  }
 
   LOG_INFO(logger_,
            "\nS3 Configuration:"
                << "\nbucket:\t\t" << config.bucketName << "\nprotocol:\t" << config.protocol << "\nurl:\t\t"
-               << config.url);
+               << config.url << "\nmax concurrent requests:\t" << config.maxConcurrentRequests);
   return config;
 }
 #endif
@@ -0,0 +1,151 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#ifndef CONCORD_THIN_REPLICA_BLOCK_READ_AHEAD_HPP_
+#define CONCORD_THIN_REPLICA_BLOCK_READ_AHEAD_HPP_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "assertUtils.hpp"
+#include "kv_types.hpp"
+
+namespace concord {
+namespace thin_replica {
+
+// Reads the blocks of the range [start, end] with several reader threads in
+// parallel and hands them out in block order. A block that is read out of
+// order waits in a reorder buffer until the blocks before it are consumed.
+// Readers don't start a block that is `max_blocks` or more ahead of the next
+// block to consume. Hence, at most `max_blocks` read blocks are held in memory.
+// We expect a single consumer.
+template <typename T>
+class BlockReadAhead {
+ public:
+  using ReadFunc = std::function<T(kvbc::BlockId)>;
+
+  BlockReadAhead(kvbc::BlockId start, kvbc::BlockId end, size_t num_readers, size_t max_blocks, ReadFunc read)
+      : end_(end),
+        max_blocks_(max_blocks),
+        read_block_(std::move(read)),
+        next_to_read_(start),
+        next_to_consume_(start) {
+    ConcordAssertGT(num_readers, 0);
+    ConcordAssertGT(max_blocks, 0);
+    for (size_t i = 0; i < num_readers; ++i) {
+      readers_.emplace_back([this]() { readLoop(); });
+    }
+  }
+
+  BlockReadAhead(const BlockReadAhead&) = delete;
+  BlockReadAhead& operator=(const BlockReadAhead&) = delete;
+
+  // Stops the readers. Blocks that were read but not consumed are dropped.
+  ~BlockReadAhead() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    readers_cv_.notify_all();
+    for (auto& reader : readers_) {
+      reader.join();
+    }
+  }
+
+  // Return the next block in order (block if it wasn't read yet) or
+  // std::nullopt after the last block of the range. If reading a block failed
+  // then the exception is rethrown once the blocks before it are consumed.
+  std::optional<std::pair<kvbc::BlockId, T>> next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (next_to_consume_ > end_) {
+      return std::nullopt;
+    }
+    consumer_cv_.wait(lock, [this]() {
+      return reorder_buffer_.count(next_to_consume_) || failedBefore(next_to_consume_ + 1);
+    });
+    if (failedBefore(next_to_consume_ + 1)) {
+      std::rethrow_exception(error_);
+    }
+    auto it = reorder_buffer_.find(next_to_consume_);
+    auto block = std::make_optional(std::make_pair(it->first, std::move(it->second)));
+    reorder_buffer_.erase(it);
+    ++next_to_consume_;
+    lock.unlock();
+    readers_cv_.notify_all();
+    return block;
+  }
+
+ private:
+  void readLoop() {
+    while (true) {
+      kvbc::BlockId block_id;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        readers_cv_.wait(lock, [this]() {
+          return stopped_ || done() || next_to_read_ < next_to_consume_ + max_blocks_;
+        });
+        if (stopped_ || done()) {
+          return;
+        }
+        block_id = next_to_read_++;
+      }
+
+      try {
+        auto block = read_block_(block_id);
+        std::lock_guard<std::mutex> lock(mutex_);
+        reorder_buffer_.emplace(block_id, std::move(block));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Keep the error of the lowest block as blocks are consumed in order
+        if (!error_ || block_id < error_block_id_) {
+          error_ = std::current_exception();
+          error_block_id_ = block_id;
+        }
+      }
+      consumer_cv_.notify_one();
+    }
+  }
+
+  // Nothing left to read, either due to the end of the range or an error
+  bool done() const { return next_to_read_ > end_ || error_; }
+
+  bool failedBefore(kvbc::BlockId block_id) const { return error_ && error_block_id_ < block_id; }
+
+  const kvbc::BlockId end_;
+  const size_t max_blocks_;
+  const ReadFunc read_block_;
+
+  std::mutex mutex_;
+  // Readers wait for room in the reorder buffer, the consumer for the next block
+  std::condition_variable readers_cv_;
+  std::condition_variable consumer_cv_;
+  kvbc::BlockId next_to_read_;
+  kvbc::BlockId next_to_consume_;
+  std::map<kvbc::BlockId, T> reorder_buffer_;
+  std::exception_ptr error_;
+  kvbc::BlockId error_block_id_{0};
+  bool stopped_{false};
+
+  std::vector<std::thread> readers_;
+};
+
+}  // namespace thin_replica
+}  // namespace concord
+
+#endif  // CONCORD_THIN_REPLICA_BLOCK_READ_AHEAD_HPP_
@@ -15,16 +15,26 @@
 #define CONCORD_THIN_REPLICA_SUBSCRIPTION_BUFFER_HPP_
 
 #include <categorization/updates.h>
+#include <algorithm>
 #include <boost/lockfree/spsc_queue.hpp>
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <tuple>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 #include "Logger.hpp"
 #include "assertUtils.hpp"
 #include "block_update/block_update.hpp"
 #include "kv_types.hpp"
+#include "kvbc_app_filter/kvbc_app_filter.h"
 
 namespace concord {
 namespace thin_replica {
@@ -36,15 +46,54 @@ class ConsumerTooSlow : public std::runtime_error {
 
 typedef kvbc::BlockUpdate SubUpdate;
 
+// A live update filtered for one (client id, key prefix) filter. It is computed
+// once per block and filter and shared by all the subscribers with that filter.
+// Hence, it is immutable once created.
+class FilteredSubUpdate {
+ public:
+  FilteredSubUpdate(kvbc::KvbFilteredUpdate&& update,
+                    const std::optional<std::string>& parent_span,
+                    std::shared_ptr<kvbc::KvbAppFilter> filter)
+      : update_(std::move(update)), parent_span_(parent_span), filter_(std::move(filter)) {}
+
+  kvbc::BlockId blockId() const { return update_.block_id; }
+  const kvbc::KvbFilteredUpdate& update() const { return update_; }
+  const std::optional<std::string>& parentSpan() const { return parent_span_; }
+
+  // Only hash streams need the hash. It is computed by the first subscriber
+  // asking for it.
+  const std::string& hash() const {
+    std::call_once(hash_computed_, [this]() { hash_ = filter_->hashUpdate(update_); });
+    return hash_;
+  }
+
+ private:
+  const kvbc::KvbFilteredUpdate update_;
+  const std::optional<std::string> parent_span_;
+  const std::shared_ptr<kvbc::KvbAppFilter> filter_;
+  mutable std::once_flag hash_computed_;
+  mutable std::string hash_;
+};
+
+typedef std::shared_ptr<const FilteredSubUpdate> FilteredSubUpdatePtr;
+
 // Each subscriber creates its own spsc queue and puts it into the shared list
 // of subscriber buffers. This is a thread-safe implementation around boost's
 // spsc queue in order to use an additional wake-up mechanism. We expect a
 // single producer (the commands handler) and a single consumer (the subscriber
 // thread in the thin replica gRPC service).
+// The updates in the queue are already filtered for the subscriber's client id
+// and key prefix.
 class SubUpdateBuffer {
  public:
-  explicit SubUpdateBuffer(size_t size)
+  // Live updates extend the state hash computations in the given index, if any
+  explicit SubUpdateBuffer(size_t size,
+                           const std::string& client_id = "",
+                           const std::string& key_prefix = "",
+                           kvbc::KvbStateHashIndex* state_hash_index = nullptr)
       : logger_(logging::getLogger("concord.thin_replica.sub_buffer")),
+        // Filtering live updates doesn't read from storage
+        filter_(std::make_shared<kvbc::KvbAppFilter>(nullptr, client_id, key_prefix, state_hash_index)),
         queue_(size),
         too_slow_(false),
         newest_block_id_(0) {}
@@ -53,10 +102,18 @@ class SubUpdateBuffer {
   SubUpdateBuffer(const SubUpdateBuffer&) = delete;
   SubUpdateBuffer& operator=(const SubUpdateBuffer&) = delete;
 
-  // Add an update to the queue and notify waiting subscribers
+  const std::shared_ptr<kvbc::KvbAppFilter>& filter() const { return filter_; }
+
+  // Filter the update for this subscriber only and add it to the queue
   void Push(const SubUpdate& update) {
+    Push(std::make_shared<const FilteredSubUpdate>(filter_->filterUpdate(update), update.parent_span, filter_));
+  }
+
+  // Add an update to the queue and notify waiting subscribers
+  void Push(const FilteredSubUpdatePtr& update) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
+      if (error_) return;
       if (!too_slow_ && !queue_.push(update)) {
         // If we fail to push a new update (because the queue is full) we
         // indicate that this queue is unusable and the reader should clean-up.
@@ -65,17 +122,31 @@ class SubUpdateBuffer {
         too_slow_ = true;
         LOG_WARN(logger_, "Failed to add update. Consumer too slow.");
       } else {
-        newest_block_id_ = update.block_id;
+        newest_block_id_ = update->blockId();
       }
     }
     cv_.notify_one();
   };
 
+  // Stop adding updates, e.g. because one couldn't be filtered. The consumer
+  // gets the error instead of the next update and should clean-up.
+  void Fail(std::exception_ptr error) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!error_) error_ = error;
+    }
+    cv_.notify_one();
+  }
+
   // Return the oldest update (block if queue is empty)
-  void Pop(SubUpdate& out) {
+  void Pop(FilteredSubUpdatePtr& out) {
     std::unique_lock<std::mutex> lock(mutex_);
     // Boost's spsc queue is wait-free but we want to block here
-    cv_.wait(lock, [this] { return too_slow_ || queue_.read_available(); });
+    cv_.wait(lock, [this] { return error_ || too_slow_ || queue_.read_available(); });
+
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
 
     if (too_slow_) {
       // We throw an exception because we cannot handle the clean-up ourselves
@@ -86,15 +157,23 @@ class SubUpdateBuffer {
     ConcordAssert(queue_.pop(out));
   };
 
+  // Throw the error passed to Fail() if there is one
   void waitUntilNonEmpty() {
     std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return queue_.read_available(); });
+    cv_.wait(lock, [this] { return error_ || queue_.read_available(); });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
   }
 
   template <typename RepT, typename PeriodT>
   [[nodiscard]] bool waitUntilNonEmpty(const std::chrono::duration<RepT, PeriodT>& duration) {
     std::unique_lock<std::mutex> lock(mutex_);
-    return cv_.wait_for(lock, duration, [this] { return queue_.read_available(); });
+    const auto non_empty = cv_.wait_for(lock, duration, [this] { return error_ || queue_.read_available(); });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return non_empty;
   }
 
   // This is not thread-safe and the caller has to make sure that there is no
@@ -119,7 +198,7 @@ class SubUpdateBuffer {
     std::unique_lock<std::mutex> lock(mutex_);
     // Undefined behavior if the queue is empty
     ConcordAssertGT(queue_.read_available(), 0);
-    return queue_.front().block_id;
+    return queue_.front()->blockId();
   }
 
   bool Empty() {
@@ -140,13 +219,16 @@ class SubUpdateBuffer {
 
  private:
   logging::Logger logger_;
-  boost::lockfree::spsc_queue<SubUpdate> queue_;
+  const std::shared_ptr<kvbc::KvbAppFilter> filter_;
+  boost::lockfree::spsc_queue<FilteredSubUpdatePtr> queue_;
   // lock used for updating the queue as well as the variables below
   std::mutex mutex_;
   std::condition_variable cv_;
 
   // Indidcate whether the consumer doesn't read fast enough
   bool too_slow_;
+  // Set by Fail()
+  std::exception_ptr error_;
   // Workaround variable (see Push() and newestBlockId())
   uint64_t newest_block_id_;
 };
@@ -155,6 +237,8 @@ class SubUpdateBuffer {
 // think of this list as the list of subscribers whereby each subscriber is
 // represented by its spsc queue. The presence or absence of a buffer determines
 // whether a subscriber is subscribed or unsubscribed respectively.
+// Subscribers are grouped by their (client id, key prefix) filter so that a
+// live update is filtered once per group rather than once per subscriber.
 class SubBufferList {
  public:
   SubBufferList() {}
@@ -167,6 +251,9 @@ class SubBufferList {
   virtual bool addBuffer(std::shared_ptr<SubUpdateBuffer> elem) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto success = subscriber_.insert(elem).second;
+    if (success) {
+      groups_[filterKey(*elem)].push_back(elem);
+    }
     return success;
   }
 
@@ -175,16 +262,44 @@ class SubBufferList {
     std::lock_guard<std::mutex> lock(mutex_);
     // If the assert fires then there is a logic error somewhere
     ConcordAssert(subscriber_.erase(elem) == 1);
+    auto group = groups_.find(filterKey(*elem));
+    ConcordAssert(group != groups_.end());
+    auto& members = group->second;
+    members.erase(std::find(members.begin(), members.end(), elem));
+    if (members.empty()) {
+      groups_.erase(group);
+    }
   }
 
   // Populate updates to all subscribers
-  // Note: This is potentially expensive depending on the update size and the
-  // number of subscribers. If TRC/TRS stays then we might want to think about
-  // an optimization.
+  // The update is filtered once per group of subscribers with the same filter
+  // and each value is decoded at most once. The subscribers of a group share
+  // the filtered update. If the update can't be filtered for a group, the
+  // subscriptions of that group are failed; the caller (adding blocks) and the
+  // other groups are not affected.
+  // The filtered update also extends the group's state hash computations.
   virtual void updateSubBuffers(SubUpdate& update) {
     std::lock_guard<std::mutex> lock(mutex_);
-    for (const auto& it : subscriber_) {
-      it->Push(update);
+    kvbc::KvbDecodedValues decoded;
+    for (const auto& [key, members] : groups_) {
+      const auto& filter = members.front()->filter();
+      FilteredSubUpdatePtr filtered_update;
+      try {
+        filtered_update = std::make_shared<const FilteredSubUpdate>(
+            filter->filterUpdate(update, decoded), update.parent_span, filter);
+      } catch (const std::exception& e) {
+        LOG_ERROR(logger_,
+                  "Closing " << members.size() << " subscriptions of client " << key.first << ", block "
+                             << update.block_id << " can't be filtered: " << e.what());
+        for (const auto& it : members) {
+          it->Fail(std::current_exception());
+        }
+        continue;
+      }
+      for (const auto& it : members) {
+        it->Push(filtered_update);
+      }
+      filter->extendStateHash(update.block_id, [&filtered_update]() { return filtered_update->hash(); });
     }
   }
 
@@ -196,7 +311,15 @@ class SubBufferList {
   virtual ~SubBufferList() = default;
 
  protected:
+  // (client id, key prefix)
+  using FilterKey = std::pair<std::string, std::string>;
+  static FilterKey filterKey(const SubUpdateBuffer& buffer) {
+    return {buffer.filter()->clientId(), buffer.filter()->keyPrefix()};
+  }
+
+  logging::Logger logger_ = logging::getLogger("concord.thin_replica.sub_buffer");
   std::unordered_set<std::shared_ptr<SubUpdateBuffer>> subscriber_;
+  std::map<FilterKey, std::vector<std::shared_ptr<SubUpdateBuffer>>> groups_;
   std::mutex mutex_;
 };
 
@@ -34,6 +34,7 @@
 #include "kvbc_app_filter/kvbc_key_types.h"
 
 #include "thin_replica.grpc.pb.h"
+#include "block_read_ahead.hpp"
 #include "subscription_buffer.hpp"
 #include "trs_metrics.hpp"
 
@@ -59,17 +60,44 @@ struct ThinReplicaServerConfig {
   // the set of client IDs known to the TRS, used to authorize prospective
   // clients.
   std::unordered_set<std::string> client_id_set;
+  // the number of threads that read and filter blocks from storage in
+  // parallel when a subscriber reads the state or catches up with the live
+  // updates.
+  const size_t sync_read_threads;
+  // the maximum number of blocks read ahead of the ones sent to a subscriber
+  // i.e. it bounds the memory used per syncing subscriber.
+  const size_t sync_read_ahead_blocks;
+  // the state hash computation of each filter is checkpointed every this
+  // many blocks so that subsequent state hash requests only read the blocks
+  // after the nearest checkpoint.
+  const kvbc::BlockId state_hash_checkpoint_interval;
+  // the maximum number of filters (client ID and key prefix) for which state
+  // hash checkpoints are kept.
+  const size_t state_hash_max_filters;
+  // the maximum number of state hash checkpoints kept per filter (the latest
+  // ones).
+  const size_t state_hash_max_checkpoints_per_filter;
 
   ThinReplicaServerConfig(const bool is_insecure_trs_,
                           const std::string& tls_trs_cert_path_,
                           const concord::kvbc::IReader* rostorage_,
                           SubBufferList& subscriber_list_,
-                          std::unordered_set<std::string>& client_id_set_)
+                          std::unordered_set<std::string>& client_id_set_,
+                          const size_t sync_read_threads_ = 4,
+                          const size_t sync_read_ahead_blocks_ = 64,
+                          const kvbc::BlockId state_hash_checkpoint_interval_ = 1000,
+                          const size_t state_hash_max_filters_ = 1000,
+                          const size_t state_hash_max_checkpoints_per_filter_ = 100)
       : is_insecure_trs(is_insecure_trs_),
         tls_trs_cert_path(tls_trs_cert_path_),
         rostorage(rostorage_),
         subscriber_list(subscriber_list_),
-        client_id_set(client_id_set_) {}
+        client_id_set(client_id_set_),
+        sync_read_threads(sync_read_threads_),
+        sync_read_ahead_blocks(sync_read_ahead_blocks_),
+        state_hash_checkpoint_interval(state_hash_checkpoint_interval_),
+        state_hash_max_filters(state_hash_max_filters_),
+        state_hash_max_checkpoints_per_filter(state_hash_max_checkpoints_per_filter_) {}
 };
 
 class ThinReplicaImpl {
@@ -89,7 +117,12 @@ class ThinReplicaImpl {
 
  public:
   ThinReplicaImpl(std::unique_ptr<ThinReplicaServerConfig> config, std::unique_ptr<ThinReplicaServerMetrics> metrics)
-      : logger_(logging::getLogger("concord.thin_replica")), config_(std::move(config)), metrics_(std::move(metrics)) {}
+      : logger_(logging::getLogger("concord.thin_replica")),
+        config_(std::move(config)),
+        metrics_(std::move(metrics)),
+        state_hash_index_(config_->state_hash_checkpoint_interval,
+                          config_->state_hash_max_filters,
+                          config_->state_hash_max_checkpoints_per_filter) {}
 
   ThinReplicaImpl(const ThinReplicaImpl&) = delete;
   ThinReplicaImpl(ThinReplicaImpl&&) = delete;
@@ -192,7 +225,7 @@ class ThinReplicaImpl {
       return kvb_status;
     }
 
-    auto [subscribe_status, live_updates] = subscribeToLiveUpdates(request);
+    auto [subscribe_status, live_updates] = subscribeToLiveUpdates(request, kvb_filter);
     if (!subscribe_status.ok()) {
       return subscribe_status;
     }
@@ -218,24 +251,24 @@ class ThinReplicaImpl {
       return grpc::Status(grpc::StatusCode::UNKNOWN, msg.str());
     }
 
-    // Read, filter, and send live updates
-    SubUpdate update;
+    // Send live updates, the buffer holds them filtered already
+    FilteredSubUpdatePtr update;
     while (!context->IsCancelled()) {
       metrics_->setLiveUpdateQueueSize(stream_type, getClientId(context), live_updates->Size());
       try {
         live_updates->Pop(update);
-      } catch (concord::thin_replica::ConsumerTooSlow& error) {
+      } catch (std::exception& error) {
+        // The consumer is too slow or an update couldn't be filtered
         LOG_WARN(logger_, "Closing subscription: " << error.what());
         break;
       }
-      auto kvb_update = kvbc::KvbUpdate{update.block_id, update.correlation_id, std::move(update.immutable_kv_pairs)};
-      const auto& filtered_update = kvb_filter->filterUpdate(kvb_update);
+      const auto& filtered_update = update->update();
       try {
         if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
           LOG_DEBUG(logger_, "Live updates send data");
           auto correlation_id = filtered_update.correlation_id;
-          if (update.parent_span) {
-            sendData(stream, filtered_update, {*update.parent_span});
+          if (update->parentSpan()) {
+            sendData(stream, filtered_update, {*update->parentSpan()});
           } else {
             auto span = opentracing::Tracer::Global()->StartSpan(
                 "trs_stream_update", {opentracing::SetTag{kCorrelationIdTag, correlation_id}});
@@ -247,13 +280,13 @@ class ThinReplicaImpl {
           }
         } else if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Hash>()) {
           LOG_DEBUG(logger_, "Live updates send hash");
-          sendHash(stream, update.block_id, kvb_filter->hashUpdate(filtered_update));
+          sendHash(stream, update->blockId(), update->hash());
         }
       } catch (std::exception& error) {
         LOG_INFO(logger_, "Subscription stream closed: " << error.what());
         break;
       }
-      metrics_->setLastSentBlockId(stream_type, getClientId(context), update.block_id);
+      metrics_->setLastSentBlockId(stream_type, getClientId(context), update->blockId());
     }
     config_->subscriber_list.removeBuffer(live_updates);
     live_updates->removeAllUpdates();
@@ -366,46 +399,27 @@ class ThinReplicaImpl {
                               kvbc::BlockId start,
                               kvbc::BlockId end,
                               std::shared_ptr<kvbc::KvbAppFilter> kvb_filter) {
-    using namespace std::chrono_literals;
-    boost::lockfree::spsc_queue<kvbc::KvbFilteredUpdate> queue{10};
-    std::atomic_bool close_stream = false;
-
-    auto kvb_reader = std::async(std::launch::async,
-                                 &kvbc::KvbAppFilter::readBlockRange,
-                                 kvb_filter,
-                                 start,
-                                 end,
-                                 std::ref(queue),
-                                 std::ref(close_stream));
-
-    kvbc::KvbFilteredUpdate kvb_update;
-    while (kvb_reader.wait_for(0s) != std::future_status::ready || !queue.empty()) {
+    if (start > end || end > config_->rostorage->getLastBlockId()) {
+      throw kvbc::InvalidBlockRange(start, end);
+    }
+    LOG_DEBUG(logger, "readFromKvbAndSendData block " << start << " to " << end);
+
+    // Readers are stopped when leaving the scope, also if sending fails
+    BlockReadAhead<kvbc::KvbFilteredUpdate> read_ahead{
+        start, end, config_->sync_read_threads, config_->sync_read_ahead_blocks, [kvb_filter](kvbc::BlockId block_id) {
+          return kvb_filter->readBlock(block_id);
+        }};
+    while (auto block = read_ahead.next()) {
       if (context->IsCancelled()) {
-        close_stream = true;
-        while (!queue.empty()) {
-          queue.pop(kvb_update);
-        }
         throw StreamCancelled("Kvb data stream cancelled");
       }
-      while (queue.pop(kvb_update)) {
-        try {
-          sendData(stream, kvb_update);
-        } catch (StreamClosed& error) {
-          LOG_WARN(logger, "Data stream closed at block " << kvb_update.block_id);
-
-          // Stop kvb_reader and empty queue
-          close_stream = true;
-          while (!queue.empty()) {
-            queue.pop(kvb_update);
-          }
-          throw;
-        }
+      try {
+        sendData(stream, block->second);
+      } catch (StreamClosed& error) {
+        LOG_WARN(logger, "Data stream closed at block " << block->first);
+        throw;
       }
     }
-    ConcordAssert(queue.empty());
-
-    // Throws exception if something goes wrong
-    kvb_reader.get();
   }
 
   template <typename ServerContextT, typename ServerWriterT>
@@ -415,12 +429,15 @@ class ThinReplicaImpl {
                                 kvbc::BlockId start,
                                 kvbc::BlockId end,
                                 std::shared_ptr<kvbc::KvbAppFilter> kvb_filter) {
-    for (auto block_id = start; block_id <= end; ++block_id) {
+    BlockReadAhead<std::string> read_ahead{
+        start, end, config_->sync_read_threads, config_->sync_read_ahead_blocks, [kvb_filter](kvbc::BlockId block_id) {
+          return kvb_filter->readBlockHash(block_id);
+        }};
+    while (auto block = read_ahead.next()) {
       if (context->IsCancelled()) {
         throw StreamCancelled("Kvb hash stream cancelled");
       }
-      std::string hash = kvb_filter->readBlockHash(block_id);
-      sendHash(stream, block_id, hash);
+      sendHash(stream, block->first, block->second);
     }
   }
 
@@ -487,11 +504,11 @@ class ThinReplicaImpl {
     // If we read updates from KVB that were added to the live updates already
     // then we just need to drop the overlap and return
     ConcordAssert(live_updates->oldestBlockId() <= end);
-    SubUpdate update;
+    FilteredSubUpdatePtr update;
     do {
       live_updates->Pop(update);
-      LOG_INFO(logger_, "Sync dropping " << update.block_id);
-    } while (update.block_id < end);
+      LOG_INFO(logger_, "Sync dropping " << update->blockId());
+    } while (update->blockId() < end);
   }
 
   // Send* prepares the response object and puts it on the stream
@@ -570,8 +587,8 @@ class ThinReplicaImpl {
   std::tuple<grpc::Status, KvbAppFilterPtr> createKvbFilter(ServerContextT* context, const RequestT* request) {
     KvbAppFilterPtr kvb_filter;
     try {
-      kvb_filter =
-          std::make_shared<kvbc::KvbAppFilter>(config_->rostorage, getClientId(context), request->key_prefix());
+      kvb_filter = std::make_shared<kvbc::KvbAppFilter>(
+          config_->rostorage, getClientId(context), request->key_prefix(), &state_hash_index_);
     } catch (std::exception& error) {
       std::stringstream msg;
       msg << "Failed to set up filter: " << error.what();
@@ -582,8 +599,10 @@ class ThinReplicaImpl {
   }
 
   template <typename RequestT>
-  std::tuple<grpc::Status, std::shared_ptr<SubUpdateBuffer>> subscribeToLiveUpdates(RequestT* request) {
-    auto live_updates = std::make_shared<SubUpdateBuffer>(kSubUpdateBufferSize);
+  std::tuple<grpc::Status, std::shared_ptr<SubUpdateBuffer>> subscribeToLiveUpdates(
+      RequestT* request, const KvbAppFilterPtr& kvb_filter) {
+    auto live_updates = std::make_shared<SubUpdateBuffer>(
+        kSubUpdateBufferSize, kvb_filter->clientId(), kvb_filter->keyPrefix(), &state_hash_index_);
     bool success = config_->subscriber_list.addBuffer(live_updates);
     if (!success) {
       std::stringstream msg;
@@ -608,6 +627,7 @@ class ThinReplicaImpl {
   logging::Logger logger_;
   std::unique_ptr<ThinReplicaServerConfig> config_;
   std::unique_ptr<ThinReplicaServerMetrics> metrics_;
+  kvbc::KvbStateHashIndex state_hash_index_;
 };
 }  // namespace thin_replica
 }  // namespace concord
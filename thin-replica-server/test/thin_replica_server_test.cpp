@@ -114,6 +114,7 @@ class FakeStorage : public concord::kvbc::IReader {
     ADD_FAILURE() << "multiGetLatestVersion() should not be called by this test";
   }
 
+  using concord::kvbc::IReader::getBlockUpdates;
   std::optional<concord::kvbc::categorization::Updates> getBlockUpdates(BlockId block_id) const override {
     if (block_id >= 0 && block_id <= block_id_) {
       auto data = db_.at(block_id);
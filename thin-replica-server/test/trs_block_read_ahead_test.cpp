@@ -0,0 +1,91 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "thin-replica-server/block_read_ahead.hpp"
+
+namespace {
+
+using concord::kvbc::BlockId;
+using concord::thin_replica::BlockReadAhead;
+using namespace std::chrono_literals;
+
+// Blocks are handed out in order even though later blocks are read faster
+TEST(trs_block_read_ahead_test, blocks_in_order) {
+  BlockReadAhead<BlockId> read_ahead{1, 100, 4, 8, [](BlockId block_id) {
+                                       std::this_thread::sleep_for(std::chrono::microseconds((100 - block_id) * 10));
+                                       return block_id * 2;
+                                     }};
+  BlockId expected = 1;
+  while (auto block = read_ahead.next()) {
+    ASSERT_EQ(block->first, expected);
+    ASSERT_EQ(block->second, expected * 2);
+    ++expected;
+  }
+  ASSERT_EQ(expected, 101);
+  ASSERT_FALSE(read_ahead.next());
+}
+
+// Readers don't get further ahead than the given number of blocks
+TEST(trs_block_read_ahead_test, read_ahead_is_bounded) {
+  std::atomic<BlockId> max_read{0};
+  BlockReadAhead<BlockId> read_ahead{1, 100, 4, 8, [&max_read](BlockId block_id) {
+                                       auto max = max_read.load();
+                                       while (block_id > max && !max_read.compare_exchange_weak(max, block_id)) {
+                                       }
+                                       return block_id;
+                                     }};
+  for (BlockId consumed = 0; consumed < 100; ++consumed) {
+    // Give the readers the chance to run ahead
+    std::this_thread::sleep_for(1ms);
+    ASSERT_LE(max_read, consumed + 8);
+    ASSERT_TRUE(read_ahead.next());
+  }
+  ASSERT_FALSE(read_ahead.next());
+}
+
+// A read error is reported after the blocks before the failed one
+TEST(trs_block_read_ahead_test, error_after_previous_blocks) {
+  BlockReadAhead<BlockId> read_ahead{1, 100, 4, 8, [](BlockId block_id) {
+                                       if (block_id == 10) {
+                                         throw std::runtime_error("read error");
+                                       }
+                                       return block_id;
+                                     }};
+  for (BlockId block_id = 1; block_id < 10; ++block_id) {
+    auto block = read_ahead.next();
+    ASSERT_TRUE(block);
+    ASSERT_EQ(block->first, block_id);
+  }
+  ASSERT_THROW(read_ahead.next(), std::runtime_error);
+}
+
+// Destroying the read-ahead before consuming all the blocks stops the readers
+TEST(trs_block_read_ahead_test, stop_before_end) {
+  std::atomic_size_t num_read{0};
+  {
+    BlockReadAhead<BlockId> read_ahead{1, 1000000, 4, 8, [&num_read](BlockId block_id) {
+                                         ++num_read;
+                                         return block_id;
+                                       }};
+    ASSERT_EQ(read_ahead.next()->first, 1);
+  }
+  ASSERT_LE(num_read, 9);
+}
+
+}  // namespace
@@ -17,17 +17,23 @@
 #include <future>
 #include <list>
 #include "Logger.hpp"
+#include "concord_kvbc.pb.h"
 #include "thin-replica-server/subscription_buffer.hpp"
 
 namespace {
 
 using concord::kvbc::categorization::ImmutableInput;
 using concord::kvbc::categorization::ImmutableValueUpdate;
+using com::vmware::concord::kvbc::ValueWithTrids;
 using concord::thin_replica::ConsumerTooSlow;
+using concord::thin_replica::FilteredSubUpdatePtr;
 using concord::thin_replica::SubBufferList;
 using concord::thin_replica::SubUpdate;
 using concord::thin_replica::SubUpdateBuffer;
 
+// Live update keys are prefixed with the block ID
+std::string prefixedKey(const std::string& key) { return std::string(sizeof(concord::kvbc::BlockId), '\0') + key; }
+
 // A producer should be able to "add" updates whether there are consumers or
 // not. Meaning, the producer does not get interrupted/disturbed if no
 // consumers are present.
@@ -36,7 +42,7 @@ TEST(trs_sub_buffer_test, no_consumer) {
   ImmutableInput input;
   ImmutableValueUpdate val;
   val.data = "value";
-  input.kv = {{"key", val}};
+  input.kv = {{prefixedKey("key"), val}};
   SubUpdate update{1337, "CID", input};
   for (unsigned i = 0; i < 100; ++i) {
     EXPECT_NO_THROW(sub_list.updateSubBuffers(update));
@@ -71,7 +77,7 @@ TEST(trs_sub_buffer_test, throw_exception_if_consumer_too_slow) {
   ImmutableInput input;
   ImmutableValueUpdate val;
   val.data = "value";
-  input.kv = {{"key", val}};
+  input.kv = {{prefixedKey("key"), val}};
   SubUpdate update{1337, "CID", input};
   auto updates = std::make_shared<SubUpdateBuffer>(10);
 
@@ -80,7 +86,7 @@ TEST(trs_sub_buffer_test, throw_exception_if_consumer_too_slow) {
     sub_list.updateSubBuffers(update);
   }
 
-  SubUpdate consumer_update;
+  FilteredSubUpdatePtr consumer_update;
   EXPECT_THROW(updates->Pop(consumer_update), ConsumerTooSlow);
 }
 
@@ -89,10 +95,10 @@ TEST(trs_sub_buffer_test, block_consumer_if_no_updates_available) {
   std::atomic_bool reader_started;
   auto updates = std::make_shared<SubUpdateBuffer>(10);
   auto reader = std::async(std::launch::async, [&] {
-    SubUpdate update;
+    FilteredSubUpdatePtr update;
     reader_started = true;
     updates->Pop(update);
-    ASSERT_EQ(update.block_id, 1337);
+    ASSERT_EQ(update->blockId(), 1337);
   });
 
   sub_list.addBuffer(updates);
@@ -104,7 +110,7 @@ TEST(trs_sub_buffer_test, block_consumer_if_no_updates_available) {
   ImmutableInput input;
   ImmutableValueUpdate val;
   val.data = "value";
-  input.kv = {{"key", val}};
+  input.kv = {{prefixedKey("key"), val}};
   SubUpdate update{1337, "CID", input};
   sub_list.updateSubBuffers(update);
 }
@@ -114,18 +120,18 @@ TEST(trs_sub_buffer_test, happy_path_w_two_consumers) {
   ImmutableInput input;
   ImmutableValueUpdate val;
   val.data = "value";
-  input.kv = {{"key", val}};
+  input.kv = {{prefixedKey("key"), val}};
   SubUpdate update{0, "CID", input};
   auto updates1 = std::make_shared<SubUpdateBuffer>(10);
   auto updates2 = std::make_shared<SubUpdateBuffer>(10);
   int num_updates = 10;
 
   auto reader_fn = [](std::shared_ptr<SubUpdateBuffer> q, int max) {
-    SubUpdate update;
+    FilteredSubUpdatePtr update;
     int counter = 0;
     do {
       q->Pop(update);
-      ASSERT_EQ(update.block_id, counter);
+      ASSERT_EQ(update->blockId(), counter);
     } while (++counter < max);
   };
   auto reader1 = std::async(std::launch::async, reader_fn, updates1, num_updates);
@@ -140,6 +146,96 @@ TEST(trs_sub_buffer_test, happy_path_w_two_consumers) {
   }
 }
 
+// Subscribers with the same client id and key prefix share the filtered update.
+TEST(trs_sub_buffer_test, subscribers_with_same_filter_share_update) {
+  SubBufferList sub_list;
+  auto value = [](const std::string& v) {
+    ValueWithTrids proto;
+    proto.set_value(v);
+    return proto.SerializeAsString();
+  };
+  ImmutableInput input;
+  input.kv[prefixedKey("a_key")] = ImmutableValueUpdate{value("a_value"), {}};
+  input.kv[prefixedKey("b_key")] = ImmutableValueUpdate{value("b_value"), {"client_2"}};
+  SubUpdate update{1, "CID", input};
+
+  auto a_updates1 = std::make_shared<SubUpdateBuffer>(10, "client_1", "a");
+  auto a_updates2 = std::make_shared<SubUpdateBuffer>(10, "client_1", "a");
+  auto all_updates1 = std::make_shared<SubUpdateBuffer>(10, "client_1", "");
+  auto all_updates2 = std::make_shared<SubUpdateBuffer>(10, "client_2", "");
+  for (const auto& buffer : {a_updates1, a_updates2, all_updates1, all_updates2}) {
+    sub_list.addBuffer(buffer);
+  }
+  sub_list.updateSubBuffers(update);
+
+  FilteredSubUpdatePtr a1, a2, all1, all2;
+  a_updates1->Pop(a1);
+  a_updates2->Pop(a2);
+  all_updates1->Pop(all1);
+  all_updates2->Pop(all2);
+
+  ASSERT_EQ(a1, a2);
+  ASSERT_EQ(a1->update().kv_pairs.size(), 1);
+  ASSERT_EQ(a1->update().kv_pairs[0].first, "a_key");
+  ASSERT_EQ(a1->update().kv_pairs[0].second, "a_value");
+  ASSERT_EQ(a1->update().correlation_id, "CID");
+
+  ASSERT_NE(all1, all2);
+  ASSERT_EQ(all1->update().kv_pairs.size(), 1);
+  ASSERT_EQ(all2->update().kv_pairs.size(), 2);
+  ASSERT_EQ(all2->update().kv_pairs[1].second, "b_value");
+
+  // The shared hash is the one each subscriber would compute on its own
+  ASSERT_EQ(a1->hash(), a_updates1->filter()->hashUpdate(a1->update()));
+  ASSERT_NE(a1->hash(), all2->hash());
+
+  sub_list.removeBuffer(a_updates1);
+  sub_list.updateSubBuffers(update);
+  a_updates2->Pop(a2);
+  ASSERT_EQ(a2->blockId(), 1);
+  ASSERT_TRUE(a_updates1->Empty());
+}
+
+// An update that can't be filtered for a group closes the subscriptions of
+// that group only, and doesn't throw into the producer.
+TEST(trs_sub_buffer_test, filter_error_fails_only_affected_subscribers) {
+  SubBufferList sub_list;
+  ValueWithTrids a_value;
+  a_value.set_value("a_value");
+  // A value with trids must have a value
+  ValueWithTrids malformed;
+  malformed.add_trid("client_2");
+  ImmutableInput input;
+  input.kv[prefixedKey("a_key")] = ImmutableValueUpdate{a_value.SerializeAsString(), {}};
+  input.kv[prefixedKey("b_key")] = ImmutableValueUpdate{malformed.SerializeAsString(), {"client_2"}};
+  SubUpdate update{1, "CID", input};
+
+  auto a_updates = std::make_shared<SubUpdateBuffer>(10, "client_1", "a");
+  auto failed_updates1 = std::make_shared<SubUpdateBuffer>(10, "client_2", "");
+  auto failed_updates2 = std::make_shared<SubUpdateBuffer>(10, "client_2", "");
+  for (const auto& buffer : {a_updates, failed_updates1, failed_updates2}) {
+    sub_list.addBuffer(buffer);
+  }
+  ASSERT_NO_THROW(sub_list.updateSubBuffers(update));
+
+  FilteredSubUpdatePtr a;
+  a_updates->Pop(a);
+  ASSERT_EQ(a->update().kv_pairs.size(), 1);
+
+  FilteredSubUpdatePtr failed;
+  ASSERT_THROW(failed_updates1->Pop(failed), concord::kvbc::KvbReadError);
+  ASSERT_THROW(failed_updates2->waitUntilNonEmpty(), concord::kvbc::KvbReadError);
+
+  // Later updates are not added to the failed buffers
+  update.block_id = 2;
+  input.kv.erase(prefixedKey("b_key"));
+  update.immutable_kv_pairs = input;
+  sub_list.updateSubBuffers(update);
+  a_updates->Pop(a);
+  ASSERT_EQ(a->blockId(), 2);
+  ASSERT_TRUE(failed_updates1->Empty());
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <stdint.h>
 #include <map>
@@ -28,16 +29,19 @@ template <class T>
 class BasicGauge;
 template <class T>
 class BasicCounter;
+class ShardedCounter;
+class ShardedGauge;
 
 using Gauge = BasicGauge<uint64_t>;
 using Counter = BasicCounter<uint64_t>;
-using AtomicGauge = BasicGauge<std::atomic_uint64_t>;
-using AtomicCounter = BasicCounter<std::atomic_uint64_t>;
+using AtomicGauge = ShardedGauge;
+using AtomicCounter = ShardedCounter;
 
 // Forward declarations since Aggregator requires these types.
 class Component;
 class Values;
 class Status;
+struct PublishedComponent;
 typedef struct metric_ Metric;
 
 // An aggregator maintains metrics for multiple components. Components
@@ -45,6 +49,15 @@ typedef struct metric_ Metric;
 // all their metric values. Therefore, the state of all metrics is eventually
 // consistent.
 //
+// Updating the aggregator doesn't take its lock: a component publishes a
+// snapshot of its values by swapping a pointer, and atomic counters and gauges
+// aren't published at all - they are read in place whenever the aggregator is
+// read.
+//
+// Registering a component replaces any component registered with the same
+// name, so that a re-created component is the one that is reported. Components
+// that were replaced can still be updated, but aren't reported anymore.
+//
 // The Aggregator is the type responsible for reporting metrics for the entire
 // system. A process should have a single aggregator, and any service
 // responsible for reporting system metrics should read it from the aggregator.
@@ -62,10 +75,12 @@ class Aggregator {
   std::string ToJson();
 
  private:
-  void RegisterComponent(Component& component);
-  void UpdateValues(const std::string& name, Values&& values);
+  void RegisterComponent(const std::shared_ptr<PublishedComponent>& component);
+  std::shared_ptr<PublishedComponent> FindComponent(const std::string& component_name);
+  std::vector<std::shared_ptr<PublishedComponent>> Components();
 
-  std::map<std::string, Component> components_;
+  // Guards the map only. The published values are swapped without it.
+  std::map<std::string, std::shared_ptr<PublishedComponent>> components_;
   std::mutex lock_;
 
   friend class Component;
@@ -85,7 +100,7 @@ class BasicGauge {
   void Inc() { ++val_; }
   void Dec() { --val_; }
   void Set(const uint64_t val) { val_ = val; }
-  uint64_t Get() { return val_; }
+  uint64_t Get() const { return val_; }
 
  private:
   T val_;
@@ -104,12 +119,73 @@ class BasicCounter {
     val_ += val;
     return val_;
   }
-  uint64_t Get() { return val_; }
+  uint64_t Get() const { return val_; }
 
  private:
   T val_;
 };
 
+// The sum of per thread shards, modulo 2^64, which can be updated from
+// multiple threads. Each thread updates its own cache line sized shard, so
+// concurrent updates don't contend. Reading the value sums the shards, hence
+// it is more expensive than updating it.
+class ShardedValue {
+ public:
+  explicit ShardedValue(const uint64_t val) : base_{val} {}
+  ShardedValue(const ShardedValue& other) : base_{other.Get()} {}
+  ShardedValue& operator=(const ShardedValue& other) {
+    const auto val = other.Get();
+    for (auto& shard : shards_) shard.val_.store(0, std::memory_order_relaxed);
+    base_.store(val, std::memory_order_relaxed);
+    return *this;
+  }
+  uint64_t Get() const { return base_.load(std::memory_order_relaxed) + SumOfShards(); }
+
+ protected:
+  void Add(const uint64_t val) { shards_[ShardIndex()].val_.fetch_add(val, std::memory_order_relaxed); }
+  // Updates racing with Set() may or may not be included in the value. Of racing Set() calls, the last one wins.
+  void Set(const uint64_t val) { base_.store(val - SumOfShards(), std::memory_order_relaxed); }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+  struct alignas(64) Shard {
+    std::atomic_uint64_t val_{0};
+  };
+
+  static size_t ShardIndex() {
+    static std::atomic_size_t next_index{0};
+    static thread_local const size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return index;
+  }
+
+  uint64_t SumOfShards() const {
+    uint64_t sum = 0;
+    for (const auto& shard : shards_) sum += shard.val_.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  std::atomic_uint64_t base_;
+  std::array<Shard, kNumShards> shards_;
+};
+
+// A counter that can be incremented from multiple threads without contention.
+// Inc() doesn't return the new value, as it would have to sum the shards.
+class ShardedCounter : public ShardedValue {
+ public:
+  using ShardedValue::ShardedValue;
+  void Inc(uint64_t val = 1) { Add(val); }
+};
+
+// A gauge that can be incremented and decremented from multiple threads
+// without contention. Set() sums the shards.
+class ShardedGauge : public ShardedValue {
+ public:
+  using ShardedValue::ShardedValue;
+  void Inc() { Add(1); }
+  void Dec() { Add(static_cast<uint64_t>(-1)); }
+  using ShardedValue::Set;
+};
+
 // Status is a text based representation of a value. It's used for things that
 // don't have strictly numeric representations, like the current state of the
 // BFT or the last message received.
@@ -118,7 +194,7 @@ class Status {
   explicit Status(const std::string& val) : val_(val) {}
 
   void Set(const std::string& val) { val_ = val; }
-  std::string Get() { return val_; }
+  std::string Get() const { return val_; }
 
  private:
   std::string val_;
@@ -133,11 +209,22 @@ struct metric_ {
   std::variant<Counter, Gauge, Status, SummaryDescription> value;
 };
 
+// Values updated on the component's thread. They are copied when the
+// component publishes them to the aggregator.
 class Values {
  private:
   std::vector<Gauge> gauges_;
   std::vector<Status> statuses_;
   std::vector<Counter> counters_;
+
+  friend class Component;
+  friend class Aggregator;
+};
+
+// Values that may be updated from any thread. The aggregator reads them in
+// place, so they are never copied.
+class AtomicValues {
+ private:
   std::vector<AtomicCounter> atomic_counters_;
   std::vector<AtomicGauge> atomic_gauges_;
 
@@ -161,6 +248,25 @@ class Names {
   friend class Aggregator;
 };
 
+// The part of a component the aggregator holds. It is shared by the component
+// and the aggregator, so either can go away first.
+struct PublishedComponent {
+  ~PublishedComponent();
+
+  // Replace the published values with a copy of the given values.
+  void Publish(const Values& new_values);
+
+  std::string name;
+  Names names;
+  std::shared_ptr<AtomicValues> atomic_values;
+  // A values buffer that is neither published nor read. Reused by the next
+  // Publish(), so that publishing doesn't allocate the values.
+  std::atomic<Values*> recycled_values{nullptr};
+  // The last published values. Only accessed with std::atomic_load and
+  // std::atomic_store, and never modified while published.
+  std::shared_ptr<const Values> values;
+};
+
 // A Component stores Values of different types and is updated on the local
 // thread. Components are sent to an Aggregator periodically. Components are
 // optimized for fast update access.
@@ -186,7 +292,8 @@ class Component {
     size_t index_;
   };
 
-  Component(const std::string& name, std::shared_ptr<Aggregator> aggregator) : aggregator_(aggregator), name_(name) {}
+  Component(const std::string& name, std::shared_ptr<Aggregator> aggregator)
+      : aggregator_(aggregator), name_(name), atomic_values_(std::make_shared<AtomicValues>()) {}
   std::string Name() { return name_; }
 
   // Create a Gauge, add it to the component and return a reference to the
@@ -207,17 +314,18 @@ class Component {
   // If registration happens before all registration of the values, then the
   // names will not properly exist in the aggregator, since only values get
   // updated at runtime for performance reasons.
-  void Register() {
-    if (auto aggregator = aggregator_.lock()) {
-      aggregator->RegisterComponent(*this);
-    }
-  }
+  //
+  // A component replaces a previously registered component with the same name.
+  void Register();
 
-  // Update the values in the aggregator
+  // Publish the values to the aggregator. Atomic values are always up to date
+  // in the aggregator and don't need this.
+  //
+  // This copies the values into a buffer that isn't being read by the
+  // aggregator, and swaps it with the published one.
   void UpdateAggregator() {
-    Values copy = values_;
-    if (auto aggregator = aggregator_.lock()) {
-      aggregator->UpdateValues(name_, std::move(copy));
+    if (published_) {
+      published_->Publish(values_);
     }
   }
 
@@ -235,13 +343,30 @@ class Component {
  private:
   friend class Aggregator;
 
-  void SetValues(Values&& values) { values_ = values; }
+  // Shared by the component, reading its own values, and the aggregator, reading the published values.
+  static std::list<Metric> CollectGauges(const std::string& component_name,
+                                         const Names& names,
+                                         const Values& values,
+                                         const AtomicValues& atomic_values);
+  static std::list<Metric> CollectCounters(const std::string& component_name,
+                                           const Names& names,
+                                           const Values& values,
+                                           const AtomicValues& atomic_values);
+  static std::list<Metric> CollectStatuses(const std::string& component_name, const Names& names, const Values& values);
+  static std::string ToJson(const std::string& component_name,
+                            const Names& names,
+                            const Values& values,
+                            const AtomicValues& atomic_values);
 
   std::weak_ptr<Aggregator> aggregator_;
   std::string name_;
 
   Names names_;
   Values values_;
+  std::shared_ptr<AtomicValues> atomic_values_;
+
+  // Set by Register().
+  std::shared_ptr<PublishedComponent> published_;
 };
 
 typedef concordMetrics::Component::Handle<concordMetrics::Gauge> GaugeHandle;
@@ -16,13 +16,39 @@
 #include <cstdint>
 #include <chrono>
 #include <vector>
+#include <deque>
+#include <array>
 #include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace concordUtil {
 
-// A collection of timers backed by a vector.
+// A collection of timers backed by a hierarchical timing wheel.
+//
+// The wheel has a resolution of 1 millisecond and kLevels levels of kSlots slots each. Level l holds the timers that
+// expire within the current kSlots^(l+1) milliseconds block; timers beyond the last level are kept in an overflow list.
+// When time advances into a new block, the timers of the corresponding slot are cascaded to the lower levels.
+// Adding, resetting and cancelling a timer is O(1), and evaluate() is amortized O(1) per expired timer. A timer never
+// fires before its exact expiry time.
+//
+// Threading: all the calls are serialized by a recursive mutex, which evaluate() holds while running the callbacks.
+// Therefore, callbacks can add, reset and cancel timers, and once cancel() returns in any thread, the timer's callback
+// is not running and will not run again. reset() and cancel() throw std::invalid_argument for an unknown handle.
+// evaluate() only takes the mutex if a timer may have expired, so calling it when nothing is due is cheap.
 class Timers {
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr uint32_t kNoLevel = UINT32_MAX;
+
+  // An intrusive doubly linked list of timers, linked through the indexes in timers_.
+  struct TimerList {
+    uint32_t head = kNil;
+    uint32_t level = kNoLevel;
+  };
+
  public:
   class Handle {
    public:
@@ -49,9 +75,6 @@ class Timers {
     };
 
    private:
-    Timer(std::chrono::milliseconds duration, Type t, const std::function<void(Handle)>& callback)
-        : Timer(duration, t, callback, std::chrono::steady_clock::now()) {}
-
     Timer(std::chrono::milliseconds d,
           Type t,
           std::function<void(Handle)> cb,
@@ -62,8 +85,6 @@ class Timers {
 
     bool recurring() const { return type_ == Type::RECURRING; }
 
-    void run_callback(Handle h) { callback_(h); }
-
     void reset(std::chrono::steady_clock::time_point now) { expires_at_ = now + duration_; }
 
     void reset(std::chrono::steady_clock::time_point now, std::chrono::milliseconds d) {
@@ -77,11 +98,27 @@ class Timers {
     uint64_t id_ = 0;
     std::function<void(Handle)> callback_;
 
+    // Links in the list the timer is currently in (nullptr if not scheduled).
+    uint32_t prev_ = kNil;
+    uint32_t next_ = kNil;
+    TimerList* list_ = nullptr;
+    // The callback is running.
+    bool firing_ = false;
+    // The timer was cancelled by its own callback.
+    bool cancelled_ = false;
+    // The last evaluation that ran the callback. A timer runs at most once per evaluation.
+    uint64_t last_evaluation_ = 0;
+
     friend class Timers;
   };
 
  public:
-  Timers() : id_counter_(0) {}
+  Timers() : id_counter_(0) {
+    for (uint32_t level = 0; level < kLevels; ++level) {
+      for (auto& slot : wheel_[level]) slot.level = level;
+    }
+    overflow_.level = kLevels;
+  }
   Timers(const Timers& timers) = delete;
   Timers& operator=(const Timers& timers) = delete;
   Timers(Timers&& timers) = delete;
@@ -96,62 +133,272 @@ class Timers {
              const std::function<void(Handle)>& cb,
              std::chrono::steady_clock::time_point now) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    timers_.emplace_back(Timer(d, t, cb, now));
-    id_counter_ += 1;
-    Handle h{id_counter_};
-    timers_.back().id_ = h.id_;
+    Handle h{++id_counter_};
+    addTimer(h.id_, Timer(d, t, cb, now));
     return h;
   }
 
-  std::vector<Timer>::iterator find(Handle handle) {
-    std::unique_lock<std::recursive_mutex> mlock(lock_);
-    auto it = std::find_if(timers_.begin(), timers_.end(), [&handle](const Timer& t) { return t.id_ == handle.id_; });
-    if (it != timers_.end())
-      return it;
-    else
-      throw std::invalid_argument("Invalid timer handle");
-  }
-
   void reset(Handle handle, std::chrono::milliseconds d) { reset(handle, d, std::chrono::steady_clock::now()); }
 
   void reset(Handle handle, std::chrono::milliseconds d, std::chrono::steady_clock::time_point now) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    find(handle)->reset(now, d);
+    const auto idx = find(handle);
+    auto& timer = timers_[idx];
+    timer.reset(now, d);
+    if (timer.list_) unlink(idx);
+    schedule(idx);
   }
 
   void cancel(Handle handle) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    timers_.erase(find(handle));
+    const auto idx = find(handle);
+    auto& timer = timers_[idx];
+    index_.erase(handle.id_);
+    if (timer.list_) unlink(idx);
+    if (timer.firing_) {
+      timer.cancelled_ = true;
+    } else {
+      release(idx);
+    }
   }
 
   // Run the callbacks for all expired timers, and reschedule them if they are recurring.
   void evaluate() { evaluate(std::chrono::steady_clock::now()); }
 
   void evaluate(std::chrono::steady_clock::time_point now) {
+    if (toTick(now) < next_due_tick_.load(std::memory_order_acquire)) return;
+
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    if (timers_.empty()) return;
-
-    // Expired ids must be stored separately since erasing causes iterator invalidation.
-    std::vector<Handle> to_cancel;
-    for (auto& timer : timers_) {
-      if (timer.expired(now)) {
-        timer.run_callback(Handle(timer.id_));
-        if (timer.recurring()) {
-          timer.reset(now);
-        } else {
-          to_cancel.push_back(Handle(timer.id_));
+    if (size_ > 0) {
+      ++evaluation_;
+      advance(std::max(toTick(now), now_tick_), now);
+      fire(wheel_[0][now_tick_ & kSlotMask], now, false);
+    }
+    updateNextDueTick();
+  }
+
+ private:
+  static constexpr uint32_t kSlotBits = 8;
+  static constexpr uint32_t kSlots = 1u << kSlotBits;
+  static constexpr uint64_t kSlotMask = kSlots - 1;
+  static constexpr uint32_t kLevels = 4;
+  static constexpr uint64_t kNever = UINT64_MAX;
+
+  static uint64_t toTick(std::chrono::steady_clock::time_point tp) {
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+    return ms > 0 ? static_cast<uint64_t>(ms) : 0;
+  }
+
+  uint32_t find(Handle handle) const {
+    const auto it = index_.find(handle.id_);
+    if (it == index_.end()) throw std::invalid_argument("Invalid timer handle");
+    return it->second;
+  }
+
+  void addTimer(uint64_t id, Timer&& timer) {
+    // Don't walk through the ticks that passed while there were no timers.
+    if (size_ == 0) now_tick_ = std::max(now_tick_, toTick(timer.expires_at_ - timer.duration_));
+    timer.id_ = id;
+    uint32_t idx;
+    if (free_.empty()) {
+      idx = static_cast<uint32_t>(timers_.size());
+      timers_.push_back(std::move(timer));
+    } else {
+      idx = free_.back();
+      free_.pop_back();
+      timers_[idx] = std::move(timer);
+    }
+    index_.emplace(id, idx);
+    ++size_;
+    schedule(idx);
+  }
+
+  void release(uint32_t idx) {
+    auto& timer = timers_[idx];
+    timer.callback_ = nullptr;
+    timer.firing_ = false;
+    timer.cancelled_ = false;
+    free_.push_back(idx);
+    --size_;
+  }
+
+  void link(uint32_t idx, TimerList& list) {
+    auto& timer = timers_[idx];
+    timer.prev_ = kNil;
+    timer.next_ = list.head;
+    if (list.head != kNil) timers_[list.head].prev_ = idx;
+    list.head = idx;
+    timer.list_ = &list;
+    if (list.level < kLevels) ++level_size_[list.level];
+  }
+
+  void unlink(uint32_t idx) {
+    auto& timer = timers_[idx];
+    auto& list = *timer.list_;
+    if (timer.prev_ != kNil) {
+      timers_[timer.prev_].next_ = timer.next_;
+    } else {
+      list.head = timer.next_;
+    }
+    if (timer.next_ != kNil) timers_[timer.next_].prev_ = timer.prev_;
+    timer.prev_ = timer.next_ = kNil;
+    timer.list_ = nullptr;
+    if (list.level < kLevels) --level_size_[list.level];
+  }
+
+  // Link the timer in the slot of the lowest level whose block (relative to now_tick_) contains its expiry tick.
+  void schedule(uint32_t idx) {
+    const auto expiry = std::max(toTick(timers_[idx].expires_at_), now_tick_);
+    if (expiry < next_due_tick_.load(std::memory_order_relaxed)) {
+      next_due_tick_.store(expiry, std::memory_order_release);
+    }
+    for (uint32_t level = 0; level < kLevels; ++level) {
+      const auto shift = kSlotBits * (level + 1);
+      if ((expiry >> shift) == (now_tick_ >> shift)) {
+        link(idx, wheel_[level][(expiry >> (kSlotBits * level)) & kSlotMask]);
+        return;
+      }
+    }
+    link(idx, overflow_);
+  }
+
+  // Set next_due_tick_ to the first tick a timer may expire in. Cancelled timers make it earlier than needed, which
+  // only costs an evaluation that doesn't fire anything.
+  void updateNextDueTick() {
+    auto tick = kNever;
+    uint32_t level = 0;
+    while (level < kLevels && level_size_[level] == 0) ++level;
+    if (level == 0) {
+      tick = now_tick_;
+      while (wheel_[0][tick & kSlotMask].head == kNil && ((tick + 1) & kSlotMask) != 0) ++tick;
+    } else if (size_ > 0) {
+      // As in advance(), nothing expires before the next block of the first non-empty level.
+      tick = ((now_tick_ >> (kSlotBits * level)) + 1) << (kSlotBits * level);
+    }
+    next_due_tick_.store(tick, std::memory_order_release);
+  }
+
+  // Re-schedule all the timers in the list relative to now_tick_.
+  void cascade(TimerList& list) {
+    TimerList detached;
+    while (list.head != kNil) {
+      const auto idx = list.head;
+      unlink(idx);
+      link(idx, detached);
+    }
+    while (detached.head != kNil) {
+      const auto idx = detached.head;
+      unlink(idx);
+      schedule(idx);
+    }
+  }
+
+  // Move the timers of a passed tick to the current one.
+  void deferToCurrentTick(TimerList& list) {
+    auto& current = wheel_[0][now_tick_ & kSlotMask];
+    while (list.head != kNil) {
+      const auto idx = list.head;
+      unlink(idx);
+      link(idx, current);
+    }
+  }
+
+  // Called when now_tick_ enters a new tick.
+  void cascade() {
+    if (now_tick_ & kSlotMask) return;
+    if ((now_tick_ & ((uint64_t{1} << (kSlotBits * kLevels)) - 1)) == 0) cascade(overflow_);
+    for (uint32_t level = kLevels - 1; level > 0; --level) {
+      if (now_tick_ & ((uint64_t{1} << (kSlotBits * level)) - 1)) continue;
+      cascade(wheel_[level][(now_tick_ >> (kSlotBits * level)) & kSlotMask]);
+    }
+  }
+
+  // Fire the timers of all the ticks before target, i.e. the ones that expire before `now`.
+  void advance(uint64_t target, std::chrono::steady_clock::time_point now) {
+    while (now_tick_ < target) {
+      if (size_ == 0) {
+        now_tick_ = target;
+        return;
+      }
+      // If the lower levels are empty, nothing expires before the next block of the first non-empty level.
+      uint32_t level = 0;
+      while (level < kLevels && level_size_[level] == 0) ++level;
+      if (level > 0) {
+        const auto nextBlock = ((now_tick_ >> (kSlotBits * level)) + 1) << (kSlotBits * level);
+        if (nextBlock > target) {
+          now_tick_ = target;
+          return;
         }
+        now_tick_ = nextBlock;
+        cascade();
+        continue;
+      }
+      // Timers added to the current slot by callbacks have expired as well. Timers that already ran in this evaluation
+      // are moved to the next tick.
+      auto& slot = wheel_[0][now_tick_ & kSlotMask];
+      while (fire(slot, now, true) > 0) {
       }
+      ++now_tick_;
+      deferToCurrentTick(slot);
+      cascade();
     }
+  }
 
-    for (auto& handle : to_cancel) {
-      cancel(handle);
+  // Run the callbacks of the (expired) timers in the list. Timers added to the list by the callbacks are not run.
+  // Returns the number of callbacks run.
+  size_t fire(TimerList& list, std::chrono::steady_clock::time_point now, bool allExpired) {
+    size_t count = 0;
+    TimerList expired;
+    for (auto idx = list.head; idx != kNil;) {
+      const auto next = timers_[idx].next_;
+      const auto& timer = timers_[idx];
+      if (timer.last_evaluation_ != evaluation_ && (allExpired || timer.expired(now))) {
+        unlink(idx);
+        link(idx, expired);
+      }
+      idx = next;
+    }
+
+    while (expired.head != kNil) {
+      const auto idx = expired.head;
+      unlink(idx);
+      // References to timers_ elements are stable, as it is a deque that only grows at the back.
+      auto& timer = timers_[idx];
+      timer.firing_ = true;
+      timer.last_evaluation_ = evaluation_;
+      ++count;
+      timer.callback_(Handle(timer.id_));
+      timer.firing_ = false;
+      if (timer.cancelled_) {
+        release(idx);
+      } else if (timer.list_) {
+        // Reset by its own callback.
+        continue;
+      } else if (timer.recurring()) {
+        timer.reset(now);
+        schedule(idx);
+      } else {
+        index_.erase(timer.id_);
+        release(idx);
+      }
     }
+    return count;
   }
 
  private:
   std::recursive_mutex lock_;
-  std::vector<Timer> timers_;
+  std::deque<Timer> timers_;
+  std::vector<uint32_t> free_;
+  std::unordered_map<uint64_t, uint32_t> index_;
+  std::array<std::array<TimerList, kSlots>, kLevels> wheel_;
+  TimerList overflow_;
+  std::array<size_t, kLevels> level_size_{};
+  size_t size_ = 0;
+  uint64_t evaluation_ = 0;
+  // All the ticks before now_tick_ were processed.
+  uint64_t now_tick_ = 0;
+  // No timer expires before this tick. Written with lock_ held, read by evaluate() without it.
+  std::atomic<uint64_t> next_due_tick_{kNever};
   uint64_t id_counter_;
 };
 
@@ -0,0 +1,90 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include "SimpleThreadPool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// A fixed size thread pool with a job deque per thread, running SimpleThreadPool jobs.
+// A thread runs the jobs of its own deque in FIFO order. When its deque is empty, it steals the newest job of another
+// thread's deque. Each deque has its own lock, so threads adding and loading jobs don't contend on a single lock.
+// Jobs added by a pool thread (e.g. the continuation of a job, added by a callback the job waited for) go to the deque
+// of that thread; other jobs are spread round robin.
+class WorkStealingThreadPool {
+ public:
+  typedef SimpleThreadPool::Job Job;
+
+  WorkStealingThreadPool() = default;
+  ~WorkStealingThreadPool() { stop(); }
+  WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+  WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+  /**
+   * starts the thread pool with desired number of threads
+   */
+  void start(size_t num_of_threads = 1);
+  /**
+   * stops the thread pool
+   * @param executeAllJobs - whether to execute remaining jobs
+   */
+  void stop(bool executeAllJobs = false);
+  /**
+   * add a job for execution
+   * @param j - subclass of Job for execution. The pool takes ownership: the job is released without being executed if
+   * the pool is not started or is stopped.
+   */
+  void add(Job* j);
+  /**
+   * get the number of threads in pool
+   */
+  size_t getNumOfThreads() const { return threads_.size(); }
+  /**
+   * get the number of jobs waiting for execution
+   */
+  size_t getNumOfJobs() const { return pending_ > 0 ? pending_.load() : 0; }
+
+ private:
+  struct Worker {
+    std::mutex lock;
+    std::deque<Job*> jobs;
+  };
+
+  void run(size_t self);
+  bool load(size_t self, Job*& outJob);
+  bool tryLoad(size_t self, Job*& outJob);
+  void execute(Job* j);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic_bool stopped_{true};
+  // Jobs in the deques. May be negative for a moment, as it is incremented after a job is added.
+  std::atomic_int64_t pending_{0};
+  std::atomic_uint64_t next_{0};  // the deque for the next job added from outside of the pool
+  std::atomic_uint32_t sleeping_{0};
+  std::mutex sleep_lock_;
+  std::condition_variable wake_cond_;
+
+  // The pool and deque index of a pool thread
+  static thread_local const WorkStealingThreadPool* current_pool_;
+  static thread_local size_t current_index_;
+};
+
+}  // namespace util
@@ -69,4 +69,42 @@ T fromBigEndianBuffer(const void *buf) {
   return netToHost(v);
 }
 
+template <typename T>
+T hostToLittleEndian(T v) {
+  static_assert(std::is_integral_v<T>);
+
+  if constexpr (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) {
+    if constexpr (sizeof(v) == 2) {
+      v = __builtin_bswap16(v);
+    } else if constexpr (sizeof(v) == 4) {
+      v = __builtin_bswap32(v);
+    } else if constexpr (sizeof(v) == 8) {
+      v = __builtin_bswap64(v);
+    }
+  }
+
+  return v;
+}
+
+template <typename T>
+T littleEndianToHost(T v) {
+  return hostToLittleEndian(v);
+}
+
+// Appends v to out in little-endian byte order.
+template <typename T>
+void appendLittleEndian(std::string &out, T v) {
+  static_assert(isEndianConvertible<T>::value);
+
+  v = hostToLittleEndian(v);
+  out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T>
+T fromLittleEndianBuffer(const void *buf) {
+  T v;
+  std::memcpy(&v, buf, sizeof(T));
+  return littleEndianToHost(v);
+}
+
 }  // namespace concordUtils
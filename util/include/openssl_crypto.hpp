@@ -30,6 +30,9 @@
 
 #include "assertUtils.hpp"
 
+// OpenSSL's EVP_MD_CTX
+struct evp_md_ctx_st;
+
 namespace concord {
 namespace util {
 namespace openssl_utils {
@@ -182,6 +185,35 @@ const size_t kExpectedSHA256HashLengthInBytes = (256 / 8);
 std::string computeSHA256Hash(const std::string& data);
 std::string computeSHA256Hash(const char* data, size_t length);
 
+// Incremental SHA-256 computation: finish() returns computeSHA256Hash of the
+// concatenation of all the data passed to update() so far. A copy of a hasher
+// continues from the data hashed so far, e.g. in order to keep checkpoints of a
+// long computation.
+//
+// May throw an UnexpectedOpenSSLCryptoFailureException if the underlying
+// OpenSSL Crypto library unexpectedly reports a failure.
+class SHA256Hasher {
+ public:
+  SHA256Hasher();
+  SHA256Hasher(const SHA256Hasher& other);
+  SHA256Hasher& operator=(const SHA256Hasher& other);
+  SHA256Hasher(SHA256Hasher&&) = default;
+  SHA256Hasher& operator=(SHA256Hasher&&) = default;
+  ~SHA256Hasher();
+
+  void update(const char* data, size_t length);
+  void update(const std::string& data) { update(data.data(), data.length()); }
+
+  // The hasher can be updated further after finish().
+  std::string finish() const;
+
+ private:
+  struct ContextDeleter {
+    void operator()(evp_md_ctx_st* context) const;
+  };
+  std::unique_ptr<evp_md_ctx_st, ContextDeleter> context_;
+};
+
 // Specialized Exception types that may be thrown by the above utilities.
 
 // Exception that may be thrown if a call into OpenSSLCrypto returns a failure
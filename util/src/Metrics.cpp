@@ -25,7 +25,10 @@ const char* const kStatusName = "status";
 const char* const kCounterName = "counter";
 
 template <typename T>
-T FindValue(const char* const val_type, const string& val_name, const vector<string>& names, const vector<T>& values) {
+const T& FindValue(const char* const val_type,
+                   const string& val_name,
+                   const vector<string>& names,
+                   const vector<T>& values) {
   for (size_t i = 0; i < names.size(); i++) {
     if (names[i] == val_name) {
       return values[i];
@@ -56,121 +59,166 @@ Component::Handle<Counter> Component::RegisterCounter(const string& name, const
 
 Component::Handle<AtomicCounter> Component::RegisterAtomicCounter(const std::string& name, const uint64_t val) {
   names_.atomic_counter_names_.emplace_back(name);
-  values_.atomic_counters_.emplace_back(AtomicCounter(val));
-  return Component::Handle<AtomicCounter>(values_.atomic_counters_, values_.atomic_counters_.size() - 1);
+  atomic_values_->atomic_counters_.emplace_back(AtomicCounter(val));
+  return Component::Handle<AtomicCounter>(atomic_values_->atomic_counters_,
+                                          atomic_values_->atomic_counters_.size() - 1);
 }
 
 Component::Handle<AtomicGauge> Component::RegisterAtomicGauge(const std::string& name, uint64_t val) {
   names_.atomic_gauge_names_.emplace_back(name);
-  values_.atomic_gauges_.emplace_back(AtomicGauge(val));
-  return Component::Handle<AtomicGauge>(values_.atomic_gauges_, values_.atomic_gauges_.size() - 1);
+  atomic_values_->atomic_gauges_.emplace_back(AtomicGauge(val));
+  return Component::Handle<AtomicGauge>(atomic_values_->atomic_gauges_, atomic_values_->atomic_gauges_.size() - 1);
 }
 
-std::list<Metric> Component::CollectGauges() {
+void Component::Register() {
+  auto published = std::make_shared<PublishedComponent>();
+  published->name = name_;
+  published->names = names_;
+  published->atomic_values = atomic_values_;
+  published->Publish(values_);
+  published_ = published;
+  if (auto aggregator = aggregator_.lock()) {
+    aggregator->RegisterComponent(published);
+  }
+}
+
+PublishedComponent::~PublishedComponent() {
+  // Recycles the last values, hence before recycled_values is destroyed
+  values.reset();
+  delete recycled_values.load();
+}
+
+void PublishedComponent::Publish(const Values& new_values) {
+  auto buffer = recycled_values.exchange(nullptr, std::memory_order_acquire);
+  if (buffer) {
+    *buffer = new_values;
+  } else {
+    buffer = new Values(new_values);
+  }
+  // Once the last reader drops the values they are recycled. Only one buffer is kept.
+  auto ptr = std::shared_ptr<const Values>(buffer, [this](const Values* v) {
+    delete recycled_values.exchange(const_cast<Values*>(v), std::memory_order_acq_rel);
+  });
+  std::atomic_store(&values, std::move(ptr));
+}
+
+std::list<Metric> Component::CollectGauges() { return CollectGauges(name_, names_, values_, *atomic_values_); }
+
+std::list<Metric> Component::CollectCounters() { return CollectCounters(name_, names_, values_, *atomic_values_); }
+
+std::list<Metric> Component::CollectStatuses() { return CollectStatuses(name_, names_, values_); }
+
+std::list<Metric> Component::CollectGauges(const std::string& component_name,
+                                           const Names& names,
+                                           const Values& values,
+                                           const AtomicValues& atomic_values) {
   std::list<Metric> ret;
-  for (size_t i = 0; i < names_.gauge_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.gauge_names_[i], values_.gauges_[i]});
+  for (size_t i = 0; i < names.gauge_names_.size(); i++) {
+    ret.emplace_back(Metric{component_name, names.gauge_names_[i], values.gauges_[i]});
   }
-  for (std::size_t i = 0; i < names_.atomic_gauge_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.atomic_gauge_names_[i], Gauge(values_.atomic_gauges_[i].Get())});
+  for (std::size_t i = 0; i < names.atomic_gauge_names_.size(); i++) {
+    ret.emplace_back(Metric{component_name, names.atomic_gauge_names_[i], Gauge(atomic_values.atomic_gauges_[i].Get())});
   }
   return ret;
 }
 
-std::list<Metric> Component::CollectCounters() {
+std::list<Metric> Component::CollectCounters(const std::string& component_name,
+                                             const Names& names,
+                                             const Values& values,
+                                             const AtomicValues& atomic_values) {
   std::list<Metric> ret;
-  for (size_t i = 0; i < names_.counter_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.counter_names_[i], values_.counters_[i]});
+  for (size_t i = 0; i < names.counter_names_.size(); i++) {
+    ret.emplace_back(Metric{component_name, names.counter_names_[i], values.counters_[i]});
   }
-  for (std::size_t i = 0; i < names_.atomic_counter_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.atomic_counter_names_[i], Counter(values_.atomic_counters_[i].Get())});
+  for (std::size_t i = 0; i < names.atomic_counter_names_.size(); i++) {
+    ret.emplace_back(
+        Metric{component_name, names.atomic_counter_names_[i], Counter(atomic_values.atomic_counters_[i].Get())});
   }
   return ret;
 }
 
-std::list<Metric> Component::CollectStatuses() {
+std::list<Metric> Component::CollectStatuses(const std::string& component_name,
+                                             const Names& names,
+                                             const Values& values) {
   std::list<Metric> ret;
-  for (size_t i = 0; i < names_.status_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.status_names_[i], values_.statuses_[i]});
+  for (size_t i = 0; i < names.status_names_.size(); i++) {
+    ret.emplace_back(Metric{component_name, names.status_names_[i], values.statuses_[i]});
   }
   return ret;
 }
 
-void Aggregator::RegisterComponent(Component& component) {
+void Aggregator::RegisterComponent(const std::shared_ptr<PublishedComponent>& component) {
   std::lock_guard<std::mutex> lock(lock_);
-  components_.insert(make_pair(component.Name(), component));
+  components_.insert_or_assign(component->name, component);
 }
 
-// Throws if the component doesn't exist.
-// This is only called from the component itself so it will never actually
-// throw.
-void Aggregator::UpdateValues(const string& name, Values&& values) {
+std::shared_ptr<PublishedComponent> Aggregator::FindComponent(const string& component_name) {
   std::lock_guard<std::mutex> lock(lock_);
-  try {
-    components_.at(name).SetValues(std::move(values));
-  } catch (const std::out_of_range& e) {
-    throw std::out_of_range("components_.at() failed for name = " + name);
+  auto it = components_.find(component_name);
+  if (it == components_.end()) {
+    throw std::out_of_range("components_.at() failed for component_name = " + component_name);
   }
+  return it->second;
 }
 
 Gauge Aggregator::GetGauge(const string& component_name, const string& val_name) {
-  std::lock_guard<std::mutex> lock(lock_);
-  try {
-    auto& component = components_.at(component_name);
-    auto& gauges = component.names_.gauge_names_;
-    if (std::find(gauges.begin(), gauges.end(), val_name) != gauges.end()) {
-      return FindValue(kGaugeName, val_name, component.names_.gauge_names_, component.values_.gauges_);
-    }
-    auto atomic_gauge =
-        FindValue(kCounterName, val_name, component.names_.atomic_gauge_names_, component.values_.atomic_gauges_);
-    return Gauge(atomic_gauge.Get());
-  } catch (const std::out_of_range& e) {
-    throw std::out_of_range("components_.at() failed for component_name = " + component_name);
+  auto component = FindComponent(component_name);
+  auto& gauges = component->names.gauge_names_;
+  if (std::find(gauges.begin(), gauges.end(), val_name) != gauges.end()) {
+    const auto values = std::atomic_load(&component->values);
+    return FindValue(kGaugeName, val_name, gauges, values->gauges_);
   }
+  auto& atomic_gauge =
+      FindValue(kCounterName, val_name, component->names.atomic_gauge_names_, component->atomic_values->atomic_gauges_);
+  return Gauge(atomic_gauge.Get());
 }
 
 Status Aggregator::GetStatus(const string& component_name, const string& val_name) {
-  std::lock_guard<std::mutex> lock(lock_);
-  try {
-    auto& component = components_.at(component_name);
-    return FindValue(kStatusName, val_name, component.names_.status_names_, component.values_.statuses_);
-  } catch (const std::out_of_range& e) {
-    throw std::out_of_range("components_.at() failed for component_name = " + component_name);
-  }
+  auto component = FindComponent(component_name);
+  const auto values = std::atomic_load(&component->values);
+  return FindValue(kStatusName, val_name, component->names.status_names_, values->statuses_);
 }
 
 Counter Aggregator::GetCounter(const string& component_name, const string& val_name) {
+  auto component = FindComponent(component_name);
+  auto& counters = component->names.counter_names_;
+  if (std::find(counters.begin(), counters.end(), val_name) != counters.end()) {
+    const auto values = std::atomic_load(&component->values);
+    return FindValue(kCounterName, val_name, counters, values->counters_);
+  }
+  auto& atomic_counter = FindValue(
+      kCounterName, val_name, component->names.atomic_counter_names_, component->atomic_values->atomic_counters_);
+  return Counter(atomic_counter.Get());
+}
+
+std::vector<std::shared_ptr<PublishedComponent>> Aggregator::Components() {
   std::lock_guard<std::mutex> lock(lock_);
-  try {
-    auto& component = components_.at(component_name);
-    auto& counters = component.names_.counter_names_;
-    if (std::find(counters.begin(), counters.end(), val_name) != counters.end()) {
-      return FindValue(kCounterName, val_name, component.names_.counter_names_, component.values_.counters_);
-    }
-    auto atomic_counter =
-        FindValue(kCounterName, val_name, component.names_.atomic_counter_names_, component.values_.atomic_counters_);
-    return Counter(atomic_counter.Get());
-  } catch (const std::out_of_range& e) {
-    throw std::out_of_range("components_.at() failed for component_name = " + component_name);
+  std::vector<std::shared_ptr<PublishedComponent>> ret;
+  ret.reserve(components_.size());
+  for (auto& comp : components_) {
+    ret.push_back(comp.second);
   }
+  return ret;
 }
 
 // Generate a JSON string of all aggregated components. To save space we don't
 // add any newline characters.
 std::string Aggregator::ToJson() {
   ostringstream oss;
-  std::lock_guard<std::mutex> lock(lock_);
 
   // Add the object opening
   oss << "{\"Components\":[";
 
   // Add all the components
-  for (auto it = components_.begin(); it != components_.end(); ++it) {
+  bool first = true;
+  for (const auto& comp : Components()) {
     // Add a comma between every component
-    if (it != components_.begin()) {
+    if (!first) {
       oss << ",";
     }
-    oss << it->second.ToJson();
+    first = false;
+    const auto values = std::atomic_load(&comp->values);
+    oss << Component::ToJson(comp->name, comp->names, *values, *comp->atomic_values);
   }
 
   // Add the object end
@@ -179,50 +227,52 @@ std::string Aggregator::ToJson() {
   return oss.str();
 }
 std::list<Metric> Aggregator::CollectGauges() {
-  std::lock_guard<std::mutex> lock(lock_);
   std::list<Metric> ret;
-  for (auto& comp : components_) {
-    const auto& gauges = comp.second.CollectGauges();
-    ret.insert(ret.end(), gauges.begin(), gauges.end());
+  for (const auto& comp : Components()) {
+    const auto values = std::atomic_load(&comp->values);
+    ret.splice(ret.end(), Component::CollectGauges(comp->name, comp->names, *values, *comp->atomic_values));
   }
   return ret;
 }
 std::list<Metric> Aggregator::CollectCounters() {
-  std::lock_guard<std::mutex> lock(lock_);
   std::list<Metric> ret;
-  for (auto& comp : components_) {
-    const auto& counters = comp.second.CollectCounters();
-    ret.insert(ret.end(), counters.begin(), counters.end());
+  for (const auto& comp : Components()) {
+    const auto values = std::atomic_load(&comp->values);
+    ret.splice(ret.end(), Component::CollectCounters(comp->name, comp->names, *values, *comp->atomic_values));
   }
   return ret;
 }
 
 std::list<Metric> Aggregator::CollectStatuses() {
-  std::lock_guard<std::mutex> lock(lock_);
   std::list<Metric> ret;
-  for (auto& comp : components_) {
-    const auto& statuses = comp.second.CollectStatuses();
-    ret.insert(ret.end(), statuses.begin(), statuses.end());
+  for (const auto& comp : Components()) {
+    const auto values = std::atomic_load(&comp->values);
+    ret.splice(ret.end(), Component::CollectStatuses(comp->name, comp->names, *values));
   }
   return ret;
 }
 
+std::string Component::ToJson() { return ToJson(name_, names_, values_, *atomic_values_); }
+
 // Generate a JSON string of the component. To save space we don't add any
 // newline characters.
-std::string Component::ToJson() {
+std::string Component::ToJson(const std::string& component_name,
+                              const Names& names,
+                              const Values& values,
+                              const AtomicValues& atomic_values) {
   ostringstream oss;
 
   // Add the object opening and component name
-  oss << "{\"Name\":\"" << name_ << "\",";
+  oss << "{\"Name\":\"" << component_name << "\",";
 
   // Add any gauges
   oss << "\"Gauges\":{";
 
-  for (size_t i = 0; i < names_.gauge_names_.size(); i++) {
+  for (size_t i = 0; i < names.gauge_names_.size(); i++) {
     if (i != 0) {
       oss << ",";
     }
-    oss << "\"" << names_.gauge_names_[i] << "\":" << values_.gauges_[i].Get() << "";
+    oss << "\"" << names.gauge_names_[i] << "\":" << values.gauges_[i].Get() << "";
   }
 
   // End gauges
@@ -231,12 +281,12 @@ std::string Component::ToJson() {
   // Add any status
   oss << "\"Statuses\":{";
 
-  for (size_t i = 0; i < names_.status_names_.size(); i++) {
+  for (size_t i = 0; i < names.status_names_.size(); i++) {
     if (i != 0) {
       oss << ",";
     }
-    oss << "\"" << names_.status_names_[i] << "\":"
-        << "\"" << values_.statuses_[i].Get() << "\"";
+    oss << "\"" << names.status_names_[i] << "\":"
+        << "\"" << values.statuses_[i].Get() << "\"";
   }
 
   // End status
@@ -245,18 +295,18 @@ std::string Component::ToJson() {
   // Add any counters
   oss << "\"Counters\":{";
 
-  for (size_t i = 0; i < names_.counter_names_.size(); i++) {
+  for (size_t i = 0; i < names.counter_names_.size(); i++) {
     if (i != 0) {
       oss << ",";
     }
-    oss << "\"" << names_.counter_names_[i] << "\":" << values_.counters_[i].Get() << "";
+    oss << "\"" << names.counter_names_[i] << "\":" << values.counters_[i].Get() << "";
   }
 
-  for (size_t i = 0; i < names_.atomic_counter_names_.size(); i++) {
-    if (i != 0 || names_.counter_names_.size() > 0) {
+  for (size_t i = 0; i < names.atomic_counter_names_.size(); i++) {
+    if (i != 0 || names.counter_names_.size() > 0) {
       oss << ",";
     }
-    oss << "\"" << names_.atomic_counter_names_[i] << "\":" << values_.atomic_counters_[i].Get() << "";
+    oss << "\"" << names.atomic_counter_names_[i] << "\":" << atomic_values.atomic_counters_[i].Get() << "";
   }
 
   // End counters
@@ -0,0 +1,139 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "WorkStealingThreadPool.hpp"
+#include "Logger.hpp"
+#include "assertUtils.hpp"
+#include <exception>
+
+namespace util {
+
+static logging::Logger WSP = logging::getLogger("thread-pool");
+
+thread_local const WorkStealingThreadPool* WorkStealingThreadPool::current_pool_ = nullptr;
+thread_local size_t WorkStealingThreadPool::current_index_ = 0;
+
+void WorkStealingThreadPool::start(size_t num_of_threads) {
+  ConcordAssertGT(num_of_threads, 0);
+  ConcordAssert(threads_.empty());
+  workers_.clear();
+  for (size_t i = 0; i < num_of_threads; ++i) workers_.push_back(std::make_unique<Worker>());
+  stopped_ = false;
+  for (size_t i = 0; i < num_of_threads; ++i) threads_.emplace_back([this, i] { run(i); });
+}
+
+void WorkStealingThreadPool::stop(bool executeAllJobs) {
+  {
+    std::lock_guard<std::mutex> l(sleep_lock_);
+    stopped_ = true;
+  }
+  wake_cond_.notify_all();
+  for (auto&& t : threads_) {
+    auto tid = t.get_id();
+    t.join();
+    LOG_DEBUG(WSP, "thread joined " << tid);
+  }
+  threads_.clear();
+  // no more pool threads; add() sees stopped_ under the deque lock, so the deques don't change any more
+  for (auto& w : workers_) {
+    std::deque<Job*> jobs;
+    {
+      std::lock_guard<std::mutex> g(w->lock);
+      jobs.swap(w->jobs);
+    }
+    LOG_DEBUG(WSP, "will " << (executeAllJobs ? "execute " : "discard ") << jobs.size() << " jobs in queue");
+    for (auto* j : jobs) {
+      if (executeAllJobs) execute(j);
+      j->release();
+    }
+  }
+  pending_ = 0;
+}
+
+void WorkStealingThreadPool::add(Job* j) {
+  if (workers_.empty()) {
+    j->release();
+    return;
+  }
+  const auto index = (current_pool_ == this) ? current_index_ : next_++ % workers_.size();
+  {
+    auto& w = *workers_[index];
+    std::unique_lock<std::mutex> g(w.lock);
+    if (stopped_) {
+      g.unlock();
+      j->release();
+      return;
+    }
+    w.jobs.push_back(j);
+  }
+  pending_++;
+  // A thread going to sleep increments sleeping_ before checking pending_, so one of us sees the other's update
+  if (sleeping_ > 0) {
+    { std::lock_guard<std::mutex> l(sleep_lock_); }
+    wake_cond_.notify_one();
+  }
+}
+
+void WorkStealingThreadPool::run(size_t self) {
+  current_pool_ = this;
+  current_index_ = self;
+  LOG_DEBUG(WSP, "thread start " << std::this_thread::get_id());
+  Job* j = nullptr;
+  while (load(self, j)) {
+    execute(j);
+    j->release();
+    j = nullptr;
+  }
+}
+
+bool WorkStealingThreadPool::load(size_t self, Job*& outJob) {
+  while (!stopped_) {
+    if (tryLoad(self, outJob)) return true;
+    std::unique_lock<std::mutex> l(sleep_lock_);
+    sleeping_++;
+    wake_cond_.wait(l, [this] { return pending_ > 0 || stopped_; });
+    sleeping_--;
+  }
+  return false;
+}
+
+bool WorkStealingThreadPool::tryLoad(size_t self, Job*& outJob) {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    auto& w = *workers_[(self + i) % workers_.size()];
+    std::lock_guard<std::mutex> g(w.lock);
+    if (w.jobs.empty()) continue;
+    if (i == 0) {
+      outJob = w.jobs.front();
+      w.jobs.pop_front();
+    } else {
+      outJob = w.jobs.back();
+      w.jobs.pop_back();
+    }
+    pending_--;
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::execute(Job* j) {
+  try {
+    j->execute();
+  } catch (std::exception& e) {
+    LOG_FATAL(WSP,
+              "WorkStealingThreadPool: exception during execution of " << typeid(*j).name() << " Reason: " << e.what());
+    std::terminate();
+  } catch (...) {
+    LOG_FATAL(WSP, "WorkStealingThreadPool: unknown exception during execution of " << typeid(*j).name());
+    std::terminate();
+  }
+}
+
+}  // namespace util
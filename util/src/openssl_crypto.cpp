@@ -22,6 +22,7 @@
 using concord::util::openssl_utils::AsymmetricPrivateKey;
 using concord::util::openssl_utils::AsymmetricPublicKey;
 using concord::util::openssl_utils::kExpectedSHA256HashLengthInBytes;
+using concord::util::openssl_utils::SHA256Hasher;
 using concord::util::openssl_utils::UnexpectedOpenSSLCryptoFailureException;
 using std::invalid_argument;
 using std::pair;
@@ -668,3 +669,64 @@ string concord::util::openssl_utils::computeSHA256Hash(const char* data, size_t
 
   return hash;
 }
+
+void SHA256Hasher::ContextDeleter::operator()(EVP_MD_CTX* context) const { EVP_MD_CTX_free(context); }
+
+SHA256Hasher::SHA256Hasher() : context_(EVP_MD_CTX_new()) {
+  if (!context_) {
+    throw UnexpectedOpenSSLCryptoFailureException(
+        "OpenSSL Crypto unexpectedly failed to allocate a message digest "
+        "context object.");
+  }
+  if (!EVP_DigestInit_ex(context_.get(), EVP_sha256(), nullptr)) {
+    throw UnexpectedOpenSSLCryptoFailureException(
+        "OpenSSL Crypto unexpectedly failed to initialize a message digest "
+        "context object for SHA-256.");
+  }
+}
+
+SHA256Hasher::SHA256Hasher(const SHA256Hasher& other) : context_(EVP_MD_CTX_new()) {
+  if (!context_) {
+    throw UnexpectedOpenSSLCryptoFailureException(
+        "OpenSSL Crypto unexpectedly failed to allocate a message digest "
+        "context object.");
+  }
+  if (!EVP_MD_CTX_copy_ex(context_.get(), other.context_.get())) {
+    throw UnexpectedOpenSSLCryptoFailureException(
+        "OpenSSL Crypto unexpectedly failed to copy a message digest context object.");
+  }
+}
+
+SHA256Hasher& SHA256Hasher::operator=(const SHA256Hasher& other) {
+  if (this != &other) {
+    *this = SHA256Hasher(other);
+  }
+  return *this;
+}
+
+SHA256Hasher::~SHA256Hasher() = default;
+
+void SHA256Hasher::update(const char* data, size_t length) {
+  if (!EVP_DigestUpdate(context_.get(), data, length)) {
+    throw UnexpectedOpenSSLCryptoFailureException("OpenSSL Crypto unexpectedly failed to hash data with SHA-256.");
+  }
+}
+
+string SHA256Hasher::finish() const {
+  // Finalize a copy, so that this hasher can be updated further
+  SHA256Hasher copy(*this);
+  string hash(kExpectedSHA256HashLengthInBytes, (char)0);
+  unsigned int hash_bytes_written;
+  if (!EVP_DigestFinal_ex(copy.context_.get(), reinterpret_cast<unsigned char*>(hash.data()), &hash_bytes_written)) {
+    throw UnexpectedOpenSSLCryptoFailureException(
+        "OpenSSL Crypto unexpectedly failed to retrieve the resulting hash "
+        "from a message digest context object for an SHA-256 hash operation.");
+  }
+  if (hash_bytes_written > kExpectedSHA256HashLengthInBytes) {
+    throw UnexpectedOpenSSLCryptoFailureException(
+        "OpenSSL Crypto unexpectedly reported retrieving a hash value longer "
+        "than that expected for an SHA-256 hash from an SHA-256 hash "
+        "operation.");
+  }
+  return hash;
+}
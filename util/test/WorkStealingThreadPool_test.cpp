@@ -0,0 +1,114 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "WorkStealingThreadPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <set>
+#include <thread>
+
+namespace {
+
+using namespace util;
+
+class FuncJob final : public WorkStealingThreadPool::Job {
+ public:
+  FuncJob(std::function<void()> f, std::atomic_int& released) : f_{std::move(f)}, released_{released} {}
+  void execute() override { f_(); }
+  void release() override {
+    released_++;
+    delete this;
+  }
+
+ private:
+  std::function<void()> f_;
+  std::atomic_int& released_;
+};
+
+TEST(WorkStealingThreadPool, executes_all_jobs) {
+  WorkStealingThreadPool pool;
+  pool.start(4);
+  ASSERT_EQ(pool.getNumOfThreads(), 4);
+  std::atomic_int executed{0};
+  std::atomic_int released{0};
+  const auto numOfJobs = 10000;
+  for (auto i = 0; i < numOfJobs; ++i) pool.add(new FuncJob([&] { executed++; }, released));
+  while (released < numOfJobs) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ASSERT_EQ(executed, numOfJobs);
+  ASSERT_EQ(pool.getNumOfJobs(), 0);
+  pool.stop();
+}
+
+TEST(WorkStealingThreadPool, idle_threads_steal_jobs) {
+  WorkStealingThreadPool pool;
+  pool.start(4);
+  std::atomic_int released{0};
+  std::mutex lock;
+  std::set<std::thread::id> threads;
+  std::promise<void> added;
+  auto addedFuture = added.get_future().share();
+  // A job adds jobs to the deque of its own thread and blocks it until all are added - other threads steal them
+  pool.add(new FuncJob(
+      [&] {
+        for (auto i = 0; i < 100; ++i)
+          pool.add(new FuncJob(
+              [&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> g(lock);
+                threads.insert(std::this_thread::get_id());
+              },
+              released));
+        added.set_value();
+      },
+      released));
+  addedFuture.wait();
+  while (released < 101) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  ASSERT_GT(threads.size(), 1);
+}
+
+TEST(WorkStealingThreadPool, stop_releases_remaining_jobs) {
+  WorkStealingThreadPool pool;
+  pool.start(1);
+  std::atomic_int executed{0};
+  std::atomic_int released{0};
+  std::promise<void> unblock;
+  auto unblockFuture = unblock.get_future().share();
+  pool.add(new FuncJob([&] { unblockFuture.wait(); }, released));
+  for (auto i = 0; i < 10; ++i) pool.add(new FuncJob([&] { executed++; }, released));
+  auto stopper = std::async(std::launch::async, [&] { pool.stop(true); });
+  unblock.set_value();
+  stopper.wait();
+  ASSERT_EQ(released, 11);
+  ASSERT_EQ(executed, 10);
+  // Jobs added after stop are released without being executed
+  pool.add(new FuncJob([&] { executed++; }, released));
+  ASSERT_EQ(pool.getNumOfJobs(), 0);
+  ASSERT_EQ(released, 12);
+  ASSERT_EQ(executed, 10);
+}
+
+TEST(WorkStealingThreadPool, jobs_added_before_start_are_released) {
+  WorkStealingThreadPool pool;
+  std::atomic_int executed{0};
+  std::atomic_int released{0};
+  pool.add(new FuncJob([&] { executed++; }, released));
+  ASSERT_EQ(released, 1);
+  ASSERT_EQ(executed, 0);
+}
+
+}  // namespace
@@ -16,6 +16,7 @@
 #include "gtest/gtest.h"
 #include "Metrics.hpp"
 #include <cmath>
+#include <thread>
 
 using namespace std;
 
@@ -199,4 +200,136 @@ TEST(MetricTest, CollectStatuses) {
   ASSERT_EQ(numOfGaugesInStateTransfer, 1);
 }
 
+TEST(MetricTest, AtomicValuesAreReadInPlace) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  auto h_counter = c.RegisterAtomicCounter("requests", 5);
+  auto h_gauge = c.RegisterAtomicGauge("in_flight", 1);
+  c.Register();
+
+  const auto num_threads = 8;
+  const auto num_increments = 10000;
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < num_threads; i++) {
+    threads.emplace_back([&]() {
+      for (auto j = 0; j < num_increments; j++) {
+        h_counter.Get().Inc();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  h_gauge.Get().Set(7);
+
+  // No UpdateAggregator() is needed for atomic values
+  ASSERT_EQ(5 + num_threads * num_increments, h_counter.Get().Get());
+  ASSERT_EQ(5 + num_threads * num_increments, aggregator->GetCounter(c.Name(), "requests").Get());
+  ASSERT_EQ(7, aggregator->GetGauge(c.Name(), "in_flight").Get());
+}
+
+TEST(MetricTest, UpdateAggregatorWhileReading) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  auto h_counter = c.RegisterCounter("blocks");
+  auto h_status = c.RegisterStatus("state", "0");
+  c.Register();
+
+  std::atomic_bool done{false};
+  std::thread reader([&]() {
+    uint64_t last = 0;
+    while (!done) {
+      const auto val = aggregator->GetCounter(c.Name(), "blocks").Get();
+      // Published values never go back, and the status is always published with its counter.
+      ASSERT_GE(val, last);
+      ASSERT_GE(std::stoull(aggregator->GetStatus(c.Name(), "state").Get()), val);
+      aggregator->ToJson();
+      last = val;
+    }
+  });
+  for (auto i = 1; i <= 20000; i++) {
+    h_status.Get().Set(std::to_string(i));
+    h_counter.Get().Inc();
+    c.UpdateAggregator();
+  }
+  done = true;
+  reader.join();
+  ASSERT_EQ(20000, aggregator->GetCounter(c.Name(), "blocks").Get());
+}
+
+TEST(MetricTest, AtomicGaugeIsUpdatedFromMultipleThreads) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  auto h_gauge = c.RegisterAtomicGauge("in_flight", 3);
+  c.Register();
+
+  const auto num_threads = 8;
+  const auto num_updates = 10000;
+  std::vector<std::thread> threads;
+  for (auto i = 0; i < num_threads; i++) {
+    threads.emplace_back([&]() {
+      for (auto j = 0; j < num_updates; j++) {
+        h_gauge.Get().Inc();
+        h_gauge.Get().Inc();
+        h_gauge.Get().Dec();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(3 + num_threads * num_updates, aggregator->GetGauge(c.Name(), "in_flight").Get());
+
+  // Set() overrides whatever the threads have added so far
+  h_gauge.Get().Set(2);
+  ASSERT_EQ(2, h_gauge.Get().Get());
+  std::thread t([&]() { h_gauge.Get().Dec(); });
+  t.join();
+  h_gauge.Get().Dec();
+  ASSERT_EQ(0, aggregator->GetGauge(c.Name(), "in_flight").Get());
+}
+
+TEST(MetricTest, ReRegisteringReplacesComponent) {
+  auto aggregator = std::make_shared<Aggregator>();
+  {
+    Component c("replica", aggregator);
+    c.RegisterCounter("messages_sent", 1);
+    c.Register();
+  }
+  Component c("replica", aggregator);
+  auto h_counter = c.RegisterCounter("messages_sent", 0);
+  c.Register();
+  h_counter.Get().Inc(3);
+  c.UpdateAggregator();
+  ASSERT_EQ(3, aggregator->GetCounter(c.Name(), "messages_sent").Get());
+}
+
+TEST(MetricTest, ReplacedComponentIsNotReported) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component old_c("replica", aggregator);
+  auto h_old_counter = old_c.RegisterCounter("messages_sent", 0);
+  auto h_old_gauge = old_c.RegisterAtomicGauge("in_flight", 0);
+  old_c.Register();
+
+  Component c("replica", aggregator);
+  auto h_counter = c.RegisterCounter("messages_sent", 0);
+  auto h_gauge = c.RegisterAtomicGauge("in_flight", 0);
+  c.Register();
+
+  // The replaced component is still alive and keeps publishing
+  h_old_counter.Get().Inc(10);
+  h_old_gauge.Get().Set(10);
+  old_c.UpdateAggregator();
+  h_counter.Get().Inc(3);
+  h_gauge.Get().Set(4);
+  c.UpdateAggregator();
+  h_old_counter.Get().Inc(10);
+  old_c.UpdateAggregator();
+
+  ASSERT_EQ(3, aggregator->GetCounter(c.Name(), "messages_sent").Get());
+  ASSERT_EQ(4, aggregator->GetGauge(c.Name(), "in_flight").Get());
+  ASSERT_EQ(1, aggregator->CollectCounters().size());
+  ASSERT_EQ(1, aggregator->CollectGauges().size());
+}
+
 }  // namespace concordMetrics
@@ -12,7 +12,10 @@
 // file.
 //
 
+#include <atomic>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 #include "gtest/gtest.h"
 #include "Timers.hpp"
 
@@ -109,4 +112,133 @@ TEST(TimersTest, Basic) {
   ASSERT_THROW(timers.reset(handle, duration * 2, now), std::invalid_argument);
 }
 
+TEST(TimersTest, LongAndShortTimersFireInOrder) {
+  auto timers = Timers();
+  steady_clock::time_point now = steady_clock::now();
+
+  // Durations that land in different levels of the wheel, including the overflow list.
+  const std::vector<milliseconds> durations{
+      milliseconds(1), milliseconds(255), milliseconds(256), milliseconds(70000), hours(24 * 60)};
+  std::vector<milliseconds> fired;
+  for (auto d : durations) {
+    timers.add(
+        d, Timers::Timer::ONESHOT, [&fired, d](Handle) { fired.push_back(d); }, now);
+  }
+
+  for (size_t i = 0; i < durations.size(); ++i) {
+    // Just before the expiry time the timer doesn't fire.
+    timers.evaluate(now + durations[i] - microseconds(1));
+    ASSERT_EQ(i, fired.size());
+    timers.evaluate(now + durations[i]);
+    ASSERT_EQ(i + 1, fired.size());
+    ASSERT_EQ(durations[i], fired.back());
+  }
+  ASSERT_EQ(fired, durations);
+}
+
+TEST(TimersTest, CallbackCanResetAndCancel) {
+  milliseconds duration(10);
+  auto timers = Timers();
+  steady_clock::time_point now = steady_clock::now();
+
+  int self_reset_counter = 0;
+  int cancelled_counter = 0;
+  Handle to_cancel = timers.add(
+      duration * 2, Timers::Timer::RECURRING, [&cancelled_counter](Handle) { ++cancelled_counter; }, now);
+  timers.add(
+      duration,
+      Timers::Timer::ONESHOT,
+      [&](Handle h) {
+        ++self_reset_counter;
+        // A oneshot timer that resets itself stays alive.
+        timers.reset(h, duration * 3, now + duration);
+        if (self_reset_counter == 1) timers.cancel(to_cancel);
+      },
+      now);
+
+  // The first timer fires, resets itself and cancels the other one, which is due at the same evaluation.
+  timers.evaluate(now + duration * 2);
+  ASSERT_EQ(1, self_reset_counter);
+  ASSERT_EQ(0, cancelled_counter);
+
+  timers.evaluate(now + duration * 4);
+  ASSERT_EQ(2, self_reset_counter);
+  ASSERT_EQ(0, cancelled_counter);
+  ASSERT_THROW(timers.cancel(to_cancel), std::invalid_argument);
+}
+
+TEST(TimersTest, CallsFromOtherThreadsTakeEffectImmediately) {
+  milliseconds duration(100);
+  auto timers = Timers();
+  steady_clock::time_point now = steady_clock::now();
+  timers.evaluate(now);
+
+  int counter = 0;
+  Handle handle;
+  std::thread([&]() {
+    handle = timers.add(
+        duration, Timers::Timer::RECURRING, [&counter](Handle) { ++counter; }, now);
+  }).join();
+  ASSERT_EQ(0, counter);
+
+  timers.evaluate(now + duration);
+  ASSERT_EQ(1, counter);
+
+  // Once cancel() returns the timer doesn't fire anymore, and an invalid handle throws as in the evaluating thread.
+  std::thread([&]() {
+    timers.cancel(handle);
+    ASSERT_THROW(timers.cancel(handle), std::invalid_argument);
+  }).join();
+  timers.evaluate(now + duration * 2);
+  ASSERT_EQ(1, counter);
+}
+
+TEST(TimersTest, EvaluateSeesTimersThatExpireEarlier) {
+  auto timers = Timers();
+  steady_clock::time_point now = steady_clock::now();
+
+  int counter = 0;
+  auto handle = timers.add(
+      milliseconds(1000), Timers::Timer::ONESHOT, [&counter](Handle) { ++counter; }, now);
+  timers.evaluate(now + milliseconds(10));
+  ASSERT_EQ(0, counter);
+
+  // Nothing is due before the first timer, until another thread makes one expire earlier.
+  std::thread([&]() { timers.reset(handle, milliseconds(20), now); }).join();
+  timers.evaluate(now + milliseconds(20));
+  ASSERT_EQ(1, counter);
+
+  std::thread([&]() {
+    timers.add(
+        milliseconds(30), Timers::Timer::ONESHOT, [&counter](Handle) { ++counter; }, now);
+  }).join();
+  timers.evaluate(now + milliseconds(29));
+  ASSERT_EQ(1, counter);
+  timers.evaluate(now + milliseconds(30));
+  ASSERT_EQ(2, counter);
+}
+
+TEST(TimersTest, CancelWaitsForRunningCallback) {
+  auto timers = Timers();
+  steady_clock::time_point now = steady_clock::now();
+
+  std::atomic_bool started{false};
+  std::atomic_bool finished{false};
+  auto handle = timers.add(
+      milliseconds(1),
+      Timers::Timer::RECURRING,
+      [&](Handle) {
+        started = true;
+        std::this_thread::sleep_for(milliseconds(50));
+        finished = true;
+      },
+      now);
+
+  std::thread evaluator([&]() { timers.evaluate(now + milliseconds(1)); });
+  while (!started) std::this_thread::yield();
+  timers.cancel(handle);
+  ASSERT_TRUE(finished);
+  evaluator.join();
+}
+
 }  // namespace concordUtil